@@ -64,8 +64,12 @@
 #include "src/timer.h"
 #include "src/scheduler.h"
 #include "src/i2c.h"
+#include "src/i2c_queue.h"
 #include "src/ble.h"
 #include "src/adc.h"
+#include "src/sound.h"
+#include "src/occupancy.h"
+#include "src/history.h"
 
 
 // Students: Here is an example of how to correctly include logging functions in
@@ -198,6 +202,11 @@ SL_WEAK void app_init(void)
 #if DEVICE_IS_BLE_SERVER
   initialize_I2C();
   initADC();
+  initSound();
+  initOccupancy();
+  initHistory();
+  initPeriodicSampling();
+  initTemperatureSensor();
 #endif
 
 
@@ -313,10 +322,21 @@ void sl_bt_on_event(sl_bt_msg_t *evt)
   handle_ble_event(evt); // put this code in ble.c/.h
 
   // sequence through states driven by events
+  // IRQs queue their events, the external signal only means the queue is
+  // not empty, so drain everything queued since the last one
+  if (SL_BT_MSG_ID(evt->header) == sl_bt_evt_system_external_signal_id){
+      scheduler_event_entry event;
+      while (getNextEvent(&event)){
+          handle_ble_scheduler_event(&event);
 #if DEVICE_IS_BLE_SERVER
-  ambient_light_state_machine(evt);
-  sound_detector_update(evt);
+          i2c_queue_update(&event);
+          periodic_sampling_update(&event);
+          ambient_light_state_machine(&event);
+          temperature_state_machine(&event);
+          sound_detector_update(&event);
 #endif
+      }
+  }
 
 
 } // sl_bt_on_event()
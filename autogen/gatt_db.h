@@ -25,6 +25,12 @@ extern const sli_bt_gattdb_t gattdb;
 #define gattdb_illuminance                    28
 #define gattdb_microphone_control             30
 #define gattdb_audio_input_description        32
+#define gattdb_health_thermometer             34
+#define gattdb_temperature_measurement        36
+#define gattdb_environmental_sensing          38
+#define gattdb_humidity                       40
+#define gattdb_study_space                    42
+#define gattdb_study_space_snapshot           44
 
 
 #endif // __GATT_DB_H
@@ -0,0 +1,315 @@
+/***********************************************************************
+ * @file      bench_series.c
+ * @brief     Host benchmark of the history encoding in src/series.c
+ *
+ * @author    Hyounjun Chang, hyounjun.chang@colorado.edu
+ * @date      Oct 17, 2026
+ *
+ * @resources Pelkonen et al., Gorilla: A Fast, Scalable, In-Memory Time
+ *            Series Database, VLDB 2015
+ *
+ * Reads history traces written by study_space_sim --history-trace and
+ * encodes them the three ways the firmware does: as one stream, as flash
+ * log records the way history.c writes them, a stream per page, and cut
+ * into SDUs the way the history channel sends them. Reports the bytes a record takes against
+ * the packed 8 byte record with a uint32 timestamp, how often each field
+ * changes, and the cost of encoding and decoding. Every record has to
+ * decode back exactly, exits 1 if one does not. Host cycles show how the
+ * cost scales, not what the M4 spends.
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCH_HAVE_TSC 1
+#else
+#define BENCH_HAVE_TSC 0
+#endif
+
+#include "src/series.h"
+#include "src/history.h"
+#include "src/flash_log.h"
+#include "src/ble.h"
+
+#define TRACE_MAX_ROWS      10080 // a week
+#define BENCH_PASSES        200
+#define RAW_RECORD_LEN      12  // the 8 byte record and a uint32 timestamp
+// a record in the flash log before it was encoded: log header and 8 bytes
+#define RAW_FLASH_LEN       (FLASH_LOG_RECORD_HEADER + 8)
+#define FLASH_PAGE_SPACE    (FLASH_PAGE_SIZE - FLASH_LOG_PAGE_HEADER)
+
+typedef struct {
+  uint32_t count;
+  uint32_t time[TRACE_MAX_ROWS];
+  int32_t values[TRACE_MAX_ROWS][HISTORY_FIELDS];
+} trace_t;
+
+static const char* field_names[HISTORY_FIELDS] = {
+  "flags", "sound class", "Leq", "humidity", "lux", "temperature",
+};
+
+static trace_t trace;
+// the longest stream an encoder takes, a week of a busy room fits
+static uint8_t stream[UINT16_MAX];
+
+static double now_s(){
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static uint64_t now_cycles(){
+#if BENCH_HAVE_TSC
+  return __rdtsc();
+#else
+  return 0;
+#endif
+}
+
+static bool load_trace(const char* path){
+  char line[256];
+  FILE* f = fopen(path, "r");
+  if (!f){
+      perror(path);
+      return false;
+  }
+  trace.count = 0;
+  while (fgets(line, sizeof(line), f) && trace.count < TRACE_MAX_ROWS){
+      unsigned long t;
+      long v[HISTORY_FIELDS];
+      if (sscanf(line, "%lu,%ld,%ld,%ld,%ld,%ld,%ld", &t, &v[0], &v[1], &v[2], &v[3], &v[4], &v[5]) != 7){
+          continue;   // header
+      }
+      trace.time[trace.count] = (uint32_t)t;
+      for (int i = 0; i < HISTORY_FIELDS; i++){
+          trace.values[trace.count][i] = (int32_t)v[i];
+      }
+      trace.count++;
+  }
+  fclose(f);
+  return trace.count > 1;
+}
+
+// decodes count records from buf and compares them with the trace from first on
+static bool decodes_back(const uint8_t* buf, uint16_t len, uint32_t first, uint32_t count){
+  series_decoder_t decoder;
+  int32_t values[HISTORY_FIELDS];
+  uint32_t t;
+  series_decoder_init(&decoder, buf, len, HISTORY_FIELDS);
+  for (uint32_t n = first; n < first + count; n++){
+      if (!series_decode(&decoder, &t, values) || t != trace.time[n] ||
+          memcmp(values, trace.values[n], sizeof(values)) != 0){
+          return false;
+      }
+  }
+  return decoder.pos == decoder.len;
+}
+
+// a flash log record a record, as history.c appends them: the values whole
+// on a new page, deltas from the record before on the same page, the
+// timestamp in the log header. Returns the bytes of all of them and the
+// pages they take.
+static uint32_t flash_records(uint32_t* pages, bool* ok){
+  // the payloads of a page back to back, without the padding
+  uint8_t stream_bytes[FLASH_PAGE_SPACE];
+  uint16_t lens[FLASH_PAGE_SPACE / FLASH_LOG_RECORD_HEADER];
+  uint8_t payload[SERIES_SAMPLE_MAX(HISTORY_FIELDS)];
+  series_encoder_t encoder;
+  series_encoder_t next;
+  uint32_t bytes = 0;
+  uint32_t used = FLASH_PAGE_SPACE;
+  uint32_t stream_len = 0;
+  uint32_t on_page = 0;
+  uint32_t first = 0;
+  uint32_t size = 0;
+
+  *pages = 0;
+  series_encoder_init(&encoder, payload, sizeof(payload), HISTORY_FIELDS);
+  for (uint32_t n = 0; n <= trace.count; n++){
+      if (n < trace.count){
+          next = encoder;
+          series_encoder_continue(&next, payload, sizeof(payload));
+          series_encode(&next, 0, trace.values[n]);
+          size = FLASH_LOG_RECORD_HEADER + ((next.len + 3u) & ~3u);
+      }
+      // a page is full, it has to decode back on its own
+      if (on_page != 0 && (n == trace.count || used + size > FLASH_PAGE_SPACE)){
+          series_decoder_t decoder;
+          int32_t values[HISTORY_FIELDS];
+          uint32_t t;
+          uint32_t at = 0;
+          series_decoder_init(&decoder, NULL, 0, HISTORY_FIELDS);
+          for (uint32_t r = 0; r < on_page; r++){
+              series_decoder_continue(&decoder, &stream_bytes[at], lens[r]);
+              if (!series_decode(&decoder, &t, values) || decoder.pos != lens[r] ||
+                  memcmp(values, trace.values[first + r], sizeof(values)) != 0){
+                  *ok = false;
+              }
+              at += lens[r];
+          }
+          first += on_page;
+          on_page = 0;
+      }
+      if (n == trace.count){
+          break;
+      }
+      if (used + size > FLASH_PAGE_SPACE){
+          series_encoder_init(&next, payload, sizeof(payload), HISTORY_FIELDS);
+          series_encode(&next, 0, trace.values[n]);
+          size = FLASH_LOG_RECORD_HEADER + ((next.len + 3u) & ~3u);
+          used = 0;
+          stream_len = 0;
+          (*pages)++;
+      }
+      memcpy(&stream_bytes[stream_len], payload, next.len);
+      stream_len += next.len;
+      lens[on_page++] = next.len;
+      used += size;
+      bytes += size;
+      encoder = next;
+  }
+  return bytes;
+}
+
+// cuts the trace into streams of up to size bytes and max records, the way
+// the history channel fills SDUs. Returns the bytes of all of them and how
+// many there are.
+static uint32_t cut_streams(uint16_t size, uint32_t max, uint32_t* streams, bool* ok){
+  uint8_t buf[HISTORY_SDU_STREAM_MAX];
+  series_encoder_t encoder;
+  uint32_t bytes = 0;
+  uint32_t first = 0;
+
+  *streams = 0;
+  series_encoder_init(&encoder, buf, size, HISTORY_FIELDS);
+  for (uint32_t n = 0; n <= trace.count; n++){
+      if (n < trace.count && encoder.count < max && series_encode(&encoder, trace.time[n], trace.values[n])){
+          continue;
+      }
+      if (!decodes_back(buf, encoder.len, first, encoder.count)){
+          *ok = false;
+      }
+      bytes += encoder.len;
+      (*streams)++;
+      first += encoder.count;
+      if (n == trace.count){
+          break;
+      }
+      series_encoder_init(&encoder, buf, size, HISTORY_FIELDS);
+      series_encode(&encoder, trace.time[n], trace.values[n]);
+  }
+  return bytes;
+}
+
+static bool bench_trace(const char* path){
+  series_encoder_t encoder;
+  series_decoder_t decoder;
+  int32_t values[HISTORY_FIELDS];
+  uint32_t changes[HISTORY_FIELDS + 1] = {0};
+  uint32_t t;
+  uint32_t pages;
+  uint32_t sdus;
+  uint32_t bytes;
+  double per_page;
+  bool ok = true;
+
+  if (!load_trace(path)){
+      fprintf(stderr, "%s: no records\n", path);
+      return false;
+  }
+  printf("%s: %lu records over %.1f h\n", path, (unsigned long)trace.count,
+         (trace.time[trace.count - 1] - trace.time[0]) / 3600.0);
+  for (uint32_t n = 1; n < trace.count; n++){
+      if (n > 1 && trace.time[n] - trace.time[n - 1] != trace.time[n - 1] - trace.time[n - 2]){
+          changes[HISTORY_FIELDS]++;
+      }
+      for (int i = 0; i < HISTORY_FIELDS; i++){
+          if (trace.values[n][i] != trace.values[n - 1][i]){
+              changes[i]++;
+          }
+      }
+  }
+  printf("  changed from the record before:");
+  for (int i = 0; i < HISTORY_FIELDS; i++){
+      printf(" %s %.0f%%,", field_names[i], 100.0 * changes[i] / (trace.count - 1));
+  }
+  printf(" period %.0f%%\n", 100.0 * changes[HISTORY_FIELDS] / (trace.count - 1));
+
+  // one stream of everything
+  series_encoder_init(&encoder, stream, sizeof(stream), HISTORY_FIELDS);
+  for (uint32_t n = 0; n < trace.count; n++){
+      series_encode(&encoder, trace.time[n], trace.values[n]);
+  }
+  if (!decodes_back(stream, encoder.len, 0, trace.count)){
+      ok = false;
+  }
+  printf("  %-14s %5.2f bytes a record, %4.1fx smaller than %d\n", "one stream",
+         (double)encoder.len / trace.count, (double)RAW_RECORD_LEN * trace.count / encoder.len,
+         RAW_RECORD_LEN);
+
+  // flash log records and history channel SDUs
+  bytes = flash_records(&pages, &ok);
+  per_page = (double)(FLASH_PAGE_SIZE - FLASH_LOG_PAGE_HEADER) * trace.count / bytes;
+  printf("  %-14s %5.2f bytes a record, %4.1fx smaller than %d; %.0f records a page over %lu pages, "
+         "%.1f days in %d pages\n", "flash records",
+         (double)bytes / trace.count, (double)RAW_FLASH_LEN * trace.count / bytes, RAW_FLASH_LEN,
+         per_page, (unsigned long)pages,
+         per_page * (FLASH_LOG_PAGES - 1) * HISTORY_PERIOD_S / 86400.0, FLASH_LOG_PAGES - 1);
+  bytes = cut_streams(HISTORY_SDU_STREAM_MAX, HISTORY_SDU_RECORDS, &sdus, &ok);
+  printf("  %-14s %5.2f bytes a record, %4.1fx smaller than %d; %.0f records an SDU\n", "SDUs",
+         (double)bytes / trace.count, (double)RAW_RECORD_LEN * trace.count / bytes, RAW_RECORD_LEN,
+         (double)trace.count / sdus);
+
+  // cost, one stream over and over
+  double start = now_s();
+  uint64_t start_cycles = now_cycles();
+  for (int pass = 0; pass < BENCH_PASSES; pass++){
+      series_encoder_init(&encoder, stream, sizeof(stream), HISTORY_FIELDS);
+      for (uint32_t n = 0; n < trace.count; n++){
+          series_encode(&encoder, trace.time[n], trace.values[n]);
+      }
+  }
+  double encode_s = now_s() - start;
+  uint64_t encode_cycles = now_cycles() - start_cycles;
+  start = now_s();
+  start_cycles = now_cycles();
+  for (int pass = 0; pass < BENCH_PASSES; pass++){
+      series_decoder_init(&decoder, stream, encoder.len, HISTORY_FIELDS);
+      while (series_decode(&decoder, &t, values)){
+      }
+  }
+  double decode_s = now_s() - start;
+  uint64_t decode_cycles = now_cycles() - start_cycles;
+  printf("  encode %6.1f ns", encode_s * 1e9 / BENCH_PASSES / trace.count);
+  if (BENCH_HAVE_TSC){
+      printf(" %6.1f host cycles", (double)encode_cycles / BENCH_PASSES / trace.count);
+  }
+  printf(", decode %6.1f ns", decode_s * 1e9 / BENCH_PASSES / trace.count);
+  if (BENCH_HAVE_TSC){
+      printf(" %6.1f host cycles", (double)decode_cycles / BENCH_PASSES / trace.count);
+  }
+  printf(" per record\n");
+
+  if (!ok){
+      printf("  CHECK FAILED: records did not decode back\n");
+  }
+  return ok;
+}
+
+int main(int argc, char** argv){
+  bool ok = true;
+  if (argc < 2){
+      fprintf(stderr, "usage: %s history.csv...\n", argv[0]);
+      return 2;
+  }
+  for (int i = 1; i < argc; i++){
+      if (!bench_trace(argv[i])){
+          ok = false;
+      }
+  }
+  return ok ? 0 : 1;
+}
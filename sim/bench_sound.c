@@ -0,0 +1,191 @@
+/***********************************************************************
+ * @file      bench_sound.c
+ * @brief     Host benchmark of the sound level block stage in src/sound.c
+ *
+ * @author    Hyounjun Chang, hyounjun.chang@colorado.edu
+ * @date      Oct 16, 2026
+ *
+ * @resources IEC 61672-1 table 3, nominal A and C weightings
+ *
+ * Measures the weighting filter response against the IEC nominal values
+ * and times the weighting filter and the whole per-buffer stage. Host
+ * times come from the scalar reference kernels in sim_cmsis_dsp.c, so
+ * they show how the cost scales, not what the M4 spends. For target
+ * numbers build with SOUND_PROFILE_CYCLES 1, which logs DWT cycle counts.
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCH_HAVE_TSC 1
+#else
+#define BENCH_HAVE_TSC 0
+#endif
+
+#include "src/adc.h"
+#include "src/sound.h"
+
+#define BENCH_BUFFERS        20000
+#define BENCH_TARGET_HZ      38400000.0  // HFXO
+#define BENCH_MAX_ERROR_DB   1.0         // up to 2 kHz
+#define TWO_PI 6.283185307179586
+
+#if SOUND_WEIGHTING != SOUND_WEIGHTING_Z
+typedef struct {
+  double hz;
+  double a_dB;
+  double c_dB;
+} weighting_point_t;
+
+static const weighting_point_t iec_points[] = {
+  { 31.5, -39.4, -3.0 },
+  { 63.0, -26.2, -0.8 },
+  { 125.0, -16.1, -0.2 },
+  { 250.0, -8.6, 0.0 },
+  { 500.0, -3.2, 0.0 },
+  { 1000.0, 0.0, 0.0 },
+  { 2000.0, 1.2, -0.2 },
+  { 3150.0, 1.2, -0.5 },
+};
+#endif
+
+// stands in for the LDMA ping-pong buffers in adc.c
+static uint16_t bench_buffers[2][SOUND_BUFFER_SAMPLES];
+
+const uint16_t* sound_capture_buffer(uint32_t n){
+  return bench_buffers[n & 1];
+}
+
+static double now_s(){
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static uint64_t now_cycles(){
+#if BENCH_HAVE_TSC
+  return __rdtsc();
+#else
+  return 0;
+#endif
+}
+
+#if SOUND_WEIGHTING != SOUND_WEIGHTING_Z
+static double block_rms(const int16_t* block, uint32_t n){
+  double sum = 0.0;
+  for (uint32_t i = 0; i < n; i++){
+      sum += (double)block[i] * block[i];
+  }
+  return sqrt(sum / n);
+}
+
+// gain of the weighting filter at one frequency, after it has settled
+static double measure_gain_dB(double hz){
+  static int16_t block[SOUND_BUFFER_SAMPLES];
+  double in_rms = 0.0;
+  double out_rms = 0.0;
+  uint32_t t = 0;
+
+  sound_weighting_reset();
+  for (int b = 0; b < 8; b++){
+      for (uint32_t i = 0; i < SOUND_BUFFER_SAMPLES; i++, t++){
+          block[i] = (int16_t)lround(8000.0 * sin(TWO_PI * hz * t / SOUND_SAMPLE_RATE_HZ));
+      }
+      in_rms = block_rms(block, SOUND_BUFFER_SAMPLES);
+      sound_weighting_apply(block, SOUND_BUFFER_SAMPLES);
+      out_rms = block_rms(block, SOUND_BUFFER_SAMPLES);
+  }
+  return 20.0 * log10(out_rms / in_rms);
+}
+#endif
+
+static void report_cost(const char* name, double seconds, uint64_t cycles, uint32_t samples){
+  printf("  %-22s %8.1f ns", name, seconds * 1e9 / samples);
+  if (BENCH_HAVE_TSC){
+      printf("  %7.1f host cycles", (double)cycles / samples);
+  }
+  printf("  per sample\n");
+}
+
+int main(){
+  static int16_t block[SOUND_BUFFER_SAMPLES];
+  sound_level_t level;
+  bool ok = true;
+
+  initSound();
+
+  // speech-like test signal around mid-scale for the full stage
+  for (uint32_t b = 0; b < 2; b++){
+      for (uint32_t i = 0; i < SOUND_BUFFER_SAMPLES; i++){
+          double t = (double)(b * SOUND_BUFFER_SAMPLES + i) / SOUND_SAMPLE_RATE_HZ;
+          double v = 2048.0 + 150.0 * sin(TWO_PI * 700.0 * t) + 80.0 * sin(TWO_PI * 1400.0 * t + 1.0)
+                   + 60.0 * sin(TWO_PI * 120.0 * t) + (double)(rand() % 17 - 8);
+          bench_buffers[b][i] = (uint16_t)lround(v);
+      }
+  }
+
+#if SOUND_WEIGHTING == SOUND_WEIGHTING_Z
+  printf("weighting: none (SOUND_WEIGHTING_Z)\n");
+#else
+  bool a_weighting = (SOUND_WEIGHTING == SOUND_WEIGHTING_A);
+  printf("%c-weighting at %d Hz\n", a_weighting ? 'A' : 'C', SOUND_SAMPLE_RATE_HZ);
+  printf("  %8s %9s %9s\n", "Hz", "measured", "IEC");
+  for (size_t i = 0; i < sizeof(iec_points) / sizeof(iec_points[0]); i++){
+      const weighting_point_t* p = &iec_points[i];
+      double expected = a_weighting ? p->a_dB : p->c_dB;
+      double measured = measure_gain_dB(p->hz);
+      bool in_band = p->hz <= 2000.0;
+      printf("  %8.1f %9.2f %9.2f%s\n", p->hz, measured, expected, in_band ? "" : "  (near Nyquist)");
+      if (in_band && fabs(measured - expected) > BENCH_MAX_ERROR_DB){
+          ok = false;
+      }
+  }
+#endif
+
+  // weighting filter alone, state carried across buffers as in a window
+  memset(block, 0, sizeof(block));
+  sound_weighting_reset();
+  double start = now_s();
+  uint64_t start_cycles = now_cycles();
+  for (uint32_t b = 0; b < BENCH_BUFFERS; b++){
+      sound_weighting_apply(block, SOUND_BUFFER_SAMPLES);
+  }
+  double filter_s = now_s() - start;
+  uint64_t filter_cycles = now_cycles() - start_cycles;
+
+  // whole per-buffer stage: bias, q15 conversion, band energies, weighting,
+  // RMS / peak / Leq
+  start = now_s();
+  start_cycles = now_cycles();
+  for (uint32_t b = 0; b < BENCH_BUFFERS; b++){
+      sound_level_process(b % SOUND_BUFFERS_PER_WINDOW, &level);
+  }
+  double stage_s = now_s() - start;
+  uint64_t stage_cycles = now_cycles() - start_cycles;
+
+  printf("cost, host build, %d buffers of %d samples\n", BENCH_BUFFERS, SOUND_BUFFER_SAMPLES);
+  report_cost("weighting filter", filter_s, filter_cycles, BENCH_BUFFERS * SOUND_BUFFER_SAMPLES);
+  report_cost("buffer stage", stage_s, stage_cycles, BENCH_BUFFERS * SOUND_BUFFER_SAMPLES);
+  printf("budget: %.0f ms per buffer, %.0f target cycles per sample at %.1f MHz\n",
+         1000.0 * SOUND_BUFFER_SAMPLES / SOUND_SAMPLE_RATE_HZ,
+         BENCH_TARGET_HZ / SOUND_SAMPLE_RATE_HZ, BENCH_TARGET_HZ / 1e6);
+  printf("last window: rms %u mV, peak %u mV, Leq %.1f dB, %s\n", level.rms_mV, level.peak_mV,
+         level.leq_dB10 / 10.0, sound_level_name(level.level));
+  if (level.features.frames > 0){
+      printf("  bands: low %.1f dB, speech %.1f dB, high %.1f dB, speech share %u%%, %u frames of %d\n",
+             level.features.low_dB10 / 10.0, level.features.speech_dB10 / 10.0,
+             level.features.high_dB10 / 10.0, level.features.speech_pct, level.features.frames,
+             SOUND_FFT_SIZE);
+  }
+
+  if (!ok){
+      printf("weighting response out of tolerance\n");
+      return 1;
+  }
+  return 0;
+}
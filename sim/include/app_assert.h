@@ -0,0 +1,21 @@
+/***********************************************************************
+ * @file      app_assert.h
+ * @brief     Host simulation stand-in for app_assert
+ *
+ * @author    Hyounjun Chang, hyounjun.chang@colorado.edu
+ * @date      Oct 16, 2026
+ *
+ * @resources
+ *
+ *
+ */
+
+#ifndef SIM_APP_ASSERT_H
+#define SIM_APP_ASSERT_H
+
+#include <assert.h>
+
+#define app_assert(expr, ...) assert(expr)
+#define app_assert_status(sc) assert((sc) == SL_STATUS_OK)
+
+#endif
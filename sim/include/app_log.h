@@ -0,0 +1,20 @@
+/***********************************************************************
+ * @file      app_log.h
+ * @brief     Host simulation stand-in for app_log (VCOM USART output)
+ *
+ * @author    Hyounjun Chang, hyounjun.chang@colorado.edu
+ * @date      Oct 16, 2026
+ *
+ * @resources
+ *
+ *
+ */
+
+#ifndef SIM_APP_LOG_H
+#define SIM_APP_LOG_H
+
+int sim_usart_printf(const char* format, ...) __attribute__((format(printf, 1, 2)));
+
+#define app_log(...) sim_usart_printf(__VA_ARGS__)
+
+#endif
@@ -0,0 +1,102 @@
+/***********************************************************************
+ * @file      arm_math.h
+ * @brief     Host simulation stand-in for CMSIS-DSP
+ *
+ * @author    Hyounjun Chang, hyounjun.chang@colorado.edu
+ * @date      Oct 16, 2026
+ *
+ * @resources CMSIS-DSP 1.14 (util/third_party/cmsis_dsp in the SDK)
+ *
+ * Only the kernels the firmware calls, implemented in sim_cmsis_dsp.c with
+ * the same fixed-point rounding and saturation as the library's portable
+ * C code, so results match the target bit for bit.
+ *
+ */
+
+#ifndef SIM_ARM_MATH_H
+#define SIM_ARM_MATH_H
+
+#include <stdint.h>
+
+typedef int8_t q7_t;
+typedef int16_t q15_t;
+typedef int32_t q31_t;
+typedef int64_t q63_t;
+typedef float float32_t;
+
+typedef enum {
+  ARM_MATH_SUCCESS          =  0,
+  ARM_MATH_ARGUMENT_ERROR   = -1,
+  ARM_MATH_LENGTH_ERROR     = -2,
+  ARM_MATH_SIZE_MISMATCH    = -3,
+  ARM_MATH_NANINF           = -4,
+  ARM_MATH_SINGULAR         = -5,
+  ARM_MATH_TEST_FAILURE     = -6,
+  ARM_MATH_DECOMPOSITION_FAILURE = -7,
+} arm_status;
+
+// basic math
+void arm_offset_q15(const q15_t* pSrc, q15_t offset, q15_t* pDst, uint32_t blockSize);
+void arm_shift_q15(const q15_t* pSrc, int8_t shiftBits, q15_t* pDst, uint32_t blockSize);
+void arm_mult_q15(const q15_t* pSrcA, const q15_t* pSrcB, q15_t* pDst, uint32_t blockSize);
+void arm_shift_q31(const q31_t* pSrc, int8_t shiftBits, q31_t* pDst, uint32_t blockSize);
+
+// support
+void arm_q15_to_q31(const q15_t* pSrc, q31_t* pDst, uint32_t blockSize);
+void arm_q31_to_q15(const q31_t* pSrc, q15_t* pDst, uint32_t blockSize);
+
+// filtering
+typedef struct {
+  uint32_t numStages;
+  q31_t* pState;        // 4 per stage: x[n-1], x[n-2], y[n-1], y[n-2]
+  const q31_t* pCoeffs; // 5 per stage: b0, b1, b2, a1, a2
+  uint8_t postShift;
+} arm_biquad_casd_df1_inst_q31;
+
+void arm_biquad_cascade_df1_init_q31(arm_biquad_casd_df1_inst_q31* S, uint8_t numStages,
+                                     const q31_t* pCoeffs, q31_t* pState, int8_t postShift);
+void arm_biquad_cascade_df1_q31(const arm_biquad_casd_df1_inst_q31* S, const q31_t* pSrc,
+                                q31_t* pDst, uint32_t blockSize);
+
+// statistics
+void arm_power_q15(const q15_t* pSrc, uint32_t blockSize, q63_t* pResult);
+void arm_mean_q15(const q15_t* pSrc, uint32_t blockSize, q15_t* pResult);
+void arm_rms_q15(const q15_t* pSrc, uint32_t blockSize, q15_t* pResult);
+void arm_max_q15(const q15_t* pSrc, uint32_t blockSize, q15_t* pResult, uint32_t* pIndex);
+void arm_min_q15(const q15_t* pSrc, uint32_t blockSize, q15_t* pResult, uint32_t* pIndex);
+
+// transforms, the instance only needs to carry the length on the host
+typedef struct {
+  uint32_t fftLenReal;
+  uint8_t ifftFlagR;
+  uint8_t bitReverseFlagR;
+  uint32_t twidCoefRModifier;
+  const q15_t* pTwiddleAReal;
+  const q15_t* pTwiddleBReal;
+  const void* pCfft;
+} arm_rfft_instance_q15;
+
+arm_status arm_rfft_init_q15(arm_rfft_instance_q15* S, uint32_t fftLenReal,
+                             uint32_t ifftFlagR, uint32_t bitReverseFlag);
+void arm_rfft_q15(const arm_rfft_instance_q15* S, q15_t* pSrc, q15_t* pDst);
+
+// fast math
+arm_status arm_sqrt_q15(q15_t in, q15_t* pOut);
+arm_status arm_sqrt_q31(q31_t in, q31_t* pOut);
+
+// Bayesian estimators
+typedef struct {
+  uint32_t vectorDimension;
+  uint32_t numberOfClasses;
+  const float32_t* theta;       // means, numberOfClasses x vectorDimension
+  const float32_t* sigma;       // variances, same layout
+  const float32_t* classPriors;
+  float32_t epsilon;            // added to every variance
+} arm_gaussian_naive_bayes_instance_f32;
+
+uint32_t arm_gaussian_naive_bayes_predict_f32(const arm_gaussian_naive_bayes_instance_f32* S,
+                                              const float32_t* in,
+                                              float32_t* pOutputProbabilities,
+                                              float32_t* pBufferB);
+
+#endif
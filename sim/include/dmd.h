@@ -0,0 +1,23 @@
+/***********************************************************************
+ * @file      dmd.h
+ * @brief     Host simulation stand-in for the dot matrix display driver
+ *
+ * @author    Hyounjun Chang, hyounjun.chang@colorado.edu
+ * @date      Oct 16, 2026
+ *
+ * @resources
+ *
+ *
+ */
+
+#ifndef SIM_DMD_H
+#define SIM_DMD_H
+
+#include "glib.h"
+
+#define DMD_OK 0
+
+EMSTATUS DMD_init(void* initConfig);
+EMSTATUS DMD_updateDisplay(void);
+
+#endif
@@ -0,0 +1,20 @@
+/***********************************************************************
+ * @file      em_chip.h
+ * @brief     Host simulation stand-in for emlib CHIP
+ *
+ * @author    Hyounjun Chang, hyounjun.chang@colorado.edu
+ * @date      Oct 16, 2026
+ *
+ * @resources
+ *
+ *
+ */
+
+#ifndef SIM_EM_CHIP_H
+#define SIM_EM_CHIP_H
+
+#include "em_device.h"
+
+static inline void CHIP_Init(void) {}
+
+#endif
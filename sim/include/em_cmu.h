@@ -0,0 +1,69 @@
+/***********************************************************************
+ * @file      em_cmu.h
+ * @brief     Host simulation stand-in for emlib CMU
+ *
+ * @author    Hyounjun Chang, hyounjun.chang@colorado.edu
+ * @date      Oct 16, 2026
+ *
+ * @resources
+ *
+ * Only the LFA source and LETIMER0 prescaler are remembered, they set the
+ * LETIMER0 tick rate in the simulator.
+ *
+ */
+
+#ifndef SIM_EM_CMU_H
+#define SIM_EM_CMU_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "em_device.h"
+
+typedef enum {
+  cmuClock_HFPER,
+  cmuClock_ADC0,
+  cmuClock_I2C0,
+  cmuClock_LFA,
+  cmuClock_LETIMER0,
+  cmuClock_LDMA,
+  cmuClock_PRS,
+  cmuClock_TIMER0,
+  cmuClock_GPIO
+} CMU_Clock_TypeDef;
+
+typedef enum {
+  cmuClkDiv_1 = 1,
+  cmuClkDiv_2 = 2,
+  cmuClkDiv_4 = 4
+} CMU_ClkDiv_TypeDef;
+
+typedef enum {
+  cmuOsc_LFXO,
+  cmuOsc_LFRCO,
+  cmuOsc_ULFRCO,
+  cmuOsc_HFXO
+} CMU_Osc_TypeDef;
+
+typedef enum {
+  cmuSelect_LFXO,
+  cmuSelect_LFRCO,
+  cmuSelect_ULFRCO
+} CMU_Select_TypeDef;
+
+typedef struct {
+  uint8_t ctune;
+  uint8_t gain;
+  uint32_t timeout;
+  uint32_t mode;
+} CMU_LFXOInit_TypeDef;
+
+#define CMU_LFXOINIT_DEFAULT { 0, 0, 0, 0 }
+
+void CMU_ClockEnable(CMU_Clock_TypeDef clock, bool enable);
+void CMU_ClockDivSet(CMU_Clock_TypeDef clock, CMU_ClkDiv_TypeDef div);
+void CMU_ClockSelectSet(CMU_Clock_TypeDef clock, CMU_Select_TypeDef ref);
+void CMU_OscillatorEnable(CMU_Osc_TypeDef osc, bool enable, bool wait);
+void CMU_LFXOInit(const CMU_LFXOInit_TypeDef* init);
+uint32_t CMU_ClockFreqGet(CMU_Clock_TypeDef clock);
+
+#endif
@@ -0,0 +1,18 @@
+/***********************************************************************
+ * @file      em_common.h
+ * @brief     Host simulation stand-in for emlib common definitions
+ *
+ * @author    Hyounjun Chang, hyounjun.chang@colorado.edu
+ * @date      Oct 16, 2026
+ *
+ * @resources
+ *
+ *
+ */
+
+#ifndef SIM_EM_COMMON_H
+#define SIM_EM_COMMON_H
+
+#include "sl_common.h"
+
+#endif
@@ -0,0 +1,35 @@
+/***********************************************************************
+ * @file      em_core.h
+ * @brief     Host simulation stand-in for emlib CORE critical sections
+ *
+ * @author    Hyounjun Chang, hyounjun.chang@colorado.edu
+ * @date      Oct 16, 2026
+ *
+ * @resources
+ *
+ * The simulator only delivers interrupts from its event loop, never in the
+ * middle of application code, so critical sections only track nesting.
+ *
+ */
+
+#ifndef SIM_EM_CORE_H
+#define SIM_EM_CORE_H
+
+#include "em_device.h"
+
+typedef uint32_t CORE_irqState_t;
+
+// NVIC priority sl_device_init_nvic() gives every IRQ, as with
+// CORE_ATOMIC_METHOD_BASEPRI
+#define CORE_INTERRUPT_DEFAULT_PRIORITY 5
+
+CORE_irqState_t sim_core_enter_critical();
+void sim_core_exit_critical(CORE_irqState_t irqState);
+
+#define CORE_DECLARE_IRQ_STATE        CORE_irqState_t irqState
+#define CORE_ENTER_CRITICAL()         irqState = sim_core_enter_critical()
+#define CORE_EXIT_CRITICAL()          sim_core_exit_critical(irqState)
+#define CORE_ENTER_ATOMIC()           CORE_ENTER_CRITICAL()
+#define CORE_EXIT_ATOMIC()            CORE_EXIT_CRITICAL()
+
+#endif
@@ -0,0 +1,48 @@
+/***********************************************************************
+ * @file      em_device.h
+ * @brief     Host simulation stand-in for the EFR32BG13P device header
+ *
+ * @author    Hyounjun Chang, hyounjun.chang@colorado.edu
+ * @date      Oct 16, 2026
+ *
+ * @resources
+ *
+ * Only the IRQ numbers, NVIC calls and flash geometry used by the firmware
+ * are provided.
+ * Peripheral instances are declared in their own em_*.h stand-ins.
+ *
+ */
+
+#ifndef SIM_EM_DEVICE_H
+#define SIM_EM_DEVICE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef enum {
+  GPIO_EVEN_IRQn,
+  I2C0_IRQn,
+  GPIO_ODD_IRQn,
+  LETIMER0_IRQn,
+  ADC0_IRQn,
+  LDMA_IRQn,
+  SIM_IRQ_COUNT
+} IRQn_Type;
+
+void NVIC_EnableIRQ(IRQn_Type irqn);
+void NVIC_DisableIRQ(IRQn_Type irqn);
+void NVIC_ClearPendingIRQ(IRQn_Type irqn);
+void NVIC_SetPendingIRQ(IRQn_Type irqn);
+uint32_t NVIC_GetEnableIRQ(IRQn_Type irqn);
+
+// flash geometry of the EFR32BG13P632F512GM48, for the MSC stand-in
+#define FLASH_BASE      (0x00000000UL)
+#define FLASH_SIZE      (0x00080000UL)
+#define FLASH_PAGE_SIZE 2048U
+
+#define __NOP()
+// one core, the ISR "preemption" points are function calls, so a compiler
+// barrier is all the memory ordering that matters
+#define __DMB() __asm__ volatile("" ::: "memory")
+
+#endif
@@ -0,0 +1,18 @@
+/***********************************************************************
+ * @file      em_emu.h
+ * @brief     Host simulation stand-in for emlib EMU
+ *
+ * @author    Hyounjun Chang, hyounjun.chang@colorado.edu
+ * @date      Oct 16, 2026
+ *
+ * @resources
+ *
+ *
+ */
+
+#ifndef SIM_EM_EMU_H
+#define SIM_EM_EMU_H
+
+#include "em_device.h"
+
+#endif
@@ -0,0 +1,63 @@
+/***********************************************************************
+ * @file      em_gpio.h
+ * @brief     Host simulation stand-in for emlib GPIO
+ *
+ * @author    Hyounjun Chang, hyounjun.chang@colorado.edu
+ * @date      Oct 16, 2026
+ *
+ * @resources
+ *
+ *
+ */
+
+#ifndef SIM_EM_GPIO_H
+#define SIM_EM_GPIO_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "em_device.h"
+
+typedef enum {
+  gpioPortA,
+  gpioPortB,
+  gpioPortC,
+  gpioPortD,
+  gpioPortE,
+  gpioPortF,
+  SIM_GPIO_PORT_COUNT
+} GPIO_Port_TypeDef;
+
+typedef enum {
+  gpioModeDisabled,
+  gpioModeInput,
+  gpioModeInputPull,
+  gpioModeInputPullFilter,
+  gpioModePushPull,
+  gpioModeWiredAnd,
+  gpioModeWiredAndPullUp
+} GPIO_Mode_TypeDef;
+
+typedef enum {
+  gpioDriveStrengthWeakAlternateWeak,
+  gpioDriveStrengthWeakAlternateStrong,
+  gpioDriveStrengthStrongAlternateWeak,
+  gpioDriveStrengthStrongAlternateStrong
+} GPIO_DriveStrength_TypeDef;
+
+void GPIO_DriveStrengthSet(GPIO_Port_TypeDef port, GPIO_DriveStrength_TypeDef strength);
+void GPIO_PinModeSet(GPIO_Port_TypeDef port, unsigned int pin, GPIO_Mode_TypeDef mode, unsigned int out);
+void GPIO_PinOutSet(GPIO_Port_TypeDef port, unsigned int pin);
+void GPIO_PinOutClear(GPIO_Port_TypeDef port, unsigned int pin);
+void GPIO_PinOutToggle(GPIO_Port_TypeDef port, unsigned int pin);
+unsigned int GPIO_PinOutGet(GPIO_Port_TypeDef port, unsigned int pin);
+unsigned int GPIO_PinInGet(GPIO_Port_TypeDef port, unsigned int pin);
+
+void GPIO_ExtIntConfig(GPIO_Port_TypeDef port, unsigned int pin, unsigned int intNo,
+                       bool risingEdge, bool fallingEdge, bool enable);
+void GPIO_IntClear(uint32_t flags);
+void GPIO_IntEnable(uint32_t flags);
+void GPIO_IntDisable(uint32_t flags);
+uint32_t GPIO_IntGet();
+uint32_t GPIO_IntGetEnabled();
+
+#endif
@@ -0,0 +1,72 @@
+/***********************************************************************
+ * @file      em_i2c.h
+ * @brief     Host simulation stand-in for emlib I2C
+ *
+ * @author    Hyounjun Chang, hyounjun.chang@colorado.edu
+ * @date      Oct 16, 2026
+ *
+ * @resources
+ *
+ *
+ */
+
+#ifndef SIM_EM_I2C_H
+#define SIM_EM_I2C_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "em_device.h"
+
+#define I2C_FLAG_WRITE          0x0001
+#define I2C_FLAG_READ           0x0002
+#define I2C_FLAG_WRITE_READ     0x0004
+#define I2C_FLAG_WRITE_WRITE    0x0008
+#define I2C_FLAG_10BIT_ADDR     0x0010
+
+#define I2C_FREQ_STANDARD_MAX   92000
+#define I2C_FREQ_FAST_MAX       392157
+
+typedef enum {
+  i2cClockHLRStandard,
+  i2cClockHLRAsymetric,
+  i2cClockHLRFast
+} I2C_ClockHLR_TypeDef;
+
+// values match emlib, negative values are errors
+typedef enum {
+  i2cTransferInProgress = 1,
+  i2cTransferDone       = 0,
+  i2cTransferNack       = -1,
+  i2cTransferBusErr     = -2,
+  i2cTransferArbLost    = -3,
+  i2cTransferUsageFault = -4,
+  i2cTransferSwFault    = -5
+} I2C_TransferReturn_TypeDef;
+
+typedef struct {
+  uint16_t addr;
+  uint16_t flags;
+  struct {
+    uint8_t* data;
+    uint16_t len;
+  } buf[2];
+} I2C_TransferSeq_TypeDef;
+
+// the one register the firmware writes, then the state of the model
+typedef struct sim_i2c {
+  uint32_t ROUTEPEN;
+  I2C_TransferSeq_TypeDef* seq;
+  bool busy;
+  bool complete;
+  I2C_TransferReturn_TypeDef result;
+  uint32_t event;             // sim_event_handle_t of the completion
+} I2C_TypeDef;
+extern I2C_TypeDef sim_i2c0;
+#define I2C0 (&sim_i2c0)
+
+void I2C_Reset(I2C_TypeDef* i2c);
+I2C_TransferReturn_TypeDef I2C_TransferInit(I2C_TypeDef* i2c, I2C_TransferSeq_TypeDef* seq);
+I2C_TransferReturn_TypeDef I2C_Transfer(I2C_TypeDef* i2c);
+uint32_t I2C_BusFreqGet(I2C_TypeDef* i2c);
+
+#endif
@@ -0,0 +1,147 @@
+/***********************************************************************
+ * @file      em_ldma.h
+ * @brief     Host simulation stand-in for emlib LDMA
+ *
+ * @author    Hyounjun Chang, hyounjun.chang@colorado.edu
+ * @date      Oct 16, 2026
+ *
+ * @resources
+ *
+ * Descriptors keep the emlib field names so the firmware initializers
+ * compile unchanged, but addresses are uintptr_t (host pointers are 64
+ * bit) and the fields are plain members instead of bit-fields. Only
+ * linked peripheral-to-memory transfers are modelled.
+ *
+ */
+
+#ifndef SIM_EM_LDMA_H
+#define SIM_EM_LDMA_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "em_device.h"
+
+#define DMA_CHAN_COUNT 8
+#define LDMA_IF_ERROR  (0x1UL << 31)
+
+#define LDMA_DESCRIPTOR_NON_EXTEND_SIZE_WORD 4
+
+typedef enum {
+  ldmaPeripheralSignal_NONE = 0,
+  ldmaPeripheralSignal_ADC0_SINGLE = 0x00080000,
+  ldmaPeripheralSignal_ADC0_SCAN   = 0x00080001
+} LDMA_PeripheralSignal_t;
+
+typedef enum { ldmaCtrlStructTypeXfer = 0 } LDMA_CtrlStructType_t;
+typedef enum { ldmaCtrlBlockSizeUnit1 = 0 } LDMA_CtrlBlockSize_t;
+typedef enum { ldmaCtrlReqModeBlock = 0, ldmaCtrlReqModeAll } LDMA_CtrlReqMode_t;
+typedef enum { ldmaCtrlSrcIncOne = 0, ldmaCtrlSrcIncTwo, ldmaCtrlSrcIncFour, ldmaCtrlSrcIncNone } LDMA_CtrlSrcInc_t;
+typedef enum { ldmaCtrlSizeByte = 0, ldmaCtrlSizeHalf, ldmaCtrlSizeWord } LDMA_CtrlSize_t;
+typedef enum { ldmaCtrlDstIncOne = 0, ldmaCtrlDstIncTwo, ldmaCtrlDstIncFour, ldmaCtrlDstIncNone } LDMA_CtrlDstInc_t;
+typedef enum { ldmaCtrlSrcAddrModeAbs = 0 } LDMA_CtrlSrcAddrMode_t;
+typedef enum { ldmaCtrlDstAddrModeAbs = 0 } LDMA_CtrlDstAddrMode_t;
+typedef enum { ldmaLinkModeAbs = 0, ldmaLinkModeRel } LDMA_LinkMode_t;
+
+typedef union {
+  struct {
+    uint32_t structType;
+    uint32_t structReq;
+    uint32_t xferCnt;
+    uint32_t byteSwap;
+    uint32_t blockSize;
+    uint32_t doneIfs;
+    uint32_t reqMode;
+    uint32_t decLoopCnt;
+    uint32_t ignoreSrec;
+    uint32_t srcInc;
+    uint32_t size;
+    uint32_t dstInc;
+    uint32_t srcAddrMode;
+    uint32_t dstAddrMode;
+    uintptr_t srcAddr;
+    uintptr_t dstAddr;
+    uint32_t linkMode;
+    uint32_t link;
+    int32_t linkAddr;
+  } xfer;
+} LDMA_Descriptor_t;
+
+typedef struct {
+  uint8_t ldmaInitCtrlNumFixed;
+  uint8_t ldmaInitCtrlSyncPrsClrEn;
+  uint8_t ldmaInitCtrlSyncPrsSetEn;
+  uint8_t ldmaInitIrqPriority;
+} LDMA_Init_t;
+
+#define LDMA_INIT_DEFAULT { 0, 0, 0, 3 }
+
+typedef struct {
+  uint32_t ldmaReqSel;
+} LDMA_TransferCfg_t;
+
+#define LDMA_TRANSFER_CFG_PERIPHERAL(signal) { (signal) }
+
+#define LDMA_DESCRIPTOR_LINKREL_P2M_BYTE(src, dest, count, linkjmp)    \
+  {                                                                    \
+    .xfer =                                                            \
+    {                                                                  \
+      .structType   = ldmaCtrlStructTypeXfer,                          \
+      .structReq    = 0,                                               \
+      .xferCnt      = (count) - 1,                                     \
+      .byteSwap     = 0,                                               \
+      .blockSize    = ldmaCtrlBlockSizeUnit1,                          \
+      .doneIfs      = 1,                                               \
+      .reqMode      = ldmaCtrlReqModeBlock,                            \
+      .decLoopCnt   = 0,                                               \
+      .ignoreSrec   = 0,                                               \
+      .srcInc       = ldmaCtrlSrcIncNone,                              \
+      .size         = ldmaCtrlSizeByte,                                \
+      .dstInc       = ldmaCtrlDstIncOne,                               \
+      .srcAddrMode  = ldmaCtrlSrcAddrModeAbs,                          \
+      .dstAddrMode  = ldmaCtrlDstAddrModeAbs,                          \
+      .srcAddr      = (uintptr_t)(src),                                \
+      .dstAddr      = (uintptr_t)(dest),                               \
+      .linkMode     = ldmaLinkModeRel,                                 \
+      .link         = 1,                                               \
+      .linkAddr     = (linkjmp) * LDMA_DESCRIPTOR_NON_EXTEND_SIZE_WORD \
+    }                                                                  \
+  }
+
+#define LDMA_DESCRIPTOR_SINGLE_P2M_BYTE(src, dest, count)              \
+  {                                                                    \
+    .xfer =                                                            \
+    {                                                                  \
+      .structType   = ldmaCtrlStructTypeXfer,                          \
+      .structReq    = 0,                                               \
+      .xferCnt      = (count) - 1,                                     \
+      .byteSwap     = 0,                                               \
+      .blockSize    = ldmaCtrlBlockSizeUnit1,                          \
+      .doneIfs      = 1,                                               \
+      .reqMode      = ldmaCtrlReqModeBlock,                            \
+      .decLoopCnt   = 0,                                               \
+      .ignoreSrec   = 0,                                               \
+      .srcInc       = ldmaCtrlSrcIncNone,                              \
+      .size         = ldmaCtrlSizeByte,                                \
+      .dstInc       = ldmaCtrlDstIncOne,                               \
+      .srcAddrMode  = ldmaCtrlSrcAddrModeAbs,                          \
+      .dstAddrMode  = ldmaCtrlDstAddrModeAbs,                          \
+      .srcAddr      = (uintptr_t)(src),                                \
+      .dstAddr      = (uintptr_t)(dest),                               \
+      .linkMode     = 0,                                               \
+      .link         = 0,                                               \
+      .linkAddr     = 0                                                \
+    }                                                                  \
+  }
+
+void LDMA_Init(const LDMA_Init_t* init);
+void LDMA_StartTransfer(int ch, const LDMA_TransferCfg_t* transfer, const LDMA_Descriptor_t* descriptor);
+void LDMA_StopTransfer(int ch);
+bool LDMA_TransferDone(int ch);
+uint32_t LDMA_TransferRemainingCount(int ch);
+void LDMA_IntClear(uint32_t flags);
+void LDMA_IntEnable(uint32_t flags);
+void LDMA_IntDisable(uint32_t flags);
+uint32_t LDMA_IntGet();
+uint32_t LDMA_IntGetEnabled();
+
+#endif
@@ -0,0 +1,77 @@
+/***********************************************************************
+ * @file      em_letimer.h
+ * @brief     Host simulation stand-in for emlib LETIMER
+ *
+ * @author    Hyounjun Chang, hyounjun.chang@colorado.edu
+ * @date      Oct 16, 2026
+ *
+ * @resources
+ *
+ *
+ */
+
+#ifndef SIM_EM_LETIMER_H
+#define SIM_EM_LETIMER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "em_device.h"
+
+// interrupt flag bit positions match LETIMER_IF on Series 1
+#define LETIMER_IF_COMP0   0x1UL
+#define LETIMER_IF_COMP1   0x2UL
+#define LETIMER_IF_UF      0x4UL
+#define LETIMER_IF_REP0    0x8UL
+#define LETIMER_IF_REP1    0x10UL
+#define LETIMER_IEN_COMP0  LETIMER_IF_COMP0
+#define LETIMER_IEN_COMP1  LETIMER_IF_COMP1
+#define LETIMER_IEN_UF     LETIMER_IF_UF
+#define LETIMER_IEN_REP0   LETIMER_IF_REP0
+#define LETIMER_IEN_REP1   LETIMER_IF_REP1
+
+#define LETIMER_CNT_MASK   0xFFFFUL
+
+typedef enum {
+  letimerUFOANone,
+  letimerUFOAToggle,
+  letimerUFOAPulse,
+  letimerUFOAPwm
+} LETIMER_UFOA_TypeDef;
+
+typedef enum {
+  letimerRepeatFree,
+  letimerRepeatOneshot,
+  letimerRepeatBuffered,
+  letimerRepeatDouble
+} LETIMER_RepeatMode_TypeDef;
+
+typedef struct {
+  bool enable;
+  bool debugRun;
+  bool comp0Top;
+  bool bufTop;
+  uint8_t out0Pol;
+  uint8_t out1Pol;
+  LETIMER_UFOA_TypeDef ufoa0;
+  LETIMER_UFOA_TypeDef ufoa1;
+  LETIMER_RepeatMode_TypeDef repMode;
+  uint32_t topValue;
+} LETIMER_Init_TypeDef;
+
+typedef struct sim_letimer LETIMER_TypeDef;
+extern LETIMER_TypeDef sim_letimer0;
+#define LETIMER0 (&sim_letimer0)
+
+void LETIMER_Init(LETIMER_TypeDef* letimer, const LETIMER_Init_TypeDef* init);
+void LETIMER_Enable(LETIMER_TypeDef* letimer, bool enable);
+void LETIMER_CompareSet(LETIMER_TypeDef* letimer, unsigned int comp, uint32_t value);
+uint32_t LETIMER_CompareGet(LETIMER_TypeDef* letimer, unsigned int comp);
+uint32_t LETIMER_CounterGet(LETIMER_TypeDef* letimer);
+void LETIMER_IntClear(LETIMER_TypeDef* letimer, uint32_t flags);
+void LETIMER_IntEnable(LETIMER_TypeDef* letimer, uint32_t flags);
+void LETIMER_IntDisable(LETIMER_TypeDef* letimer, uint32_t flags);
+void LETIMER_IntSet(LETIMER_TypeDef* letimer, uint32_t flags);
+uint32_t LETIMER_IntGet(LETIMER_TypeDef* letimer);
+uint32_t LETIMER_IntGetEnabled(LETIMER_TypeDef* letimer);
+
+#endif
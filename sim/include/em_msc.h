@@ -0,0 +1,33 @@
+/***********************************************************************
+ * @file      em_msc.h
+ * @brief     Host simulation stand-in for emlib MSC
+ *
+ * @author    Hyounjun Chang, hyounjun.chang@colorado.edu
+ * @date      Oct 17, 2026
+ *
+ * @resources
+ *
+ * The flash behind it is the emulated storage region in sim_msc.c.
+ *
+ */
+
+#ifndef SIM_EM_MSC_H
+#define SIM_EM_MSC_H
+
+#include <stdint.h>
+#include "em_device.h"
+
+typedef enum {
+  mscReturnOk          =  0,
+  mscReturnInvalidAddr = -1,
+  mscReturnLocked      = -2,
+  mscReturnTimeOut     = -3,
+  mscReturnUnaligned   = -4
+} MSC_Status_TypeDef;
+
+void MSC_Init(void);
+void MSC_Deinit(void);
+MSC_Status_TypeDef MSC_ErasePage(uint32_t* startAddress);
+MSC_Status_TypeDef MSC_WriteWord(uint32_t* address, void const* data, uint32_t numBytes);
+
+#endif
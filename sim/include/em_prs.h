@@ -0,0 +1,36 @@
+/***********************************************************************
+ * @file      em_prs.h
+ * @brief     Host simulation stand-in for emlib PRS
+ *
+ * @author    Hyounjun Chang, hyounjun.chang@colorado.edu
+ * @date      Oct 16, 2026
+ *
+ * @resources
+ *
+ *
+ */
+
+#ifndef SIM_EM_PRS_H
+#define SIM_EM_PRS_H
+
+#include <stdint.h>
+#include "em_device.h"
+
+#define PRS_CHAN_COUNT 12
+
+// source and signal encodings match efr32bg13p_prs.h
+#define PRS_CH_CTRL_SOURCESEL_NONE   (0x0UL << 8)
+#define PRS_CH_CTRL_SOURCESEL_TIMER0 (0x1CUL << 8)
+#define PRS_CH_CTRL_SIGSEL_TIMER0UF  (0x0UL << 0)
+#define PRS_CH_CTRL_SIGSEL_TIMER0OF  (0x1UL << 0)
+
+typedef enum {
+  prsEdgeOff,
+  prsEdgePos,
+  prsEdgeNeg,
+  prsEdgeBoth
+} PRS_Edge_TypeDef;
+
+void PRS_SourceSignalSet(unsigned int ch, uint32_t source, uint32_t signal, PRS_Edge_TypeDef edge);
+
+#endif
@@ -0,0 +1,71 @@
+/***********************************************************************
+ * @file      em_timer.h
+ * @brief     Host simulation stand-in for emlib TIMER
+ *
+ * @author    Hyounjun Chang, hyounjun.chang@colorado.edu
+ * @date      Oct 16, 2026
+ *
+ * @resources
+ *
+ * Only up-counting with overflow at TOP, which is all the firmware uses
+ * to pace the ADC through PRS.
+ *
+ */
+
+#ifndef SIM_EM_TIMER_H
+#define SIM_EM_TIMER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "em_device.h"
+
+typedef enum {
+  timerPrescale1 = 0,
+  timerPrescale2,
+  timerPrescale4,
+  timerPrescale8,
+  timerPrescale16,
+  timerPrescale32,
+  timerPrescale64,
+  timerPrescale128,
+  timerPrescale256,
+  timerPrescale512,
+  timerPrescale1024
+} TIMER_Prescale_TypeDef;
+
+typedef enum { timerClkSelHFPerClk } TIMER_ClkSel_TypeDef;
+typedef enum { timerInputActionNone } TIMER_InputAction_TypeDef;
+typedef enum { timerModeUp } TIMER_Mode_TypeDef;
+
+// field order matches emlib on Series 1
+typedef struct {
+  bool enable;
+  bool debugRun;
+  TIMER_Prescale_TypeDef prescale;
+  TIMER_ClkSel_TypeDef clkSel;
+  bool count2x;
+  bool ati;
+  TIMER_InputAction_TypeDef fallAction;
+  TIMER_InputAction_TypeDef riseAction;
+  TIMER_Mode_TypeDef mode;
+  bool dmaClrAct;
+  bool quadModeX4;
+  bool oneShot;
+  bool sync;
+} TIMER_Init_TypeDef;
+
+#define TIMER_INIT_DEFAULT { true, false, timerPrescale1, timerClkSelHFPerClk, false, false, \
+                             timerInputActionNone, timerInputActionNone, timerModeUp,       \
+                             false, false, false, false }
+
+typedef struct sim_timer TIMER_TypeDef;
+extern TIMER_TypeDef sim_timer0;
+#define TIMER0 (&sim_timer0)
+
+void TIMER_Init(TIMER_TypeDef* timer, const TIMER_Init_TypeDef* init);
+void TIMER_Enable(TIMER_TypeDef* timer, bool enable);
+void TIMER_TopSet(TIMER_TypeDef* timer, uint32_t val);
+uint32_t TIMER_TopGet(TIMER_TypeDef* timer);
+void TIMER_CounterSet(TIMER_TypeDef* timer, uint32_t val);
+
+#endif
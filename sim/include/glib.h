@@ -0,0 +1,53 @@
+/***********************************************************************
+ * @file      glib.h
+ * @brief     Host simulation stand-in for the GLIB graphics library
+ *
+ * @author    Hyounjun Chang, hyounjun.chang@colorado.edu
+ * @date      Oct 16, 2026
+ *
+ * @resources
+ *
+ * Text drawn on a line is kept per row so the simulator can dump the LCD.
+ *
+ */
+
+#ifndef SIM_GLIB_H
+#define SIM_GLIB_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef uint32_t EMSTATUS;
+
+#define GLIB_OK 0
+
+#define White 0xFFFFFF
+#define Black 0x000000
+
+typedef enum {
+  GLIB_ALIGN_LEFT,
+  GLIB_ALIGN_CENTER,
+  GLIB_ALIGN_RIGHT
+} GLIB_Align_t;
+
+typedef struct {
+  uint8_t fontWidth;
+  uint8_t fontHeight;
+} GLIB_Font_t;
+
+typedef struct {
+  uint32_t backgroundColor;
+  uint32_t foregroundColor;
+  const GLIB_Font_t* font;
+} GLIB_Context_t;
+
+extern const GLIB_Font_t GLIB_FontNarrow6x8;
+
+EMSTATUS GLIB_contextInit(GLIB_Context_t* context);
+EMSTATUS GLIB_clear(GLIB_Context_t* context);
+EMSTATUS GLIB_setFont(GLIB_Context_t* context, GLIB_Font_t* font);
+EMSTATUS GLIB_drawStringOnLine(GLIB_Context_t* context, const char* str, uint8_t line,
+                               GLIB_Align_t align, int32_t xOffset, int32_t yOffset,
+                               bool opaque);
+
+#endif
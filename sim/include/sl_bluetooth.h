@@ -0,0 +1,25 @@
+/***********************************************************************
+ * @file      sl_bluetooth.h
+ * @brief     Host simulation stand-in for autogen/sl_bluetooth.h
+ *
+ * @author    Hyounjun Chang, hyounjun.chang@colorado.edu
+ * @date      Oct 16, 2026
+ *
+ * @resources
+ *
+ * The real sl_bt_api.h from the SDK is used for all types and prototypes,
+ * the commands themselves are implemented by sim/sim_bt.c.
+ *
+ */
+
+#ifndef SIM_SL_BLUETOOTH_H
+#define SIM_SL_BLUETOOTH_H
+
+#include <stdbool.h>
+#include "sl_component_catalog.h"
+#include "sl_power_manager.h"
+#include "sl_bt_api.h"
+
+void sl_bt_on_event(sl_bt_msg_t* evt);
+
+#endif
@@ -0,0 +1,20 @@
+/***********************************************************************
+ * @file      sl_component_catalog.h
+ * @brief     Host simulation component catalog
+ *
+ * @author    Hyounjun Chang, hyounjun.chang@colorado.edu
+ * @date      Oct 16, 2026
+ *
+ * @resources
+ *
+ *
+ */
+
+#ifndef SIM_SL_COMPONENT_CATALOG_H
+#define SIM_SL_COMPONENT_CATALOG_H
+
+#define SL_CATALOG_BLUETOOTH_PRESENT
+#define SL_CATALOG_POWER_MANAGER_PRESENT
+#define SL_CATALOG_APP_LOG_PRESENT
+
+#endif
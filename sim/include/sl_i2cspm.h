@@ -0,0 +1,35 @@
+/***********************************************************************
+ * @file      sl_i2cspm.h
+ * @brief     Host simulation stand-in for the I2CSPM driver
+ *
+ * @author    Hyounjun Chang, hyounjun.chang@colorado.edu
+ * @date      Oct 16, 2026
+ *
+ * @resources
+ *
+ *
+ */
+
+#ifndef SIM_SL_I2CSPM_H
+#define SIM_SL_I2CSPM_H
+
+#include "em_gpio.h"
+#include "em_i2c.h"
+
+typedef struct {
+  I2C_TypeDef* port;
+  GPIO_Port_TypeDef sclPort;
+  uint8_t sclPin;
+  GPIO_Port_TypeDef sdaPort;
+  uint8_t sdaPin;
+  uint8_t portLocationScl;
+  uint8_t portLocationSda;
+  uint32_t i2cRefFreq;
+  uint32_t i2cMaxFreq;
+  I2C_ClockHLR_TypeDef i2cClhr;
+} I2CSPM_Init_TypeDef;
+
+void I2CSPM_Init(I2CSPM_Init_TypeDef* init);
+I2C_TransferReturn_TypeDef I2CSPM_Transfer(I2C_TypeDef* i2c, I2C_TransferSeq_TypeDef* seq);
+
+#endif
@@ -0,0 +1,40 @@
+/***********************************************************************
+ * @file      sl_power_manager.h
+ * @brief     Host simulation stand-in for the power manager service
+ *
+ * @author    Hyounjun Chang, hyounjun.chang@colorado.edu
+ * @date      Oct 16, 2026
+ *
+ * @resources
+ *
+ * Requirements are reference counted like the real service, the simulator
+ * uses them to pick which energy mode idle time is charged to.
+ *
+ */
+
+#ifndef SIM_SL_POWER_MANAGER_H
+#define SIM_SL_POWER_MANAGER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// the real header pulls in em_device.h through the sleeptimer and core headers
+#include "em_core.h"
+
+typedef enum {
+  SL_POWER_MANAGER_EM0 = 0,
+  SL_POWER_MANAGER_EM1,
+  SL_POWER_MANAGER_EM2,
+  SL_POWER_MANAGER_EM3
+} sl_power_manager_em_t;
+
+typedef enum {
+  SL_POWER_MANAGER_IGNORE = (1UL << 0UL),
+  SL_POWER_MANAGER_SLEEP  = (1UL << 1UL),
+  SL_POWER_MANAGER_WAKEUP = (1UL << 2UL)
+} sl_power_manager_on_isr_exit_t;
+
+void sl_power_manager_add_em_requirement(sl_power_manager_em_t em);
+void sl_power_manager_remove_em_requirement(sl_power_manager_em_t em);
+
+#endif
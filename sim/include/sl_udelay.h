@@ -0,0 +1,19 @@
+/***********************************************************************
+ * @file      sl_udelay.h
+ * @brief     Host simulation stand-in for the microsecond delay service
+ *
+ * @author    Hyounjun Chang, hyounjun.chang@colorado.edu
+ * @date      Oct 16, 2026
+ *
+ * @resources
+ *
+ *
+ */
+
+#ifndef SIM_SL_UDELAY_H
+#define SIM_SL_UDELAY_H
+
+// busy wait, takes no virtual time
+void sl_udelay_wait(unsigned us);
+
+#endif
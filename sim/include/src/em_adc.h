@@ -0,0 +1,100 @@
+/***********************************************************************
+ * @file      em_adc.h
+ * @brief     Host simulation stand-in for src/em_adc.h (emlib ADC)
+ *
+ * @author    Hyounjun Chang, hyounjun.chang@colorado.edu
+ * @date      Oct 16, 2026
+ *
+ * @resources
+ *
+ * Found ahead of src/em_adc.h through the sim include path, so firmware
+ * files can keep including "src/em_adc.h" unchanged.
+ *
+ */
+
+#ifndef SIM_EM_ADC_H
+#define SIM_EM_ADC_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "em_device.h"
+
+#define ADC_IF_SINGLE      0x1UL
+#define ADC_IF_SCAN        0x2UL
+#define ADC_IF_SINGLEOF    0x100UL
+#define ADC_IEN_SINGLE     ADC_IF_SINGLE
+#define ADC_IEN_SCAN       ADC_IF_SCAN
+#define ADC_IEN_SINGLEOF   ADC_IF_SINGLEOF
+
+typedef enum { adcOvsRateSel2 } ADC_OvsRateSel_TypeDef;
+typedef enum { adcWarmupNormal, adcWarmupKeepADCWarm } ADC_Warmup_TypeDef;
+typedef enum { adcEm2Disabled, adcEm2ClockOnDemand, adcEm2ClockAlwaysOn } ADC_EM2ClockConfig_TypeDef;
+typedef enum { adcPRSSELCh0, adcPRSSELCh1, adcPRSSELCh2, adcPRSSELCh3 } ADC_PRSSEL_TypeDef;
+typedef enum { adcAcqTime1, adcAcqTime2, adcAcqTime4, adcAcqTime8, adcAcqTime16 } ADC_AcqTime_TypeDef;
+typedef enum { adcRef1V25, adcRef2V5, adcRefVDD } ADC_Ref_TypeDef;
+typedef enum { adcRes12Bit, adcRes8Bit, adcRes6Bit } ADC_Res_TypeDef;
+typedef enum { adcNegSelVSS } ADC_NegSel_TypeDef;
+typedef enum { adcStartSingle = 0x1, adcStartScan = 0x4 } ADC_Start_TypeDef;
+
+// APORT2X channel N maps to port F pin (N - 16) on the BG13 QFN48
+typedef enum {
+  adcPosSelAPORT0XCH0 = 0,
+  adcPosSelAPORT2XCH19 = 0x53,
+  adcPosSelAPORT2XCH20 = 0x54
+} ADC_PosSel_TypeDef;
+
+typedef struct {
+  ADC_OvsRateSel_TypeDef ovsRateSel;
+  ADC_Warmup_TypeDef warmUpMode;
+  uint8_t timebase;
+  uint8_t prescale;
+  bool tailgate;
+  ADC_EM2ClockConfig_TypeDef em2ClockConfig;
+} ADC_Init_TypeDef;
+
+#define ADC_INIT_DEFAULT { adcOvsRateSel2, adcWarmupNormal, 0, 0, false, adcEm2Disabled }
+
+typedef struct {
+  ADC_PRSSEL_TypeDef prsSel;
+  ADC_AcqTime_TypeDef acqTime;
+  ADC_Ref_TypeDef reference;
+  ADC_Res_TypeDef resolution;
+  ADC_PosSel_TypeDef posSel;
+  ADC_NegSel_TypeDef negSel;
+  bool diff;
+  bool prsEnable;
+  bool leftAdjust;
+  bool rep;
+  bool singleDmaEm2Wu;
+  bool fifoOverwrite;
+} ADC_InitSingle_TypeDef;
+
+#define ADC_INITSINGLE_DEFAULT { adcPRSSELCh0, adcAcqTime1, adcRef1V25, adcRes12Bit, \
+                                 adcPosSelAPORT0XCH0, adcNegSelVSS, false, false,   \
+                                 false, false, false, false }
+
+// SINGLEDATA is the only register the firmware touches directly (as an
+// LDMA source address), the rest is simulator state
+typedef struct sim_adc {
+  volatile uint32_t SINGLEDATA;
+  uint32_t ien;
+  uint32_t ifl;
+  ADC_InitSingle_TypeDef single;
+  uint64_t event;
+} ADC_TypeDef;
+extern ADC_TypeDef sim_adc0;
+#define ADC0 (&sim_adc0)
+
+void ADC_Init(ADC_TypeDef* adc, const ADC_Init_TypeDef* init);
+void ADC_InitSingle(ADC_TypeDef* adc, const ADC_InitSingle_TypeDef* init);
+uint8_t ADC_TimebaseCalc(uint32_t hfperFreq);
+uint8_t ADC_PrescaleCalc(uint32_t adcFreq, uint32_t hfperFreq);
+void ADC_Start(ADC_TypeDef* adc, ADC_Start_TypeDef cmd);
+uint32_t ADC_DataSingleGet(ADC_TypeDef* adc);
+void ADC_IntClear(ADC_TypeDef* adc, uint32_t flags);
+void ADC_IntEnable(ADC_TypeDef* adc, uint32_t flags);
+void ADC_IntDisable(ADC_TypeDef* adc, uint32_t flags);
+uint32_t ADC_IntGet(ADC_TypeDef* adc);
+uint32_t ADC_IntGetEnabled(ADC_TypeDef* adc);
+
+#endif
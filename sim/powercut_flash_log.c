@@ -0,0 +1,237 @@
+/***********************************************************************
+ * @file      powercut_flash_log.c
+ * @brief     Power cut test of the flash log in src/flash_log.c
+ *
+ * @author    Hyounjun Chang, hyounjun.chang@colorado.edu
+ * @date      Oct 17, 2026
+ *
+ * @resources
+ *
+ * Appends records to the emulated flash of sim_msc.c until a power cut
+ * lands in the middle of a write or an erase, then starts the log again
+ * the way a reset would and checks what it recovered against a model of
+ * every record whose append returned true: the sequence numbers carry on
+ * where the acknowledged ones ended, or one further when the cut hit the
+ * last word of a record and left it whole, every record kept reads back as it
+ * was written, no more than the oldest pages went, and seeks by sequence
+ * number and by timestamp land on the right record. The first start is on
+ * flash full of garbage. Exits 1 on a failed check.
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sim.h"
+#include "src/flash_log.h"
+
+#define DEFAULT_CUTS  400
+#define MODEL_MAX     (1u << 20)
+// an armed cut hits within this many word writes, about two laps of the ring
+#define CUT_MAX_WORDS (2u * FLASH_LOG_PAGES * FLASH_PAGE_SIZE / 4)
+// what the log keeps at least: the head page and all but one of the others
+// full of the longest records
+#define KEEP_MIN      ((FLASH_LOG_PAGES - 2) * ((FLASH_PAGE_SIZE - FLASH_LOG_PAGE_HEADER) / \
+                       (FLASH_LOG_RECORD_HEADER + FLASH_LOG_MAX_LEN)))
+
+// acknowledged records by sequence number, the payload follows from them
+static uint32_t model_time[MODEL_MAX];
+static uint8_t model_len[MODEL_MAX];
+static uint32_t model_next = 0;
+static uint32_t rng = 1;
+static uint32_t failures = 0;
+
+static uint32_t test_random(){
+  // xorshift32
+  rng ^= rng << 13;
+  rng ^= rng >> 17;
+  rng ^= rng << 5;
+  return rng;
+}
+
+static void payload(uint32_t seq, uint32_t timestamp, uint8_t len, uint8_t* data){
+  uint32_t x = seq * 2654435761u ^ timestamp * 40503u ^ len;
+  for (uint8_t i = 0; i < len; i++){
+      x = x * 1103515245u + 12345u;
+      data[i] = (uint8_t)(x >> 16);
+  }
+}
+
+static void fail(const char* what, uint32_t cut, uint32_t seq){
+  if (failures < 10){
+      printf("CHECK FAILED: %s, cut %lu, record %lu\n", what, (unsigned long)cut, (unsigned long)seq);
+  }
+  failures++;
+}
+
+// oldest acknowledged record from first on with a timestamp at or after t
+static uint32_t model_seek_time(uint32_t first, uint32_t t){
+  uint32_t lo = first;
+  uint32_t hi = model_next;
+  while (lo < hi){
+      uint32_t mid = lo + (hi - lo) / 2;
+      if (model_time[mid] < t){
+          lo = mid + 1;
+      }
+      else{
+          hi = mid;
+      }
+  }
+  return lo;
+}
+
+static void check_log(uint32_t cut){
+  uint8_t want[FLASH_LOG_MAX_LEN];
+  uint8_t got[FLASH_LOG_MAX_LEN];
+  flash_log_cursor_t cursor;
+  uint32_t first = flash_log_first();
+  uint32_t seq;
+  uint32_t t;
+  int32_t len;
+
+  if (flash_log_next() != model_next){
+      fail("sequence does not carry on from the last acknowledged record", cut, flash_log_next());
+      return;
+  }
+  if (first > model_next || model_next - first < (model_next < KEEP_MIN ? model_next : KEEP_MIN)){
+      fail("more than the oldest pages lost", cut, first);
+      return;
+  }
+  if (model_next == first){
+      return;
+  }
+  if (flash_log_last_timestamp() != model_time[model_next - 1]){
+      fail("newest timestamp", cut, model_next - 1);
+  }
+
+  // everything kept, in order
+  if (!flash_log_seek(first, &cursor)){
+      fail("oldest record not found", cut, first);
+      return;
+  }
+  for (uint32_t s = first; s < model_next; s++){
+      len = flash_log_read(&cursor, &seq, &t, got, sizeof(got));
+      payload(s, model_time[s], model_len[s], want);
+      if (len != model_len[s] || seq != s || t != model_time[s] || memcmp(got, want, model_len[s]) != 0){
+          fail("record reads back wrong", cut, s);
+          return;
+      }
+  }
+  if (flash_log_read(&cursor, NULL, NULL, got, sizeof(got)) != -1){
+      fail("record past the newest", cut, model_next);
+  }
+
+  // seeks
+  for (int i = 0; i < 32; i++){
+      uint32_t s = first + test_random() % (model_next - first);
+      if (!flash_log_seek(s, &cursor) || flash_log_read(&cursor, &seq, NULL, got, sizeof(got)) < 0 ||
+          seq != s){
+          fail("seek by sequence number", cut, s);
+      }
+      t = model_time[first] + test_random() % (model_time[model_next - 1] - model_time[first] + 2);
+      s = model_seek_time(first, t);
+      if (s == model_next){
+          if (flash_log_seek_time(t, &cursor)){
+              fail("seek by timestamp past the newest", cut, s);
+          }
+      }
+      else if (!flash_log_seek_time(t, &cursor) ||
+               flash_log_read(&cursor, &seq, NULL, got, sizeof(got)) < 0 || seq != s){
+          fail("seek by timestamp", cut, s);
+      }
+  }
+  if (flash_log_seek(first - 1, &cursor) && first > 0){
+      fail("seek before the oldest", cut, first - 1);
+  }
+  if (flash_log_seek(model_next, &cursor)){
+      fail("seek past the newest", cut, model_next);
+  }
+}
+
+int main(int argc, char** argv){
+  uint8_t data[FLASH_LOG_MAX_LEN];
+  uint32_t cuts = DEFAULT_CUTS;
+  uint32_t seed = 1;
+  uint32_t timestamp = 1000;
+  uint8_t len = 0;
+  uint64_t torn = 0;
+  uint64_t dropped = 0;
+  uint64_t recovered = 0;
+  uint32_t wear_min;
+  uint32_t wear_max;
+
+  for (int i = 1; i + 1 < argc; i += 2){
+      if (strcmp(argv[i], "--cuts") == 0){
+          cuts = (uint32_t)strtoul(argv[i + 1], NULL, 0);
+      }
+      else if (strcmp(argv[i], "--seed") == 0){
+          seed = (uint32_t)strtoul(argv[i + 1], NULL, 0);
+      }
+      else{
+          fprintf(stderr, "usage: %s [--cuts N] [--seed N]\n", argv[0]);
+          return 2;
+      }
+  }
+  rng = 0x9E3779B9u ^ seed;
+  sim_msc_init(seed);
+  sim_msc_scramble();
+  initFlashLog();
+  if (flash_log_next() != 0 || flash_log_first() != 0){
+      fail("garbage taken for records", 0, flash_log_next());
+  }
+
+  for (uint32_t cut = 1; cut <= cuts && model_next + 4096 < MODEL_MAX; cut++){
+      sim_msc_cut_after(1 + test_random() % CUT_MAX_WORDS);
+      while (sim_msc_powered()){
+          len = (test_random() & 1) ? 8 : (uint8_t)(1 + test_random() % FLASH_LOG_MAX_LEN);
+          timestamp += test_random() % 3;
+          payload(model_next, timestamp, len, data);
+          if (flash_log_append(timestamp, data, len)){
+              model_time[model_next] = timestamp;
+              model_len[model_next] = len;
+              model_next++;
+          }
+          else if (sim_msc_powered()){
+              fail("append failed with the power on", cut, model_next);
+          }
+      }
+      sim_msc_power_on();
+      initFlashLog();
+      // the torn last word of the record the cut hit came out as written
+      if (flash_log_next() == model_next + 1){
+          model_time[model_next] = timestamp;
+          model_len[model_next] = len;
+          model_next++;
+      }
+      torn += flash_log_stats()->torn;
+      dropped += flash_log_stats()->dropped;
+      recovered += flash_log_stats()->recovered;
+      check_log(cut);
+  }
+
+  flash_log_wear(&wear_min, &wear_max);
+  printf("%lu power cuts, %lu records acknowledged, %.0f recovered per restart\n",
+         (unsigned long)sim_msc_stats()->cuts, (unsigned long)model_next,
+         cuts ? (double)recovered / cuts : 0.0);
+  printf("  torn pages %llu, pages dropped %llu, pages erased %llu, erase counts %lu to %lu\n",
+         (unsigned long long)torn, (unsigned long long)dropped,
+         (unsigned long long)sim_msc_stats()->erases, (unsigned long)wear_min, (unsigned long)wear_max);
+  // one erase per page per lap, a cut erase is done again
+  if (wear_max > wear_min + 2){
+      printf("CHECK FAILED: erase counts %lu to %lu\n", (unsigned long)wear_min, (unsigned long)wear_max);
+      failures++;
+  }
+  if (sim_msc_stats()->overwrites != 0 || sim_msc_stats()->locked != 0 || sim_msc_stats()->invalid != 0){
+      printf("CHECK FAILED: %llu overwrites, %llu locked, %llu invalid\n",
+             (unsigned long long)sim_msc_stats()->overwrites,
+             (unsigned long long)sim_msc_stats()->locked,
+             (unsigned long long)sim_msc_stats()->invalid);
+      failures++;
+  }
+  if (failures != 0){
+      printf("%lu checks failed\n", (unsigned long)failures);
+      return 1;
+  }
+  printf("all checks passed\n");
+  return 0;
+}
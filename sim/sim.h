@@ -0,0 +1,267 @@
+/***********************************************************************
+ * @file      sim.h
+ * @brief     Internal interface shared by the host simulation modules
+ *
+ * @author    Hyounjun Chang, hyounjun.chang@colorado.edu
+ * @date      Oct 16, 2026
+ *
+ * @resources
+ *
+ * Nothing in here is visible to the firmware, it only talks to the fake
+ * emlib/sl_bt headers in sim/include.
+ *
+ */
+
+#ifndef SIM_H
+#define SIM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "em_device.h"
+#include "em_gpio.h"
+#include "em_i2c.h"
+#include "sl_power_manager.h"
+#include "sl_bt_api.h"
+
+#include "sim_clock.h"
+
+// ---------------------------------------------------------------------
+// statistics collected over one run
+// ---------------------------------------------------------------------
+typedef struct {
+  uint64_t wakeups;                 // sleep -> run transitions caused by an IRQ or stack event
+  uint64_t irq_count[SIM_IRQ_COUNT];
+  uint64_t em_residency_ns[4];      // idle time charged to each energy mode
+  uint64_t bt_events;               // events handed to sl_bt_on_event()
+  uint64_t ext_signal_events;       // sl_bt_evt_system_external_signal_id deliveries
+  uint64_t ext_signals_merged;      // signal bits raised while the same bit was still pending
+  uint64_t notifications;           // notifications accepted by the stack
+  uint64_t notify_errors;           // notifications the stack rejected as invalid
+  uint64_t notify_refused;          // notifications refused for lack of TX buffers
+  uint64_t ble_congestions;         // link stalls injected, see --ble-congestion
+  uint64_t ble_max_connections;     // most connections open at once
+  uint64_t ble_connect_refused;     // connection attempts while not advertising with a slot free
+  uint64_t ble_param_updates;       // connection parameter requests accepted
+  uint64_t ble_param_rejects;       // and rejected as invalid
+  uint64_t ble_conn_events;         // connection events the board listened to
+  uint64_t ble_connected_ns;        // summed over all connections
+  uint64_t beacon_updates;          // advertising data with new sensor values
+  uint64_t beacon_needless;         // of those, nothing crossed its deadband
+  uint64_t beacon_gaps;             // change counter did not go up by one
+  uint64_t beacon_mismatches;       // missing or off the snapshot by more than the deadband
+  uint64_t broadcast_updates;       // periodic advertising data set
+  uint64_t broadcast_unchanged;     // set again with the same values
+  uint64_t broadcast_gaps;          // sequence number did not go up by one
+  uint64_t broadcast_mismatches;    // malformed or disagreed with the snapshot
+  uint64_t broadcast_events;        // periodic advertising events sent
+  uint64_t history_downloads;       // history answers read to their end SDU
+  uint64_t history_records;         // records in them
+  uint64_t history_max_ns;          // longest download, channel request to end SDU
+  uint64_t history_max_records;     // and the records it brought
+  uint64_t history_max_bytes;       // and their encoded bytes
+  uint64_t history_refused;         // channel requests the board turned down
+  uint64_t history_aborted;         // downloads cut short by a close or a disconnect
+  uint64_t history_busy;            // K-frames refused for lack of TX buffers
+  uint64_t history_gaps;            // records skipped between downloads
+  uint64_t history_malformed;       // SDUs or K-frames that did not parse
+  uint64_t history_credit_violations; // K-frames sent without a credit or too long
+  uint64_t i2c_transfers;
+  uint64_t i2c_collisions;          // I2C_TransferInit() while a transfer was in flight
+  uint64_t i2c_nacks;
+  uint64_t i2c_faults;              // NACKs, lost arbitrations and stuck buses injected
+  uint64_t i2c_bus_stuck;           // of those, a slave holding SDA low
+  uint64_t als_interrupts;          // VEML6030 INT line pulled low
+  uint64_t adc_conversions;
+  uint64_t letimer_uf;
+  uint64_t usart_bytes;
+  uint64_t lcd_updates;
+  uint64_t pm_errors;               // requirement removed more times than added
+  uint64_t timebase_errors;         // letimerTicks64() behind or off the LETIMER0 ticks since init
+  uint64_t pb0_presses;             // presses by the scripted user
+  uint64_t occupancy_minutes;       // minutes the occupied flag was compared with the truth
+  uint64_t occupancy_agree;         // and the minutes it matched
+  uint64_t light_minutes;           // minutes the displayed lux was compared with the room
+  uint64_t light_agree;             // and the minutes it was close
+  uint64_t climate_minutes;         // minutes the displayed temperature and humidity were compared
+  uint64_t temp_agree;              // minutes the temperature was close
+  uint64_t humidity_agree;          // minutes the humidity was close
+  uint64_t snapshot_gaps;           // snapshot sequence numbers the central never saw
+  uint64_t snapshot_mismatches;     // snapshots that disagreed with the single characteristics
+} sim_stats_t;
+
+extern sim_stats_t sim_stats;
+
+// ---------------------------------------------------------------------
+// run options
+// ---------------------------------------------------------------------
+typedef struct {
+  double hours;          // virtual time to simulate
+  double start_hour;     // time of day at t = 0
+  uint32_t seed;
+  bool log;              // echo firmware LOG_*() output to stdout
+  bool lcd;              // dump LCD contents at the end
+  bool check;            // verify cadence invariants, exit 1 on failure
+  double connect_at_s;   // central connects and subscribes, < 0 for never
+  double disconnect_at_s;// central disconnects, < 0 for never
+  double gateway_at_s;   // snapshot only gateway connects, < 0 for never
+  uint32_t extra_centrals;// more snapshot only centrals, 10 s apart after the gateway
+  const char* trace_path;// labelled occupancy feature vectors as CSV, NULL for none
+  const char* history_trace_path; // history records as CSV, NULL for none
+  double i2c_fault_rate; // chance of a fault per I2C transfer
+  double i2c_outage_at_s;// every transfer fails from then until a request has used up its retries, < 0 for never
+  double ble_congestion_rate; // chance a notification stalls the link
+  double history_every_s;// gateway downloads the history this often, <= 0 for never
+  uint32_t gateway_phy;  // 2 if the gateway supports the 2M PHY, 1 if not
+  uint32_t gateway_data_length; // longest LL payload the gateway takes
+  double gateway_reconnect_every_s; // gateway drops the link and comes back this often, <= 0 for never
+} sim_options_t;
+
+extern sim_options_t sim_options;
+
+// ---------------------------------------------------------------------
+// interrupts (sim_emlib.c)
+// ---------------------------------------------------------------------
+// flag irqn pending, runs the handler right away if enabled and not nested
+void sim_irq_raise(IRQn_Type irqn);
+// number of handlers run since the last call, used for wake-up accounting
+uint32_t sim_irq_take_handled();
+
+// ---------------------------------------------------------------------
+// power manager / GPIO / USART (sim_emlib.c)
+// ---------------------------------------------------------------------
+sl_power_manager_em_t sim_power_lowest_em();
+void sim_gpio_drive_input(GPIO_Port_TypeDef port, unsigned int pin, unsigned int level);
+unsigned int sim_gpio_output(GPIO_Port_TypeDef port, unsigned int pin);
+uint32_t sim_letimer_freq();
+// LFA ticks since LETIMER_Init(), what letimerTicks64() should return (sim_letimer.c)
+uint64_t sim_letimer_ticks_since_init();
+
+// ---------------------------------------------------------------------
+// ADC / TIMER0 / PRS / LDMA sample pacing (sim_adc.c, sim_timer.c, sim_ldma.c)
+// ---------------------------------------------------------------------
+// true if ADC0 single conversions are PRS triggered, channel in prs_ch
+bool sim_adc_prs_channel(unsigned int* prs_ch);
+uint32_t sim_adc_sample_code(uint64_t t_ns);
+bool sim_timer0_running();
+// overflows since TIMER0 was last (re)configured, up to and including t_ns
+uint64_t sim_timer0_overflows(uint64_t t_ns);
+uint64_t sim_timer0_overflow_ns(uint64_t n);
+bool sim_prs_is_timer0_overflow(unsigned int ch);
+// call around any change to the pacing chain
+void sim_ldma_pacing_changing();
+void sim_ldma_pacing_changed();
+
+// ---------------------------------------------------------------------
+// scripted user (sim_main.c)
+// ---------------------------------------------------------------------
+// press and release PB0 starting at at_ns
+void sim_user_press_pb0(uint64_t at_ns);
+
+// ---------------------------------------------------------------------
+// I2C bus (sim_i2c.c)
+// ---------------------------------------------------------------------
+typedef struct {
+  uint8_t addr; // 7-bit address
+  I2C_TransferReturn_TypeDef (*write)(void* ctx, const uint8_t* data, uint16_t len);
+  I2C_TransferReturn_TypeDef (*read)(void* ctx, uint8_t* data, uint16_t len);
+  void* ctx;
+} sim_i2c_device_t;
+
+void sim_i2c_attach(const sim_i2c_device_t* dev);
+// GPIO output changes, the I2C pins are bit-banged during a bus clear
+void sim_i2c_gpio_output(GPIO_Port_TypeDef port, unsigned int pin, unsigned int level);
+// true while a slave holds SDA low
+bool sim_i2c_bus_stuck();
+void sim_veml6030_attach();
+void sim_si7021_attach();
+// SENSOR_ENABLE powers the Si7021 (sim_si7021.c)
+void sim_si7021_gpio_output(GPIO_Port_TypeDef port, unsigned int pin, unsigned int level);
+
+// ---------------------------------------------------------------------
+// environment models (sim_env.c)
+// ---------------------------------------------------------------------
+void sim_env_init(uint32_t seed, double start_hour);
+double sim_env_hour_of_day(uint64_t t_ns);
+bool sim_env_occupied(uint64_t t_ns);
+double sim_env_lux(uint64_t t_ns);
+double sim_env_temperature_c(uint64_t t_ns);
+double sim_env_humidity_pct(uint64_t t_ns);
+double sim_env_sound_envelope_mv(uint64_t t_ns);
+double sim_env_sound_audio_mv(uint64_t t_ns);
+// millivolts seen by the ADC on a given positive input selection
+double sim_env_adc_input_mv(uint32_t pos_sel, uint64_t t_ns);
+
+// ---------------------------------------------------------------------
+// internal flash behind the MSC stand-in (sim_msc.c)
+// ---------------------------------------------------------------------
+typedef struct {
+  uint64_t words;        // words written
+  uint64_t erases;       // pages erased
+  uint64_t overwrites;   // words written that were not erased
+  uint64_t locked;       // writes and erases without MSC_Init()
+  uint64_t invalid;      // outside the storage or not aligned
+  uint64_t cuts;         // power cuts that hit an operation
+} sim_msc_stats_t;
+
+// erased storage, seed for the torn bits of power cuts
+void sim_msc_init(uint32_t seed);
+// random contents, like flash nobody erased
+void sim_msc_scramble();
+// the power goes in the middle of the word write this many from now
+void sim_msc_cut_after(uint64_t words);
+bool sim_msc_powered();
+void sim_msc_power_on();
+const sim_msc_stats_t* sim_msc_stats();
+uint32_t sim_msc_page_erases(uint32_t page);
+
+// ---------------------------------------------------------------------
+// Bluetooth stand-in (sim_bt.c)
+// ---------------------------------------------------------------------
+void sim_bt_init();
+void sim_bt_boot();
+// hands one pending event to sl_bt_on_event(), false if nothing pending
+bool sim_bt_process_one();
+// true if an event or external signal is waiting for delivery
+bool sim_bt_pending();
+// schedule a scripted central: connect, pair, subscribe, disconnect.
+// mtu is the ATT_MTU it exchanges, 23 to keep the default. Once bonded it
+// downloads the history every history_every_s, 0 for never.
+void sim_bt_add_central(const char* name, bool snapshot_only, uint16_t mtu,
+                        double connect_at_s, double disconnect_at_s, double history_every_s);
+// what the link layer of a central added last supports, by default the
+// 2M PHY and 251 byte packets
+void sim_bt_set_central_link(uint32_t central, bool phy_2m, uint16_t max_data_len);
+// a central added last drops the link every every_s seconds and connects
+// again a second later, with the bond of its first pairing
+void sim_bt_set_central_reconnect(uint32_t central, double every_s);
+uint32_t sim_bt_num_centrals();
+const char* sim_bt_central_name(uint32_t central);
+double sim_bt_central_connect_at(uint32_t central);
+bool sim_bt_central_connected(uint32_t central);
+bool sim_bt_central_ever_connected(uint32_t central);
+// connection parameters in use, 1.25 ms units
+uint16_t sim_bt_central_interval(uint32_t central);
+uint16_t sim_bt_central_latency(uint32_t central);
+// link in use: sl_bt_gap_phy_*, LL payload board to central, ATT_MTU
+uint8_t sim_bt_central_phy(uint32_t central);
+uint16_t sim_bt_central_data_length(uint32_t central);
+uint16_t sim_bt_central_mtu(uint32_t central);
+// and what the central supports
+bool sim_bt_central_phy_2m(uint32_t central);
+uint16_t sim_bt_central_max_data_length(uint32_t central);
+uint16_t sim_bt_central_max_mtu(uint32_t central);
+uint64_t sim_bt_central_notifications(uint32_t central, uint16_t characteristic);
+// all centrals together
+uint64_t sim_bt_notifications_for(uint16_t characteristic);
+// brings sim_stats.ble_conn_events and broadcast_events up to now, before
+// the summary
+void sim_bt_count_conn_events();
+
+// ---------------------------------------------------------------------
+// LCD (sim_lcd.c)
+// ---------------------------------------------------------------------
+void sim_lcd_dump();
+const char* sim_lcd_row(unsigned int row);
+
+#endif
@@ -0,0 +1,119 @@
+/***********************************************************************
+ * @file      sim_adc.c
+ * @brief     Fake ADC0 sampling the environment microphone model
+ *
+ * @author    Hyounjun Chang, hyounjun.chang@colorado.edu
+ * @date      Oct 16, 2026
+ *
+ * @resources
+ *
+ *
+ */
+#include "sim.h"
+#include "src/em_adc.h"
+
+// acquisition + 13 conversion cycles at 16 MHz, rounded up
+#define SIM_ADC_CONVERSION_NS 2000
+
+ADC_TypeDef sim_adc0;
+
+static double reference_mv(ADC_Ref_TypeDef ref){
+  switch (ref){
+    case adcRef1V25: return 1250.0;
+    case adcRef2V5:  return 2500.0;
+    default:         return 3300.0;
+  }
+}
+
+static uint32_t convert(ADC_TypeDef* adc, uint64_t t_ns){
+  double mv = sim_env_adc_input_mv((uint32_t)adc->single.posSel, t_ns);
+  double code = mv * 4096.0 / reference_mv(adc->single.reference);
+  if (code < 0.0){
+      code = 0.0;
+  }
+  if (code > 4095.0){
+      code = 4095.0;
+  }
+  sim_stats.adc_conversions++;
+  return (uint32_t)code;
+}
+
+static void single_done_event(void* ctx){
+  ADC_TypeDef* adc = ctx;
+  adc->event = 0;
+  adc->SINGLEDATA = convert(adc, sim_clock_now_ns());
+  adc->ifl |= ADC_IF_SINGLE;
+  if (adc->ifl & adc->ien){
+      sim_irq_raise(ADC0_IRQn);
+  }
+}
+
+void ADC_Init(ADC_TypeDef* adc, const ADC_Init_TypeDef* init){
+  (void)adc;
+  (void)init;
+}
+
+void ADC_InitSingle(ADC_TypeDef* adc, const ADC_InitSingle_TypeDef* init){
+  sim_ldma_pacing_changing();
+  adc->single = *init;
+  sim_ldma_pacing_changed();
+}
+
+bool sim_adc_prs_channel(unsigned int* prs_ch){
+  if (!sim_adc0.single.prsEnable){
+      return false;
+  }
+  *prs_ch = (unsigned int)sim_adc0.single.prsSel;
+  return true;
+}
+
+// conversion triggered by PRS at t_ns, read straight out by the LDMA
+uint32_t sim_adc_sample_code(uint64_t t_ns){
+  sim_adc0.SINGLEDATA = convert(&sim_adc0, t_ns);
+  return sim_adc0.SINGLEDATA;
+}
+
+uint8_t ADC_TimebaseCalc(uint32_t hfperFreq){
+  (void)hfperFreq;
+  return 19;
+}
+
+uint8_t ADC_PrescaleCalc(uint32_t adcFreq, uint32_t hfperFreq){
+  (void)adcFreq;
+  (void)hfperFreq;
+  return 0;
+}
+
+void ADC_Start(ADC_TypeDef* adc, ADC_Start_TypeDef cmd){
+  // PRS triggered conversions are started by the PRS signal only
+  if (cmd != adcStartSingle || adc->event != 0 || adc->single.prsEnable){
+      return;
+  }
+  adc->event = sim_clock_schedule(sim_clock_now_ns() + SIM_ADC_CONVERSION_NS,
+                                  single_done_event, adc);
+}
+
+uint32_t ADC_DataSingleGet(ADC_TypeDef* adc){
+  adc->ifl &= ~ADC_IF_SINGLE;
+  return adc->SINGLEDATA;
+}
+
+void ADC_IntClear(ADC_TypeDef* adc, uint32_t flags){
+  adc->ifl &= ~flags;
+}
+
+void ADC_IntEnable(ADC_TypeDef* adc, uint32_t flags){
+  adc->ien |= flags;
+}
+
+void ADC_IntDisable(ADC_TypeDef* adc, uint32_t flags){
+  adc->ien &= ~flags;
+}
+
+uint32_t ADC_IntGet(ADC_TypeDef* adc){
+  return adc->ifl;
+}
+
+uint32_t ADC_IntGetEnabled(ADC_TypeDef* adc){
+  return adc->ifl & adc->ien;
+}
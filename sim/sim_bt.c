@@ -0,0 +1,1493 @@
+/***********************************************************************
+ * @file      sim_bt.c
+ * @brief     Stand-in Bluetooth stack and scripted GATT client
+ *
+ * @author    Hyounjun Chang, hyounjun.chang@colorado.edu
+ * @date      Oct 16, 2026
+ *
+ * @resources Bluetooth API reference (sl_bt_api.h, Gecko SDK 4.3.2)
+ *
+ * Events are queued in order and handed to sl_bt_on_event() one per
+ * sim_bt_process_one() call, the way sl_bt_step() does on target.
+ * sl_bt_external_signal() ORs bits into one pending mask which is turned
+ * into a single sl_bt_evt_system_external_signal_id when the queue is
+ * empty, so signals raised twice before delivery merge exactly like they
+ * do in the real stack.
+ *
+ * Scripted centrals connect while the board advertises, pair with passkey
+ * confirmation (the "user" presses PB0), subscribe to every notifying
+ * characteristic, or only to the snapshot, and optionally disconnect
+ * later. One that finds the board not advertising tries again a second
+ * later. A central can also drop the link every so often and come back a
+ * second later: once it has a bond, it reconnects with the bonding handle
+ * in the opened event and encrypts without pairing again, so the board
+ * only learns about the encryption from the security mode in the next
+ * connection parameters event, there is no sm_bonded. Each keeps the last value of every characteristic and checks
+ * every study space snapshot against them: the snapshot has to carry what
+ * the single characteristics last said, and its sequence number has to go
+ * up by one per notification.
+ *
+ * Centrals open at a 30 ms interval and accept any valid parameter
+ * request, it takes effect SIM_BT_UPDATE_EVENTS connection events later
+ * like the link layer's connection update instant. The connection events
+ * the board has to listen to are counted from the interval and latency in
+ * use.
+ *
+ * A gateway scanning the connectable set decodes the manufacturer data of
+ * every new advertising data: its counter has to go up by one per change,
+ * the values have to be within the deadbands of the snapshot, and it may
+ * only change when a value crossed its deadband.
+ *
+ * The second advertising set carries the periodic broadcast. Every new
+ * periodic advertising data is decoded the way an observer would and
+ * checked against the snapshot last written to the GATT database: its
+ * sequence number has to go up by one per change and the data may only be
+ * set again when a value changed.
+ *
+ * A central can pull the sensor history over the L2CAP channel now and
+ * then, from the first record it does not have yet. K-frames are cut into
+ * link layer packets of the data length in use, each packet takes its
+ * airtime on the PHY in use, and a connection event goes on while there is
+ * data until SIM_BT_EVENT_GUARD_US before the next anchor, the way a
+ * gateway that does not limit the event length allows it. The stack holds
+ * SIM_BT_L2CAP_TX_BUFFERS K-frames per link before it answers
+ * SL_STATUS_NO_MORE_RESOURCE. The central gives a credit
+ * back for every K-frame once it arrived. A K-frame without a credit, a
+ * record index that skips ahead or an SDU that does not parse fails the
+ * run.
+ *
+ * Every central exchanges the ATT_MTU right after connecting, the smaller
+ * of its own and the board's maximum is used. PHY and data length stay at
+ * 1M and 27 bytes until the board asks; a PHY update takes effect at an
+ * instant SIM_BT_UPDATE_EVENTS intervals later, a data length update after
+ * the two packets of its exchange, each limited to what the central can do.
+ *
+ * With --ble-congestion the link stalls now and then: for a while every
+ * notification is refused with SL_STATUS_NO_MORE_RESOURCE, the way the
+ * stack answers when its TX buffers are full because the peer stopped
+ * acknowledging. Lazy soft timers run on the virtual clock.
+ *
+ */
+#include <stdio.h>
+#include <string.h>
+
+#include "sim.h"
+#include "sl_bluetooth.h"
+#include "sl_bluetooth_advertiser_config.h"
+#include "gatt_db.h"
+#include "ble.h"
+#include "sound.h"
+#include "history.h"
+
+#define SIM_BT_EVENT_QUEUE_LEN 32
+#define SIM_BT_MAX_CENTRALS    8
+#define SIM_BT_PASSKEY         123456
+#define SIM_BT_MAX_VALUE       20     // ATT_MTU 23 less the notification header
+#define SIM_BT_SOFT_TIMERS     8
+// connection events between a parameter request and its instant
+#define SIM_BT_UPDATE_EVENTS   6
+// a central that finds the board not advertising scans again after this
+#define SIM_BT_RETRY_NS        (1 * SIM_NS_PER_SEC)
+// a bonded central reconnecting starts encryption this long after connecting
+#define SIM_BT_ENCRYPT_NS      (100 * SIM_NS_PER_MS)
+// length of a stall of the link, uniform in between
+#define SIM_BT_CONGESTION_MIN_NS (100 * SIM_NS_PER_MS)
+#define SIM_BT_CONGESTION_MAX_NS (2000 * SIM_NS_PER_MS)
+// the central's end of the history channel
+#define SIM_BT_L2CAP_MAX_SDU   1024
+#define SIM_BT_L2CAP_MAX_PDU   247
+#define SIM_BT_L2CAP_CREDITS   8
+#define SIM_BT_L2CAP_TX_BUFFERS 4      // K-frames the stack holds per link
+// a connection event ends this long before the next anchor
+#define SIM_BT_EVENT_GUARD_US  1250
+// airtime of an encrypted data packet and its empty acknowledgement, 1 or
+// 2 bits a microsecond: preamble, access address, LL header, MIC and CRC
+// around the payload, the 10 bytes of the empty packet and two inter frame
+// spaces. The 2M preamble is a byte longer, close enough.
+#define SIM_BT_PACKET_US(len, mbps) (((((len) + 14) * 8) + 10 * 8) / (mbps) + 2 * 150)
+// LL data length limits, Core spec Vol 6 Part B 4.5.10
+#define SIM_BT_MIN_DATA_LEN    27
+#define SIM_BT_MAX_DATA_LEN    251
+#define SIM_BT_MIN_TX_TIME     328
+#define SIM_BT_MAX_TX_TIME     17040
+#define SIM_BT_DEFAULT_MAX_MTU 247    // the stack's until set_max_mtu
+
+// study space characteristics a central can subscribe to
+static const uint16_t subscribed_characteristics[] = {
+  gattdb_space_occupied,
+  gattdb_illuminance,
+  gattdb_audio_input_description,
+  gattdb_temperature_measurement,
+  gattdb_humidity,
+  gattdb_study_space_snapshot,
+};
+#define NUM_SUBSCRIBED (sizeof(subscribed_characteristics) / sizeof(subscribed_characteristics[0]))
+
+typedef struct {
+  const char* name;
+  bool snapshot_only;       // subscribes to the snapshot and nothing else
+  uint16_t mtu;             // ATT_MTU it exchanges after connecting
+  bool phy_2m;              // supports the LE 2M PHY
+  uint16_t max_data_len;    // longest LL payload it takes
+  double connect_at_s;      // first attempt, negative for never
+  bool connected;
+  bool ever_connected;
+  bool bonded;              // link encrypted
+  bool has_bond;            // paired before, encrypts without pairing again
+  double reconnect_every_s; // drops the link and comes back this often, 0 for never
+  sim_event_handle_t drop_timer;
+  uint8_t connection;       // handle while connected
+  bool subscribed[NUM_SUBSCRIBED];
+  uint64_t notifications[NUM_SUBSCRIBED];
+  uint8_t last_value[NUM_SUBSCRIBED][SIM_BT_MAX_VALUE];
+  size_t last_len[NUM_SUBSCRIBED];    // 0 until the first notification
+  bool have_sequence;
+  uint16_t last_sequence;
+  uint16_t interval;        // 1.25 ms units, in use
+  uint16_t latency;
+  uint16_t timeout;         // 10 ms units, in use
+  uint64_t params_since_ns; // events counted up to here
+  bool update_pending;      // requested parameters waiting for their instant
+  uint16_t update_interval;
+  uint16_t update_latency;
+  uint16_t update_timeout;
+  double history_every_s;   // pulls the history this often once bonded, 0 for never
+  sim_event_handle_t download_timer;
+  bool l2cap_pending;       // channel asked for, no answer yet
+  bool l2cap_open;
+  uint16_t l2cap_cid;       // the board's end
+  uint16_t l2cap_board_mps; // K-frames the board takes from the central
+  uint16_t board_credits;   // K-frames the board may still send
+  uint16_t own_credits;     // and the central
+  uint32_t history_next;    // first record it does not have
+  uint32_t history_time;    // timestamp of the newest record it has
+  uint32_t download_records;
+  uint32_t download_bytes;  // encoded records
+  uint64_t download_start_ns;
+  uint8_t sdu[SIM_BT_L2CAP_MAX_SDU];
+  uint16_t sdu_len;         // from the first K-frame, 0 between SDUs
+  uint16_t sdu_got;
+  uint8_t frames[SIM_BT_L2CAP_TX_BUFFERS][SIM_BT_L2CAP_MAX_PDU];
+  uint16_t frame_len[SIM_BT_L2CAP_TX_BUFFERS];
+  uint32_t frames_head;
+  uint32_t frames_count;    // K-frames on their way, oldest first
+  uint64_t link_free_ns;    // the last of them arrives
+  uint64_t link_anchor_ns;  // connection event it goes out in
+  uint16_t att_mtu;         // exchanged, in use
+  uint8_t phy;              // sl_bt_gap_phy_*, in use
+  uint16_t data_len;        // board to central LL payload, in use
+  bool phy_pending;         // PHY update waiting for its instant
+} sim_central_t;
+
+static sl_bt_msg_t event_queue[SIM_BT_EVENT_QUEUE_LEN];
+static uint32_t queue_head = 0;
+static uint32_t queue_count = 0;
+static uint32_t pending_signals = 0;
+static bool advertising = false;
+static uint8_t num_advertising_sets = 0;
+static uint8_t connectable_set = 0xFF;
+static bool periodic_running = false;
+static uint16_t periodic_interval = 0;       // 1.25 ms units
+static uint64_t periodic_since_ns = 0;
+// Study Space service UUID, little endian, in front of the broadcast record
+static const uint8_t study_space_uuid[16] = {
+  0x89, 0x62, 0x13, 0x2d, 0x2a, 0x65, 0xec, 0x87,
+  0x3e, 0x43, 0xc8, 0x38, 0x03, 0x00, 0x00, 0x00
+};
+static uint8_t broadcast_data[BROADCAST_DATA_LEN];
+static uint8_t beacon_payload[BEACON_PAYLOAD_LEN];   // last one the gateway scanned
+static bool have_beacon = false;
+static bool have_broadcast = false;
+static uint8_t gatt_snapshot[SNAPSHOT_LEN];  // last written to the GATT database
+static bool have_gatt_snapshot = false;
+static sim_central_t centrals[SIM_BT_MAX_CENTRALS];
+static uint32_t num_centrals = 0;
+static sim_event_handle_t soft_timers[SIM_BT_SOFT_TIMERS];
+static uint64_t soft_timer_period_ns[SIM_BT_SOFT_TIMERS];
+static uint64_t congested_until_ns = 0;
+static uint16_t board_max_mtu = SIM_BT_DEFAULT_MAX_MTU;
+static uint32_t rng = 1;
+
+static uint32_t bt_random(){
+  // xorshift32
+  rng ^= rng << 13;
+  rng ^= rng >> 17;
+  rng ^= rng << 5;
+  return rng;
+}
+
+static double bt_uniform(){
+  return (bt_random() >> 8) / (double)(1 << 24);
+}
+
+static uint16_t get_u16(const uint8_t* p){
+  return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static int subscribed_index(uint16_t characteristic){
+  for (uint32_t i = 0; i < NUM_SUBSCRIBED; i++){
+      if (subscribed_characteristics[i] == characteristic){
+          return (int)i;
+      }
+  }
+  return -1;
+}
+
+static uint32_t open_connections(){
+  uint32_t n = 0;
+  for (uint32_t i = 0; i < num_centrals; i++){
+      if (centrals[i].connected){
+          n++;
+      }
+  }
+  return n;
+}
+
+// NULL if no central is connected on the handle
+static sim_central_t* find_central(uint8_t connection){
+  for (uint32_t i = 0; i < num_centrals; i++){
+      if (centrals[i].connected && centrals[i].connection == connection){
+          return &centrals[i];
+      }
+  }
+  return NULL;
+}
+
+static void push_event(const sl_bt_msg_t* msg){
+  if (queue_count == SIM_BT_EVENT_QUEUE_LEN){
+      fprintf(stderr, "sim_bt: event queue full, event 0x%08x dropped\n", (unsigned int)msg->header);
+      return;
+  }
+  event_queue[(queue_head + queue_count) % SIM_BT_EVENT_QUEUE_LEN] = *msg;
+  queue_count++;
+}
+
+void sim_bt_init(){
+  queue_head = 0;
+  queue_count = 0;
+  pending_signals = 0;
+  advertising = false;
+  num_advertising_sets = 0;
+  connectable_set = 0xFF;
+  periodic_running = false;
+  have_broadcast = false;
+  have_beacon = false;
+  have_gatt_snapshot = false;
+  memset(centrals, 0, sizeof(centrals));
+  num_centrals = 0;
+  memset(soft_timers, 0, sizeof(soft_timers));
+  congested_until_ns = 0;
+  board_max_mtu = SIM_BT_DEFAULT_MAX_MTU;
+  rng = 0x7F4A7C15u ^ (sim_options.seed * 2654435761u);
+}
+
+void sim_bt_boot(){
+  sl_bt_msg_t msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.header = sl_bt_evt_system_boot_id;
+  msg.data.evt_system_boot.major = 5;
+  msg.data.evt_system_boot.minor = 1;
+  push_event(&msg);
+}
+
+bool sim_bt_process_one(){
+  sl_bt_msg_t msg;
+  if (queue_count > 0){
+      msg = event_queue[queue_head];
+      queue_head = (queue_head + 1) % SIM_BT_EVENT_QUEUE_LEN;
+      queue_count--;
+  }
+  else if (pending_signals != 0){
+      memset(&msg, 0, sizeof(msg));
+      msg.header = sl_bt_evt_system_external_signal_id;
+      msg.data.evt_system_external_signal.extsignals = pending_signals;
+      pending_signals = 0;
+      sim_stats.ext_signal_events++;
+  }
+  else{
+      return false;
+  }
+  sim_stats.bt_events++;
+  sl_bt_on_event(&msg);
+  return true;
+}
+
+bool sim_bt_pending(){
+  return queue_count > 0 || pending_signals != 0;
+}
+
+uint32_t sim_bt_num_centrals(){
+  return num_centrals;
+}
+
+const char* sim_bt_central_name(uint32_t central){
+  return centrals[central].name;
+}
+
+double sim_bt_central_connect_at(uint32_t central){
+  return centrals[central].connect_at_s;
+}
+
+bool sim_bt_central_connected(uint32_t central){
+  return centrals[central].connected;
+}
+
+uint16_t sim_bt_central_interval(uint32_t central){
+  return centrals[central].interval;
+}
+
+uint16_t sim_bt_central_latency(uint32_t central){
+  return centrals[central].latency;
+}
+
+uint8_t sim_bt_central_phy(uint32_t central){
+  return centrals[central].phy;
+}
+
+uint16_t sim_bt_central_data_length(uint32_t central){
+  return centrals[central].data_len;
+}
+
+uint16_t sim_bt_central_mtu(uint32_t central){
+  return centrals[central].att_mtu;
+}
+
+bool sim_bt_central_phy_2m(uint32_t central){
+  return centrals[central].phy_2m;
+}
+
+uint16_t sim_bt_central_max_data_length(uint32_t central){
+  return centrals[central].max_data_len;
+}
+
+uint16_t sim_bt_central_max_mtu(uint32_t central){
+  return centrals[central].mtu;
+}
+
+bool sim_bt_central_ever_connected(uint32_t central){
+  return centrals[central].ever_connected;
+}
+
+uint64_t sim_bt_central_notifications(uint32_t central, uint16_t characteristic){
+  int i = subscribed_index(characteristic);
+  return i < 0 ? 0 : centrals[central].notifications[i];
+}
+
+uint64_t sim_bt_notifications_for(uint16_t characteristic){
+  uint64_t n = 0;
+  for (uint32_t c = 0; c < num_centrals; c++){
+      n += sim_bt_central_notifications(c, characteristic);
+  }
+  return n;
+}
+
+// connection events the board listened to since the last call: one per
+// interval, latency + 1 intervals apart while it has nothing to send
+static void central_count_events(sim_central_t* central){
+  uint64_t now = sim_clock_now_ns();
+  uint64_t period_ns = (uint64_t)central->interval * 1250 * SIM_NS_PER_US * (central->latency + 1u);
+  if (central->connected && period_ns > 0){
+      sim_stats.ble_conn_events += (now - central->params_since_ns) / period_ns;
+      sim_stats.ble_connected_ns += now - central->params_since_ns;
+  }
+  central->params_since_ns = now;
+}
+
+void sim_bt_count_conn_events(){
+  uint64_t now = sim_clock_now_ns();
+  for (uint32_t c = 0; c < num_centrals; c++){
+      central_count_events(&centrals[c]);
+  }
+  if (periodic_running){
+      sim_stats.broadcast_events += (now - periodic_since_ns) / ((uint64_t)periodic_interval * 1250 * SIM_NS_PER_US);
+      periodic_since_ns = now;
+  }
+}
+
+// *********************************************************************
+// scripted centrals
+// *********************************************************************
+static void central_disconnect(void* ctx);
+static void central_encrypt(void* ctx);
+static void central_subscribe(void* ctx);
+
+static void central_connect(void* ctx){
+  sim_central_t* central = ctx;
+  sl_bt_msg_t msg;
+  uint8_t handle;
+
+  if (central->connected){
+      return;
+  }
+  // not advertising: scan again later, it is a firmware bug if a slot is free
+  if (!advertising){
+      if (open_connections() < SL_BT_CONFIG_MAX_CONNECTIONS){
+          sim_stats.ble_connect_refused++;
+      }
+      sim_clock_schedule(sim_clock_now_ns() + SIM_BT_RETRY_NS, central_connect, central);
+      return;
+  }
+  // lowest handle not in use, like the stack
+  for (handle = 1; find_central(handle) != NULL; handle++){
+  }
+  // connectable advertising ends with the connection
+  advertising = false;
+  memset(central->subscribed, 0, sizeof(central->subscribed));
+  central->connected = true;
+  central->ever_connected = true;
+  central->bonded = false;
+  central->connection = handle;
+  central->have_sequence = false;
+  central->interval = 24;
+  central->latency = 0;
+  central->timeout = 500;
+  central->update_pending = false;
+  central->params_since_ns = sim_clock_now_ns();
+  central->phy = sl_bt_gap_phy_1m;
+  central->phy_pending = false;
+  central->data_len = SIM_BT_MIN_DATA_LEN;
+  central->att_mtu = 23;
+  central->link_free_ns = 0;
+  if (open_connections() > sim_stats.ble_max_connections){
+      sim_stats.ble_max_connections = open_connections();
+  }
+
+  memset(&msg, 0, sizeof(msg));
+  msg.header = sl_bt_evt_connection_opened_id;
+  msg.data.evt_connection_opened.address_type = sl_bt_gap_public_address;
+  msg.data.evt_connection_opened.master = 0;
+  msg.data.evt_connection_opened.connection = handle;
+  msg.data.evt_connection_opened.bonding = central->has_bond ? (uint8_t)(central - &centrals[0])
+                                                             : SL_BT_INVALID_BONDING_HANDLE;
+  msg.data.evt_connection_opened.advertiser = 0;
+  msg.data.evt_connection_opened.sync = SL_BT_INVALID_SYNC_HANDLE;
+  push_event(&msg);
+
+  // phones typically open at 30 ms, no latency
+  memset(&msg, 0, sizeof(msg));
+  msg.header = sl_bt_evt_connection_parameters_id;
+  msg.data.evt_connection_parameters.connection = handle;
+  msg.data.evt_connection_parameters.interval = central->interval;
+  msg.data.evt_connection_parameters.latency = central->latency;
+  msg.data.evt_connection_parameters.timeout = central->timeout;
+  push_event(&msg);
+
+  memset(&msg, 0, sizeof(msg));
+  msg.header = sl_bt_evt_connection_phy_status_id;
+  msg.data.evt_connection_phy_status.connection = handle;
+  msg.data.evt_connection_phy_status.phy = sl_bt_gap_phy_1m;
+  push_event(&msg);
+
+  // either side larger than the default, the smaller of the two is used
+  if (central->mtu > 23 || board_max_mtu > 23){
+      central->att_mtu = central->mtu < board_max_mtu ? central->mtu : board_max_mtu;
+      memset(&msg, 0, sizeof(msg));
+      msg.header = sl_bt_evt_gatt_mtu_exchanged_id;
+      msg.data.evt_gatt_mtu_exchanged.connection = handle;
+      msg.data.evt_gatt_mtu_exchanged.mtu = central->att_mtu;
+      push_event(&msg);
+  }
+
+  if (central->reconnect_every_s > 0.0){
+      central->drop_timer = sim_clock_schedule(sim_clock_now_ns() +
+                                               (uint64_t)(central->reconnect_every_s * SIM_NS_PER_SEC),
+                                               central_disconnect, central);
+  }
+  // bonded before: encrypt with the stored keys, no pairing
+  if (central->has_bond){
+      sim_clock_schedule(sim_clock_now_ns() + SIM_BT_ENCRYPT_NS, central_encrypt, central);
+      return;
+  }
+  // central starts pairing shortly after
+  memset(&msg, 0, sizeof(msg));
+  msg.header = sl_bt_evt_sm_confirm_bonding_id;
+  msg.data.evt_sm_confirm_bonding.connection = handle;
+  msg.data.evt_sm_confirm_bonding.bonding_handle = SL_BT_INVALID_BONDING_HANDLE;
+  push_event(&msg);
+}
+
+// encryption with the keys of an earlier pairing is up. The stack only
+// reports it in the security mode of a connection parameters event.
+static void central_encrypt(void* ctx){
+  sim_central_t* central = ctx;
+  sl_bt_msg_t msg;
+  if (!central->connected){
+      return;
+  }
+  central_count_events(central);
+  central->bonded = true;
+  memset(&msg, 0, sizeof(msg));
+  msg.header = sl_bt_evt_connection_parameters_id;
+  msg.data.evt_connection_parameters.connection = central->connection;
+  msg.data.evt_connection_parameters.interval = central->interval;
+  msg.data.evt_connection_parameters.latency = central->latency;
+  msg.data.evt_connection_parameters.timeout = central->timeout;
+  msg.data.evt_connection_parameters.security_mode = sl_bt_connection_mode1_level3;
+  push_event(&msg);
+  sim_clock_schedule(sim_clock_now_ns() + 300 * SIM_NS_PER_MS, central_subscribe, central);
+}
+
+static void central_disconnect(void* ctx){
+  sim_central_t* central = ctx;
+  sl_bt_msg_t msg;
+  if (!central->connected){
+      return;
+  }
+  central_count_events(central);
+  central->connected = false;
+  sim_clock_cancel(central->drop_timer);
+  central->drop_timer = 0;
+  if (central->l2cap_pending || central->l2cap_open){
+      sim_stats.history_aborted++;
+  }
+  central->l2cap_pending = false;
+  central->l2cap_open = false;
+  memset(&msg, 0, sizeof(msg));
+  msg.header = sl_bt_evt_connection_closed_id;
+  msg.data.evt_connection_closed.reason = SL_STATUS_BT_CTRL_REMOTE_USER_TERMINATED;
+  msg.data.evt_connection_closed.connection = central->connection;
+  push_event(&msg);
+  if (central->reconnect_every_s > 0.0){
+      sim_clock_schedule(sim_clock_now_ns() + SIM_BT_RETRY_NS, central_connect, central);
+  }
+}
+
+// the user reads the passkey and confirms on the board. Two presses at
+// the same moment count as one, so whoever is still waiting asks again.
+static void central_confirm(void* ctx){
+  sim_central_t* central = ctx;
+  if (!central->connected || central->bonded){
+      return;
+  }
+  sim_user_press_pb0(sim_clock_now_ns());
+  sim_clock_schedule(sim_clock_now_ns() + 2 * SIM_NS_PER_SEC, central_confirm, central);
+}
+
+static void central_download(void* ctx);
+
+// next history download, replaces one already planned
+static void central_plan_download(sim_central_t* central, double after_s){
+  if (central->history_every_s <= 0.0){
+      return;
+  }
+  sim_clock_cancel(central->download_timer);
+  central->download_timer = sim_clock_schedule(sim_clock_now_ns() + (uint64_t)(after_s * SIM_NS_PER_SEC),
+                                               central_download, central);
+}
+
+// the central asks for the history channel
+static void central_download(void* ctx){
+  sim_central_t* central = ctx;
+  sl_bt_msg_t msg;
+  central->download_timer = 0;
+  if (!central->connected || !central->bonded || central->l2cap_pending || central->l2cap_open){
+      return;
+  }
+  central->l2cap_pending = true;
+  central->l2cap_cid = (uint16_t)(0x40 + (central - &centrals[0]));
+  central->board_credits = SIM_BT_L2CAP_CREDITS;
+  central->download_start_ns = sim_clock_now_ns();
+  central->download_records = 0;
+  central->download_bytes = 0;
+  central->sdu_len = 0;
+  central->frames_head = 0;
+  central->frames_count = 0;
+  memset(&msg, 0, sizeof(msg));
+  msg.header = sl_bt_evt_l2cap_le_channel_open_request_id;
+  msg.data.evt_l2cap_le_channel_open_request.connection = central->connection;
+  msg.data.evt_l2cap_le_channel_open_request.spsm = HISTORY_SPSM;
+  msg.data.evt_l2cap_le_channel_open_request.cid = central->l2cap_cid;
+  msg.data.evt_l2cap_le_channel_open_request.max_sdu = SIM_BT_L2CAP_MAX_SDU;
+  msg.data.evt_l2cap_le_channel_open_request.max_pdu = SIM_BT_L2CAP_MAX_PDU;
+  msg.data.evt_l2cap_le_channel_open_request.credit = SIM_BT_L2CAP_CREDITS;
+  msg.data.evt_l2cap_le_channel_open_request.remote_cid = 0x40;
+  push_event(&msg);
+}
+
+// the central closes the channel, the board hears about it
+static void central_close_channel(sim_central_t* central){
+  sl_bt_msg_t msg;
+  central->l2cap_open = false;
+  memset(&msg, 0, sizeof(msg));
+  msg.header = sl_bt_evt_l2cap_channel_closed_id;
+  msg.data.evt_l2cap_channel_closed.connection = central->connection;
+  msg.data.evt_l2cap_channel_closed.cid = central->l2cap_cid;
+  push_event(&msg);
+  central_plan_download(central, central->history_every_s);
+}
+
+// one SDU of the answer: header, then the records as one stream
+static void central_history_sdu(sim_central_t* central){
+  const uint8_t* sdu = central->sdu;
+  series_decoder_t decoder;
+  int32_t values[HISTORY_FIELDS];
+  uint32_t timestamp;
+  uint32_t first;
+  uint16_t count;
+  uint64_t took;
+
+  if (central->sdu_len < HISTORY_HEADER_LEN){
+      sim_stats.history_malformed++;
+      return;
+  }
+  first = (uint32_t)sdu[0] | (uint32_t)sdu[1] << 8 | (uint32_t)sdu[2] << 16 | (uint32_t)sdu[3] << 24;
+  count = get_u16(&sdu[4]);
+  if (get_u16(&sdu[6]) != HISTORY_PERIOD_S || first < central->history_next){
+      sim_stats.history_malformed++;
+      return;
+  }
+  // records overwritten before the central came back for them
+  sim_stats.history_gaps += first - central->history_next;
+  // the stream has to hold count records and nothing else, stamped later
+  // than the ones before
+  series_decoder_init(&decoder, &sdu[HISTORY_HEADER_LEN], central->sdu_len - HISTORY_HEADER_LEN,
+                      HISTORY_FIELDS);
+  while (series_decode(&decoder, &timestamp, values)){
+      if ((values[HISTORY_FLAGS] & ~(SNAPSHOT_FLAG_OCCUPIED | SNAPSHOT_FLAG_LIGHT_VALID | SNAPSHOT_FLAG_CLIMATE_VALID)) ||
+          values[HISTORY_SOUND_CLASS] < SOUND_QUIET || values[HISTORY_SOUND_CLASS] > SOUND_LOUD ||
+          values[HISTORY_LEQ] < 0 || values[HISTORY_LEQ] > 255 ||
+          values[HISTORY_HUMIDITY] < 0 || values[HISTORY_HUMIDITY] > 200 ||
+          values[HISTORY_LUX] < 0 || values[HISTORY_LUX] > UINT16_MAX ||
+          timestamp <= central->history_time){
+          sim_stats.history_malformed++;
+      }
+      central->history_time = timestamp;
+  }
+  if (decoder.count != count || decoder.pos != decoder.len){
+      sim_stats.history_malformed++;
+      return;
+  }
+  central->history_next = first + count;
+  central->download_records += count;
+  central->download_bytes += central->sdu_len - HISTORY_HEADER_LEN;
+  sim_stats.history_records += count;
+  if (count != 0){
+      return;
+  }
+  // the end of the answer
+  took = sim_clock_now_ns() - central->download_start_ns;
+  sim_stats.history_downloads++;
+  if (took > sim_stats.history_max_ns){
+      sim_stats.history_max_ns = took;
+      sim_stats.history_max_records = central->download_records;
+      sim_stats.history_max_bytes = central->download_bytes;
+  }
+  central_close_channel(central);
+}
+
+// the oldest K-frame on the link arrives, the central gives its credit back
+static void central_frame(void* ctx){
+  sim_central_t* central = ctx;
+  sl_bt_msg_t msg;
+  const uint8_t* data;
+  uint16_t len;
+
+  if (central->frames_count == 0){
+      return;
+  }
+  data = central->frames[central->frames_head];
+  len = central->frame_len[central->frames_head];
+  central->frames_head = (central->frames_head + 1) % SIM_BT_L2CAP_TX_BUFFERS;
+  central->frames_count--;
+  if (!central->connected || !central->l2cap_open){
+      return;
+  }
+  if (central->sdu_len == 0){
+      if (len < 2){
+          sim_stats.history_malformed++;
+          return;
+      }
+      central->sdu_len = get_u16(data);
+      central->sdu_got = 0;
+      data += 2;
+      len -= 2;
+  }
+  if (central->sdu_len > SIM_BT_L2CAP_MAX_SDU || central->sdu_got + len > central->sdu_len){
+      sim_stats.history_malformed++;
+      central->sdu_len = 0;
+  }
+  else{
+      memcpy(&central->sdu[central->sdu_got], data, len);
+      central->sdu_got += len;
+      if (central->sdu_got == central->sdu_len){
+          central_history_sdu(central);
+          central->sdu_len = 0;
+      }
+  }
+  if (!central->l2cap_open){
+      return;
+  }
+  central->board_credits++;
+  memset(&msg, 0, sizeof(msg));
+  msg.header = sl_bt_evt_l2cap_channel_credit_id;
+  msg.data.evt_l2cap_channel_credit.connection = central->connection;
+  msg.data.evt_l2cap_channel_credit.cid = central->l2cap_cid;
+  msg.data.evt_l2cap_channel_credit.credit = 1;
+  push_event(&msg);
+}
+
+// the request SDU in one K-frame: its length, then the first record wanted
+static void central_request_history(sim_central_t* central){
+  sl_bt_msg_t msg;
+  uint8_t* p;
+  if (central->own_credits == 0 || central->l2cap_board_mps < 2 + HISTORY_REQUEST_LEN){
+      sim_stats.history_malformed++;
+      return;
+  }
+  central->own_credits--;
+  memset(&msg, 0, sizeof(msg));
+  msg.header = sl_bt_evt_l2cap_channel_data_id;
+  msg.data.evt_l2cap_channel_data.connection = central->connection;
+  msg.data.evt_l2cap_channel_data.cid = central->l2cap_cid;
+  msg.data.evt_l2cap_channel_data.data.len = 2 + HISTORY_REQUEST_LEN;
+  p = msg.data.evt_l2cap_channel_data.data.data;
+  UINT16_TO_BITSTREAM(p, HISTORY_REQUEST_LEN);
+  UINT32_TO_BITSTREAM(p, central->history_next);
+  push_event(&msg);
+}
+
+// the connection update instant, the new parameters are in use
+static void central_update(void* ctx){
+  sim_central_t* central = ctx;
+  sl_bt_msg_t msg;
+  if (!central->connected || !central->update_pending){
+      return;
+  }
+  central_count_events(central);
+  central->update_pending = false;
+  central->interval = central->update_interval;
+  central->latency = central->update_latency;
+  central->timeout = central->update_timeout;
+  memset(&msg, 0, sizeof(msg));
+  msg.header = sl_bt_evt_connection_parameters_id;
+  msg.data.evt_connection_parameters.connection = central->connection;
+  msg.data.evt_connection_parameters.interval = central->interval;
+  msg.data.evt_connection_parameters.latency = central->latency;
+  msg.data.evt_connection_parameters.timeout = central->timeout;
+  msg.data.evt_connection_parameters.security_mode = central->bonded ? sl_bt_connection_mode1_level3
+                                                                    : sl_bt_connection_mode1_level1;
+  push_event(&msg);
+}
+
+// the PHY update instant
+static void central_phy_update(void* ctx){
+  sim_central_t* central = ctx;
+  sl_bt_msg_t msg;
+  if (!central->connected || !central->phy_pending){
+      return;
+  }
+  central->phy_pending = false;
+  central->phy = sl_bt_gap_phy_2m;
+  memset(&msg, 0, sizeof(msg));
+  msg.header = sl_bt_evt_connection_phy_status_id;
+  msg.data.evt_connection_phy_status.connection = central->connection;
+  msg.data.evt_connection_phy_status.phy = central->phy;
+  push_event(&msg);
+}
+
+static void central_passkey(void* ctx){
+  sim_central_t* central = ctx;
+  sl_bt_msg_t msg;
+  if (!central->connected){
+      return;
+  }
+  memset(&msg, 0, sizeof(msg));
+  msg.header = sl_bt_evt_sm_confirm_passkey_id;
+  msg.data.evt_sm_confirm_passkey.connection = central->connection;
+  msg.data.evt_sm_confirm_passkey.passkey = SIM_BT_PASSKEY;
+  push_event(&msg);
+  sim_clock_schedule(sim_clock_now_ns() + 2 * SIM_NS_PER_SEC, central_confirm, central);
+}
+
+static void central_subscribe(void* ctx){
+  sim_central_t* central = ctx;
+  sl_bt_msg_t msg;
+  if (!central->connected){
+      return;
+  }
+  for (uint32_t i = 0; i < NUM_SUBSCRIBED; i++){
+      if (central->snapshot_only && subscribed_characteristics[i] != gattdb_study_space_snapshot){
+          continue;
+      }
+      central->subscribed[i] = true;
+      memset(&msg, 0, sizeof(msg));
+      msg.header = sl_bt_evt_gatt_server_characteristic_status_id;
+      msg.data.evt_gatt_server_characteristic_status.connection = central->connection;
+      msg.data.evt_gatt_server_characteristic_status.characteristic = subscribed_characteristics[i];
+      msg.data.evt_gatt_server_characteristic_status.status_flags = sl_bt_gatt_server_client_config;
+      msg.data.evt_gatt_server_characteristic_status.client_config_flags = sl_bt_gatt_notification;
+      push_event(&msg);
+  }
+  central_plan_download(central, central->history_every_s);
+}
+
+void sim_bt_set_central_link(uint32_t central, bool phy_2m, uint16_t max_data_len){
+  if (central >= num_centrals){
+      return;
+  }
+  centrals[central].phy_2m = phy_2m;
+  centrals[central].max_data_len = max_data_len < SIM_BT_MIN_DATA_LEN ? SIM_BT_MIN_DATA_LEN :
+                                   (max_data_len > SIM_BT_MAX_DATA_LEN ? SIM_BT_MAX_DATA_LEN : max_data_len);
+}
+
+void sim_bt_set_central_reconnect(uint32_t central, double every_s){
+  if (central >= num_centrals){
+      return;
+  }
+  centrals[central].reconnect_every_s = every_s;
+}
+
+void sim_bt_add_central(const char* name, bool snapshot_only, uint16_t mtu,
+                        double connect_at_s, double disconnect_at_s, double history_every_s){
+  sim_central_t* central;
+  if (num_centrals == SIM_BT_MAX_CENTRALS){
+      fprintf(stderr, "sim_bt: more than %d centrals, %s left out\n", SIM_BT_MAX_CENTRALS, name);
+      return;
+  }
+  central = &centrals[num_centrals++];
+  central->name = name;
+  central->snapshot_only = snapshot_only;
+  central->mtu = mtu;
+  central->phy_2m = true;
+  central->max_data_len = SIM_BT_MAX_DATA_LEN;
+  central->connect_at_s = connect_at_s;
+  central->history_every_s = history_every_s;
+  if (connect_at_s >= 0.0){
+      sim_clock_schedule((uint64_t)(connect_at_s * SIM_NS_PER_SEC), central_connect, central);
+  }
+  if (disconnect_at_s >= 0.0){
+      sim_clock_schedule((uint64_t)(disconnect_at_s * SIM_NS_PER_SEC), central_disconnect, central);
+  }
+}
+
+// *********************************************************************
+// sl_bt commands used by the firmware
+// *********************************************************************
+sl_status_t sl_bt_external_signal(uint32_t signals){
+  if (pending_signals & signals){
+      sim_stats.ext_signals_merged++;
+  }
+  pending_signals |= signals;
+  return SL_STATUS_OK;
+}
+
+sl_status_t sl_bt_system_get_identity_address(bd_addr* address, uint8_t* type){
+  static const bd_addr sim_address = { .addr = { 0x13, 0x00, 0x23, 0x58, 0x0B, 0x00 } };
+  *address = sim_address;
+  *type = sl_bt_gap_public_address;
+  return SL_STATUS_OK;
+}
+
+static void soft_timer_expired(void* ctx){
+  uint8_t handle = (uint8_t)(uintptr_t)ctx;
+  sl_bt_msg_t msg;
+
+  if (soft_timer_period_ns[handle] != 0){
+      soft_timers[handle] = sim_clock_schedule(sim_clock_now_ns() + soft_timer_period_ns[handle],
+                                               soft_timer_expired, ctx);
+  }
+  else{
+      soft_timers[handle] = 0;
+  }
+  memset(&msg, 0, sizeof(msg));
+  msg.header = sl_bt_evt_system_soft_timer_id;
+  msg.data.evt_system_soft_timer.handle = handle;
+  push_event(&msg);
+}
+
+// time and slack in 32768 Hz ticks, slack is not modelled
+sl_status_t sl_bt_system_set_lazy_soft_timer(uint32_t time, uint32_t slack, uint8_t handle, uint8_t single_shot){
+  (void)slack;
+  uint64_t period_ns = (uint64_t)time * SIM_NS_PER_SEC / 32768;
+  if (handle >= SIM_BT_SOFT_TIMERS){
+      return SL_STATUS_INVALID_HANDLE;
+  }
+  if (soft_timers[handle] != 0){
+      sim_clock_cancel(soft_timers[handle]);
+      soft_timers[handle] = 0;
+  }
+  if (time == 0){
+      return SL_STATUS_OK;
+  }
+  soft_timer_period_ns[handle] = single_shot ? 0 : period_ns;
+  soft_timers[handle] = sim_clock_schedule(sim_clock_now_ns() + period_ns, soft_timer_expired,
+                                           (void*)(uintptr_t)handle);
+  return SL_STATUS_OK;
+}
+
+sl_status_t sl_bt_advertiser_create_set(uint8_t* handle){
+  if (num_advertising_sets == SL_BT_CONFIG_USER_ADVERTISERS){
+      return SL_STATUS_NO_MORE_RESOURCE;
+  }
+  *handle = num_advertising_sets++;
+  return SL_STATUS_OK;
+}
+
+sl_status_t sl_bt_advertiser_set_timing(uint8_t advertising_set, uint32_t interval_min,
+                                        uint32_t interval_max, uint16_t duration,
+                                        uint8_t maxevents){
+  (void)advertising_set;
+  (void)interval_min;
+  (void)interval_max;
+  (void)duration;
+  (void)maxevents;
+  return SL_STATUS_OK;
+}
+
+sl_status_t sl_bt_legacy_advertiser_generate_data(uint8_t advertising_set, uint8_t discover){
+  (void)advertising_set;
+  (void)discover;
+  return SL_STATUS_OK;
+}
+
+sl_status_t sl_bt_legacy_advertiser_start(uint8_t advertising_set, uint8_t connect){
+  if (advertising_set >= num_advertising_sets){
+      return SL_STATUS_INVALID_HANDLE;
+  }
+  (void)connect;
+  connectable_set = advertising_set;
+  advertising = true;
+  return SL_STATUS_OK;
+}
+
+sl_status_t sl_bt_advertiser_stop(uint8_t advertising_set){
+  if (advertising_set >= num_advertising_sets){
+      return SL_STATUS_INVALID_HANDLE;
+  }
+  if (advertising_set == connectable_set){
+      advertising = false;
+  }
+  return SL_STATUS_OK;
+}
+
+// the manufacturer specific data of an advertising packet, NULL if none
+static const uint8_t* find_beacon(const uint8_t* data, size_t len){
+  size_t i = 0;
+  while (i + 1 < len && data[i] != 0){
+      if (i + 1 + data[i] > len){
+          return NULL;
+      }
+      if (data[i + 1] == 0xFF && data[i] == 3 + BEACON_PAYLOAD_LEN &&
+          (data[i + 2] | (data[i + 3] << 8)) == BEACON_COMPANY_ID){
+          return &data[i + 4];
+      }
+      i += 1 + data[i];
+  }
+  return NULL;
+}
+
+static uint16_t lux_of(const uint8_t* p){
+  return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+// a passive gateway scans the new advertising data
+static void check_beacon(const uint8_t* data, size_t len){
+  const uint8_t* payload = find_beacon(data, len);
+  uint16_t lux;
+  uint16_t last_lux;
+  uint16_t change;
+
+  if (payload == NULL){
+      sim_stats.beacon_mismatches++;
+      return;
+  }
+  // advertising restarted with the same payload
+  if (have_beacon && memcmp(payload, beacon_payload, BEACON_PAYLOAD_LEN) == 0){
+      return;
+  }
+  lux = lux_of(&payload[3]);
+  if (have_beacon){
+      sim_stats.beacon_updates++;
+      if (payload[0] != (uint8_t)(beacon_payload[0] + 1)){
+          sim_stats.beacon_gaps++;
+      }
+      last_lux = lux_of(&beacon_payload[3]);
+      change = lux > last_lux ? lux - last_lux : last_lux - lux;
+      if (payload[1] == beacon_payload[1] && payload[2] == beacon_payload[2] &&
+          change <= BEACON_LUX_DEADBAND(last_lux)){
+          sim_stats.beacon_needless++;
+      }
+  }
+  // as current as the snapshot, within the deadband
+  if (have_gatt_snapshot){
+      change = lux > lux_of(&gatt_snapshot[6]) ? lux - lux_of(&gatt_snapshot[6])
+                                                : lux_of(&gatt_snapshot[6]) - lux;
+      if ((payload[1] & SNAPSHOT_FLAG_OCCUPIED) != (gatt_snapshot[2] & SNAPSHOT_FLAG_OCCUPIED) ||
+          payload[2] != gatt_snapshot[3] || change > BEACON_LUX_DEADBAND(lux)){
+          sim_stats.beacon_mismatches++;
+      }
+  }
+  memcpy(beacon_payload, payload, BEACON_PAYLOAD_LEN);
+  have_beacon = true;
+}
+
+sl_status_t sl_bt_legacy_advertiser_set_data(uint8_t advertising_set, uint8_t type,
+                                             size_t data_len, const uint8_t* data){
+  if (advertising_set >= num_advertising_sets){
+      return SL_STATUS_INVALID_HANDLE;
+  }
+  if (data_len > 31){
+      return SL_STATUS_INVALID_PARAMETER;
+  }
+  if (type == sl_bt_advertiser_advertising_data_packet){
+      check_beacon(data, data_len);
+  }
+  return SL_STATUS_OK;
+}
+
+sl_status_t sl_bt_extended_advertiser_generate_data(uint8_t advertising_set, uint8_t discover){
+  (void)discover;
+  return advertising_set < num_advertising_sets ? SL_STATUS_OK : SL_STATUS_INVALID_HANDLE;
+}
+
+sl_status_t sl_bt_extended_advertiser_start(uint8_t advertising_set, uint8_t connect, uint32_t flags){
+  (void)flags;
+  if (advertising_set >= num_advertising_sets || advertising_set == connectable_set){
+      return SL_STATUS_INVALID_HANDLE;
+  }
+  // a connectable set could be connected to, the centrals only use legacy
+  return connect == sl_bt_extended_advertiser_non_connectable ? SL_STATUS_OK : SL_STATUS_INVALID_PARAMETER;
+}
+
+sl_status_t sl_bt_periodic_advertiser_start(uint8_t advertising_set, uint16_t interval_min,
+                                            uint16_t interval_max, uint32_t flags){
+  (void)flags;
+  if (advertising_set >= num_advertising_sets){
+      return SL_STATUS_INVALID_HANDLE;
+  }
+  if (interval_min < 6 || interval_min > interval_max){
+      return SL_STATUS_INVALID_PARAMETER;
+  }
+  periodic_running = true;
+  periodic_interval = interval_max;
+  periodic_since_ns = sim_clock_now_ns();
+  return SL_STATUS_OK;
+}
+
+sl_status_t sl_bt_periodic_advertiser_stop(uint8_t advertising_set){
+  if (advertising_set >= num_advertising_sets){
+      return SL_STATUS_INVALID_HANDLE;
+  }
+  sim_bt_count_conn_events();
+  periodic_running = false;
+  return SL_STATUS_OK;
+}
+
+// an observer synced to the train reads the new data
+static void check_broadcast(const uint8_t* data, size_t len){
+  const uint8_t* record = &data[2 + 16];
+  const uint8_t* last = &broadcast_data[2 + 16];
+  int16_t leq;
+  int16_t snapshot_leq;
+
+  if (len != BROADCAST_DATA_LEN || data[0] != BROADCAST_DATA_LEN - 1 || data[1] != BROADCAST_AD_TYPE ||
+      memcmp(&data[2], &study_space_uuid[0], 16) != 0){
+      sim_stats.broadcast_mismatches++;
+      return;
+  }
+  sim_stats.broadcast_updates++;
+  if (have_broadcast){
+      if ((uint16_t)(record[0] | (record[1] << 8)) != (uint16_t)(last[0] + (last[1] << 8) + 1)){
+          sim_stats.broadcast_gaps++;
+      }
+      if (memcmp(&record[2], &last[2], SNAPSHOT_LEN - 2) == 0){
+          sim_stats.broadcast_unchanged++;
+      }
+  }
+  // the snapshot without its sequence number, Leq to the nearest dB
+  if (have_gatt_snapshot){
+      leq = (int16_t)(record[4] | (record[5] << 8));
+      snapshot_leq = (int16_t)(gatt_snapshot[4] | (gatt_snapshot[5] << 8));
+      if (memcmp(&record[2], &gatt_snapshot[2], 2) != 0 ||
+          memcmp(&record[6], &gatt_snapshot[6], SNAPSHOT_LEN - 6) != 0 ||
+          leq % 10 != 0 || leq - snapshot_leq > 5 || snapshot_leq - leq > 5){
+          sim_stats.broadcast_mismatches++;
+      }
+  }
+  memcpy(broadcast_data, data, len);
+  have_broadcast = true;
+}
+
+sl_status_t sl_bt_periodic_advertiser_set_data(uint8_t advertising_set, size_t data_len,
+                                               const uint8_t* data){
+  if (advertising_set >= num_advertising_sets){
+      return SL_STATUS_INVALID_HANDLE;
+  }
+  // what fits in one AUX_SYNC_IND
+  if (data_len > 247){
+      return SL_STATUS_INVALID_PARAMETER;
+  }
+  check_broadcast(data, data_len);
+  return SL_STATUS_OK;
+}
+
+sl_status_t sl_bt_connection_set_parameters(uint8_t connection, uint16_t min_interval,
+                                            uint16_t max_interval, uint16_t latency,
+                                            uint16_t timeout, uint16_t min_ce_length,
+                                            uint16_t max_ce_length){
+  (void)min_ce_length;
+  (void)max_ce_length;
+  sim_central_t* central = find_central(connection);
+  if (central == NULL){
+      return SL_STATUS_INVALID_HANDLE;
+  }
+  // Core spec ranges, and the timeout has to outlast two of the longest
+  // gaps latency allows: timeout * 10 ms > (1 + latency) * interval * 2.5 ms
+  if (min_interval < 6 || max_interval > 3200 || min_interval > max_interval ||
+      latency > 499 || timeout < 10 || timeout > 3200 ||
+      (uint32_t)timeout * 4 <= (uint32_t)(latency + 1) * max_interval){
+      sim_stats.ble_param_rejects++;
+      return SL_STATUS_INVALID_PARAMETER;
+  }
+  sim_stats.ble_param_updates++;
+  // the central takes the longest interval it is offered, a later request
+  // replaces one still waiting for its instant
+  if (!central->update_pending){
+      sim_clock_schedule(sim_clock_now_ns() + (uint64_t)SIM_BT_UPDATE_EVENTS * central->interval * 1250 *
+                         SIM_NS_PER_US, central_update, central);
+  }
+  central->update_pending = true;
+  central->update_interval = max_interval;
+  central->update_latency = latency;
+  central->update_timeout = timeout;
+  return SL_STATUS_OK;
+}
+
+sl_status_t sl_bt_connection_set_preferred_phy(uint8_t connection, uint8_t preferred_phy,
+                                               uint8_t accepted_phy){
+  sim_central_t* central = find_central(connection);
+  if (central == NULL){
+      return SL_STATUS_INVALID_HANDLE;
+  }
+  if (preferred_phy == 0 || accepted_phy == 0){
+      return SL_STATUS_INVALID_PARAMETER;
+  }
+  // only 2M is worth a procedure here, the central stays on 1M otherwise
+  if ((preferred_phy & sl_bt_gap_phy_2m) && central->phy_2m && central->phy != sl_bt_gap_phy_2m &&
+      !central->phy_pending){
+      central->phy_pending = true;
+      sim_clock_schedule(sim_clock_now_ns() + (uint64_t)SIM_BT_UPDATE_EVENTS * central->interval * 1250 *
+                         SIM_NS_PER_US, central_phy_update, central);
+  }
+  return SL_STATUS_OK;
+}
+
+sl_status_t sl_bt_connection_set_data_length(uint8_t connection, uint16_t tx_data_len,
+                                             uint16_t tx_time_us){
+  sl_bt_msg_t msg;
+  uint16_t len;
+  sim_central_t* central = find_central(connection);
+  if (central == NULL){
+      return SL_STATUS_INVALID_HANDLE;
+  }
+  if (tx_data_len < SIM_BT_MIN_DATA_LEN || tx_data_len > SIM_BT_MAX_DATA_LEN ||
+      tx_time_us < SIM_BT_MIN_TX_TIME || tx_time_us > SIM_BT_MAX_TX_TIME){
+      return SL_STATUS_INVALID_PARAMETER;
+  }
+  // what both sides take and fits the time on the 1M PHY
+  len = tx_data_len < central->max_data_len ? tx_data_len : central->max_data_len;
+  if (len > tx_time_us / 8 - 14){
+      len = (uint16_t)(tx_time_us / 8 - 14);
+  }
+  central->data_len = len;
+  memset(&msg, 0, sizeof(msg));
+  msg.header = sl_bt_evt_connection_data_length_id;
+  msg.data.evt_connection_data_length.connection = connection;
+  msg.data.evt_connection_data_length.tx_data_len = len;
+  msg.data.evt_connection_data_length.tx_time_us = (uint16_t)((len + 14) * 8);
+  msg.data.evt_connection_data_length.rx_data_len = len;
+  msg.data.evt_connection_data_length.rx_time_us = (uint16_t)((len + 14) * 8);
+  push_event(&msg);
+  return SL_STATUS_OK;
+}
+
+sl_status_t sl_bt_connection_close(uint8_t connection){
+  sim_central_t* central = find_central(connection);
+  if (central == NULL){
+      return SL_STATUS_INVALID_HANDLE;
+  }
+  central_disconnect(central);
+  return SL_STATUS_OK;
+}
+
+// NULL unless a central has the channel open, or asked for it, on the handles
+static sim_central_t* find_channel(uint8_t connection, uint16_t cid){
+  sim_central_t* central = find_central(connection);
+  if (central == NULL || !(central->l2cap_open || central->l2cap_pending) || central->l2cap_cid != cid){
+      return NULL;
+  }
+  return central;
+}
+
+sl_status_t sl_bt_l2cap_send_le_channel_open_response(uint8_t connection, uint16_t cid,
+                                                      uint16_t max_sdu, uint16_t max_pdu,
+                                                      uint16_t credit, uint16_t errorcode){
+  sim_central_t* central = find_channel(connection, cid);
+  if (central == NULL || !central->l2cap_pending){
+      return SL_STATUS_INVALID_HANDLE;
+  }
+  central->l2cap_pending = false;
+  if (errorcode != sl_bt_l2cap_connection_result_successful){
+      sim_stats.history_refused++;
+      central_plan_download(central, central->history_every_s);
+      return SL_STATUS_OK;
+  }
+  if (max_sdu < 23 || max_sdu > 65533 || max_pdu < 23 || max_pdu > 252){
+      sim_stats.history_malformed++;
+      return SL_STATUS_INVALID_PARAMETER;
+  }
+  central->l2cap_open = true;
+  central->l2cap_board_mps = max_pdu;
+  central->own_credits = credit;
+  central_request_history(central);
+  return SL_STATUS_OK;
+}
+
+// sends one LL packet on the link, returns when its acknowledgement is in.
+// An idle link waits for the next anchor, a busy one moves to the next
+// event once this one runs into the guard.
+static uint64_t link_packet(sim_central_t* central, uint16_t len){
+  uint64_t now = sim_clock_now_ns();
+  uint64_t interval_ns = (uint64_t)central->interval * 1250 * SIM_NS_PER_US;
+  uint64_t air_ns = (uint64_t)SIM_BT_PACKET_US(len, central->phy == sl_bt_gap_phy_2m ? 2 : 1) * SIM_NS_PER_US;
+  uint64_t t;
+  if (central->link_free_ns < now){
+      central->link_anchor_ns = central->params_since_ns +
+          ((now - central->params_since_ns) / interval_ns + 1) * interval_ns;
+      t = central->link_anchor_ns;
+  }
+  else{
+      t = central->link_free_ns;
+      if (t + air_ns > central->link_anchor_ns + interval_ns - SIM_BT_EVENT_GUARD_US * SIM_NS_PER_US){
+          central->link_anchor_ns += interval_ns;
+          t = central->link_anchor_ns;
+      }
+  }
+  central->link_free_ns = t + air_ns;
+  return central->link_free_ns;
+}
+
+// the board hands the stack a K-frame for the central
+sl_status_t sl_bt_l2cap_channel_send_data(uint8_t connection, uint16_t cid, size_t data_len,
+                                          const uint8_t* data){
+  uint64_t now = sim_clock_now_ns();
+  uint64_t done_ns = 0;
+  uint32_t left;
+  uint32_t slot;
+  sim_central_t* central = find_channel(connection, cid);
+  if (central == NULL || !central->l2cap_open){
+      return SL_STATUS_INVALID_HANDLE;
+  }
+  if (data_len == 0 || data_len > SIM_BT_L2CAP_MAX_PDU){
+      sim_stats.history_credit_violations++;
+      return SL_STATUS_INVALID_PARAMETER;
+  }
+  if (central->board_credits == 0){
+      sim_stats.history_credit_violations++;
+      return SL_STATUS_INVALID_STATE;
+  }
+  // stalled link or TX buffers full
+  if (now < congested_until_ns || central->frames_count == SIM_BT_L2CAP_TX_BUFFERS){
+      sim_stats.history_busy++;
+      return SL_STATUS_NO_MORE_RESOURCE;
+  }
+  central->board_credits--;
+  slot = (central->frames_head + central->frames_count) % SIM_BT_L2CAP_TX_BUFFERS;
+  memcpy(central->frames[slot], data, data_len);
+  central->frame_len[slot] = (uint16_t)data_len;
+  central->frames_count++;
+  // the K-frame and its L2CAP header in packets of the data length
+  for (left = (uint32_t)data_len + 4; left > 0; ){
+      uint16_t len = left < central->data_len ? (uint16_t)left : central->data_len;
+      done_ns = link_packet(central, len);
+      left -= len;
+  }
+  sim_clock_schedule(done_ns, central_frame, central);
+  return SL_STATUS_OK;
+}
+
+sl_status_t sl_bt_l2cap_channel_send_credit(uint8_t connection, uint16_t cid, uint16_t credit){
+  sim_central_t* central = find_channel(connection, cid);
+  if (central == NULL || !central->l2cap_open){
+      return SL_STATUS_INVALID_HANDLE;
+  }
+  if (credit == 0){
+      return SL_STATUS_INVALID_PARAMETER;
+  }
+  central->own_credits += credit;
+  return SL_STATUS_OK;
+}
+
+sl_status_t sl_bt_l2cap_close_channel(uint8_t connection, uint16_t cid){
+  sim_central_t* central = find_channel(connection, cid);
+  if (central == NULL || !central->l2cap_open){
+      return SL_STATUS_INVALID_HANDLE;
+  }
+  sim_stats.history_aborted++;
+  central_close_channel(central);
+  return SL_STATUS_OK;
+}
+
+sl_status_t sl_bt_sm_configure(uint8_t flags, uint8_t io_capabilities){
+  (void)flags;
+  (void)io_capabilities;
+  return SL_STATUS_OK;
+}
+
+sl_status_t sl_bt_sm_delete_bondings(){
+  for (uint32_t i = 0; i < num_centrals; i++){
+      centrals[i].has_bond = false;
+  }
+  return SL_STATUS_OK;
+}
+
+sl_status_t sl_bt_sm_bonding_confirm(uint8_t connection, uint8_t confirm){
+  sim_central_t* central = find_central(connection);
+  if (central == NULL){
+      return SL_STATUS_INVALID_HANDLE;
+  }
+  if (confirm){
+      sim_clock_schedule(sim_clock_now_ns() + 200 * SIM_NS_PER_MS, central_passkey, central);
+  }
+  return SL_STATUS_OK;
+}
+
+sl_status_t sl_bt_sm_passkey_confirm(uint8_t connection, uint8_t confirm){
+  sl_bt_msg_t msg;
+  sim_central_t* central = find_central(connection);
+  if (central == NULL){
+      return SL_STATUS_INVALID_HANDLE;
+  }
+  if (!confirm){
+      return SL_STATUS_OK;
+  }
+  central->bonded = true;
+  central->has_bond = true;
+  memset(&msg, 0, sizeof(msg));
+  msg.header = sl_bt_evt_sm_bonded_id;
+  msg.data.evt_sm_bonded.connection = connection;
+  msg.data.evt_sm_bonded.bonding = (uint8_t)(central - &centrals[0]);
+  msg.data.evt_sm_bonded.security_mode = sl_bt_connection_mode1_level3;
+  push_event(&msg);
+  sim_clock_schedule(sim_clock_now_ns() + 300 * SIM_NS_PER_MS, central_subscribe, central);
+  return SL_STATUS_OK;
+}
+
+sl_status_t sl_bt_gatt_server_set_max_mtu(uint16_t max_mtu, uint16_t* max_mtu_out){
+  if (max_mtu < 23 || max_mtu > 250){
+      return SL_STATUS_INVALID_PARAMETER;
+  }
+  board_max_mtu = max_mtu;
+  *max_mtu_out = board_max_mtu;
+  return SL_STATUS_OK;
+}
+
+sl_status_t sl_bt_gatt_server_write_attribute_value(uint16_t attribute, uint16_t offset,
+                                                    size_t value_len, const uint8_t* value){
+  if (attribute == gattdb_study_space_snapshot && offset == 0 && value_len == SNAPSHOT_LEN){
+      memcpy(gatt_snapshot, value, SNAPSHOT_LEN);
+      have_gatt_snapshot = true;
+  }
+  return SL_STATUS_OK;
+}
+
+// last value a central got for a characteristic, NULL if none arrived yet
+static const uint8_t* last_value(const sim_central_t* central, uint16_t characteristic, size_t* len){
+  int i = subscribed_index(characteristic);
+  if (i < 0 || central->last_len[i] == 0){
+      return NULL;
+  }
+  *len = central->last_len[i];
+  return central->last_value[i];
+}
+
+static void check_snapshot(sim_central_t* central, const uint8_t* value, size_t value_len){
+  const uint8_t* last;
+  size_t len;
+  bool ok = true;
+
+  if (value_len != SNAPSHOT_LEN){
+      sim_stats.snapshot_mismatches++;
+      return;
+  }
+  uint16_t sequence = get_u16(&value[0]);
+  uint8_t flags = value[2];
+  if (central->have_sequence && sequence != (uint16_t)(central->last_sequence + 1)){
+      sim_stats.snapshot_gaps += (uint16_t)(sequence - central->last_sequence - 1);
+  }
+  central->have_sequence = true;
+  central->last_sequence = sequence;
+
+  last = last_value(central, gattdb_space_occupied, &len);
+  if (last != NULL){
+      bool occupied = len == 8 && memcmp(last, "Occupied", 8) == 0;
+      ok = ok && occupied == ((flags & SNAPSHOT_FLAG_OCCUPIED) != 0);
+  }
+  last = last_value(central, gattdb_audio_input_description, &len);
+  if (last != NULL){
+      const char* name = sound_level_name((sound_class_t)value[3]);
+      ok = ok && len == strlen(name) && memcmp(last, name, len) == 0;
+  }
+  last = last_value(central, gattdb_illuminance, &len);
+  if (last != NULL && (flags & SNAPSHOT_FLAG_LIGHT_VALID)){
+      ok = ok && get_u16(last) == get_u16(&value[6]);
+  }
+  last = last_value(central, gattdb_temperature_measurement, &len);
+  if (last != NULL && (flags & SNAPSHOT_FLAG_CLIMATE_VALID)){
+      // IEEE-11073 FLOAT, exponent -3: the mantissa is millidegrees
+      int32_t mc = (int32_t)((uint32_t)last[1] << 8 | (uint32_t)last[2] << 16 | (uint32_t)last[3] << 24) >> 8;
+      ok = ok && (int16_t)(mc / 10) == (int16_t)get_u16(&value[8]);
+  }
+  last = last_value(central, gattdb_humidity, &len);
+  if (last != NULL && (flags & SNAPSHOT_FLAG_CLIMATE_VALID)){
+      ok = ok && get_u16(last) == get_u16(&value[10]);
+  }
+  if (!ok){
+      sim_stats.snapshot_mismatches++;
+  }
+}
+
+// one connection, only if the client enabled notifications on the characteristic
+sl_status_t sl_bt_gatt_server_send_notification(uint8_t connection, uint16_t characteristic,
+                                                size_t value_len, const uint8_t* value){
+  int i;
+  uint64_t now = sim_clock_now_ns();
+  sim_central_t* central = find_central(connection);
+  if (central == NULL){
+      sim_stats.notify_errors++;
+      return SL_STATUS_INVALID_HANDLE;
+  }
+  i = subscribed_index(characteristic);
+  if (i < 0 || !central->subscribed[i]){
+      sim_stats.notify_errors++;
+      return SL_STATUS_INVALID_STATE;
+  }
+  if (value_len > SIM_BT_MAX_VALUE){
+      sim_stats.notify_errors++;
+      return SL_STATUS_COMMAND_TOO_LONG;
+  }
+  // the link stalls, TX buffers stay full until it recovers
+  if (now >= congested_until_ns && sim_options.ble_congestion_rate > 0.0 &&
+      bt_uniform() < sim_options.ble_congestion_rate){
+      sim_stats.ble_congestions++;
+      congested_until_ns = now + SIM_BT_CONGESTION_MIN_NS +
+          (uint64_t)(bt_uniform() * (SIM_BT_CONGESTION_MAX_NS - SIM_BT_CONGESTION_MIN_NS));
+  }
+  if (now < congested_until_ns){
+      sim_stats.notify_refused++;
+      return SL_STATUS_NO_MORE_RESOURCE;
+  }
+  central->notifications[i]++;
+  sim_stats.notifications++;
+  if (characteristic == gattdb_study_space_snapshot){
+      check_snapshot(central, value, value_len);
+  }
+  memcpy(central->last_value[i], value, value_len);
+  central->last_len[i] = value_len;
+  return SL_STATUS_OK;
+}
+
+// log.c prints status strings, a hex code is enough here
+int32_t sl_status_get_string_n(sl_status_t status, char* buffer, uint32_t buffer_length){
+  return snprintf(buffer, buffer_length, "SL_STATUS 0x%04x", (unsigned int)status);
+}
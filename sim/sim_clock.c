@@ -0,0 +1,155 @@
+/***********************************************************************
+ * @file      sim_clock.c
+ * @brief     Discrete-event virtual clock for the host simulation build
+ *
+ * @author    Hyounjun Chang, hyounjun.chang@colorado.edu
+ * @date      Oct 16, 2026
+ *
+ * @resources
+ *
+ * Events are kept in a binary min-heap ordered by (time, sequence), so two
+ * events scheduled for the same instant run in the order they were added.
+ * Time only moves when sim_clock_run_next() pops an event, which is what
+ * lets 24 hours of firmware operation replay in a few seconds.
+ *
+ */
+#include "sim_clock.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+typedef struct {
+  uint64_t at_ns;
+  uint64_t seq;
+  sim_event_handle_t handle;
+  sim_event_cb_t cb;
+  void* ctx;
+} sim_event_t;
+
+static sim_event_t heap[SIM_CLOCK_MAX_EVENTS];
+static uint32_t heap_len = 0;
+static uint64_t now_ns = 0;
+static uint64_t next_seq = 0;
+static sim_event_handle_t next_handle = 1;
+
+static bool event_before(const sim_event_t* a, const sim_event_t* b){
+  if (a->at_ns != b->at_ns){
+      return a->at_ns < b->at_ns;
+  }
+  return a->seq < b->seq;
+}
+
+static void heap_swap(uint32_t i, uint32_t j){
+  sim_event_t tmp = heap[i];
+  heap[i] = heap[j];
+  heap[j] = tmp;
+}
+
+static void heap_sift_up(uint32_t i){
+  while (i > 0){
+      uint32_t parent = (i - 1) / 2;
+      if (!event_before(&heap[i], &heap[parent])){
+          break;
+      }
+      heap_swap(i, parent);
+      i = parent;
+  }
+}
+
+static void heap_sift_down(uint32_t i){
+  while (1){
+      uint32_t left = 2 * i + 1;
+      uint32_t right = left + 1;
+      uint32_t smallest = i;
+      if (left < heap_len && event_before(&heap[left], &heap[smallest])){
+          smallest = left;
+      }
+      if (right < heap_len && event_before(&heap[right], &heap[smallest])){
+          smallest = right;
+      }
+      if (smallest == i){
+          break;
+      }
+      heap_swap(i, smallest);
+      i = smallest;
+  }
+}
+
+static void heap_remove(uint32_t i){
+  heap_len--;
+  if (i == heap_len){
+      return;
+  }
+  heap[i] = heap[heap_len];
+  heap_sift_down(i);
+  heap_sift_up(i);
+}
+
+void sim_clock_reset(){
+  heap_len = 0;
+  now_ns = 0;
+  next_seq = 0;
+  next_handle = 1;
+}
+
+uint64_t sim_clock_now_ns(){
+  return now_ns;
+}
+
+sim_event_handle_t sim_clock_schedule(uint64_t at_ns, sim_event_cb_t cb, void* ctx){
+  if (heap_len == SIM_CLOCK_MAX_EVENTS){
+      fprintf(stderr, "sim_clock: event queue full\n");
+      abort();
+  }
+  if (at_ns < now_ns){
+      at_ns = now_ns;
+  }
+  sim_event_handle_t handle = next_handle++;
+  if (next_handle == 0){
+      next_handle = 1;
+  }
+  sim_event_t* ev = &heap[heap_len];
+  ev->at_ns = at_ns;
+  ev->seq = next_seq++;
+  ev->handle = handle;
+  ev->cb = cb;
+  ev->ctx = ctx;
+  heap_len++;
+  // ev no longer points at this event once it moves up the heap
+  heap_sift_up(heap_len - 1);
+  return handle;
+}
+
+void sim_clock_cancel(sim_event_handle_t handle){
+  if (handle == 0){
+      return;
+  }
+  for (uint32_t i = 0; i < heap_len; i++){
+      if (heap[i].handle == handle){
+          heap_remove(i);
+          return;
+      }
+  }
+}
+
+bool sim_clock_next_event_ns(uint64_t* at_ns){
+  if (heap_len == 0){
+      return false;
+  }
+  *at_ns = heap[0].at_ns;
+  return true;
+}
+
+bool sim_clock_run_next(uint64_t until_ns){
+  if (heap_len == 0 || heap[0].at_ns > until_ns){
+      if (until_ns > now_ns){
+          now_ns = until_ns;
+      }
+      return false;
+  }
+  sim_event_t ev = heap[0];
+  heap_remove(0);
+  now_ns = ev.at_ns;
+  ev.cb(ev.ctx);
+  return true;
+}
@@ -0,0 +1,47 @@
+/***********************************************************************
+ * @file      sim_clock.h
+ * @brief     Discrete-event virtual clock for the host simulation build
+ *
+ * @author    Hyounjun Chang, hyounjun.chang@colorado.edu
+ * @date      Oct 16, 2026
+ *
+ * @resources
+ *
+ *
+ */
+
+#ifndef SIM_CLOCK_H
+#define SIM_CLOCK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define SIM_NS_PER_US  1000ULL
+#define SIM_NS_PER_MS  1000000ULL
+#define SIM_NS_PER_SEC 1000000000ULL
+
+// max number of events outstanding at once (peripherals + scenario)
+#define SIM_CLOCK_MAX_EVENTS 64
+
+typedef void (*sim_event_cb_t)(void* ctx);
+
+// handle returned by sim_clock_schedule(), 0 is never a valid handle
+typedef uint32_t sim_event_handle_t;
+
+void sim_clock_reset();
+
+// current virtual time in ns since reset
+uint64_t sim_clock_now_ns();
+
+// schedule cb(ctx) to run at absolute virtual time at_ns (clamped to now)
+sim_event_handle_t sim_clock_schedule(uint64_t at_ns, sim_event_cb_t cb, void* ctx);
+void sim_clock_cancel(sim_event_handle_t handle);
+
+// time of the earliest pending event, false if queue is empty
+bool sim_clock_next_event_ns(uint64_t* at_ns);
+
+// advance virtual time to the earliest event (if <= until_ns) and run it,
+// returns false if nothing was due before until_ns (time is moved to until_ns)
+bool sim_clock_run_next(uint64_t until_ns);
+
+#endif
@@ -0,0 +1,328 @@
+/***********************************************************************
+ * @file      sim_cmsis_dsp.c
+ * @brief     Reference C versions of the CMSIS-DSP kernels the firmware uses
+ *
+ * @author    Hyounjun Chang, hyounjun.chang@colorado.edu
+ * @date      Oct 16, 2026
+ *
+ * @resources CMSIS-DSP 1.14 Source/ (StatisticsFunctions and friends), ARM_MATH_DSP off
+ *
+ * The vendored SDK only ships the CMSIS-DSP headers, the target links the
+ * prebuilt library. These follow the library's scalar code path: q31 or q63
+ * accumulators, truncating shifts and saturation to 16 bits where the
+ * library uses __SSAT. Square roots are exact integer roots, the library's
+ * Newton-Raphson result can differ in the last bit.
+ *
+ * arm_rfft_q15 is a double precision FFT scaled and truncated the way the
+ * library's fixed-point one is, output = DFT / N. The library loses a few
+ * more low bits in its butterflies, which only shows on tiny signals.
+ *
+ */
+#include <string.h>
+#include <math.h>
+
+#include "arm_math.h"
+
+static q31_t ssat16(q31_t x){
+  if (x > INT16_MAX){
+      return INT16_MAX;
+  }
+  if (x < INT16_MIN){
+      return INT16_MIN;
+  }
+  return x;
+}
+
+static q31_t ssat32(q63_t x){
+  if (x > INT32_MAX){
+      return INT32_MAX;
+  }
+  if (x < INT32_MIN){
+      return INT32_MIN;
+  }
+  return (q31_t)x;
+}
+
+static uint64_t isqrt64(uint64_t x){
+  uint64_t result = 0;
+  uint64_t bit = 1ULL << 62;
+
+  while (bit > x){
+      bit >>= 2;
+  }
+  while (bit != 0){
+      if (x >= result + bit){
+          x -= result + bit;
+          result = (result >> 1) + bit;
+      }
+      else{
+          result >>= 1;
+      }
+      bit >>= 2;
+  }
+  return result;
+}
+
+void arm_offset_q15(const q15_t* pSrc, q15_t offset, q15_t* pDst, uint32_t blockSize){
+  for (uint32_t i = 0; i < blockSize; i++){
+      pDst[i] = (q15_t)ssat16((q31_t)pSrc[i] + offset);
+  }
+}
+
+void arm_shift_q15(const q15_t* pSrc, int8_t shiftBits, q15_t* pDst, uint32_t blockSize){
+  for (uint32_t i = 0; i < blockSize; i++){
+      if (shiftBits >= 0){
+          pDst[i] = (q15_t)ssat16((q31_t)pSrc[i] << shiftBits);
+      }
+      else{
+          pDst[i] = (q15_t)(pSrc[i] >> -shiftBits);
+      }
+  }
+}
+
+void arm_shift_q31(const q31_t* pSrc, int8_t shiftBits, q31_t* pDst, uint32_t blockSize){
+  for (uint32_t i = 0; i < blockSize; i++){
+      if (shiftBits >= 0){
+          pDst[i] = ssat32((q63_t)pSrc[i] << shiftBits);
+      }
+      else{
+          pDst[i] = pSrc[i] >> -shiftBits;
+      }
+  }
+}
+
+void arm_q15_to_q31(const q15_t* pSrc, q31_t* pDst, uint32_t blockSize){
+  for (uint32_t i = 0; i < blockSize; i++){
+      pDst[i] = (q31_t)pSrc[i] << 16;
+  }
+}
+
+void arm_q31_to_q15(const q31_t* pSrc, q15_t* pDst, uint32_t blockSize){
+  for (uint32_t i = 0; i < blockSize; i++){
+      pDst[i] = (q15_t)(pSrc[i] >> 16);
+  }
+}
+
+void arm_biquad_cascade_df1_init_q31(arm_biquad_casd_df1_inst_q31* S, uint8_t numStages,
+                                     const q31_t* pCoeffs, q31_t* pState, int8_t postShift){
+  S->numStages = numStages;
+  S->pCoeffs = pCoeffs;
+  S->pState = pState;
+  S->postShift = (uint8_t)postShift;
+  memset(pState, 0, 4U * numStages * sizeof(q31_t));
+}
+
+// direct form I, 64-bit accumulator, no saturation of the result
+void arm_biquad_cascade_df1_q31(const arm_biquad_casd_df1_inst_q31* S, const q31_t* pSrc,
+                                q31_t* pDst, uint32_t blockSize){
+  const q31_t* coeffs = S->pCoeffs;
+  q31_t* state = S->pState;
+  uint32_t shift = 31U - S->postShift;
+  const q31_t* in = pSrc;
+
+  for (uint32_t stage = 0; stage < S->numStages; stage++){
+      q31_t b0 = coeffs[0];
+      q31_t b1 = coeffs[1];
+      q31_t b2 = coeffs[2];
+      q31_t a1 = coeffs[3];
+      q31_t a2 = coeffs[4];
+      q31_t x1 = state[0];
+      q31_t x2 = state[1];
+      q31_t y1 = state[2];
+      q31_t y2 = state[3];
+
+      for (uint32_t i = 0; i < blockSize; i++){
+          q31_t x0 = in[i];
+          q63_t acc = (q63_t)b0 * x0 + (q63_t)b1 * x1 + (q63_t)b2 * x2
+                    + (q63_t)a1 * y1 + (q63_t)a2 * y2;
+          q31_t y0 = (q31_t)(acc >> shift);
+          x2 = x1;
+          x1 = x0;
+          y2 = y1;
+          y1 = y0;
+          pDst[i] = y0;
+      }
+
+      state[0] = x1;
+      state[1] = x2;
+      state[2] = y1;
+      state[3] = y2;
+      coeffs += 5;
+      state += 4;
+      in = pDst; // later stages run in place on the output
+  }
+}
+
+void arm_mult_q15(const q15_t* pSrcA, const q15_t* pSrcB, q15_t* pDst, uint32_t blockSize){
+  for (uint32_t i = 0; i < blockSize; i++){
+      pDst[i] = (q15_t)ssat16(((q31_t)pSrcA[i] * pSrcB[i]) >> 15);
+  }
+}
+
+void arm_power_q15(const q15_t* pSrc, uint32_t blockSize, q63_t* pResult){
+  q63_t sum = 0;
+  for (uint32_t i = 0; i < blockSize; i++){
+      sum += (q31_t)pSrc[i] * pSrc[i];
+  }
+  *pResult = sum;
+}
+
+void arm_mean_q15(const q15_t* pSrc, uint32_t blockSize, q15_t* pResult){
+  q31_t sum = 0;
+  for (uint32_t i = 0; i < blockSize; i++){
+      sum += pSrc[i];
+  }
+  *pResult = (q15_t)(sum / (int32_t)blockSize);
+}
+
+void arm_rms_q15(const q15_t* pSrc, uint32_t blockSize, q15_t* pResult){
+  q63_t sum = 0;
+  for (uint32_t i = 0; i < blockSize; i++){
+      sum += (q31_t)pSrc[i] * pSrc[i];
+  }
+  arm_sqrt_q15((q15_t)ssat16((q31_t)((sum / (q63_t)blockSize) >> 15)), pResult);
+}
+
+void arm_max_q15(const q15_t* pSrc, uint32_t blockSize, q15_t* pResult, uint32_t* pIndex){
+  q15_t max = pSrc[0];
+  uint32_t index = 0;
+  for (uint32_t i = 1; i < blockSize; i++){
+      if (pSrc[i] > max){
+          max = pSrc[i];
+          index = i;
+      }
+  }
+  *pResult = max;
+  *pIndex = index;
+}
+
+void arm_min_q15(const q15_t* pSrc, uint32_t blockSize, q15_t* pResult, uint32_t* pIndex){
+  q15_t min = pSrc[0];
+  uint32_t index = 0;
+  for (uint32_t i = 1; i < blockSize; i++){
+      if (pSrc[i] < min){
+          min = pSrc[i];
+          index = i;
+      }
+  }
+  *pResult = min;
+  *pIndex = index;
+}
+
+arm_status arm_sqrt_q15(q15_t in, q15_t* pOut){
+  if (in <= 0){
+      *pOut = 0;
+      return (in < 0) ? ARM_MATH_ARGUMENT_ERROR : ARM_MATH_SUCCESS;
+  }
+  *pOut = (q15_t)isqrt64((uint64_t)in << 15);
+  return ARM_MATH_SUCCESS;
+}
+
+arm_status arm_sqrt_q31(q31_t in, q31_t* pOut){
+  if (in <= 0){
+      *pOut = 0;
+      return (in < 0) ? ARM_MATH_ARGUMENT_ERROR : ARM_MATH_SUCCESS;
+  }
+  *pOut = (q31_t)isqrt64((uint64_t)in << 31);
+  return ARM_MATH_SUCCESS;
+}
+
+#define SIM_RFFT_MAX 8192
+
+arm_status arm_rfft_init_q15(arm_rfft_instance_q15* S, uint32_t fftLenReal,
+                             uint32_t ifftFlagR, uint32_t bitReverseFlag){
+  memset(S, 0, sizeof(*S));
+  // the library supports 32 to 8192
+  if (fftLenReal < 32 || fftLenReal > SIM_RFFT_MAX || (fftLenReal & (fftLenReal - 1)) != 0){
+      return ARM_MATH_ARGUMENT_ERROR;
+  }
+  S->fftLenReal = fftLenReal;
+  S->ifftFlagR = (uint8_t)ifftFlagR;
+  S->bitReverseFlagR = (uint8_t)bitReverseFlag;
+  S->twidCoefRModifier = SIM_RFFT_MAX / fftLenReal;
+  return ARM_MATH_SUCCESS;
+}
+
+// forward transform only, output holds all N complex bins interleaved
+void arm_rfft_q15(const arm_rfft_instance_q15* S, q15_t* pSrc, q15_t* pDst){
+  static double re[SIM_RFFT_MAX];
+  static double im[SIM_RFFT_MAX];
+  static double twiddle_re[SIM_RFFT_MAX / 2];
+  static double twiddle_im[SIM_RFFT_MAX / 2];
+  static uint32_t twiddle_n = 0;
+  uint32_t n = S->fftLenReal;
+  uint32_t i;
+  uint32_t j = 0;
+
+  if (twiddle_n != n){
+      for (i = 0; i < n / 2; i++){
+          twiddle_re[i] = cos(-2.0 * M_PI * i / n);
+          twiddle_im[i] = sin(-2.0 * M_PI * i / n);
+      }
+      twiddle_n = n;
+  }
+
+  // bit reversed load
+  for (i = 0; i < n; i++){
+      re[j] = pSrc[i];
+      im[j] = 0.0;
+      uint32_t bit = n >> 1;
+      while (j & bit){
+          j ^= bit;
+          bit >>= 1;
+      }
+      j |= bit;
+  }
+
+  // iterative radix-2
+  for (uint32_t len = 2; len <= n; len <<= 1){
+      uint32_t step = n / len;
+      for (i = 0; i < n; i += len){
+          for (uint32_t k = 0; k < len / 2; k++){
+              double wr = twiddle_re[k * step];
+              double wi = twiddle_im[k * step];
+              uint32_t a = i + k;
+              uint32_t b = a + len / 2;
+              double tr = re[b] * wr - im[b] * wi;
+              double ti = re[b] * wi + im[b] * wr;
+              re[b] = re[a] - tr;
+              im[b] = im[a] - ti;
+              re[a] += tr;
+              im[a] += ti;
+          }
+      }
+  }
+
+  for (i = 0; i < n; i++){
+      pDst[2 * i] = (q15_t)ssat16((q31_t)(re[i] / n));
+      pDst[2 * i + 1] = (q15_t)ssat16((q31_t)(im[i] / n));
+  }
+}
+
+// log posteriors up to the shared evidence term, in single precision like
+// the library, which picks the class with arm_max_f32
+uint32_t arm_gaussian_naive_bayes_predict_f32(const arm_gaussian_naive_bayes_instance_f32* S,
+                                              const float32_t* in,
+                                              float32_t* pOutputProbabilities,
+                                              float32_t* pBufferB){
+  const float32_t* pTheta = S->theta;
+  const float32_t* pSigma = S->sigma;
+  uint32_t best = 0;
+
+  (void)pBufferB;
+  for (uint32_t c = 0; c < S->numberOfClasses; c++){
+      float32_t acc1 = 0.0f;
+      float32_t acc2 = 0.0f;
+      for (uint32_t d = 0; d < S->vectorDimension; d++){
+          float32_t sigma = *pSigma++ + S->epsilon;
+          float32_t diff = in[d] - *pTheta++;
+          acc1 += logf(2.0f * 3.14159265358979f * sigma);
+          acc2 += diff * diff / sigma;
+      }
+      pOutputProbabilities[c] = -0.5f * acc1 - 0.5f * acc2 + logf(S->classPriors[c]);
+      if (pOutputProbabilities[c] > pOutputProbabilities[best]){
+          best = c;
+      }
+  }
+  return best;
+}
@@ -0,0 +1,370 @@
+/***********************************************************************
+ * @file      sim_emlib.c
+ * @brief     Fake NVIC, CORE, CMU, GPIO, power manager and VCOM USART
+ *
+ * @author    Hyounjun Chang, hyounjun.chang@colorado.edu
+ * @date      Oct 16, 2026
+ *
+ * @resources
+ *
+ * Interrupts are only ever raised from virtual clock callbacks, so a
+ * handler never preempts firmware code. A handler raised from inside
+ * another handler stays pending until the outer one returns, the same
+ * tail-chaining order the NVIC would give for equal priorities.
+ *
+ */
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+
+#include "sim.h"
+#include "em_core.h"
+#include "em_cmu.h"
+#include "em_gpio.h"
+#include "sl_udelay.h"
+#include "app_log.h"
+
+sim_stats_t sim_stats;
+sim_options_t sim_options;
+
+// *********************************************************************
+// NVIC
+// *********************************************************************
+
+// firmware handlers, default to an empty handler if the firmware has none
+void __attribute__((weak)) GPIO_EVEN_IRQHandler(void) {}
+void __attribute__((weak)) GPIO_ODD_IRQHandler(void) {}
+void __attribute__((weak)) I2C0_IRQHandler(void) {}
+void __attribute__((weak)) LETIMER0_IRQHandler(void) {}
+void __attribute__((weak)) ADC0_IRQHandler(void) {}
+void __attribute__((weak)) LDMA_IRQHandler(void) {}
+
+static void (*const irq_handlers[SIM_IRQ_COUNT])(void) = {
+  [GPIO_EVEN_IRQn] = GPIO_EVEN_IRQHandler,
+  [I2C0_IRQn]      = I2C0_IRQHandler,
+  [GPIO_ODD_IRQn]  = GPIO_ODD_IRQHandler,
+  [LETIMER0_IRQn]  = LETIMER0_IRQHandler,
+  [ADC0_IRQn]      = ADC0_IRQHandler,
+  [LDMA_IRQn]      = LDMA_IRQHandler,
+};
+
+static bool irq_enabled[SIM_IRQ_COUNT];
+static bool irq_pending[SIM_IRQ_COUNT];
+static bool in_handler = false;
+static uint32_t handled_since_take = 0;
+
+static void irq_dispatch(){
+  bool ran = true;
+  if (in_handler){
+      return;
+  }
+  while (ran){
+      ran = false;
+      for (int i = 0; i < SIM_IRQ_COUNT; i++){
+          if (irq_pending[i] && irq_enabled[i]){
+              irq_pending[i] = false;
+              in_handler = true;
+              irq_handlers[i]();
+              in_handler = false;
+              sim_stats.irq_count[i]++;
+              handled_since_take++;
+              ran = true;
+          }
+      }
+  }
+}
+
+static void irq_dispatch_event(void* ctx){
+  (void)ctx;
+  irq_dispatch();
+}
+
+void sim_irq_raise(IRQn_Type irqn){
+  irq_pending[irqn] = true;
+  irq_dispatch();
+}
+
+uint32_t sim_irq_take_handled(){
+  uint32_t handled = handled_since_take;
+  handled_since_take = 0;
+  return handled;
+}
+
+void NVIC_EnableIRQ(IRQn_Type irqn){
+  irq_enabled[irqn] = true;
+  if (irq_pending[irqn]){
+      // taken once the firmware code that enabled it returns to the loop
+      sim_clock_schedule(sim_clock_now_ns(), irq_dispatch_event, NULL);
+  }
+}
+
+void NVIC_DisableIRQ(IRQn_Type irqn){
+  irq_enabled[irqn] = false;
+}
+
+void NVIC_ClearPendingIRQ(IRQn_Type irqn){
+  irq_pending[irqn] = false;
+}
+
+void NVIC_SetPendingIRQ(IRQn_Type irqn){
+  irq_pending[irqn] = true;
+  sim_clock_schedule(sim_clock_now_ns(), irq_dispatch_event, NULL);
+}
+
+uint32_t NVIC_GetEnableIRQ(IRQn_Type irqn){
+  return irq_enabled[irqn] ? 1 : 0;
+}
+
+// *********************************************************************
+// CORE
+// *********************************************************************
+static uint32_t critical_depth = 0;
+
+CORE_irqState_t sim_core_enter_critical(){
+  return critical_depth++;
+}
+
+void sim_core_exit_critical(CORE_irqState_t irqState){
+  critical_depth = irqState;
+}
+
+void sl_udelay_wait(unsigned us){
+  (void)us;
+}
+
+// *********************************************************************
+// CMU, only what decides the LETIMER0 tick rate
+// *********************************************************************
+#define SIM_LFXO_FREQ   32768
+#define SIM_ULFRCO_FREQ 1000
+
+static uint32_t lfa_freq = SIM_LFXO_FREQ;
+static uint32_t letimer_div = 1;
+
+void CMU_ClockEnable(CMU_Clock_TypeDef clock, bool enable){
+  (void)clock;
+  (void)enable;
+}
+
+void CMU_ClockDivSet(CMU_Clock_TypeDef clock, CMU_ClkDiv_TypeDef div){
+  if (clock == cmuClock_LETIMER0){
+      letimer_div = (uint32_t)div;
+  }
+}
+
+void CMU_ClockSelectSet(CMU_Clock_TypeDef clock, CMU_Select_TypeDef ref){
+  if (clock == cmuClock_LFA){
+      lfa_freq = (ref == cmuSelect_ULFRCO) ? SIM_ULFRCO_FREQ : SIM_LFXO_FREQ;
+  }
+}
+
+void CMU_OscillatorEnable(CMU_Osc_TypeDef osc, bool enable, bool wait){
+  (void)osc;
+  (void)enable;
+  (void)wait;
+}
+
+void CMU_LFXOInit(const CMU_LFXOInit_TypeDef* init){
+  (void)init;
+}
+
+uint32_t CMU_ClockFreqGet(CMU_Clock_TypeDef clock){
+  if (clock == cmuClock_LETIMER0){
+      return sim_letimer_freq();
+  }
+  return 19000000;
+}
+
+uint32_t sim_letimer_freq(){
+  return lfa_freq / letimer_div;
+}
+
+// *********************************************************************
+// power manager
+// *********************************************************************
+static int32_t em_requirements[4];
+
+void sl_power_manager_add_em_requirement(sl_power_manager_em_t em){
+  em_requirements[em]++;
+}
+
+void sl_power_manager_remove_em_requirement(sl_power_manager_em_t em){
+  if (em_requirements[em] == 0){
+      // the real service asserts here
+      sim_stats.pm_errors++;
+      fprintf(stderr, "sim: power manager EM%d requirement removed while not held\n", (int)em);
+      return;
+  }
+  em_requirements[em]--;
+}
+
+// EM2 is the floor, the Bluetooth stack never lets the MCU into EM3
+sl_power_manager_em_t sim_power_lowest_em(){
+  if (em_requirements[SL_POWER_MANAGER_EM0] > 0){
+      return SL_POWER_MANAGER_EM0;
+  }
+  if (em_requirements[SL_POWER_MANAGER_EM1] > 0){
+      return SL_POWER_MANAGER_EM1;
+  }
+  return SL_POWER_MANAGER_EM2;
+}
+
+// *********************************************************************
+// GPIO
+// *********************************************************************
+#define SIM_GPIO_PINS 16
+#define SIM_GPIO_EXTINT 16
+
+typedef struct {
+  GPIO_Mode_TypeDef mode;
+  unsigned int dout;
+  unsigned int din;
+} sim_pin_t;
+
+typedef struct {
+  bool configured;
+  GPIO_Port_TypeDef port;
+  unsigned int pin;
+  bool rising;
+  bool falling;
+} sim_extint_t;
+
+static sim_pin_t pins[SIM_GPIO_PORT_COUNT][SIM_GPIO_PINS];
+static sim_extint_t extints[SIM_GPIO_EXTINT];
+static uint32_t gpio_ien = 0;
+static uint32_t gpio_if = 0;
+
+static void gpio_raise(){
+  if (gpio_if & gpio_ien & 0x5555){
+      sim_irq_raise(GPIO_EVEN_IRQn);
+  }
+  if (gpio_if & gpio_ien & 0xAAAA){
+      sim_irq_raise(GPIO_ODD_IRQn);
+  }
+}
+
+void GPIO_DriveStrengthSet(GPIO_Port_TypeDef port, GPIO_DriveStrength_TypeDef strength){
+  (void)port;
+  (void)strength;
+}
+
+// the I2C bus clear and the Si7021 supply follow output levels
+static void gpio_output_changed(GPIO_Port_TypeDef port, unsigned int pin, unsigned int level){
+  sim_i2c_gpio_output(port, pin, level);
+  sim_si7021_gpio_output(port, pin, level);
+}
+
+void GPIO_PinModeSet(GPIO_Port_TypeDef port, unsigned int pin, GPIO_Mode_TypeDef mode, unsigned int out){
+  pins[port][pin].mode = mode;
+  pins[port][pin].dout = out ? 1 : 0;
+  // input with DOUT = 1 has the pull-up enabled, idle level is high
+  if (mode == gpioModeInput || mode == gpioModeInputPull || mode == gpioModeInputPullFilter){
+      pins[port][pin].din = out ? 1 : 0;
+  }
+  gpio_output_changed(port, pin, pins[port][pin].dout);
+}
+
+void GPIO_PinOutSet(GPIO_Port_TypeDef port, unsigned int pin){
+  pins[port][pin].dout = 1;
+  gpio_output_changed(port, pin, 1);
+}
+
+void GPIO_PinOutClear(GPIO_Port_TypeDef port, unsigned int pin){
+  pins[port][pin].dout = 0;
+  gpio_output_changed(port, pin, 0);
+}
+
+void GPIO_PinOutToggle(GPIO_Port_TypeDef port, unsigned int pin){
+  pins[port][pin].dout ^= 1;
+  gpio_output_changed(port, pin, pins[port][pin].dout);
+}
+
+unsigned int GPIO_PinOutGet(GPIO_Port_TypeDef port, unsigned int pin){
+  return pins[port][pin].dout;
+}
+
+unsigned int GPIO_PinInGet(GPIO_Port_TypeDef port, unsigned int pin){
+  if (pins[port][pin].mode == gpioModePushPull){
+      return pins[port][pin].dout;
+  }
+  return pins[port][pin].din;
+}
+
+void GPIO_ExtIntConfig(GPIO_Port_TypeDef port, unsigned int pin, unsigned int intNo,
+                       bool risingEdge, bool fallingEdge, bool enable){
+  extints[intNo].configured = true;
+  extints[intNo].port = port;
+  extints[intNo].pin = pin;
+  extints[intNo].rising = risingEdge;
+  extints[intNo].falling = fallingEdge;
+  gpio_if &= ~(1UL << intNo);
+  if (enable){
+      gpio_ien |= (1UL << intNo);
+  }
+  else{
+      gpio_ien &= ~(1UL << intNo);
+  }
+}
+
+void GPIO_IntClear(uint32_t flags){
+  gpio_if &= ~flags;
+}
+
+void GPIO_IntEnable(uint32_t flags){
+  gpio_ien |= flags;
+  gpio_raise();
+}
+
+void GPIO_IntDisable(uint32_t flags){
+  gpio_ien &= ~flags;
+}
+
+uint32_t GPIO_IntGet(){
+  return gpio_if;
+}
+
+uint32_t GPIO_IntGetEnabled(){
+  return gpio_if & gpio_ien;
+}
+
+void sim_gpio_drive_input(GPIO_Port_TypeDef port, unsigned int pin, unsigned int level){
+  level = level ? 1 : 0;
+  unsigned int old = pins[port][pin].din;
+  pins[port][pin].din = level;
+  if (old == level){
+      return;
+  }
+  for (int i = 0; i < SIM_GPIO_EXTINT; i++){
+      sim_extint_t* ext = &extints[i];
+      if (!ext->configured || ext->port != port || ext->pin != pin){
+          continue;
+      }
+      if ((level && ext->rising) || (!level && ext->falling)){
+          gpio_if |= (1UL << i);
+      }
+  }
+  gpio_raise();
+}
+
+unsigned int sim_gpio_output(GPIO_Port_TypeDef port, unsigned int pin){
+  return pins[port][pin].dout;
+}
+
+// *********************************************************************
+// VCOM USART, sink for app_log()
+// *********************************************************************
+int sim_usart_printf(const char* format, ...){
+  char line[256];
+  va_list va;
+  va_start(va, format);
+  int len = vsnprintf(line, sizeof(line), format, va);
+  va_end(va);
+  if (len < 0){
+      return len;
+  }
+  sim_stats.usart_bytes += (uint64_t)len;
+  if (sim_options.log){
+      fputs(line, stdout);
+  }
+  return len;
+}
@@ -0,0 +1,195 @@
+/***********************************************************************
+ * @file      sim_env.c
+ * @brief     Study space environment model: occupancy, light, sound and climate
+ *
+ * @author    Hyounjun Chang, hyounjun.chang@colorado.edu
+ * @date      Oct 16, 2026
+ *
+ * @resources SparkFun Sound Detector (SEN-12642) hookup guide
+ *
+ * Every value is a pure function of virtual time and the seed, so a
+ * sensor can be sampled at any instant and two runs with the same seed
+ * see exactly the same room. Random variation comes from hashing the
+ * seed with the index of a time slot instead of a stateful PRNG.
+ *
+ * The sound detector has an AUDIO output (microphone amplifier, biased
+ * at mid-supply) and an ENVELOPE output (rectified, low passed AUDIO).
+ * ENVELOPE is wired to PF3 (APORT2XCH19), AUDIO to PF4 (APORT2XCH20).
+ *
+ */
+#include <math.h>
+
+#include "sim.h"
+#include "src/em_adc.h"
+
+#define TWO_PI 6.283185307179586
+
+#define AUDIO_BIAS_MV     1250.0
+#define ENVELOPE_GAIN     1.5
+#define NOISE_FLOOR_MV    3.0
+#define SPEECH_F0_HZ      140.0
+#define SPEECH_MAX_HZ     3400.0
+
+typedef struct {
+  double start;
+  double end;
+} hour_range_t;
+
+// hours of the day the space is in use
+static const hour_range_t occupied_hours[] = {
+  { 8.5, 11.75 },
+  { 13.0, 17.5 },
+  { 19.0, 21.5 },
+};
+
+// ventilation runs all day, fans go to high during the afternoon
+static const hour_range_t hvac_hours = { 7.0, 22.0 };
+static const hour_range_t hvac_high_hours = { 12.5, 15.0 };
+
+static uint32_t env_seed = 1;
+static double env_start_hour = 0.0;
+
+static uint64_t splitmix64(uint64_t x){
+  x += 0x9E3779B97F4A7C15ULL;
+  x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+  return x ^ (x >> 31);
+}
+
+// uniform [0, 1) for a (stream, slot) pair
+static double hash_uniform(uint32_t stream, uint64_t slot){
+  uint64_t h = splitmix64(((uint64_t)env_seed << 32) ^ ((uint64_t)stream << 56) ^ slot);
+  return (double)(h >> 11) / 9007199254740992.0;
+}
+
+static bool in_range(const hour_range_t* r, double hour){
+  return hour >= r->start && hour < r->end;
+}
+
+void sim_env_init(uint32_t seed, double start_hour){
+  env_seed = seed;
+  env_start_hour = start_hour;
+}
+
+double sim_env_hour_of_day(uint64_t t_ns){
+  return fmod(env_start_hour + (double)t_ns / (3600.0 * SIM_NS_PER_SEC), 24.0);
+}
+
+bool sim_env_occupied(uint64_t t_ns){
+  double hour = sim_env_hour_of_day(t_ns);
+  for (unsigned int i = 0; i < sizeof(occupied_hours) / sizeof(occupied_hours[0]); i++){
+      if (in_range(&occupied_hours[i], hour)){
+          return true;
+      }
+  }
+  return false;
+}
+
+// daylight through a window peaks above the 1888 lux range of the default
+// VEML6030 setting, plus desk lamps while occupied
+double sim_env_lux(uint64_t t_ns){
+  double hour = sim_env_hour_of_day(t_ns);
+  double lux = 0.01;
+  if (hour > 6.0 && hour < 20.0){
+      double clouds = 0.8 + 0.2 * hash_uniform(1, t_ns / (600 * SIM_NS_PER_SEC));
+      lux += 2600.0 * pow(sin(M_PI * (hour - 6.0) / 14.0), 1.5) * clouds;
+  }
+  if (sim_env_occupied(t_ns)){
+      lux += 320.0;
+  }
+  return lux;
+}
+
+// heating follows the day, warmest mid afternoon, people add a little
+// gradually. Smooth, so a reading every 30 s tracks it.
+double sim_env_temperature_c(uint64_t t_ns){
+  double hour = sim_env_hour_of_day(t_ns);
+  double t = 21.0 + 1.5 * sin(TWO_PI * (hour - 9.0) / 24.0);
+  t += 0.3 * sin(TWO_PI * hour / 3.0 + env_seed);
+  return t;
+}
+
+// relative humidity drops as the room warms up
+double sim_env_humidity_pct(uint64_t t_ns){
+  double hour = sim_env_hour_of_day(t_ns);
+  double rh = 45.0 - 6.0 * sin(TWO_PI * (hour - 9.0) / 24.0);
+  rh += 2.0 * sin(TWO_PI * hour / 5.0 + 2.0 * env_seed);
+  return rh;
+}
+
+static double hvac_level(uint64_t t_ns){
+  double hour = sim_env_hour_of_day(t_ns);
+  if (in_range(&hvac_high_hours, hour)){
+      return 2.0;
+  }
+  if (in_range(&hvac_hours, hour)){
+      return 1.0;
+  }
+  return 0.0;
+}
+
+// speech amplitude in mV, 0 when nobody is talking. Conversations are
+// decided per minute, talk spurts per 400 ms slot.
+static double speech_amplitude_mv(uint64_t t_ns){
+  if (!sim_env_occupied(t_ns)){
+      return 0.0;
+  }
+  if (hash_uniform(2, t_ns / (60 * SIM_NS_PER_SEC)) > 0.5){
+      return 0.0;
+  }
+  uint64_t slot = t_ns / (400 * SIM_NS_PER_MS);
+  if (hash_uniform(3, slot) > 0.6){
+      return 0.0;
+  }
+  return 60.0 + 120.0 * hash_uniform(4, slot);
+}
+
+double sim_env_sound_audio_mv(uint64_t t_ns){
+  double t = (double)t_ns / SIM_NS_PER_SEC;
+  double mv = AUDIO_BIAS_MV;
+
+  // broadband floor, a fresh value every 50 us
+  mv += NOISE_FLOOR_MV * 1.732 * (2.0 * hash_uniform(5, t_ns / (50 * SIM_NS_PER_US)) - 1.0);
+
+  // ventilation rumble
+  double hvac = hvac_level(t_ns);
+  if (hvac > 0.0){
+      mv += hvac * (50.0 * sin(TWO_PI * 120.0 * t) + 25.0 * sin(TWO_PI * 180.0 * t + 1.0));
+  }
+
+  // voiced speech, harmonics of F0 up to the telephone band edge,
+  // weighted towards the 500 - 2000 Hz formant region, 4 Hz syllable rate
+  double speech = speech_amplitude_mv(t_ns);
+  if (speech > 0.0){
+      double voiced = 0.0;
+      for (int k = 2; k * SPEECH_F0_HZ < SPEECH_MAX_HZ; k++){
+          double f = k * SPEECH_F0_HZ;
+          double w = (f > 500.0 && f < 2000.0) ? 1.0 : 0.4;
+          voiced += w * sin(TWO_PI * f * t + k);
+      }
+      mv += speech * (0.5 + 0.5 * sin(TWO_PI * 4.0 * t)) * voiced / 6.0;
+  }
+  return mv;
+}
+
+// envelope follows the RMS of the AC part of AUDIO
+double sim_env_sound_envelope_mv(uint64_t t_ns){
+  double hvac = hvac_level(t_ns);
+  double power = NOISE_FLOOR_MV * NOISE_FLOOR_MV;
+  power += hvac * hvac * (50.0 * 50.0 + 25.0 * 25.0) / 2.0;
+  double speech = speech_amplitude_mv(t_ns);
+  power += speech * speech / 2.0;
+  double ripple = 1.0 + 0.05 * (2.0 * hash_uniform(6, t_ns / (10 * SIM_NS_PER_MS)) - 1.0);
+  return ENVELOPE_GAIN * sqrt(power) * ripple;
+}
+
+double sim_env_adc_input_mv(uint32_t pos_sel, uint64_t t_ns){
+  switch (pos_sel){
+    case adcPosSelAPORT2XCH19:
+      return sim_env_sound_envelope_mv(t_ns);
+    case adcPosSelAPORT2XCH20:
+      return sim_env_sound_audio_mv(t_ns);
+    default:
+      return 0.0;
+  }
+}
@@ -0,0 +1,275 @@
+/***********************************************************************
+ * @file      sim_i2c.c
+ * @brief     Fake I2C0 and I2CSPM with attachable device models
+ *
+ * @author    Hyounjun Chang, hyounjun.chang@colorado.edu
+ * @date      Oct 16, 2026
+ *
+ * @resources
+ *
+ * I2C_TransferInit() puts the whole sequence on the wire at once and
+ * raises a single I2C0 IRQ when the bus time for it has passed, after
+ * which I2C_Transfer() reports the result. I2CSPM_Transfer() completes
+ * immediately, the firmware only uses it during init.
+ *
+ * With --i2c-faults a transfer may be NACKed, lose arbitration or leave a
+ * slave holding SDA low. A stuck bus completes no transfer until SCL has
+ * been clocked enough times by hand (GPIO) for the slave to let go.
+ * With --i2c-outage-at every transfer from then on loses arbitration, until
+ * one request has failed all its retries.
+ *
+ */
+#include <string.h>
+
+#include "sim.h"
+#include "em_i2c.h"
+#include "sl_i2cspm.h"
+#include "src/i2c_queue.h"
+
+#define SIM_I2C_MAX_DEVICES 4
+#define SIM_I2C_BUS_HZ      92000
+#define SIM_I2C_MAX_WRITE   32
+#define SIM_I2C_OUTAGE_SEQS 8   // requests told apart during an outage
+
+// pins from I2CSPM_Init(), and the stuck slave
+static struct {
+  GPIO_Port_TypeDef scl_port;
+  unsigned int scl_pin;
+  GPIO_Port_TypeDef sda_port;
+  unsigned int sda_pin;
+  bool configured;
+  bool stuck;
+  uint32_t clocks_to_release;  // SCL rising edges until SDA is let go
+  uint32_t rng;
+  // --i2c-outage-at, the requests that failed in it and how often
+  bool outage_over;
+  const I2C_TransferSeq_TypeDef* outage_seqs[SIM_I2C_OUTAGE_SEQS];
+  uint32_t outage_attempts[SIM_I2C_OUTAGE_SEQS];
+} bus;
+
+I2C_TypeDef sim_i2c0;
+
+static sim_i2c_device_t devices[SIM_I2C_MAX_DEVICES];
+static uint32_t num_devices = 0;
+
+void sim_i2c_attach(const sim_i2c_device_t* dev){
+  devices[num_devices++] = *dev;
+}
+
+static sim_i2c_device_t* find_device(uint16_t addr){
+  for (uint32_t i = 0; i < num_devices; i++){
+      if (devices[i].addr == (addr >> 1)){
+          return &devices[i];
+      }
+  }
+  return NULL;
+}
+
+static uint32_t bus_random(){
+  // xorshift32
+  bus.rng ^= bus.rng << 13;
+  bus.rng ^= bus.rng >> 17;
+  bus.rng ^= bus.rng << 5;
+  return bus.rng;
+}
+
+static double bus_uniform(){
+  return (bus_random() >> 8) / (double)(1 << 24);
+}
+
+static void bus_set_stuck(bool stuck){
+  bus.stuck = stuck;
+  if (bus.configured){
+      sim_gpio_drive_input(bus.sda_port, bus.sda_pin, stuck ? 0 : 1);
+  }
+}
+
+bool sim_i2c_bus_stuck(){
+  return bus.stuck;
+}
+
+void sim_i2c_gpio_output(GPIO_Port_TypeDef port, unsigned int pin, unsigned int level){
+  if (!bus.stuck || !bus.configured || port != bus.scl_port || pin != bus.scl_pin || !level){
+      return;
+  }
+  if (--bus.clocks_to_release == 0){
+      bus_set_stuck(false);
+  }
+}
+
+// true while the outage lasts, it ends once one sequence failed its first
+// attempt and all its retries. Others queued meanwhile have retries left.
+static bool bus_in_outage(const I2C_TransferSeq_TypeDef* seq){
+  uint32_t i;
+  if (sim_options.i2c_outage_at_s < 0.0 || bus.outage_over ||
+      sim_clock_now_ns() < (uint64_t)(sim_options.i2c_outage_at_s * SIM_NS_PER_SEC)){
+      return false;
+  }
+  for (i = 0; i < SIM_I2C_OUTAGE_SEQS - 1 && bus.outage_seqs[i] && bus.outage_seqs[i] != seq; i++){
+  }
+  bus.outage_seqs[i] = seq;
+  if (++bus.outage_attempts[i] > I2C_REQUEST_MAX_RETRIES){
+      bus.outage_over = true;
+  }
+  return true;
+}
+
+// false if the fault takes the transfer off the bus, ret has its result
+static bool bus_inject_fault(const I2C_TransferSeq_TypeDef* seq, I2C_TransferReturn_TypeDef* ret){
+  double r;
+  if (bus_in_outage(seq)){
+      sim_stats.i2c_faults++;
+      *ret = i2cTransferArbLost;
+      return true;
+  }
+  if (sim_options.i2c_fault_rate <= 0.0 || bus_uniform() >= sim_options.i2c_fault_rate){
+      return false;
+  }
+  sim_stats.i2c_faults++;
+  r = bus_uniform();
+  if (r < 0.6){
+      sim_stats.i2c_nacks++;
+      *ret = i2cTransferNack;
+  }
+  else if (r < 0.8){
+      *ret = i2cTransferArbLost;
+  }
+  else{
+      // the slave stops in the middle of a byte, up to 9 clocks from its end
+      sim_stats.i2c_bus_stuck++;
+      bus.clocks_to_release = 1 + bus_random() % 9;
+      bus_set_stuck(true);
+      *ret = i2cTransferBusErr;
+  }
+  return true;
+}
+
+// run the sequence against the device model
+static I2C_TransferReturn_TypeDef bus_execute(I2C_TransferSeq_TypeDef* seq){
+  sim_i2c_device_t* dev = find_device(seq->addr);
+  I2C_TransferReturn_TypeDef ret;
+  uint8_t joined[SIM_I2C_MAX_WRITE];
+
+  sim_stats.i2c_transfers++;
+  if (bus.stuck){
+      return i2cTransferBusErr;
+  }
+  if (bus_inject_fault(seq, &ret)){
+      return ret;
+  }
+  if (dev == NULL){
+      sim_stats.i2c_nacks++;
+      return i2cTransferNack;
+  }
+
+  switch (seq->flags){
+    case I2C_FLAG_WRITE:
+      ret = dev->write(dev->ctx, seq->buf[0].data, seq->buf[0].len);
+      break;
+    case I2C_FLAG_READ:
+      ret = dev->read(dev->ctx, seq->buf[0].data, seq->buf[0].len);
+      break;
+    case I2C_FLAG_WRITE_READ:
+      ret = dev->write(dev->ctx, seq->buf[0].data, seq->buf[0].len);
+      if (ret == i2cTransferDone){
+          ret = dev->read(dev->ctx, seq->buf[1].data, seq->buf[1].len);
+      }
+      break;
+    case I2C_FLAG_WRITE_WRITE:
+      if (seq->buf[0].len + seq->buf[1].len > SIM_I2C_MAX_WRITE){
+          return i2cTransferUsageFault;
+      }
+      memcpy(joined, seq->buf[0].data, seq->buf[0].len);
+      memcpy(&joined[seq->buf[0].len], seq->buf[1].data, seq->buf[1].len);
+      ret = dev->write(dev->ctx, joined, seq->buf[0].len + seq->buf[1].len);
+      break;
+    default:
+      ret = i2cTransferUsageFault;
+      break;
+  }
+  if (ret == i2cTransferNack){
+      sim_stats.i2c_nacks++;
+  }
+  return ret;
+}
+
+// 9 clocks per byte plus start, repeated start and stop
+static uint64_t transfer_duration_ns(const I2C_TransferSeq_TypeDef* seq){
+  uint32_t bytes = 1 + seq->buf[0].len;
+  uint32_t bits = 2;
+  if (seq->flags == I2C_FLAG_WRITE_READ || seq->flags == I2C_FLAG_WRITE_WRITE){
+      bytes += 1 + seq->buf[1].len;
+      bits += 1;
+  }
+  bits += bytes * 9;
+  return (uint64_t)bits * SIM_NS_PER_SEC / SIM_I2C_BUS_HZ;
+}
+
+static void transfer_done_event(void* ctx){
+  I2C_TypeDef* i2c = ctx;
+  i2c->event = 0;
+  i2c->result = bus_execute(i2c->seq);
+  // with SDA held low the controller never gets past the start condition
+  if (bus.stuck){
+      return;
+  }
+  i2c->complete = true;
+  sim_irq_raise(I2C0_IRQn);
+}
+
+void I2C_Reset(I2C_TypeDef* i2c){
+  if (i2c->event){
+      sim_clock_cancel(i2c->event);
+      i2c->event = 0;
+  }
+  i2c->busy = false;
+  i2c->complete = false;
+}
+
+I2C_TransferReturn_TypeDef I2C_TransferInit(I2C_TypeDef* i2c, I2C_TransferSeq_TypeDef* seq){
+  if (i2c->busy){
+      // the hardware would abort the transfer in flight and start over
+      sim_stats.i2c_collisions++;
+      sim_clock_cancel(i2c->event);
+  }
+  i2c->seq = seq;
+  i2c->busy = true;
+  i2c->complete = false;
+  i2c->event = sim_clock_schedule(sim_clock_now_ns() + transfer_duration_ns(seq),
+                                  transfer_done_event, i2c);
+  return i2cTransferInProgress;
+}
+
+I2C_TransferReturn_TypeDef I2C_Transfer(I2C_TypeDef* i2c){
+  if (i2c->busy && !i2c->complete){
+      return i2cTransferInProgress;
+  }
+  i2c->busy = false;
+  i2c->complete = false;
+  return i2c->result;
+}
+
+uint32_t I2C_BusFreqGet(I2C_TypeDef* i2c){
+  (void)i2c;
+  return SIM_I2C_BUS_HZ;
+}
+
+void I2CSPM_Init(I2CSPM_Init_TypeDef* init){
+  bus.scl_port = init->sclPort;
+  bus.scl_pin = init->sclPin;
+  bus.sda_port = init->sdaPort;
+  bus.sda_pin = init->sdaPin;
+  if (!bus.configured){
+      bus.rng = 0x9E3779B9u ^ (sim_options.seed * 2654435761u);
+  }
+  bus.configured = true;
+  init->port->ROUTEPEN = 1;
+  // both lines pulled up, SDA low only while a slave holds it
+  sim_gpio_drive_input(bus.scl_port, bus.scl_pin, 1);
+  sim_gpio_drive_input(bus.sda_port, bus.sda_pin, bus.stuck ? 0 : 1);
+}
+
+I2C_TransferReturn_TypeDef I2CSPM_Transfer(I2C_TypeDef* i2c, I2C_TransferSeq_TypeDef* seq){
+  (void)i2c;
+  return bus_execute(seq);
+}
@@ -0,0 +1,77 @@
+/***********************************************************************
+ * @file      sim_lcd.c
+ * @brief     Fake GLIB/DMD memory LCD keeping one string per text row
+ *
+ * @author    Hyounjun Chang, hyounjun.chang@colorado.edu
+ * @date      Oct 16, 2026
+ *
+ * @resources
+ *
+ *
+ */
+#include <stdio.h>
+#include <string.h>
+
+#include "sim.h"
+#include "glib.h"
+#include "dmd.h"
+
+#define SIM_LCD_ROWS    13
+#define SIM_LCD_ROW_LEN 20
+
+const GLIB_Font_t GLIB_FontNarrow6x8 = { 6, 8 };
+
+static char rows[SIM_LCD_ROWS][SIM_LCD_ROW_LEN + 1];
+
+EMSTATUS GLIB_contextInit(GLIB_Context_t* context){
+  memset(context, 0, sizeof(*context));
+  return GLIB_OK;
+}
+
+EMSTATUS GLIB_clear(GLIB_Context_t* context){
+  (void)context;
+  memset(rows, 0, sizeof(rows));
+  return GLIB_OK;
+}
+
+EMSTATUS GLIB_setFont(GLIB_Context_t* context, GLIB_Font_t* font){
+  context->font = font;
+  return GLIB_OK;
+}
+
+EMSTATUS GLIB_drawStringOnLine(GLIB_Context_t* context, const char* str, uint8_t line,
+                               GLIB_Align_t align, int32_t xOffset, int32_t yOffset,
+                               bool opaque){
+  (void)context;
+  (void)align;
+  (void)xOffset;
+  (void)yOffset;
+  (void)opaque;
+  if (line >= SIM_LCD_ROWS){
+      return 1;
+  }
+  snprintf(rows[line], sizeof(rows[line]), "%s", str);
+  return GLIB_OK;
+}
+
+EMSTATUS DMD_init(void* initConfig){
+  (void)initConfig;
+  return DMD_OK;
+}
+
+EMSTATUS DMD_updateDisplay(void){
+  sim_stats.lcd_updates++;
+  return DMD_OK;
+}
+
+const char* sim_lcd_row(unsigned int row){
+  return row < SIM_LCD_ROWS ? rows[row] : "";
+}
+
+void sim_lcd_dump(){
+  printf("+----------------------+\n");
+  for (int i = 0; i < SIM_LCD_ROWS; i++){
+      printf("| %-20s |\n", rows[i]);
+  }
+  printf("+----------------------+\n");
+}
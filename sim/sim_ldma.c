@@ -0,0 +1,213 @@
+/***********************************************************************
+ * @file      sim_ldma.c
+ * @brief     Simulated LDMA for ADC0 single conversions paced by PRS
+ *
+ * @author    Hyounjun Chang, hyounjun.chang@colorado.edu
+ * @date      Oct 16, 2026
+ *
+ * @resources EFR32xG13 reference manual, LDMA chapter
+ *
+ * A channel requested by ADC0_SINGLE moves one sample per ADC trigger.
+ * When the ADC is triggered from a PRS channel carrying TIMER0 overflow,
+ * sample n is taken at TIMER0 overflow n, so the whole descriptor is
+ * filled in one go when it completes instead of one clock event per
+ * sample. Any change to the pacing chain settles the samples taken so far
+ * first, so stopping the timer half way through a buffer leaves exactly
+ * the samples the hardware would have written.
+ *
+ */
+#include <string.h>
+
+#include "sim.h"
+#include "em_ldma.h"
+#include "src/em_adc.h"
+
+typedef struct {
+  bool active;
+  uint32_t reqsel;
+  const LDMA_Descriptor_t* desc;
+  uint32_t done;        // units written into desc
+  uint32_t remaining;   // units left in desc
+  bool paced;
+  uint64_t base_ovf;    // TIMER0 overflows already turned into samples
+  sim_event_handle_t event;
+} ldma_channel_t;
+
+static ldma_channel_t channels[DMA_CHAN_COUNT];
+static uint32_t ldma_if = 0;
+static uint32_t ldma_ien = 0;
+static uint32_t settle_depth = 0;
+
+static void raise_event(void* ctx){
+  (void)ctx;
+  if (ldma_if & ldma_ien){
+      sim_irq_raise(LDMA_IRQn);
+  }
+}
+
+static bool is_paced(const ldma_channel_t* chan){
+  unsigned int prs_ch;
+  return chan->active &&
+         chan->reqsel == ldmaPeripheralSignal_ADC0_SINGLE &&
+         sim_adc_prs_channel(&prs_ch) &&
+         sim_prs_is_timer0_overflow(prs_ch) &&
+         sim_timer0_running();
+}
+
+static void write_unit(const LDMA_Descriptor_t* desc, uint32_t index, uint32_t value){
+  uint8_t* dst = (uint8_t*)desc->xfer.dstAddr;
+  switch (desc->xfer.size){
+    case ldmaCtrlSizeByte:
+      dst[index] = (uint8_t)value;
+      break;
+    case ldmaCtrlSizeHalf:
+      ((uint16_t*)dst)[index] = (uint16_t)value;
+      break;
+    default:
+      ((uint32_t*)dst)[index] = value;
+      break;
+  }
+}
+
+// descriptor finished, raise its done flag and follow the link
+static void descriptor_done(int ch){
+  ldma_channel_t* chan = &channels[ch];
+  const LDMA_Descriptor_t* desc = chan->desc;
+  if (desc->xfer.doneIfs){
+      ldma_if |= 1u << ch;
+      // taken once the code that caused this returns to the loop
+      sim_clock_schedule(sim_clock_now_ns(), raise_event, NULL);
+  }
+  if (desc->xfer.link){
+      // relative link, counted in words like the hardware
+      chan->desc = desc + desc->xfer.linkAddr / LDMA_DESCRIPTOR_NON_EXTEND_SIZE_WORD;
+      chan->done = 0;
+      chan->remaining = chan->desc->xfer.xferCnt + 1;
+  }
+  else{
+      chan->active = false;
+  }
+}
+
+// turn every TIMER0 overflow up to now into a sample
+static void settle(int ch){
+  ldma_channel_t* chan = &channels[ch];
+  uint64_t now = sim_clock_now_ns();
+  uint64_t due;
+
+  if (!chan->paced){
+      return;
+  }
+  due = sim_timer0_overflows(now);
+  while (chan->active && chan->base_ovf < due){
+      uint64_t n = chan->base_ovf + 1;
+      uint32_t code = sim_adc_sample_code(sim_timer0_overflow_ns(n));
+      write_unit(chan->desc, chan->done, code);
+      chan->base_ovf = n;
+      chan->done++;
+      chan->remaining--;
+      if (chan->remaining == 0){
+          descriptor_done(ch);
+      }
+  }
+}
+
+static void completion_event(void* ctx);
+
+static void reschedule(int ch){
+  ldma_channel_t* chan = &channels[ch];
+  if (chan->event){
+      sim_clock_cancel(chan->event);
+      chan->event = 0;
+  }
+  chan->paced = is_paced(chan);
+  if (!chan->paced){
+      return;
+  }
+  chan->base_ovf = sim_timer0_overflows(sim_clock_now_ns());
+  chan->event = sim_clock_schedule(sim_timer0_overflow_ns(chan->base_ovf + chan->remaining),
+                                   completion_event, (void*)(intptr_t)ch);
+}
+
+static void completion_event(void* ctx){
+  int ch = (int)(intptr_t)ctx;
+  channels[ch].event = 0;
+  settle(ch);
+  reschedule(ch);
+}
+
+void sim_ldma_pacing_changing(){
+  if (settle_depth++ > 0){
+      return;
+  }
+  for (int ch = 0; ch < DMA_CHAN_COUNT; ch++){
+      settle(ch);
+  }
+}
+
+void sim_ldma_pacing_changed(){
+  if (--settle_depth > 0){
+      return;
+  }
+  for (int ch = 0; ch < DMA_CHAN_COUNT; ch++){
+      reschedule(ch);
+  }
+}
+
+void LDMA_Init(const LDMA_Init_t* init){
+  (void)init;
+  memset(channels, 0, sizeof(channels));
+  ldma_if = 0;
+  ldma_ien = LDMA_IF_ERROR;
+  NVIC_ClearPendingIRQ(LDMA_IRQn);
+  NVIC_EnableIRQ(LDMA_IRQn);
+}
+
+void LDMA_StartTransfer(int ch, const LDMA_TransferCfg_t* transfer, const LDMA_Descriptor_t* descriptor){
+  ldma_channel_t* chan = &channels[ch];
+  sim_ldma_pacing_changing();
+  chan->active = true;
+  chan->reqsel = transfer->ldmaReqSel;
+  chan->desc = descriptor;
+  chan->done = 0;
+  chan->remaining = descriptor->xfer.xferCnt + 1;
+  ldma_ien |= 1u << ch;
+  sim_ldma_pacing_changed();
+}
+
+void LDMA_StopTransfer(int ch){
+  sim_ldma_pacing_changing();
+  channels[ch].active = false;
+  ldma_ien &= ~(1u << ch);
+  sim_ldma_pacing_changed();
+}
+
+bool LDMA_TransferDone(int ch){
+  return !channels[ch].active;
+}
+
+uint32_t LDMA_TransferRemainingCount(int ch){
+  sim_ldma_pacing_changing();
+  sim_ldma_pacing_changed();
+  return channels[ch].active ? channels[ch].remaining : 0;
+}
+
+void LDMA_IntClear(uint32_t flags){
+  ldma_if &= ~flags;
+}
+
+void LDMA_IntEnable(uint32_t flags){
+  ldma_ien |= flags;
+}
+
+void LDMA_IntDisable(uint32_t flags){
+  ldma_ien &= ~flags;
+}
+
+uint32_t LDMA_IntGet(){
+  return ldma_if;
+}
+
+uint32_t LDMA_IntGetEnabled(){
+  return ldma_if & ldma_ien;
+}
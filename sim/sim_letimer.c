@@ -0,0 +1,190 @@
+/***********************************************************************
+ * @file      sim_letimer.c
+ * @brief     Fake LETIMER0 driven by the virtual clock
+ *
+ * @author    Hyounjun Chang, hyounjun.chang@colorado.edu
+ * @date      Oct 16, 2026
+ *
+ * @resources EFR32xG13 Reference Manual, LETIMER chapter
+ *
+ * The counter is not stepped tick by tick. Its value is computed from the
+ * virtual time elapsed since the last reconfiguration, and only the next
+ * UF and COMP1 matches are put on the event queue. With COMP0 as TOP the
+ * counter runs TOP, TOP-1, ..., 0, TOP, so one period is TOP + 1 ticks.
+ *
+ */
+#include "sim.h"
+#include "em_letimer.h"
+
+struct sim_letimer {
+  bool running;
+  bool comp0_top;
+  uint32_t comp[2];
+  uint32_t ien;
+  uint32_t ifl;
+  uint32_t cnt_at_ref;     // counter value at ref_tick
+  uint64_t ref_tick;       // absolute LFA tick number of the last reconfiguration
+  sim_event_handle_t uf_event;
+  sim_event_handle_t comp1_event;
+  uint64_t comp1_tick;     // absolute tick + 1 of the last COMP1 match, 0 for none
+  uint64_t init_tick;      // absolute tick of LETIMER_Init()
+};
+
+LETIMER_TypeDef sim_letimer0;
+
+static uint32_t letimer_top(LETIMER_TypeDef* t){
+  return t->comp0_top ? (t->comp[0] & LETIMER_CNT_MASK) : LETIMER_CNT_MASK;
+}
+
+// ticks are counted from virtual time 0, so reconfiguring never shifts the
+// tick phase
+static uint64_t abs_tick_now(){
+  return sim_clock_now_ns() * sim_letimer_freq() / SIM_NS_PER_SEC;
+}
+
+static uint64_t ticks_since_ref(LETIMER_TypeDef* t){
+  return abs_tick_now() - t->ref_tick;
+}
+
+// virtual time of tick number k after ref_tick
+static uint64_t tick_time_ns(LETIMER_TypeDef* t, uint64_t k){
+  uint32_t freq = sim_letimer_freq();
+  return ((t->ref_tick + k) * SIM_NS_PER_SEC + freq - 1) / freq;
+}
+
+// position in the down-count, 0 at TOP and TOP at 0
+static uint64_t count_position(LETIMER_TypeDef* t, uint64_t ticks){
+  uint32_t top = letimer_top(t);
+  uint32_t cnt = t->cnt_at_ref > top ? top : t->cnt_at_ref;
+  return (uint64_t)(top - cnt) + ticks;
+}
+
+static void letimer_reschedule(LETIMER_TypeDef* t);
+
+static void letimer_uf_event(void* ctx){
+  LETIMER_TypeDef* t = ctx;
+  t->uf_event = 0;
+  t->ifl |= LETIMER_IF_UF;
+  sim_stats.letimer_uf++;
+  letimer_reschedule(t);
+  if (t->ifl & t->ien){
+      sim_irq_raise(LETIMER0_IRQn);
+  }
+}
+
+static void letimer_comp1_event(void* ctx){
+  LETIMER_TypeDef* t = ctx;
+  t->comp1_event = 0;
+  t->ifl |= LETIMER_IF_COMP1;
+  t->comp1_tick = abs_tick_now() + 1;
+  letimer_reschedule(t);
+  if (t->ifl & t->ien){
+      sim_irq_raise(LETIMER0_IRQn);
+  }
+}
+
+static void letimer_reschedule(LETIMER_TypeDef* t){
+  sim_clock_cancel(t->uf_event);
+  sim_clock_cancel(t->comp1_event);
+  t->uf_event = 0;
+  t->comp1_event = 0;
+  if (!t->running){
+      return;
+  }
+
+  uint64_t period = (uint64_t)letimer_top(t) + 1;
+  uint64_t now_ticks = ticks_since_ref(t);
+  uint64_t base = count_position(t, 0);
+  uint64_t pos = base + now_ticks;
+
+  uint64_t next_uf = (pos / period + 1) * period;
+
+  // the UF flag is set with or without its interrupt, tickless firmware polls it
+  t->uf_event = sim_clock_schedule(tick_time_ns(t, next_uf - base), letimer_uf_event, t);
+  if ((t->ien & LETIMER_IEN_COMP1) && t->comp[1] <= letimer_top(t)){
+      uint64_t match = letimer_top(t) - t->comp[1]; // position within a period
+      uint64_t next = (pos / period) * period + match;
+      // a match on the current tick is still to come unless it has been
+      // delivered, e.g. COMP1 = TOP matches on the reload, the tick of the UF
+      if (next < pos || (next == pos && t->comp1_tick == abs_tick_now() + 1)){
+          next += period;
+      }
+      t->comp1_event = sim_clock_schedule(tick_time_ns(t, next - base), letimer_comp1_event, t);
+  }
+}
+
+// freeze the counter at its current value and restart time keeping
+static void letimer_rebase(LETIMER_TypeDef* t){
+  t->cnt_at_ref = LETIMER_CounterGet(t);
+  t->ref_tick = abs_tick_now();
+}
+
+void LETIMER_Init(LETIMER_TypeDef* letimer, const LETIMER_Init_TypeDef* init){
+  letimer->comp0_top = init->comp0Top;
+  letimer->comp[0] = init->topValue;
+  letimer->cnt_at_ref = 0;
+  letimer->ref_tick = abs_tick_now();
+  letimer->init_tick = letimer->ref_tick;
+  letimer->running = init->enable;
+  letimer_reschedule(letimer);
+}
+
+void LETIMER_Enable(LETIMER_TypeDef* letimer, bool enable){
+  letimer_rebase(letimer);
+  letimer->running = enable;
+  letimer_reschedule(letimer);
+}
+
+void LETIMER_CompareSet(LETIMER_TypeDef* letimer, unsigned int comp, uint32_t value){
+  letimer_rebase(letimer);
+  letimer->comp[comp] = value & LETIMER_CNT_MASK;
+  letimer_reschedule(letimer);
+}
+
+uint32_t LETIMER_CompareGet(LETIMER_TypeDef* letimer, unsigned int comp){
+  return letimer->comp[comp];
+}
+
+uint32_t LETIMER_CounterGet(LETIMER_TypeDef* letimer){
+  if (!letimer->running){
+      return letimer->cnt_at_ref;
+  }
+  uint64_t period = (uint64_t)letimer_top(letimer) + 1;
+  uint64_t pos = count_position(letimer, ticks_since_ref(letimer));
+  return letimer_top(letimer) - (uint32_t)(pos % period);
+}
+
+void LETIMER_IntClear(LETIMER_TypeDef* letimer, uint32_t flags){
+  letimer->ifl &= ~flags;
+}
+
+void LETIMER_IntEnable(LETIMER_TypeDef* letimer, uint32_t flags){
+  letimer_rebase(letimer);
+  letimer->ien |= flags;
+  letimer_reschedule(letimer);
+}
+
+void LETIMER_IntDisable(LETIMER_TypeDef* letimer, uint32_t flags){
+  letimer_rebase(letimer);
+  letimer->ien &= ~flags;
+  letimer_reschedule(letimer);
+}
+
+void LETIMER_IntSet(LETIMER_TypeDef* letimer, uint32_t flags){
+  letimer->ifl |= flags;
+  if (letimer->ifl & letimer->ien){
+      sim_irq_raise(LETIMER0_IRQn);
+  }
+}
+
+uint32_t LETIMER_IntGet(LETIMER_TypeDef* letimer){
+  return letimer->ifl;
+}
+
+uint32_t LETIMER_IntGetEnabled(LETIMER_TypeDef* letimer){
+  return letimer->ifl & letimer->ien;
+}
+
+uint64_t sim_letimer_ticks_since_init(){
+  return abs_tick_now() - sim_letimer0.init_tick;
+}
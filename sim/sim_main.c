@@ -0,0 +1,886 @@
+/***********************************************************************
+ * @file      sim_main.c
+ * @brief     Host entry point: runs the firmware against simulated time
+ *
+ * @author    Hyounjun Chang, hyounjun.chang@colorado.edu
+ * @date      Oct 16, 2026
+ *
+ * @resources main.c (Silicon Labs super loop), EFR32BG13 datasheet
+ *            current consumption tables
+ *
+ * Mirrors main.c: app_init(), then a loop of stack event processing,
+ * app_process_action() and sleep. Sleep jumps the virtual clock to the
+ * next scheduled peripheral event instead of waiting, so a day of
+ * firmware time runs in well under a minute, most of it spent producing
+ * the audio samples the LDMA captures.
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "sim.h"
+#include "sl_bluetooth.h"
+#include "gatt_db.h"
+#include "app.h"
+#include "src/timer.h"
+#include "src/irq.h"
+#include "src/i2c.h"
+#include "src/i2c_queue.h"
+#include "src/scheduler.h"
+#include "src/adc.h"
+#include "src/lcd.h"
+#include "src/occupancy.h"
+#include "src/history.h"
+#include "src/flash_log.h"
+#include "src/ble.h"
+
+#define PB0_PORT gpioPortF
+#define PB0_PIN  6
+#define PB0_HOLD_NS (150 * SIM_NS_PER_MS)
+
+// 7-bit addresses, see sim_veml6030.c and sim_si7021.c
+#define VEML6030_ADDR 0x48
+#define SI7021_ADDR   0x40
+
+// someone in the room glances at the display this often
+#define USER_GLANCE_NS (15 * 60 * SIM_NS_PER_SEC)
+
+// rough EFR32BG13 figures at 3.3 V, only used for the relative estimate
+#define EM0_CURRENT_UA       3300.0 // 38.4 MHz HFXO, executing from flash
+#define EM1_CURRENT_UA       1450.0
+#define EM2_CURRENT_UA       2.5    // LFXO + LETIMER0 + RAM retention
+#define WAKEUP_ACTIVE_US     100.0  // average EM0 time per wake-up
+#define SUPPLY_V             3.3
+
+// *********************************************************************
+// scripted user
+// *********************************************************************
+static void pb0_release(void* ctx){
+  (void)ctx;
+  sim_gpio_drive_input(PB0_PORT, PB0_PIN, 1);
+}
+
+static void pb0_press(void* ctx){
+  (void)ctx;
+  // PB0 is active low
+  sim_gpio_drive_input(PB0_PORT, PB0_PIN, 0);
+  sim_clock_schedule(sim_clock_now_ns() + PB0_HOLD_NS, pb0_release, NULL);
+}
+
+void sim_user_press_pb0(uint64_t at_ns){
+  sim_stats.pb0_presses++;
+  sim_clock_schedule(at_ns, pb0_press, NULL);
+}
+
+// someone walking in or out presses PB0 if the display shows the wrong
+// state, and whoever is in the room corrects it when they look at it.
+// Checked once a minute of virtual time.
+static bool last_occupied = false;
+static uint64_t last_glance_ns = 0;
+
+static bool display_shows_occupied(){
+  return strcmp(sim_lcd_row(DISPLAY_ROW_OCCUPIED), "Occupied") == 0;
+}
+
+static void occupancy_watch(void* ctx){
+  (void)ctx;
+  uint64_t now = sim_clock_now_ns();
+  bool occupied = sim_env_occupied(now);
+  bool shown = display_shows_occupied();
+  bool press = false;
+
+  if (occupied != last_occupied){
+      last_occupied = occupied;
+      last_glance_ns = now;
+      press = (shown != occupied);
+  }
+  else if (occupied && now - last_glance_ns >= USER_GLANCE_NS){
+      last_glance_ns = now;
+      press = !shown;
+  }
+  if (press){
+      sim_user_press_pb0(now);
+  }
+
+  sim_stats.occupancy_minutes++;
+  if (shown == occupied){
+      sim_stats.occupancy_agree++;
+  }
+  sim_clock_schedule(now + 60 * SIM_NS_PER_SEC, occupancy_watch, NULL);
+}
+
+// the lux on the display against the room once a minute, close is within
+// a quarter or 2 lux (the display shows whole lux)
+#define LIGHT_TOLERANCE      0.25
+#define LIGHT_TOLERANCE_LUX  2.0
+
+static void light_watch(void* ctx){
+  (void)ctx;
+  uint64_t now = sim_clock_now_ns();
+  double truth = sim_env_lux(now);
+  unsigned int shown;
+
+  if (sscanf(sim_lcd_row(DISPLAY_ROW_AMBLIGHTVALUE), "Light = %u lx", &shown) == 1){
+      sim_stats.light_minutes++;
+      if (fabs(shown - truth) <= fmax(LIGHT_TOLERANCE * truth, LIGHT_TOLERANCE_LUX)){
+          sim_stats.light_agree++;
+      }
+  }
+  sim_clock_schedule(now + 60 * SIM_NS_PER_SEC, light_watch, NULL);
+}
+
+// temperature and humidity on the display against the room once a minute,
+// both are shown in whole units
+#define TEMP_TOLERANCE_C        1.0
+#define HUMIDITY_TOLERANCE_PCT  2.0
+
+static void climate_watch(void* ctx){
+  (void)ctx;
+  uint64_t now = sim_clock_now_ns();
+  int temp;
+  unsigned int humidity;
+
+  if (sscanf(sim_lcd_row(DISPLAY_ROW_TEMPVALUE), "Temp = %d C", &temp) == 1 &&
+      sscanf(sim_lcd_row(DISPLAY_ROW_HUMIDITY), "Humidity = %u %%", &humidity) == 1){
+      sim_stats.climate_minutes++;
+      if (fabs(temp - sim_env_temperature_c(now)) <= TEMP_TOLERANCE_C){
+          sim_stats.temp_agree++;
+      }
+      if (fabs(humidity - sim_env_humidity_pct(now)) <= HUMIDITY_TOLERANCE_PCT){
+          sim_stats.humidity_agree++;
+      }
+  }
+  sim_clock_schedule(now + 60 * SIM_NS_PER_SEC, climate_watch, NULL);
+}
+
+// a phone that wants everything, a gateway that only takes the snapshot
+// and pulls the history, and optionally more gateways
+static void add_centrals(){
+  static const char* extra_names[] = { "gateway 2", "gateway 3", "gateway 4",
+                                       "gateway 5", "gateway 6", "gateway 7" };
+  double at = sim_options.gateway_at_s >= 0.0 ? sim_options.gateway_at_s : 20.0;
+  double history_every_s = BLE_HISTORY_CHANNEL && sim_options.history_every_s > 0.0 ?
+                           sim_options.history_every_s : 0.0;
+  sim_bt_add_central("phone", false, 247, sim_options.connect_at_s, sim_options.disconnect_at_s, 0.0);
+  sim_bt_add_central("gateway", true, 23, sim_options.gateway_at_s, -1.0, history_every_s);
+  sim_bt_set_central_link(1, sim_options.gateway_phy == 2, (uint16_t)sim_options.gateway_data_length);
+  if (sim_options.gateway_reconnect_every_s > 0.0){
+      sim_bt_set_central_reconnect(1, sim_options.gateway_reconnect_every_s);
+  }
+  for (uint32_t i = 0; i < sim_options.extra_centrals && i < 6; i++){
+      sim_bt_add_central(extra_names[i], true, 23, at + 10.0 * (i + 1), -1.0, 0.0);
+  }
+}
+
+// one CSV line per completed feature vector, labelled with the truth
+static FILE* trace_file = NULL;
+static uint32_t traced_periods = 0;
+
+static void occupancy_trace(){
+  if (!trace_file || occupancy_periods() == traced_periods){
+      return;
+  }
+  uint64_t now = sim_clock_now_ns();
+  const float* x = occupancy_features();
+  traced_periods = occupancy_periods();
+  fprintf(trace_file, "%.4f,%d", sim_env_hour_of_day(now), sim_env_occupied(now) ? 1 : 0);
+  for (int i = 0; i < OCCUPANCY_FEATURES; i++){
+      fprintf(trace_file, ",%.4f", x[i]);
+  }
+  fprintf(trace_file, "\n");
+}
+
+// one CSV line per history record, read back the way the channel reads it
+static FILE* history_trace_file = NULL;
+static uint32_t traced_records = 0;
+
+static void history_trace(){
+  uint8_t stream[SERIES_SAMPLE_MAX(HISTORY_FIELDS)];
+  series_encoder_t encoder;
+  series_decoder_t decoder;
+  int32_t values[HISTORY_FIELDS];
+  uint32_t timestamp;
+
+  while (history_trace_file && traced_records < history_next()){
+      series_encoder_init(&encoder, stream, sizeof(stream), HISTORY_FIELDS);
+      if (history_read(&traced_records, &encoder, 1) == 0){
+          break;
+      }
+      series_decoder_init(&decoder, stream, encoder.len, HISTORY_FIELDS);
+      series_decode(&decoder, &timestamp, values);
+      fprintf(history_trace_file, "%lu", (unsigned long)timestamp);
+      for (int i = 0; i < HISTORY_FIELDS; i++){
+          fprintf(history_trace_file, ",%ld", (long)values[i]);
+      }
+      fprintf(history_trace_file, "\n");
+      traced_records++;
+  }
+}
+
+// *********************************************************************
+// options
+// *********************************************************************
+static void usage(const char* prog){
+  fprintf(stderr,
+          "usage: %s [options]\n"
+          "  --hours H           virtual hours to run (default 24)\n"
+          "  --start-hour H      time of day at t = 0 (default 0)\n"
+          "  --seed N            environment seed (default 1)\n"
+          "  --connect-at S      phone connects S seconds in (default 5, -1 never)\n"
+          "  --disconnect-at S   phone disconnects S seconds in (default never)\n"
+          "  --gateway-at S      snapshot only gateway connects S seconds in (default 20, -1 never)\n"
+          "  --extra-centrals N  more snapshot only centrals, 10 s apart after the gateway\n"
+          "  --history-every S   gateway downloads the history every S seconds (default 3600, 0 never)\n"
+          "  --gateway-phy N     1 if the gateway only has the 1M PHY (default 2)\n"
+          "  --gateway-data-length N  longest LL payload the gateway takes, 27 to 251 (default 251)\n"
+          "  --gateway-reconnect-every S  gateway drops the link every S seconds and reconnects bonded\n"
+          "  --log               echo firmware log output\n"
+          "  --lcd               dump the LCD at the end\n"
+          "  --trace FILE        write labelled occupancy feature vectors as CSV\n"
+          "  --history-trace FILE  write the history records as CSV\n"
+          "  --i2c-faults P      chance of a NACK, lost arbitration or stuck bus per I2C transfer\n"
+          "  --i2c-outage-at S   every I2C transfer fails from S seconds in until a request runs out of retries\n"
+          "  --ble-congestion P  chance a notification stalls the link for 0.1 to 2 s\n"
+          "  --check             verify timing invariants, exit 1 on failure\n",
+          prog);
+}
+
+static void parse_options(int argc, char** argv){
+  sim_options.hours = 24.0;
+  sim_options.start_hour = 0.0;
+  sim_options.seed = 1;
+  sim_options.connect_at_s = 5.0;
+  sim_options.disconnect_at_s = -1.0;
+  sim_options.gateway_at_s = 20.0;
+  sim_options.history_every_s = 3600.0;
+  sim_options.gateway_phy = 2;
+  sim_options.gateway_data_length = 251;
+  sim_options.i2c_outage_at_s = -1.0;
+
+  for (int i = 1; i < argc; i++){
+      const char* arg = argv[i];
+      const char* value = (i + 1 < argc) ? argv[i + 1] : NULL;
+      if (strcmp(arg, "--log") == 0){
+          sim_options.log = true;
+      }
+      else if (strcmp(arg, "--lcd") == 0){
+          sim_options.lcd = true;
+      }
+      else if (strcmp(arg, "--check") == 0){
+          sim_options.check = true;
+      }
+      else if (value && strcmp(arg, "--hours") == 0){
+          sim_options.hours = atof(value);
+          i++;
+      }
+      else if (value && strcmp(arg, "--start-hour") == 0){
+          sim_options.start_hour = atof(value);
+          i++;
+      }
+      else if (value && strcmp(arg, "--seed") == 0){
+          sim_options.seed = (uint32_t)strtoul(value, NULL, 0);
+          i++;
+      }
+      else if (value && strcmp(arg, "--connect-at") == 0){
+          sim_options.connect_at_s = atof(value);
+          i++;
+      }
+      else if (value && strcmp(arg, "--disconnect-at") == 0){
+          sim_options.disconnect_at_s = atof(value);
+          i++;
+      }
+      else if (value && strcmp(arg, "--trace") == 0){
+          sim_options.trace_path = value;
+          i++;
+      }
+      else if (value && strcmp(arg, "--history-trace") == 0){
+          sim_options.history_trace_path = value;
+          i++;
+      }
+      else if (value && strcmp(arg, "--i2c-faults") == 0){
+          sim_options.i2c_fault_rate = atof(value);
+          i++;
+      }
+      else if (value && strcmp(arg, "--i2c-outage-at") == 0){
+          sim_options.i2c_outage_at_s = atof(value);
+          i++;
+      }
+      else if (value && strcmp(arg, "--gateway-at") == 0){
+          sim_options.gateway_at_s = atof(value);
+          i++;
+      }
+      else if (value && strcmp(arg, "--extra-centrals") == 0){
+          sim_options.extra_centrals = (uint32_t)strtoul(value, NULL, 0);
+          i++;
+      }
+      else if (value && strcmp(arg, "--ble-congestion") == 0){
+          sim_options.ble_congestion_rate = atof(value);
+          i++;
+      }
+      else if (value && strcmp(arg, "--history-every") == 0){
+          sim_options.history_every_s = atof(value);
+          i++;
+      }
+      else if (value && strcmp(arg, "--gateway-phy") == 0){
+          sim_options.gateway_phy = (uint32_t)strtoul(value, NULL, 0);
+          i++;
+      }
+      else if (value && strcmp(arg, "--gateway-data-length") == 0){
+          sim_options.gateway_data_length = (uint32_t)strtoul(value, NULL, 0);
+          i++;
+      }
+      else if (value && strcmp(arg, "--gateway-reconnect-every") == 0){
+          sim_options.gateway_reconnect_every_s = atof(value);
+          i++;
+      }
+      else{
+          usage(argv[0]);
+          exit(2);
+      }
+  }
+}
+
+// *********************************************************************
+// report
+// *********************************************************************
+static uint32_t scheduler_event_overruns(){
+  uint32_t overruns = 0;
+  for (int event = 0; event < NUM_SCHEDULER_EVENTS; event++){
+      overruns += get_scheduler_event_overruns((scheduler_event)event);
+  }
+  return overruns;
+}
+
+static double em_current_ua(int em){
+  switch (em){
+    case 0:
+      return EM0_CURRENT_UA;
+    case 1:
+      return EM1_CURRENT_UA;
+    default:
+      return EM2_CURRENT_UA;
+  }
+}
+
+static void print_summary(double hours){
+  const i2c_device_stats_t* veml = i2c_queue_device_stats(VEML6030_ADDR);
+  const i2c_device_stats_t* si7021 = i2c_queue_device_stats(SI7021_ADDR);
+  double total_s = hours * 3600.0;
+  double charge_uc = sim_stats.wakeups * WAKEUP_ACTIVE_US * 1e-6 * EM0_CURRENT_UA;
+  uint32_t wear_min, wear_max;
+
+  printf("simulated %.2f h (start %.2f h, seed %u)\n", hours, sim_options.start_hour,
+         (unsigned int)sim_options.seed);
+  printf("  wake-ups            %10llu  (%.1f per hour, %s)\n",
+         (unsigned long long)sim_stats.wakeups, sim_stats.wakeups / hours,
+         TIMER_TICKLESS ? "tickless" : "1 s LETIMER0 underflow");
+  printf("  irqs      letimer0  %10llu  gpio %llu  i2c0 %llu  adc0 %llu  ldma %llu\n",
+         (unsigned long long)sim_stats.irq_count[LETIMER0_IRQn],
+         (unsigned long long)(sim_stats.irq_count[GPIO_EVEN_IRQn] + sim_stats.irq_count[GPIO_ODD_IRQn]),
+         (unsigned long long)sim_stats.irq_count[I2C0_IRQn],
+         (unsigned long long)sim_stats.irq_count[ADC0_IRQn],
+         (unsigned long long)sim_stats.irq_count[LDMA_IRQn]);
+  printf("  bt events           %10llu  (external signals %llu, merged bits %llu)\n",
+         (unsigned long long)sim_stats.bt_events,
+         (unsigned long long)sim_stats.ext_signal_events,
+         (unsigned long long)sim_stats.ext_signals_merged);
+  printf("  event queue         high water %lu of %d, overruns %lu\n",
+         (unsigned long)get_scheduler_event_high_water(), SCHEDULER_EVENT_QUEUE_DEPTH,
+         (unsigned long)scheduler_event_overruns());
+  printf("  notifications       %10llu  (space %llu, lux %llu, audio %llu, temp %llu, rh %llu, errors %llu, refused %llu)\n",
+         (unsigned long long)sim_stats.notifications,
+         (unsigned long long)sim_bt_notifications_for(gattdb_space_occupied),
+         (unsigned long long)sim_bt_notifications_for(gattdb_illuminance),
+         (unsigned long long)sim_bt_notifications_for(gattdb_audio_input_description),
+         (unsigned long long)sim_bt_notifications_for(gattdb_temperature_measurement),
+         (unsigned long long)sim_bt_notifications_for(gattdb_humidity),
+         (unsigned long long)sim_stats.notify_errors,
+         (unsigned long long)sim_stats.notify_refused);
+  printf("  connections         max %llu of %d open, %llu connects refused with a slot free\n",
+         (unsigned long long)sim_stats.ble_max_connections, SL_BT_CONFIG_MAX_CONNECTIONS,
+         (unsigned long long)sim_stats.ble_connect_refused);
+  printf("  connection events   %10llu  (%.0f per connection hour, %llu parameter updates, %llu rejected)\n",
+         (unsigned long long)sim_stats.ble_conn_events,
+         sim_stats.ble_connected_ns ? sim_stats.ble_conn_events * 3600.0 * SIM_NS_PER_SEC /
+                                      sim_stats.ble_connected_ns : 0.0,
+         (unsigned long long)sim_stats.ble_param_updates,
+         (unsigned long long)sim_stats.ble_param_rejects);
+  for (uint32_t c = 0; c < sim_bt_num_centrals(); c++){
+      printf("  %-19s %10llu  snapshots (lux %llu; %uM PHY, data length %u, MTU %u)\n", sim_bt_central_name(c),
+             (unsigned long long)sim_bt_central_notifications(c, gattdb_study_space_snapshot),
+             (unsigned long long)sim_bt_central_notifications(c, gattdb_illuminance),
+             sim_bt_central_phy(c) == sl_bt_gap_phy_2m ? 2u : 1u,
+             (unsigned int)sim_bt_central_data_length(c), (unsigned int)sim_bt_central_mtu(c));
+  }
+  printf("  notification queue  %10lu  enqueued (coalesced %lu, dropped %lu, sent %lu; link stalls %llu)\n",
+         (unsigned long)get_notification_stats()->enqueued,
+         (unsigned long)get_notification_stats()->coalesced,
+         (unsigned long)get_notification_stats()->dropped,
+         (unsigned long)get_notification_stats()->sent,
+         (unsigned long long)sim_stats.ble_congestions);
+  printf("  snapshots           %10llu  (sequence gaps %llu, mismatches %llu)\n",
+         (unsigned long long)sim_bt_notifications_for(gattdb_study_space_snapshot),
+         (unsigned long long)sim_stats.snapshot_gaps,
+         (unsigned long long)sim_stats.snapshot_mismatches);
+  printf("  beacon              %10llu  updates (%.0f per hour, needless %llu, gaps %llu, mismatches %llu)\n",
+         (unsigned long long)sim_stats.beacon_updates,
+         hours > 0.0 ? sim_stats.beacon_updates / hours : 0.0,
+         (unsigned long long)sim_stats.beacon_needless,
+         (unsigned long long)sim_stats.beacon_gaps,
+         (unsigned long long)sim_stats.beacon_mismatches);
+  printf("  broadcast           %10llu  updates (%.0f per hour, unchanged %llu, gaps %llu, mismatches %llu; "
+         "%llu periodic events)\n",
+         (unsigned long long)sim_stats.broadcast_updates,
+         hours > 0.0 ? sim_stats.broadcast_updates / hours : 0.0,
+         (unsigned long long)sim_stats.broadcast_unchanged,
+         (unsigned long long)sim_stats.broadcast_gaps,
+         (unsigned long long)sim_stats.broadcast_mismatches,
+         (unsigned long long)sim_stats.broadcast_events);
+  printf("  history downloads   %10llu  (%llu records, longest %.2f s for %llu in %llu bytes at %.1f kB/s; refused %llu, "
+         "aborted %llu, no TX buffer %llu)\n",
+         (unsigned long long)sim_stats.history_downloads,
+         (unsigned long long)sim_stats.history_records,
+         sim_stats.history_max_ns / (double)SIM_NS_PER_SEC,
+         (unsigned long long)sim_stats.history_max_records,
+         (unsigned long long)sim_stats.history_max_bytes,
+         sim_stats.history_max_ns ? sim_stats.history_max_bytes * (double)SIM_NS_PER_SEC /
+                                    sim_stats.history_max_ns / 1000.0 : 0.0,
+         (unsigned long long)sim_stats.history_refused,
+         (unsigned long long)sim_stats.history_aborted,
+         (unsigned long long)sim_stats.history_busy);
+  flash_log_wear(&wear_min, &wear_max);
+  printf("  flash log           %10lu  history records (first %lu, %llu words written, %llu pages erased, "
+         "erase counts %lu to %lu, write errors %lu)\n",
+         (unsigned long)flash_log_next(), (unsigned long)flash_log_first(),
+         (unsigned long long)sim_msc_stats()->words,
+         (unsigned long long)sim_msc_stats()->erases,
+         (unsigned long)wear_min, (unsigned long)wear_max,
+         (unsigned long)flash_log_stats()->write_errors);
+  printf("  i2c transfers       %10llu  (nacks %llu, collisions %llu, queue high water %lu)\n",
+         (unsigned long long)sim_stats.i2c_transfers,
+         (unsigned long long)sim_stats.i2c_nacks,
+         (unsigned long long)sim_stats.i2c_collisions,
+         (unsigned long)i2c_queue_high_water());
+  if (veml != NULL && (veml->nacks || veml->bus_errors || sim_stats.i2c_faults)){
+      printf("  i2c faults          %10llu  (stuck bus %llu, recoveries %lu; VEML6030 nacks %lu, "
+             "bus errors %lu, retries %lu, failed %lu)\n",
+             (unsigned long long)sim_stats.i2c_faults,
+             (unsigned long long)sim_stats.i2c_bus_stuck,
+             (unsigned long)i2c_queue_bus_recoveries(),
+             (unsigned long)veml->nacks, (unsigned long)veml->bus_errors,
+             (unsigned long)veml->retries, (unsigned long)veml->failures);
+  }
+  if (si7021 != NULL && (si7021->nacks || si7021->bus_errors || sim_stats.i2c_faults)){
+      printf("                                (Si7021 nacks %lu, bus errors %lu, retries %lu, failed %lu)\n",
+             (unsigned long)si7021->nacks, (unsigned long)si7021->bus_errors,
+             (unsigned long)si7021->retries, (unsigned long)si7021->failures);
+  }
+  printf("  als range changes   %10lu  (saturated readings %lu, INT %llu, %s)\n",
+         (unsigned long)VEML6030_range_changes(), (unsigned long)VEML6030_saturated_reads(),
+         (unsigned long long)sim_stats.als_interrupts,
+         VEML6030_THRESHOLD_INT ? "threshold interrupt" : "polled");
+  if (sim_stats.light_minutes > 0){
+      printf("  light shown         %9.1f%%  close to the room\n",
+             100.0 * sim_stats.light_agree / sim_stats.light_minutes);
+  }
+  if (sim_stats.climate_minutes > 0){
+      printf("  climate shown       %9.1f%%  temperature close to the room (humidity %.1f%%)\n",
+             100.0 * sim_stats.temp_agree / sim_stats.climate_minutes,
+             100.0 * sim_stats.humidity_agree / sim_stats.climate_minutes);
+  }
+  printf("  adc conversions     %10llu\n", (unsigned long long)sim_stats.adc_conversions);
+  printf("  lcd updates         %10llu\n", (unsigned long long)sim_stats.lcd_updates);
+  if (sim_stats.occupancy_minutes > 0){
+      printf("  occupancy shown     %9.1f%%  correct (%llu classifier periods, %llu PB0 presses)\n",
+             100.0 * sim_stats.occupancy_agree / sim_stats.occupancy_minutes,
+             (unsigned long long)occupancy_periods(),
+             (unsigned long long)sim_stats.pb0_presses);
+  }
+  printf("  vcom bytes          %10llu\n", (unsigned long long)sim_stats.usart_bytes);
+
+  for (int em = 0; em < 4; em++){
+      double s = sim_stats.em_residency_ns[em] / (double)SIM_NS_PER_SEC;
+      charge_uc += s * em_current_ua(em);
+      if (s > 0.0){
+          printf("  EM%d residency       %10.1f s  (%.2f%%)\n", em, s, 100.0 * s / total_s);
+      }
+  }
+  printf("  est. average current  %8.2f uA  (%.3f J)\n", charge_uc / total_s,
+         charge_uc * 1e-6 * SUPPLY_V);
+}
+
+// letimerTicks64() after every event, underflows included: never behind the
+// last reading and exactly the ticks the LETIMER0 has counted
+static void timebase_watch(){
+  static uint64_t last_ticks = 0;
+  uint64_t ticks = letimerTicks64();
+  if (ticks < last_ticks || ticks != sim_letimer_ticks_since_init() ||
+      letimerMicroseconds() != ticks * SIM_NS_PER_SEC / get_LETIMER_freq() / 1000){
+      sim_stats.timebase_errors++;
+  }
+  last_ticks = ticks;
+}
+
+// returns the number of failed checks
+static int run_checks(double hours){
+  const i2c_device_stats_t* veml = i2c_queue_device_stats(VEML6030_ADDR);
+  const i2c_device_stats_t* si7021 = i2c_queue_device_stats(SI7021_ADDR);
+  int failures = 0;
+  double seconds = hours * 3600.0;
+  // COMP0 is reloaded after reaching 0, so one period is TOP + 1 ticks
+  double expected_uf = floor(seconds * get_LETIMER_freq() / (get_LETIMER_TOP_value() + 1.0));
+#if TIMER_TICKLESS
+  // soft timers from boot, one per sound window and one per VEML6030 read
+  double expected_windows = floor(seconds * 1000.0 / SOUND_WINDOW_PERIOD_MS);
+  double expected_reads = floor(seconds * 1000.0 / AMBIENT_LIGHT_PERIOD_MS);
+  // the one due right at the end of the run does not get to start
+  double expected_measurements = ceil(seconds * 1000.0 / TEMPERATURE_PERIOD_MS) - 1.0;
+#else
+  // the LETIMER0 ISR starts a window every underflow and a VEML6030 read
+  // every 5th
+  double expected_windows = expected_uf;
+  double expected_reads = floor(expected_uf / 5.0);
+  double expected_measurements = floor(expected_uf * 1000.0 / TEMPERATURE_PERIOD_MS);
+#endif
+#if VEML6030_THRESHOLD_INT
+  // no polling, each INT is an ALS_INT read, the ALS read and the two
+  // threshold writes, plus the blocking configuration at boot
+  double expected_transfers = 4.0 * sim_stats.als_interrupts + 5.0;
+  (void)expected_reads;
+#else
+  // plus the two blocking configuration writes at boot
+  double expected_transfers = expected_reads + 2.0;
+#endif
+  // and one ALS_CONF_0 write per range change, and the retries
+  expected_transfers += VEML6030_range_changes();
+  if (veml != NULL){
+      expected_transfers += veml->retries;
+  }
+  // Si7021: measure command, humidity read and temperature read, for the
+  // one after power-up and the periodic ones
+  expected_transfers += 3.0 * (expected_measurements + 1.0);
+  if (si7021 != NULL){
+      expected_transfers += si7021->retries;
+  }
+
+  if (fabs((double)sim_stats.letimer_uf - expected_uf) > 1.0){
+      printf("CHECK FAILED: %llu LETIMER0 underflows, expected %.0f\n",
+             (unsigned long long)sim_stats.letimer_uf, expected_uf);
+      failures++;
+  }
+#if SOUND_SAMPLING_LDMA
+  // one window of LDMA buffers per window period
+  double expected_conversions = expected_windows * SOUND_BUFFER_SAMPLES * SOUND_BUFFERS_PER_WINDOW;
+  double conversion_slack = SOUND_BUFFER_SAMPLES * SOUND_BUFFERS_PER_WINDOW;
+#else
+  double expected_conversions = expected_windows;
+  double conversion_slack = 1.0;
+#endif
+  if (fabs((double)sim_stats.adc_conversions - expected_conversions) > conversion_slack){
+      printf("CHECK FAILED: %llu ADC conversions, expected %.0f\n",
+             (unsigned long long)sim_stats.adc_conversions, expected_conversions);
+      failures++;
+  }
+  // VEML6030 reads are one write-read each, a Si7021 measurement may be
+  // half way through at the end
+  if (fabs((double)sim_stats.i2c_transfers - expected_transfers) > 3.0){
+      printf("CHECK FAILED: %llu I2C transfers, expected about %.0f\n",
+             (unsigned long long)sim_stats.i2c_transfers, expected_transfers);
+      failures++;
+  }
+  // injected faults must not cost a reading, an outage costs exactly one
+  // and the bus has to come back after it
+  uint32_t outage_failures = sim_options.i2c_outage_at_s >= 0.0 && sim_options.i2c_outage_at_s < seconds;
+  if ((veml != NULL ? veml->failures : 0) + (si7021 != NULL ? si7021->failures : 0) != outage_failures){
+      printf("CHECK FAILED: %lu VEML6030 and %lu Si7021 requests failed after %d retries, expected %lu\n",
+             (unsigned long)(veml != NULL ? veml->failures : 0),
+             (unsigned long)(si7021 != NULL ? si7021->failures : 0), I2C_REQUEST_MAX_RETRIES,
+             (unsigned long)outage_failures);
+      failures++;
+  }
+  if (sim_stats.i2c_bus_stuck > i2c_queue_bus_recoveries()){
+      printf("CHECK FAILED: bus stuck %llu times, recovered %lu times\n",
+             (unsigned long long)sim_stats.i2c_bus_stuck,
+             (unsigned long)i2c_queue_bus_recoveries());
+      failures++;
+  }
+  if ((sim_stats.i2c_nacks != 0 && sim_options.i2c_fault_rate <= 0.0) || sim_stats.i2c_collisions != 0){
+      printf("CHECK FAILED: %llu I2C NACKs, %llu collisions\n",
+             (unsigned long long)sim_stats.i2c_nacks,
+             (unsigned long long)sim_stats.i2c_collisions);
+      failures++;
+  }
+  if (sim_stats.light_minutes > 0 && sim_stats.light_agree < 0.98 * sim_stats.light_minutes){
+      printf("CHECK FAILED: displayed lux close to the room only %llu of %llu minutes\n",
+             (unsigned long long)sim_stats.light_agree,
+             (unsigned long long)sim_stats.light_minutes);
+      failures++;
+  }
+  if (sim_stats.climate_minutes + 1 < hours * 60.0 ||
+      sim_stats.temp_agree < 0.98 * sim_stats.climate_minutes ||
+      sim_stats.humidity_agree < 0.98 * sim_stats.climate_minutes){
+      printf("CHECK FAILED: temperature close to the room %llu, humidity %llu of %llu minutes shown\n",
+             (unsigned long long)sim_stats.temp_agree,
+             (unsigned long long)sim_stats.humidity_agree,
+             (unsigned long long)sim_stats.climate_minutes);
+      failures++;
+  }
+  // auto-ranging leaves at most the reading that triggered a change saturated
+  if (VEML6030_saturated_reads() > VEML6030_range_changes()){
+      printf("CHECK FAILED: %lu saturated VEML6030 readings, %lu range changes\n",
+             (unsigned long)VEML6030_saturated_reads(), (unsigned long)VEML6030_range_changes());
+      failures++;
+  }
+  if (sim_options.connect_at_s >= 0.0 && sim_options.connect_at_s + 10.0 < seconds &&
+      sim_bt_notifications_for(gattdb_illuminance) == 0){
+      printf("CHECK FAILED: no illuminance notifications reached the central\n");
+      failures++;
+  }
+  // one snapshot per window while subscribed, to every central that got a
+  // connection
+  for (uint32_t c = 0; c < sim_bt_num_centrals(); c++){
+      double at = sim_bt_central_connect_at(c);
+      if (at >= 0.0 && at + 10.0 < seconds &&
+          (!sim_bt_central_ever_connected(c) ||
+           sim_bt_central_notifications(c, gattdb_study_space_snapshot) == 0)){
+          printf("CHECK FAILED: no snapshot notifications reached the %s\n", sim_bt_central_name(c));
+          failures++;
+      }
+  }
+  // advertising goes on while a slot is free, so nobody is turned away
+  // until SL_BT_CONFIG_MAX_CONNECTIONS are open
+  if (sim_stats.ble_max_connections > SL_BT_CONFIG_MAX_CONNECTIONS ||
+      sim_stats.ble_connect_refused != 0){
+      printf("CHECK FAILED: %llu connections open at once, %llu connects refused with a slot free\n",
+             (unsigned long long)sim_stats.ble_max_connections,
+             (unsigned long long)sim_stats.ble_connect_refused);
+      failures++;
+  }
+  // a value replaced in the notification queue is the only way to miss a
+  // snapshot, and a stall can let a snapshot overtake a single characteristic
+  // of the same window
+  if (sim_stats.snapshot_gaps > (uint64_t)get_notification_stats()->coalesced +
+                                get_notification_stats()->dropped ||
+      sim_stats.snapshot_mismatches > sim_stats.ble_congestions){
+      printf("CHECK FAILED: %llu snapshots missed, %llu disagreed with the single characteristics\n",
+             (unsigned long long)sim_stats.snapshot_gaps,
+             (unsigned long long)sim_stats.snapshot_mismatches);
+      failures++;
+  }
+#if BLE_BEACON
+  // scanners see every change past a deadband, and nothing else
+  if (sim_stats.beacon_updates == 0 || sim_stats.beacon_needless != 0 ||
+      sim_stats.beacon_gaps != 0 || sim_stats.beacon_mismatches != 0){
+      printf("CHECK FAILED: %llu beacon updates, %llu needless, %llu gaps, %llu mismatches\n",
+             (unsigned long long)sim_stats.beacon_updates,
+             (unsigned long long)sim_stats.beacon_needless,
+             (unsigned long long)sim_stats.beacon_gaps,
+             (unsigned long long)sim_stats.beacon_mismatches);
+      failures++;
+  }
+#endif
+#if BLE_PERIODIC_BROADCAST
+  // observers see every change of the room, and nothing else
+  if (sim_stats.broadcast_updates == 0 || sim_stats.broadcast_unchanged != 0 ||
+      sim_stats.broadcast_gaps != 0 || sim_stats.broadcast_mismatches != 0){
+      printf("CHECK FAILED: %llu broadcast updates, %llu unchanged, %llu gaps, %llu mismatches\n",
+             (unsigned long long)sim_stats.broadcast_updates,
+             (unsigned long long)sim_stats.broadcast_unchanged,
+             (unsigned long long)sim_stats.broadcast_gaps,
+             (unsigned long long)sim_stats.broadcast_mismatches);
+      failures++;
+  }
+#endif
+#if BLE_HISTORY_CHANNEL
+  // the gateway pulls the history on schedule without losing a record, the
+  // board never sends past its credits, and a day of records takes seconds
+  if (sim_options.history_every_s > 0.0 && sim_options.gateway_at_s >= 0.0 &&
+      sim_options.gateway_at_s + sim_options.history_every_s + 10.0 < hours * 3600.0 &&
+      sim_stats.history_downloads == 0){
+      printf("CHECK FAILED: no history download\n");
+      failures++;
+  }
+  if (sim_stats.history_gaps != 0 || sim_stats.history_malformed != 0 ||
+      sim_stats.history_credit_violations != 0 || sim_stats.history_aborted != 0 ||
+      sim_stats.history_refused != 0){
+      printf("CHECK FAILED: history downloads with %llu records skipped, %llu malformed, "
+             "%llu credit violations, %llu aborted, %llu refused\n",
+             (unsigned long long)sim_stats.history_gaps,
+             (unsigned long long)sim_stats.history_malformed,
+             (unsigned long long)sim_stats.history_credit_violations,
+             (unsigned long long)sim_stats.history_aborted,
+             (unsigned long long)sim_stats.history_refused);
+      failures++;
+  }
+  if (sim_stats.history_max_ns > 10 * SIM_NS_PER_SEC){
+      printf("CHECK FAILED: history download took %.2f s\n",
+             sim_stats.history_max_ns / (double)SIM_NS_PER_SEC);
+      failures++;
+  }
+#endif
+  // a record a minute goes into the history, and to flash the way NOR flash
+  // allows. The history is only kept for the channel.
+  if ((BLE_HISTORY_CHANNEL && history_next() + 1 < (uint32_t)(hours * 3600.0 / HISTORY_PERIOD_S)) ||
+      flash_log_stats()->write_errors != 0 || sim_msc_stats()->overwrites != 0 ||
+      sim_msc_stats()->locked != 0 || sim_msc_stats()->invalid != 0){
+      printf("CHECK FAILED: %lu history records, %lu write errors, %llu overwrites, "
+             "%llu locked, %llu invalid\n",
+             (unsigned long)history_next(), (unsigned long)flash_log_stats()->write_errors,
+             (unsigned long long)sim_msc_stats()->overwrites,
+             (unsigned long long)sim_msc_stats()->locked,
+             (unsigned long long)sim_msc_stats()->invalid);
+      failures++;
+  }
+  // every request is valid, and a connection with nothing queued is back on
+  // the idle parameters by the end of the run
+  if (sim_stats.ble_param_rejects != 0){
+      printf("CHECK FAILED: %llu connection parameter requests rejected\n",
+             (unsigned long long)sim_stats.ble_param_rejects);
+      failures++;
+  }
+  for (uint32_t c = 0; c < sim_bt_num_centrals(); c++){
+      if (sim_bt_central_connected(c) && get_notification_stats()->enqueued == 0 &&
+          (sim_bt_central_interval(c) < BLE_IDLE_INTERVAL_MIN ||
+           sim_bt_central_latency(c) != BLE_IDLE_LATENCY)){
+          printf("CHECK FAILED: %s left at interval %u, latency %u\n", sim_bt_central_name(c),
+                 (unsigned int)sim_bt_central_interval(c), (unsigned int)sim_bt_central_latency(c));
+          failures++;
+      }
+  }
+  // every connection ends up on the best link both sides can do
+  for (uint32_t c = 0; c < sim_bt_num_centrals(); c++){
+      uint16_t data_len = sim_bt_central_max_data_length(c) < BLE_DATA_LENGTH ?
+                          sim_bt_central_max_data_length(c) : BLE_DATA_LENGTH;
+      uint16_t mtu = sim_bt_central_max_mtu(c) < BLE_MAX_MTU ?
+                     sim_bt_central_max_mtu(c) : BLE_MAX_MTU;
+      if (sim_bt_central_connected(c) &&
+          ((sim_bt_central_phy_2m(c) && sim_bt_central_phy(c) != sl_bt_gap_phy_2m) ||
+           sim_bt_central_data_length(c) != data_len || sim_bt_central_mtu(c) != mtu)){
+          printf("CHECK FAILED: %s on the %uM PHY, data length %u, MTU %u\n", sim_bt_central_name(c),
+                 sim_bt_central_phy(c) == sl_bt_gap_phy_2m ? 2u : 1u,
+                 (unsigned int)sim_bt_central_data_length(c), (unsigned int)sim_bt_central_mtu(c));
+          failures++;
+      }
+  }
+  // notifications only go to subscribed connections, the stack only refuses
+  // them while the link is stalled, and the queue hands every one of them
+  // over once it recovers
+  if (sim_stats.notify_errors != 0 ||
+      (sim_stats.notify_refused != 0 && sim_options.ble_congestion_rate <= 0.0) ||
+      get_notification_stats()->dropped != 0 ||
+      get_notification_stats()->sent != sim_stats.notifications){
+      printf("CHECK FAILED: %llu notifications rejected, %llu refused, %lu dropped, %lu sent of %llu received\n",
+             (unsigned long long)sim_stats.notify_errors,
+             (unsigned long long)sim_stats.notify_refused,
+             (unsigned long)get_notification_stats()->dropped,
+             (unsigned long)get_notification_stats()->sent,
+             (unsigned long long)sim_stats.notifications);
+      failures++;
+  }
+  if (scheduler_event_overruns() != 0){
+      printf("CHECK FAILED: %lu scheduler events dropped on a full queue\n",
+             (unsigned long)scheduler_event_overruns());
+      failures++;
+  }
+  if (sim_stats.pm_errors != 0){
+      printf("CHECK FAILED: %llu unbalanced power manager requirement removals\n",
+             (unsigned long long)sim_stats.pm_errors);
+      failures++;
+  }
+  if (sim_stats.timebase_errors != 0){
+      printf("CHECK FAILED: %llu timebase readings went backwards or off the LETIMER0 count\n",
+             (unsigned long long)sim_stats.timebase_errors);
+      failures++;
+  }
+  if (failures == 0){
+      printf("all checks passed\n");
+  }
+  return failures;
+}
+
+// *********************************************************************
+// super loop
+// *********************************************************************
+int main(int argc, char** argv){
+  uint64_t end_ns;
+
+  parse_options(argc, argv);
+  if (sim_options.trace_path){
+      trace_file = fopen(sim_options.trace_path, "w");
+      if (!trace_file){
+          perror(sim_options.trace_path);
+          return 2;
+      }
+      fprintf(trace_file, "hour,occupied,speech_db,speech_activity,leq_db,log_lux\n");
+  }
+  if (sim_options.history_trace_path){
+      history_trace_file = fopen(sim_options.history_trace_path, "w");
+      if (!history_trace_file){
+          perror(sim_options.history_trace_path);
+          return 2;
+      }
+      fprintf(history_trace_file, "time,flags,sound_class,leq_db,humidity,lux,temp_e2\n");
+  }
+  end_ns = (uint64_t)(sim_options.hours * 3600.0 * SIM_NS_PER_SEC);
+
+  sim_clock_reset();
+  sim_env_init(sim_options.seed, sim_options.start_hour);
+  sim_gpio_drive_input(PB0_PORT, PB0_PIN, 1);
+  sim_veml6030_attach();
+  sim_si7021_attach();
+  sim_bt_init();
+  sim_msc_init(sim_options.seed);
+
+  app_init();
+  sim_bt_boot();
+  add_centrals();
+  last_occupied = sim_env_occupied(0);
+  sim_clock_schedule(60 * SIM_NS_PER_SEC, occupancy_watch, NULL);
+  sim_clock_schedule(60 * SIM_NS_PER_SEC, light_watch, NULL);
+  sim_clock_schedule(60 * SIM_NS_PER_SEC, climate_watch, NULL);
+
+  while (sim_clock_now_ns() < end_ns){
+      uint64_t before;
+      sl_power_manager_em_t sleep_em;
+
+      // sl_system_process_action(): the stack hands over pending events
+      while (sim_bt_process_one()){
+      }
+
+      app_process_action();
+      occupancy_trace();
+      history_trace();
+
+      // sl_power_manager_sleep(): idle until the next peripheral event
+      before = sim_clock_now_ns();
+      sleep_em = sim_power_lowest_em();
+      (void)sim_irq_take_handled();
+      if (!sim_clock_run_next(end_ns)){
+          sim_stats.em_residency_ns[sleep_em] += end_ns - before;
+          break;
+      }
+      sim_stats.em_residency_ns[sleep_em] += sim_clock_now_ns() - before;
+      if (sim_irq_take_handled() > 0 || sim_bt_pending()){
+          sim_stats.wakeups++;
+      }
+      timebase_watch();
+  }
+
+  if (trace_file){
+      fclose(trace_file);
+  }
+  if (history_trace_file){
+      fclose(history_trace_file);
+  }
+  sim_bt_count_conn_events();
+  print_summary(sim_options.hours);
+  if (sim_options.lcd){
+      sim_lcd_dump();
+  }
+  if (sim_options.check){
+      return run_checks(sim_options.hours) ? 1 : 0;
+  }
+  return 0;
+}
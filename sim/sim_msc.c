@@ -0,0 +1,184 @@
+/***********************************************************************
+ * @file      sim_msc.c
+ * @brief     Emulated internal flash behind the MSC stand-in
+ *
+ * @author    Hyounjun Chang, hyounjun.chang@colorado.edu
+ * @date      Oct 17, 2026
+ *
+ * @resources EFR32xG13 Reference Manual, MSC chapter
+ *
+ * Only the storage region the linker file reserves for the flash log
+ * exists, as linker_storage_begin, and the firmware reads it directly the
+ * way it reads memory mapped flash. It behaves like NOR flash: an erase
+ * sets a page to 0xFF, a write can only clear bits, and MSC_Init() has to
+ * unlock it first. Writing a word that is not erased is counted, the log
+ * never needs to.
+ *
+ * A power cut can be armed to hit after a number of word writes, an erase
+ * counting as a word per word of the page. The operation it hits is left
+ * half done: the words before it are written or erased, the word it hits
+ * has some of its bits changed, and every later call fails until
+ * sim_msc_power_on().
+ *
+ */
+#include <string.h>
+
+#include "sim.h"
+#include "em_msc.h"
+#include "flash_log.h"
+
+#define SIM_MSC_PAGE_WORDS    (FLASH_PAGE_SIZE / 4)
+#define SIM_MSC_STORAGE_WORDS (FLASH_LOG_PAGES * SIM_MSC_PAGE_WORDS)
+
+uint32_t linker_storage_begin[SIM_MSC_STORAGE_WORDS] __attribute__((aligned(FLASH_PAGE_SIZE)));
+
+static bool unlocked = false;
+static bool powered = true;
+static uint64_t cut_after = 0;   // word writes to the power cut, 0 for none
+static uint32_t page_erases[FLASH_LOG_PAGES];
+static sim_msc_stats_t stats;
+static uint32_t rng = 1;
+
+static uint32_t msc_random(){
+  // xorshift32
+  rng ^= rng << 13;
+  rng ^= rng >> 17;
+  rng ^= rng << 5;
+  return rng;
+}
+
+void sim_msc_init(uint32_t seed){
+  memset(linker_storage_begin, 0xFF, sizeof(linker_storage_begin));
+  memset(page_erases, 0, sizeof(page_erases));
+  memset(&stats, 0, sizeof(stats));
+  unlocked = false;
+  powered = true;
+  cut_after = 0;
+  rng = 0x2545F491u ^ (seed * 2654435761u);
+  if (rng == 0){
+      rng = 1;
+  }
+}
+
+void sim_msc_scramble(){
+  for (uint32_t i = 0; i < SIM_MSC_STORAGE_WORDS; i++){
+      linker_storage_begin[i] = msc_random();
+  }
+}
+
+void sim_msc_cut_after(uint64_t words){
+  cut_after = words;
+}
+
+bool sim_msc_powered(){
+  return powered;
+}
+
+void sim_msc_power_on(){
+  powered = true;
+  unlocked = false;
+  cut_after = 0;
+}
+
+const sim_msc_stats_t* sim_msc_stats(){
+  return &stats;
+}
+
+uint32_t sim_msc_page_erases(uint32_t page){
+  return page < FLASH_LOG_PAGES ? page_erases[page] : 0;
+}
+
+// true if the power goes with this word
+static bool cut_now(){
+  if (cut_after == 0){
+      return false;
+  }
+  if (--cut_after > 0){
+      return false;
+  }
+  powered = false;
+  stats.cuts++;
+  return true;
+}
+
+// word index in the storage, -1 outside it
+static int32_t storage_index(const uint32_t* address){
+  uintptr_t offset = (uintptr_t)address - (uintptr_t)linker_storage_begin;
+  if ((uintptr_t)address < (uintptr_t)linker_storage_begin ||
+      offset >= sizeof(linker_storage_begin)){
+      return -1;
+  }
+  return (int32_t)(offset / 4);
+}
+
+void MSC_Init(void){
+  unlocked = true;
+}
+
+void MSC_Deinit(void){
+  unlocked = false;
+}
+
+MSC_Status_TypeDef MSC_ErasePage(uint32_t* startAddress){
+  int32_t index = storage_index(startAddress);
+  if (!powered){
+      return mscReturnTimeOut;
+  }
+  if (index < 0){
+      stats.invalid++;
+      return mscReturnInvalidAddr;
+  }
+  if (index % SIM_MSC_PAGE_WORDS != 0){
+      stats.invalid++;
+      return mscReturnUnaligned;
+  }
+  if (!unlocked){
+      stats.locked++;
+      return mscReturnLocked;
+  }
+  for (uint32_t i = 0; i < SIM_MSC_PAGE_WORDS; i++){
+      if (cut_now()){
+          linker_storage_begin[index + i] |= msc_random();
+          return mscReturnTimeOut;
+      }
+      linker_storage_begin[index + i] = 0xFFFFFFFFUL;
+  }
+  page_erases[index / SIM_MSC_PAGE_WORDS]++;
+  stats.erases++;
+  return mscReturnOk;
+}
+
+MSC_Status_TypeDef MSC_WriteWord(uint32_t* address, void const* data, uint32_t numBytes){
+  int32_t index = storage_index(address);
+  const uint8_t* bytes = data;
+  uint32_t word;
+  if (!powered){
+      return mscReturnTimeOut;
+  }
+  if (index < 0 || storage_index(address + numBytes / 4 - 1) < 0){
+      stats.invalid++;
+      return mscReturnInvalidAddr;
+  }
+  if (numBytes % 4 != 0){
+      stats.invalid++;
+      return mscReturnUnaligned;
+  }
+  if (!unlocked){
+      stats.locked++;
+      return mscReturnLocked;
+  }
+  for (uint32_t i = 0; i < numBytes / 4; i++){
+      memcpy(&word, &bytes[4 * i], 4);
+      if (linker_storage_begin[index + i] != 0xFFFFFFFFUL){
+          stats.overwrites++;
+      }
+      if (cut_now()){
+          linker_storage_begin[index + i] &= word | msc_random();
+          return mscReturnTimeOut;
+      }
+      // programming only clears bits
+      linker_storage_begin[index + i] &= word;
+      stats.words++;
+  }
+  return mscReturnOk;
+}
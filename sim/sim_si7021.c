@@ -0,0 +1,176 @@
+/***********************************************************************
+ * @file      sim_si7021.c
+ * @brief     Si7021 humidity and temperature sensor model on the fake I2C bus
+ *
+ * @author    Hyounjun Chang, hyounjun.chang@colorado.edu
+ * @date      Oct 17, 2026
+ *
+ * @resources Silicon Labs Si7021-A20 datasheet, rev 1.2
+ *
+ * Powered from SENSOR_ENABLE (PD15, shared with the LCD). Until the
+ * power-up time has passed after it goes high the sensor NACKs its
+ * address. A no hold master measure command converts the humidity and
+ * then the temperature at the maximum conversion times; reads before
+ * that are NACKed, the way the real part answers no hold polling.
+ * Results are MSB first, a third byte read gets the CRC.
+ *
+ */
+#include "sim.h"
+
+#define SI7021_ADDR 0x40
+
+// board wiring, see gpio.c
+#define SI7021_ENABLE_PORT gpioPortD
+#define SI7021_ENABLE_PIN  15
+
+#define CMD_MEASURE_RH_NO_HOLD    0xF5
+#define CMD_MEASURE_TEMP_NO_HOLD  0xF3
+#define CMD_READ_TEMP_FROM_RH     0xE0
+#define CMD_RESET                 0xFE
+
+// datasheet maximums
+#define POWER_UP_NS       (80 * SIM_NS_PER_MS)
+#define RH_CONVERSION_NS  (12 * SIM_NS_PER_MS)
+#define TEMP_CONVERSION_NS (10800 * SIM_NS_PER_US)
+
+typedef struct {
+  bool powered;
+  uint64_t ready_ns;      // power-up or reset over
+  uint64_t done_ns;       // conversion in progress until then
+  uint8_t cmd;
+  uint16_t rh_code;
+  uint16_t temp_code;
+  bool rh_valid;          // a humidity measurement has finished since power-up
+} si7021_model_t;
+
+static si7021_model_t si7021;
+
+static uint16_t rh_code(double rh){
+  double code = (rh + 6.0) * 65536.0 / 125.0;
+  if (code < 0.0){
+      code = 0.0;
+  }
+  if (code > 65535.0){
+      code = 65535.0;
+  }
+  return (uint16_t)code & ~0x3;
+}
+
+static uint16_t temp_code(double t){
+  double code = (t + 46.85) * 65536.0 / 175.72;
+  if (code < 0.0){
+      code = 0.0;
+  }
+  if (code > 65535.0){
+      code = 65535.0;
+  }
+  return (uint16_t)code & ~0x3;
+}
+
+// CRC-8, polynomial x^8 + x^5 + x^4 + 1, init 0
+static uint8_t crc8(const uint8_t* data, int len){
+  uint8_t crc = 0;
+  for (int i = 0; i < len; i++){
+      crc ^= data[i];
+      for (int b = 0; b < 8; b++){
+          crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x31) : (uint8_t)(crc << 1);
+      }
+  }
+  return crc;
+}
+
+static bool awake(si7021_model_t* m){
+  return m->powered && sim_clock_now_ns() >= m->ready_ns;
+}
+
+static I2C_TransferReturn_TypeDef si7021_write(void* ctx, const uint8_t* data, uint16_t len){
+  si7021_model_t* m = ctx;
+  uint64_t now = sim_clock_now_ns();
+
+  // busy converting or still powering up, the address is not acknowledged
+  if (!awake(m) || now < m->done_ns){
+      return i2cTransferNack;
+  }
+  if (len == 0){
+      return i2cTransferDone;
+  }
+  m->cmd = data[0];
+  switch (m->cmd){
+    case CMD_MEASURE_RH_NO_HOLD:
+      // sampled at the start, the room does not change in 23 ms
+      m->rh_code = rh_code(sim_env_humidity_pct(now));
+      m->temp_code = temp_code(sim_env_temperature_c(now));
+      m->done_ns = now + RH_CONVERSION_NS + TEMP_CONVERSION_NS;
+      m->rh_valid = true;
+      break;
+    case CMD_MEASURE_TEMP_NO_HOLD:
+      m->temp_code = temp_code(sim_env_temperature_c(now));
+      m->done_ns = now + TEMP_CONVERSION_NS;
+      break;
+    case CMD_RESET:
+      m->ready_ns = now + 15 * SIM_NS_PER_MS;
+      m->rh_valid = false;
+      break;
+    default:
+      break;
+  }
+  return i2cTransferDone;
+}
+
+static I2C_TransferReturn_TypeDef si7021_read(void* ctx, uint8_t* data, uint16_t len){
+  si7021_model_t* m = ctx;
+  uint8_t value[3];
+  uint16_t code;
+
+  if (!awake(m) || sim_clock_now_ns() < m->done_ns){
+      return i2cTransferNack;
+  }
+  switch (m->cmd){
+    case CMD_MEASURE_RH_NO_HOLD:
+      code = m->rh_code;
+      break;
+    case CMD_MEASURE_TEMP_NO_HOLD:
+      code = m->temp_code;
+      break;
+    case CMD_READ_TEMP_FROM_RH:
+      if (!m->rh_valid){
+          return i2cTransferNack;
+      }
+      code = m->temp_code;
+      break;
+    default:
+      return i2cTransferNack;
+  }
+  value[0] = (uint8_t)(code >> 8);
+  value[1] = (uint8_t)code;
+  value[2] = crc8(value, 2);
+  for (uint16_t i = 0; i < len; i++){
+      data[i] = i < 3 ? value[i] : 0xFF;
+  }
+  return i2cTransferDone;
+}
+
+void sim_si7021_gpio_output(GPIO_Port_TypeDef port, unsigned int pin, unsigned int level){
+  if (port != SI7021_ENABLE_PORT || pin != SI7021_ENABLE_PIN){
+      return;
+  }
+  if (level && !si7021.powered){
+      si7021.ready_ns = sim_clock_now_ns() + POWER_UP_NS;
+      si7021.done_ns = 0;
+      si7021.rh_valid = false;
+  }
+  si7021.powered = level ? true : false;
+}
+
+void sim_si7021_attach(){
+  sim_i2c_device_t dev = {
+    .addr = SI7021_ADDR,
+    .write = si7021_write,
+    .read = si7021_read,
+    .ctx = &si7021
+  };
+  si7021.powered = false;
+  si7021.done_ns = 0;
+  si7021.rh_valid = false;
+  sim_i2c_attach(&dev);
+}
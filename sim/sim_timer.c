@@ -0,0 +1,135 @@
+/***********************************************************************
+ * @file      sim_timer.c
+ * @brief     Simulated TIMER0 and PRS routing
+ *
+ * @author    Hyounjun Chang, hyounjun.chang@colorado.edu
+ * @date      Oct 16, 2026
+ *
+ * @resources EFR32xG13 reference manual, TIMER and PRS chapters
+ *
+ * TIMER0 is never stepped tick by tick. While it runs its overflow times
+ * are a closed-form function of the start time, so consumers (ADC through
+ * PRS, LDMA) can ask "how many overflows up to t" or "when is overflow n".
+ * Every configuration change notifies the LDMA model first so it can
+ * settle samples taken under the old configuration.
+ *
+ */
+#include "sim.h"
+#include "em_cmu.h"
+#include "em_timer.h"
+#include "em_prs.h"
+
+struct sim_timer {
+  bool running;
+  uint32_t top;
+  uint32_t prescale;   // divider, 1..1024
+  uint32_t cnt;        // counter value at start_ns (or while stopped)
+  uint64_t start_ns;
+};
+
+TIMER_TypeDef sim_timer0 = { .top = 0xFFFF, .prescale = 1 };
+
+static uint32_t prs_source[PRS_CHAN_COUNT];
+static uint32_t prs_signal[PRS_CHAN_COUNT];
+
+static uint64_t timer_freq(){
+  return CMU_ClockFreqGet(cmuClock_TIMER0);
+}
+
+// timer ticks elapsed between start_ns and t_ns
+static uint64_t ticks_since_start(TIMER_TypeDef* timer, uint64_t t_ns){
+  if (t_ns <= timer->start_ns){
+      return 0;
+  }
+  unsigned __int128 ticks = (unsigned __int128)(t_ns - timer->start_ns) * timer_freq();
+  return (uint64_t)(ticks / ((unsigned __int128)timer->prescale * SIM_NS_PER_SEC));
+}
+
+static uint32_t counter_now(TIMER_TypeDef* timer){
+  if (!timer->running){
+      return timer->cnt;
+  }
+  uint64_t ticks = ticks_since_start(timer, sim_clock_now_ns()) + timer->cnt;
+  return (uint32_t)(ticks % ((uint64_t)timer->top + 1));
+}
+
+// counter keeps its value across a reconfiguration, restart from there
+static void rebase(TIMER_TypeDef* timer){
+  timer->cnt = counter_now(timer);
+  timer->start_ns = sim_clock_now_ns();
+}
+
+bool sim_timer0_running(){
+  return sim_timer0.running;
+}
+
+uint64_t sim_timer0_overflows(uint64_t t_ns){
+  TIMER_TypeDef* timer = &sim_timer0;
+  if (!timer->running){
+      return 0;
+  }
+  return (ticks_since_start(timer, t_ns) + timer->cnt) / ((uint64_t)timer->top + 1);
+}
+
+uint64_t sim_timer0_overflow_ns(uint64_t n){
+  TIMER_TypeDef* timer = &sim_timer0;
+  // tick at which overflow n happens, relative to start_ns
+  uint64_t ticks = n * ((uint64_t)timer->top + 1) - timer->cnt;
+  unsigned __int128 ns = (unsigned __int128)ticks * timer->prescale * SIM_NS_PER_SEC;
+  uint64_t freq = timer_freq();
+  return timer->start_ns + (uint64_t)((ns + freq - 1) / freq);
+}
+
+bool sim_prs_is_timer0_overflow(unsigned int ch){
+  return ch < PRS_CHAN_COUNT &&
+         prs_source[ch] == PRS_CH_CTRL_SOURCESEL_TIMER0 &&
+         prs_signal[ch] == PRS_CH_CTRL_SIGSEL_TIMER0OF;
+}
+
+void TIMER_Init(TIMER_TypeDef* timer, const TIMER_Init_TypeDef* init){
+  sim_ldma_pacing_changing();
+  rebase(timer);
+  timer->prescale = 1u << init->prescale;
+  timer->running = init->enable;
+  timer->cnt = 0;
+  sim_ldma_pacing_changed();
+}
+
+void TIMER_Enable(TIMER_TypeDef* timer, bool enable){
+  sim_ldma_pacing_changing();
+  rebase(timer);
+  timer->running = enable;
+  sim_ldma_pacing_changed();
+}
+
+void TIMER_TopSet(TIMER_TypeDef* timer, uint32_t val){
+  sim_ldma_pacing_changing();
+  rebase(timer);
+  timer->top = val & 0xFFFF;
+  if (timer->cnt > timer->top){
+      timer->cnt = 0;
+  }
+  sim_ldma_pacing_changed();
+}
+
+uint32_t TIMER_TopGet(TIMER_TypeDef* timer){
+  return timer->top;
+}
+
+void TIMER_CounterSet(TIMER_TypeDef* timer, uint32_t val){
+  sim_ldma_pacing_changing();
+  rebase(timer);
+  timer->cnt = val & 0xFFFF;
+  sim_ldma_pacing_changed();
+}
+
+void PRS_SourceSignalSet(unsigned int ch, uint32_t source, uint32_t signal, PRS_Edge_TypeDef edge){
+  (void)edge;
+  if (ch >= PRS_CHAN_COUNT){
+      return;
+  }
+  sim_ldma_pacing_changing();
+  prs_source[ch] = source;
+  prs_signal[ch] = signal;
+  sim_ldma_pacing_changed();
+}
@@ -0,0 +1,163 @@
+/***********************************************************************
+ * @file      sim_veml6030.c
+ * @brief     VEML6030 ambient light sensor model on the fake I2C bus
+ *
+ * @author    Hyounjun Chang, hyounjun.chang@colorado.edu
+ * @date      Oct 16, 2026
+ *
+ * @resources Vishay VEML6030 datasheet (doc 84366) and application note
+ *            "Designing the VEML6030 into an Application" (doc 84367)
+ *
+ * Command codes address 16-bit registers sent LSB first. The sensor
+ * measures once per refresh time: the environment lux divided by the
+ * resolution for the configured gain and integration time, clipped at 16
+ * bits. With ALS_INT_EN a measurement above ALS_WH or below ALS_WL pulls
+ * the INT line low until ALS_INT is read.
+ *
+ */
+#include <math.h>
+
+#include "sim.h"
+
+#define VEML6030_ADDR 0x48
+
+// board wiring, see gpio.c
+#define VEML6030_INT_PORT gpioPortD
+#define VEML6030_INT_PIN  10
+
+#define REG_ALS_CONF  0x00
+#define REG_ALS_WH    0x01
+#define REG_ALS_WL    0x02
+#define REG_PSM       0x03
+#define REG_ALS       0x04
+#define REG_WHITE     0x05
+#define REG_ALS_INT   0x06
+#define NUM_REGS      0x07
+
+#define ALS_CONF_SD      0x0001
+#define ALS_CONF_INT_EN  0x0002
+#define ALS_INT_TH_HIGH  0x4000
+#define ALS_INT_TH_LOW   0x8000
+
+typedef struct {
+  uint16_t regs[NUM_REGS];
+  uint8_t cmd;
+  bool measuring;     // a measurement is scheduled
+  bool int_low;       // INT pulled low, until ALS_INT is read
+} veml6030_model_t;
+
+static veml6030_model_t veml6030;
+
+// lux per count at ALS_IT = 100 ms, indexed by ALS_GAIN (x1, x2, x1/8, x1/4)
+static const double resolution_100ms[4] = { 0.0576, 0.0288, 0.4608, 0.2304 };
+
+static double it_scale(uint16_t conf){
+  switch ((conf >> 6) & 0xF){
+    case 0xC: return 4.0;   // 25 ms
+    case 0x8: return 2.0;   // 50 ms
+    case 0x0: return 1.0;   // 100 ms
+    case 0x1: return 0.5;   // 200 ms
+    case 0x2: return 0.25;  // 400 ms
+    case 0x3: return 0.125; // 800 ms
+    default:  return 1.0;
+  }
+}
+
+static uint16_t als_counts(veml6030_model_t* m){
+  uint16_t conf = m->regs[REG_ALS_CONF];
+  double resolution = resolution_100ms[(conf >> 11) & 0x3] * it_scale(conf);
+  double counts = floor(sim_env_lux(sim_clock_now_ns()) / resolution);
+  if (counts > 65535.0){
+      counts = 65535.0;
+  }
+  return (uint16_t)counts;
+}
+
+// integration time plus the power saving wait of PSM (0.5, 1, 2, 4 s)
+static uint64_t refresh_ns(veml6030_model_t* m){
+  uint64_t it_ms = (uint64_t)(100.0 / it_scale(m->regs[REG_ALS_CONF]));
+  uint16_t psm = m->regs[REG_PSM];
+  if (psm & 0x1){
+      it_ms += 500ULL << ((psm >> 1) & 0x3);
+  }
+  return it_ms * SIM_NS_PER_MS;
+}
+
+static void measure(void* ctx){
+  veml6030_model_t* m = ctx;
+  uint16_t conf = m->regs[REG_ALS_CONF];
+
+  if (conf & ALS_CONF_SD){
+      m->measuring = false;
+      return;
+  }
+  m->regs[REG_ALS] = als_counts(m);
+  if (conf & ALS_CONF_INT_EN){
+      if (m->regs[REG_ALS] > m->regs[REG_ALS_WH]){
+          m->regs[REG_ALS_INT] |= ALS_INT_TH_HIGH;
+      }
+      if (m->regs[REG_ALS] < m->regs[REG_ALS_WL]){
+          m->regs[REG_ALS_INT] |= ALS_INT_TH_LOW;
+      }
+      if (m->regs[REG_ALS_INT] && !m->int_low){
+          m->int_low = true;
+          sim_stats.als_interrupts++;
+          sim_gpio_drive_input(VEML6030_INT_PORT, VEML6030_INT_PIN, 0);
+      }
+  }
+  sim_clock_schedule(sim_clock_now_ns() + refresh_ns(m), measure, m);
+}
+
+static I2C_TransferReturn_TypeDef veml6030_write(void* ctx, const uint8_t* data, uint16_t len){
+  veml6030_model_t* m = ctx;
+  if (len == 0){
+      return i2cTransferDone;
+  }
+  m->cmd = data[0];
+  if (len >= 3 && m->cmd < NUM_REGS && m->cmd != REG_ALS && m->cmd != REG_WHITE &&
+      m->cmd != REG_ALS_INT){
+      m->regs[m->cmd] = (uint16_t)data[1] | ((uint16_t)data[2] << 8);
+  }
+  // measurements start once the sensor is powered on
+  if (!(m->regs[REG_ALS_CONF] & ALS_CONF_SD) && !m->measuring){
+      m->measuring = true;
+      sim_clock_schedule(sim_clock_now_ns() + refresh_ns(m), measure, m);
+  }
+  return i2cTransferDone;
+}
+
+static I2C_TransferReturn_TypeDef veml6030_read(void* ctx, uint8_t* data, uint16_t len){
+  veml6030_model_t* m = ctx;
+  uint16_t value = 0;
+  if (m->cmd == REG_ALS_INT){
+      // reading the status clears it and releases INT
+      value = m->regs[REG_ALS_INT];
+      m->regs[REG_ALS_INT] = 0;
+      m->int_low = false;
+      sim_gpio_drive_input(VEML6030_INT_PORT, VEML6030_INT_PIN, 1);
+  }
+  else if (m->cmd < NUM_REGS){
+      value = m->regs[m->cmd];
+  }
+  if (len > 0){
+      data[0] = (uint8_t)value;
+  }
+  if (len > 1){
+      data[1] = (uint8_t)(value >> 8);
+  }
+  return i2cTransferDone;
+}
+
+void sim_veml6030_attach(){
+  sim_i2c_device_t dev = {
+    .addr = VEML6030_ADDR,
+    .write = veml6030_write,
+    .read = veml6030_read,
+    .ctx = &veml6030
+  };
+  veml6030.regs[REG_ALS_CONF] = ALS_CONF_SD; // powers up in shutdown
+  veml6030.measuring = false;
+  veml6030.int_low = false;
+  sim_gpio_drive_input(VEML6030_INT_PORT, VEML6030_INT_PIN, 1); // pulled up
+  sim_i2c_attach(&dev);
+}
@@ -0,0 +1,293 @@
+/***********************************************************************
+ * @file      train_occupancy.c
+ * @brief     Host harness: fits and scores the occupancy model in src/occupancy.c
+ *
+ * @author    Hyounjun Chang, hyounjun.chang@colorado.edu
+ * @date      Oct 16, 2026
+ *
+ * @resources CMSIS-DSP Bayesian estimators, scikit-learn GaussianNB
+ *
+ * Reads labelled feature traces written by study_space_sim --trace, fits
+ * the per-class means, variances and priors of a Gaussian naive Bayes model
+ * on the first one and replays the second through the same predict and
+ * decide functions the firmware runs. Reports accuracy per period, after the
+ * smoothing, and the cost of one inference. Host cycles come from the
+ * reference predict in sim_cmsis_dsp.c, two classes by four features is a
+ * few hundred cycles on the M4 with its FPU.
+ *
+ * With --model FILE the fitted model is written out in the layout of
+ * src/occupancy_model.c, which is how that file is produced.
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCH_HAVE_TSC 1
+#else
+#define BENCH_HAVE_TSC 0
+#endif
+
+#include "arm_math.h"
+#include "src/occupancy.h"
+
+#define TRACE_MAX_ROWS      20000
+#define BENCH_INFERENCES    200000
+// variance added to every feature, as a share of the largest variance,
+// keeps a feature that never moves in one class from deciding alone
+#define VAR_SMOOTHING       1e-2
+
+extern const arm_gaussian_naive_bayes_instance_f32 occupancy_model;
+
+typedef struct {
+  float hour;
+  int label;
+  float x[OCCUPANCY_FEATURES];
+} trace_row_t;
+
+typedef struct {
+  trace_row_t* rows;
+  uint32_t count;
+} trace_t;
+
+static const char* feature_names[OCCUPANCY_FEATURES] = {
+  "speech dB", "speech activity", "Leq dB", "log10(lux + 1)",
+};
+
+static float fit_theta[OCCUPANCY_CLASSES * OCCUPANCY_FEATURES];
+static float fit_sigma[OCCUPANCY_CLASSES * OCCUPANCY_FEATURES];
+static float fit_priors[OCCUPANCY_CLASSES];
+static arm_gaussian_naive_bayes_instance_f32 fit_model = {
+  .vectorDimension = OCCUPANCY_FEATURES,
+  .numberOfClasses = OCCUPANCY_CLASSES,
+  .theta = fit_theta,
+  .sigma = fit_sigma,
+  .classPriors = fit_priors,
+};
+
+static void read_trace(const char* path, trace_t* trace){
+  char line[256];
+  FILE* f = fopen(path, "r");
+  if (!f){
+      perror(path);
+      exit(2);
+  }
+  trace->rows = calloc(TRACE_MAX_ROWS, sizeof(trace_row_t));
+  trace->count = 0;
+  while (fgets(line, sizeof(line), f) && trace->count < TRACE_MAX_ROWS){
+      trace_row_t* r = &trace->rows[trace->count];
+      if (sscanf(line, "%f,%d,%f,%f,%f,%f", &r->hour, &r->label,
+                 &r->x[0], &r->x[1], &r->x[2], &r->x[3]) == 2 + OCCUPANCY_FEATURES){
+          trace->count++;
+      }
+  }
+  fclose(f);
+  if (trace->count == 0){
+      fprintf(stderr, "%s: no feature vectors\n", path);
+      exit(2);
+  }
+}
+
+static void fit(const trace_t* trace){
+  double sum[OCCUPANCY_CLASSES][OCCUPANCY_FEATURES] = {{0}};
+  double sum_sq[OCCUPANCY_CLASSES][OCCUPANCY_FEATURES] = {{0}};
+  uint32_t count[OCCUPANCY_CLASSES] = {0};
+  double max_var = 0.0;
+
+  for (uint32_t i = 0; i < trace->count; i++){
+      const trace_row_t* r = &trace->rows[i];
+      count[r->label]++;
+      for (int d = 0; d < OCCUPANCY_FEATURES; d++){
+          sum[r->label][d] += r->x[d];
+          sum_sq[r->label][d] += (double)r->x[d] * r->x[d];
+      }
+  }
+  for (int c = 0; c < OCCUPANCY_CLASSES; c++){
+      fit_priors[c] = (float)count[c] / trace->count;
+      for (int d = 0; d < OCCUPANCY_FEATURES; d++){
+          double mean = count[c] ? sum[c][d] / count[c] : 0.0;
+          double var = count[c] ? sum_sq[c][d] / count[c] - mean * mean : 0.0;
+          if (var < 0.0){
+              var = 0.0;
+          }
+          fit_theta[c * OCCUPANCY_FEATURES + d] = (float)mean;
+          fit_sigma[c * OCCUPANCY_FEATURES + d] = (float)var;
+          if (var > max_var){
+              max_var = var;
+          }
+      }
+  }
+  fit_model.epsilon = (float)(VAR_SMOOTHING * max_var);
+}
+
+// same normalization as occupancy_predict(), for a model other than the flash one
+static float predict_with(const arm_gaussian_naive_bayes_instance_f32* model, const float* x){
+  float32_t log_posterior[OCCUPANCY_CLASSES];
+  float32_t scratch[OCCUPANCY_CLASSES];
+  (void)arm_gaussian_naive_bayes_predict_f32(model, x, log_posterior, scratch);
+  float margin = log_posterior[OCCUPANCY_AVAILABLE] - log_posterior[OCCUPANCY_OCCUPIED];
+  if (margin > 80.0f){
+      return 0.0f;
+  }
+  if (margin < -80.0f){
+      return 1.0f;
+  }
+  return 1.0f / (1.0f + expf(margin));
+}
+
+static void report(const char* name, const uint32_t confusion[2][2]){
+  uint32_t total = confusion[0][0] + confusion[0][1] + confusion[1][0] + confusion[1][1];
+  printf("  %-26s %6.2f%%  (true avail: %u ok, %u wrong; true occupied: %u ok, %u wrong)\n",
+         name, 100.0 * (confusion[0][0] + confusion[1][1]) / total,
+         confusion[0][0], confusion[0][1], confusion[1][1], confusion[1][0]);
+}
+
+// per period and after occupancy_decide(), confusion[truth][decision]
+static void evaluate(const char* name, const arm_gaussian_naive_bayes_instance_f32* model,
+                     const trace_t* trace){
+  uint32_t raw[2][2] = {{0}};
+  uint32_t smoothed[2][2] = {{0}};
+  bool occupied = false;
+  char label[64];
+
+  initOccupancy();
+  for (uint32_t i = 0; i < trace->count; i++){
+      const trace_row_t* r = &trace->rows[i];
+      float p = model ? predict_with(model, r->x) : occupancy_predict(r->x);
+      raw[r->label][p >= 0.5f]++;
+      (void)occupancy_decide(p, &occupied);
+      smoothed[r->label][occupied]++;
+  }
+  snprintf(label, sizeof(label), "%s, per period", name);
+  report(label, raw);
+  snprintf(label, sizeof(label), "%s, smoothed", name);
+  report(label, smoothed);
+}
+
+static double now_s(){
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static uint64_t now_cycles(){
+#if BENCH_HAVE_TSC
+  return __rdtsc();
+#else
+  return 0;
+#endif
+}
+
+static void write_model(const char* path){
+  FILE* f = fopen(path, "w");
+  if (!f){
+      perror(path);
+      exit(2);
+  }
+  fprintf(f,
+          "/***********************************************************************\n"
+          " * @file      occupancy_model.c\n"
+          " * @brief     Gaussian naive Bayes occupancy model, kept in flash\n"
+          " *\n"
+          " * @author    Hyounjun Chang, hyounjun.chang@colorado.edu\n"
+          " * @date      Oct 16, 2026\n"
+          " *\n"
+          " * @resources generated by sim/train_occupancy.c, do not edit\n"
+          " *\n"
+          " */\n"
+          "#include \"occupancy.h\"\n"
+          "\n"
+          "#include \"arm_math.h\"\n"
+          "\n"
+          "// per class: speech dB, speech activity, Leq dB, log10(lux + 1)\n"
+          "static const float32_t occupancy_theta[OCCUPANCY_CLASSES * OCCUPANCY_FEATURES] = {\n");
+  for (int c = 0; c < OCCUPANCY_CLASSES; c++){
+      fprintf(f, " ");
+      for (int d = 0; d < OCCUPANCY_FEATURES; d++){
+          fprintf(f, " %.6gf,", fit_theta[c * OCCUPANCY_FEATURES + d]);
+      }
+      fprintf(f, "\n");
+  }
+  fprintf(f, "};\n\nstatic const float32_t occupancy_sigma[OCCUPANCY_CLASSES * OCCUPANCY_FEATURES] = {\n");
+  for (int c = 0; c < OCCUPANCY_CLASSES; c++){
+      fprintf(f, " ");
+      for (int d = 0; d < OCCUPANCY_FEATURES; d++){
+          fprintf(f, " %.6gf,", fit_sigma[c * OCCUPANCY_FEATURES + d]);
+      }
+      fprintf(f, "\n");
+  }
+  fprintf(f, "};\n\nstatic const float32_t occupancy_priors[OCCUPANCY_CLASSES] = {\n ");
+  for (int c = 0; c < OCCUPANCY_CLASSES; c++){
+      fprintf(f, " %.6gf,", fit_priors[c]);
+  }
+  fprintf(f,
+          "\n};\n"
+          "\n"
+          "const arm_gaussian_naive_bayes_instance_f32 occupancy_model = {\n"
+          "  .vectorDimension = OCCUPANCY_FEATURES,\n"
+          "  .numberOfClasses = OCCUPANCY_CLASSES,\n"
+          "  .theta = occupancy_theta,\n"
+          "  .sigma = occupancy_sigma,\n"
+          "  .classPriors = occupancy_priors,\n"
+          "  .epsilon = %.6gf,\n"
+          "};\n", fit_model.epsilon);
+  fclose(f);
+}
+
+int main(int argc, char** argv){
+  trace_t train;
+  trace_t test;
+  const char* model_path = NULL;
+
+  if (argc == 5 && strcmp(argv[3], "--model") == 0){
+      model_path = argv[4];
+  }
+  else if (argc != 3){
+      fprintf(stderr, "usage: %s TRAIN.csv TEST.csv [--model FILE]\n", argv[0]);
+      return 2;
+  }
+  read_trace(argv[1], &train);
+  read_trace(argv[2], &test);
+
+  fit(&train);
+  printf("fitted on %u periods of %d sound windows, epsilon %.4g\n", train.count,
+         OCCUPANCY_PERIOD_WINDOWS, fit_model.epsilon);
+  printf("  %-18s %20s %20s\n", "", "available", "occupied");
+  for (int d = 0; d < OCCUPANCY_FEATURES; d++){
+      printf("  %-18s %9.3f +- %-8.3f %9.3f +- %-8.3f\n", feature_names[d],
+             fit_theta[d], sqrt(fit_sigma[d]),
+             fit_theta[OCCUPANCY_FEATURES + d], sqrt(fit_sigma[OCCUPANCY_FEATURES + d]));
+  }
+  printf("  %-18s %20.3f %20.3f\n", "prior", fit_priors[0], fit_priors[1]);
+
+  printf("test trace, %u periods\n", test.count);
+  evaluate("fitted model", &fit_model, &test);
+  evaluate("flash model", NULL, &test);
+
+  // inference cost of the flash model, predict plus the logistic
+  volatile float sink = 0.0f;
+  double start = now_s();
+  uint64_t start_cycles = now_cycles();
+  for (uint32_t i = 0; i < BENCH_INFERENCES; i++){
+      sink += occupancy_predict(test.rows[i % test.count].x);
+  }
+  double elapsed = now_s() - start;
+  uint64_t cycles = now_cycles() - start_cycles;
+  printf("inference, host build: %.1f ns", elapsed * 1e9 / BENCH_INFERENCES);
+  if (BENCH_HAVE_TSC){
+      printf(", %.0f host cycles", (double)cycles / BENCH_INFERENCES);
+  }
+  printf(" per feature vector\n");
+
+  if (model_path){
+      write_model(model_path);
+      printf("model written to %s\n", model_path);
+  }
+  free(train.rows);
+  free(test.rows);
+  return 0;
+}
@@ -21,6 +21,12 @@
 #include "em_emu.h"
 #include "em_gpio.h"
 #include "em_letimer.h"
+#include "em_timer.h"
+#include "em_prs.h"
+#include "em_ldma.h"
+#include "em_core.h"
+#include "sl_power_manager.h"
+#include "app.h"
 
 // Note: em_adc.h was not included in Gecko 4.3.2 sdk, so source header file was copied over to /src
 // from https://github.com/SiliconLabs/gecko_sdk/blob/59d2160fe448b13730a91c0f019a8b4c53c43eb2/platform/emlib/inc/em_adc.h
@@ -38,6 +44,104 @@
 uint32_t adc_mv = 0; // ADC value in mV (max 2.5V)
 bool ok_to_update_gatt = false;
 
+#if SOUND_SAMPLING_LDMA
+// ping-pong buffers, LDMA fills one while the main loop reads the other
+static uint16_t sound_buffers[2][SOUND_BUFFER_SAMPLES];
+static LDMA_Descriptor_t sound_descriptors[2];
+static LDMA_TransferCfg_t sound_transfer_cfg;
+
+static volatile bool sound_capture_active = false;
+static volatile uint32_t sound_buffers_filled = 0;
+
+static void initSoundCapture(){
+  CMU_ClockEnable(cmuClock_TIMER0, true);
+  CMU_ClockEnable(cmuClock_PRS, true);
+  CMU_ClockEnable(cmuClock_LDMA, true);
+
+  // TIMER0 overflows at the sample rate, left stopped until a window starts
+  TIMER_Init_TypeDef timerInit = TIMER_INIT_DEFAULT;
+  timerInit.enable = false;
+  TIMER_Init(TIMER0, &timerInit);
+  TIMER_TopSet(TIMER0, CMU_ClockFreqGet(cmuClock_TIMER0) / SOUND_SAMPLE_RATE_HZ - 1);
+
+  // every overflow pulse starts one ADC0 single conversion
+  PRS_SourceSignalSet(SOUND_PRS_CHANNEL, PRS_CH_CTRL_SOURCESEL_TIMER0,
+                      PRS_CH_CTRL_SIGSEL_TIMER0OF, prsEdgeOff);
+
+  // same priority as LETIMER0, I2C0 and GPIO, which sl_device_init_nvic()
+  // leaves at the default, so the IRQs feeding the scheduler queue never
+  // preempt each other and CORE critical sections mask LDMA too
+  LDMA_Init_t ldmaInit = LDMA_INIT_DEFAULT;
+  ldmaInit.ldmaInitIrqPriority = CORE_INTERRUPT_DEFAULT_PRIORITY;
+  LDMA_Init(&ldmaInit);
+
+  // each conversion requests one half-word move out of SINGLEDATA and each
+  // descriptor raises the done interrupt. A two buffer window ends with
+  // buffer 1, the LDMA stops there by itself however late the interrupt is
+  // taken. Longer windows link buffer 1 back to buffer 0.
+  sound_transfer_cfg = (LDMA_TransferCfg_t)LDMA_TRANSFER_CFG_PERIPHERAL(ldmaPeripheralSignal_ADC0_SINGLE);
+  sound_descriptors[0] = (LDMA_Descriptor_t)LDMA_DESCRIPTOR_LINKREL_P2M_BYTE(&ADC0->SINGLEDATA,
+                                                                           sound_buffers[0],
+                                                                           SOUND_BUFFER_SAMPLES, 1);
+#if SOUND_BUFFERS_PER_WINDOW == 2
+  sound_descriptors[1] = (LDMA_Descriptor_t)LDMA_DESCRIPTOR_SINGLE_P2M_BYTE(&ADC0->SINGLEDATA,
+                                                                          sound_buffers[1],
+                                                                          SOUND_BUFFER_SAMPLES);
+#else
+  sound_descriptors[1] = (LDMA_Descriptor_t)LDMA_DESCRIPTOR_LINKREL_P2M_BYTE(&ADC0->SINGLEDATA,
+                                                                           sound_buffers[1],
+                                                                           SOUND_BUFFER_SAMPLES, -1);
+#endif
+  sound_descriptors[0].xfer.size = ldmaCtrlSizeHalf;
+  sound_descriptors[1].xfer.size = ldmaCtrlSizeHalf;
+#if SOUND_IRQ_PER_WINDOW
+  // buffer 0 is read together with buffer 1, no need to wake up for it
+  sound_descriptors[0].xfer.doneIfs = 0;
+#endif
+}
+
+void sound_capture_start(){
+  // previous window still running, skip this one
+  if (sound_capture_active){
+      return;
+  }
+  sound_capture_active = true;
+  sound_buffers_filled = 0;
+
+  // TIMER0, ADC0 and LDMA need the HF clocks, stay in EM1 for the window
+  if (LOWEST_ENERGY_MODE >= 2){
+      sl_power_manager_add_em_requirement(SL_POWER_MANAGER_EM1);
+  }
+
+  LDMA_StartTransfer(SOUND_LDMA_CHANNEL, &sound_transfer_cfg, &sound_descriptors[0]);
+  TIMER_CounterSet(TIMER0, 0);
+  TIMER_Enable(TIMER0, true);
+}
+
+uint32_t sound_capture_buffer_done(){
+#if SOUND_IRQ_PER_WINDOW
+  sound_buffers_filled = SOUND_BUFFERS_PER_WINDOW - 1;
+#endif
+  uint32_t n = sound_buffers_filled++;
+
+  // window complete, stop pacing. A two buffer window's LDMA has ended on
+  // its own already, a longer one is stopped before it wraps into buffer 0.
+  if (sound_buffers_filled >= SOUND_BUFFERS_PER_WINDOW){
+      TIMER_Enable(TIMER0, false);
+      LDMA_StopTransfer(SOUND_LDMA_CHANNEL);
+      if (LOWEST_ENERGY_MODE >= 2){
+          sl_power_manager_remove_em_requirement(SL_POWER_MANAGER_EM1);
+      }
+      sound_capture_active = false;
+  }
+  return n;
+}
+
+const uint16_t* sound_capture_buffer(uint32_t n){
+  return sound_buffers[n & 1];
+}
+#endif
+
 /**************************************************************************//**
  * @brief ADC initialization
  * Source: https://github.com/SiliconLabs/peripheral_examples/blob/master/series1/adc/adc_single_letimer_interrupt/src/main_s1.c
@@ -61,6 +165,18 @@ void initADC ()
   initSingle.resolution = adcRes12Bit; // 12-bit resolution
   initSingle.acqTime    = adcAcqTime4; // set acquisition time to meet minimum requirements
 
+#if SOUND_SAMPLING_LDMA
+  // AUDIO output, conversions started by PRS, results moved by LDMA
+  initSingle.posSel = adcPosSelAPORT2XCH20; //Using PF4, APORT2XCH20
+  initSingle.prsEnable = true;
+  initSingle.prsSel = adcPRSSELCh0; // SOUND_PRS_CHANNEL
+
+  ADC_Init(ADC0, &init);
+  ADC_InitSingle(ADC0, &initSingle);
+
+  // no ADC0 interrupt, the CPU only wakes on a full LDMA buffer
+  initSoundCapture();
+#else
   // Select ADC input. See README for corresponding EXP header pin.
   initSingle.posSel = adcPosSelAPORT2XCH19; //Using PF3, APORT2XCH19
 
@@ -74,5 +190,6 @@ void initADC ()
   // Enable ADC interrupts
   NVIC_ClearPendingIRQ(ADC0_IRQn);
   NVIC_EnableIRQ(ADC0_IRQn);
+#endif
 
 }
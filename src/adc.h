@@ -1,20 +1,48 @@
 /***********************************************************************
- * @file      adc.h
- * @brief     ADC module header for Blue Gecko
- *
- * @author    Hyounjun Chang, hyounjun.chang@colorado.edu
- * @date      Apr 21, 2025
+ * @file      adc.h
+ * @brief     ADC module header for Blue Gecko
  *
- * @resources ECEN5823 final project
- *
+ * @author    Hyounjun Chang, hyounjun.chang@colorado.edu
+ * @date      Apr 21, 2025
+ * @resources ECEN5823 final project
  *
- *
- */
+ */
 #ifndef SRC_ADC_H_
 #define SRC_ADC_H_
 
 #include <stdint.h>
 #include <stdbool.h>
 
+#include "timer.h"
+
+// 1: sound detector AUDIO output sampled in bursts,
+//    TIMER0 overflow -> PRS -> ADC0 single conversion -> LDMA ping-pong buffers
+// 0: one ENVELOPE conversion per LETIMER0 underflow, one ADC0 IRQ per sample
+#define SOUND_SAMPLING_LDMA 1
+
+#if SOUND_SAMPLING_LDMA
+#define SOUND_SAMPLE_RATE_HZ      8000
+#define SOUND_BUFFER_SAMPLES      512  // 64 ms per buffer at 8 kHz
+#define SOUND_BUFFERS_PER_WINDOW  2    // one window captured every LETIMER0 period
+#define SOUND_LDMA_CHANNEL        0
+#define SOUND_PRS_CHANNEL         0
+
+// tickless, only the last buffer of a window raises the LDMA interrupt and
+// the main loop gets both in the same wake-up. Needs the whole window to
+// fit in the ping-pong buffers.
+#define SOUND_IRQ_PER_WINDOW      (TIMER_TICKLESS && SOUND_BUFFERS_PER_WINDOW == 2)
+#endif
+
 void initADC();
+
+#if SOUND_SAMPLING_LDMA
+// start one capture window, from LETIMER0 UF or its soft timer when tickless
+void sound_capture_start();
+// from LDMA IRQ, returns the buffer number within the window that just filled,
+// with SOUND_IRQ_PER_WINDOW the last one, all before it are full as well
+uint32_t sound_capture_buffer_done();
+// raw 12-bit samples of buffer number n of the current window
+const uint16_t* sound_capture_buffer(uint32_t n);
+#endif
+
 #endif
@@ -20,11 +20,16 @@
 
 #include <stdint.h>
 #include <math.h>
+#include <string.h>
 
 #include "gpio.h"
 
 #include "src/em_adc.h"
 #include "adc.h"
+#include "occupancy.h"
+#include "history.h"
+#include "irq.h"
+#include "timer.h"
 
 // Include logging for this file
 #define INCLUDE_LOG_DEBUG 1
@@ -34,18 +39,24 @@
 // each tick is 0.625ms -> 1/0.625 = 1.6
 #define ADVERTISING_INTERVAL(x) (x * 8) / 5
 #define AD_INVERTAL_MS_VAL 250
-
-// each tick is 1.25ms --> 1/1.25 = 0.8
-#define CONNECTION_INTERVAL(x) (x * 4) / 5
-#define CONN_INTERVAL_MS_VAL 75
-
-// 300ms latency
-#define SLAVE_LATENCY_MS_VAL 300
-#define SLAVE_LATENCY_INTERVALS 4 // 300/75
-
-#define SUPERVISION_TIMEOUT_MS_VAL (1 + SLAVE_LATENCY_INTERVALS) * (CONN_INTERVAL_MS_VAL * 2) + CONN_INTERVAL_MS_VAL
-// divide by 10 since each value is 10ms
-#define SUPERVISION_TIMEOUT (SUPERVISION_TIMEOUT_MS_VAL / 10) + 1 // +1 to meet supervision req
+// extended advertising of the broadcast set, how fast observers find the
+// periodic train
+#define BROADCAST_AD_INTERVAL_MS_VAL 1000
+
+// connections go back to idle parameters on a one-shot lazy soft timer
+// BLE_BURST_HOLD_MS after the last one stopped being busy
+#define CONN_PARAMS_TIMER_HANDLE 2
+#define CONN_PARAMS_HOLD_TICKS ((BLE_BURST_HOLD_MS * 32768) / 1000)
+#define CONN_PARAMS_SLACK_TICKS (CONN_PARAMS_HOLD_TICKS / 4)
+// connections still pairing are checked on a one-shot lazy soft timer
+// BLE_PAIRING_TIMEOUT_MS after the oldest of them opened
+#define PAIRING_TIMER_HANDLE 4
+#define PAIRING_TIMEOUT_TICKS ((BLE_PAIRING_TIMEOUT_MS * 32768ull) / 1000)
+#define PAIRING_SLACK_TICKS (PAIRING_TIMEOUT_TICKS / 8)
+
+// longest TX time asked for with the data length, a BLE_DATA_LENGTH packet
+// on the 1M PHY: preamble, access address, header, MIC and CRC around it
+#define DATA_LENGTH_TX_TIME_US ((BLE_DATA_LENGTH + 14) * 8)
 
 // Used by Client Only
 
@@ -55,24 +66,70 @@
 #define SCAN_WINDOW_MS_VAL 25
 
 
-// struct for notification queue
+// ATT_MTU 23 less the opcode and the handle
+#define NOTIFICATION_MAX_LEN 20
+
+// queued notifications are retried on a lazy stack soft timer, about once a
+// connection interval, handle 0 is the LCD's, 2 the parameter manager's,
+// 3 the history channel's, 4 the pairing timeout's
+#define NOTIFY_RETRY_TIMER_HANDLE 1
+#define NOTIFY_RETRY_MS 30
+#define NOTIFY_RETRY_TICKS ((NOTIFY_RETRY_MS * 32768) / 1000)
+#define NOTIFY_RETRY_SLACK_TICKS (NOTIFY_RETRY_TICKS / 3)
+// retries in a row without a buffer freed before the queue is given up,
+// longer than a supervision timeout so a lost link closes first
+#define NOTIFY_RETRY_LIMIT 200
+
+// our end of the history channel only ever receives the 4 byte request
+#define HISTORY_RX_MAX_SDU 23
+#define HISTORY_RX_MAX_PDU 23
+#define HISTORY_RX_CREDITS 2
+// K-frames as long as the data length lets one LL packet carry, less the
+// L2CAP header, see history_frame_len()
+#define HISTORY_TX_MAX_PDU (BLE_DATA_LENGTH - 4)
+#define HISTORY_SDU_MAX (HISTORY_HEADER_LEN + HISTORY_SDU_STREAM_MAX)
+// the stack had no TX buffer for a K-frame, try again on a one-shot lazy timer
+#define HISTORY_RETRY_TIMER_HANDLE 3
+#define HISTORY_RETRY_MS 10
+#define HISTORY_RETRY_TICKS ((HISTORY_RETRY_MS * 32768) / 1000)
+#define HISTORY_RETRY_SLACK_TICKS (HISTORY_RETRY_TICKS / 2)
+
+// struct for notification queue, the payload is a copy
 typedef struct{
   uint16_t attribute;
   uint16_t offset;
   size_t value_len;
-  uint8_t* value;
+  uint8_t value[NOTIFICATION_MAX_LEN];
+  uint8_t connections; // bit per ble_data.connections slot still owed the value
 } ble_notification_struct_t;
 
+// the history channel, one client at a time
+typedef struct{
+  bool open;
+  uint8_t connection;
+  uint16_t cid;
+  uint16_t max_pdu;       // K-frame payload, the client's limit or ours
+  uint16_t sdu_stream;    // stream bytes per SDU that fit the client's max_sdu
+  uint16_t credits;       // K-frames the client can still take
+  uint16_t request_len;   // from the first K-frame of the request, 0 before it
+  uint16_t request_got;
+  uint8_t request[HISTORY_REQUEST_LEN];
+  bool streaming;         // request taken, until the end SDU went out
+  uint32_t index;         // next record to send
+  uint16_t sdu_len;       // SDU being sent with its length field, 0 for none
+  uint16_t sdu_sent;
+  bool sdu_last;          // it is the end SDU
+  uint8_t sdu[2 + HISTORY_SDU_MAX];
+  uint64_t started;       // letimerTicks64() when the request came in
+  uint32_t record_bytes;  // encoded records sent since, for the goodput
+} ble_history_channel_t;
+
 
 // BLE private data
 ble_data_struct_t ble_data = {.myAddress = {{0}}, .myAddressType = 0,
-                              .advertisingSetHandle = 0, .connectionHandle = 0,
-                              .ok_to_send_htm_notifications = false,
-                              .ok_to_send_amb_light_notifications = false,
-                              .ok_to_send_sound_level_notifications = false,
-                              .ok_to_send_occupied_notifications = false,
-                              .passkey_received = false,
-                              .is_bonded = false};
+                              .advertisingSetHandle = 0,
+                              .advertising = false,
+                              .num_connections = 0};
 
 
 // buffers for server
@@ -81,7 +138,11 @@ ble_data_struct_t ble_data = {.myAddress = {{0}}, .myAddressType = 0,
 uint8_t htm_temperature_buffer[5];
 uint8_t *htm_temperature_ptr = &htm_temperature_buffer[0];
 uint32_t htm_temperature_flt;
-uint8_t flags = 0x00;
+uint8_t flags = 0x00; // Celsius, no time stamp, no type
+
+// humidity sensor, 1/100 %RH
+uint16_t humidity_val;
+uint16_t* humidity_ptr = &humidity_val;
 
 uint8_t PB0_pressed = 0;
 uint8_t *PB0_pressed_ptr = &PB0_pressed;
@@ -99,74 +160,383 @@ bool space_occupied = false;
 char occupied_str[10] = {0}; // Available or Occupied
 char* occupied_ptr = &occupied_str[0];
 
-// for indications queue
-ble_notification_struct_t notif_to_send;
-
-// storing last values
-int latest_temp = 0;
+// study space snapshot, latest value of every sensor
+uint8_t snapshot_buffer[SNAPSHOT_LEN];
+uint16_t snapshot_sequence = 0;
+uint8_t snapshot_flags = 0;
+uint8_t snapshot_sound_class = SOUND_QUIET;
+int16_t snapshot_leq_dB10 = 0;
+int16_t snapshot_temp_e2 = 0;
 
+// notifications the stack had no buffers for, oldest first. At most one
+// entry per characteristic, a newer value replaces the queued one.
 #define QUEUE_DEPTH 10
-// to send indications via timer
+ble_notification_struct_t notification_queue[QUEUE_DEPTH];
+uint8_t queue_head = 0;
+uint8_t queue_count = 0;
+ble_notification_stats_t notification_stats = {0};
+
+#if BLE_BEACON
+// Study Location service, 00000001-38c8-433e-87ec-652a2d136289, little endian
+static const uint8_t study_location_uuid[16] = {
+  0x89, 0x62, 0x13, 0x2d, 0x2a, 0x65, 0xec, 0x87,
+  0x3e, 0x43, 0xc8, 0x38, 0x01, 0x00, 0x00, 0x00
+};
+
+// values in the advertising data, compared with the deadbands
+uint8_t beacon_buffer[BEACON_DATA_LEN];
+uint8_t beacon_counter = 0;
+uint8_t beacon_flags = 0;
+uint8_t beacon_sound_class = SOUND_QUIET;
+uint16_t beacon_lux = 0;
+#endif
+
+#if BLE_PERIODIC_BROADCAST
+// Study Space service, 00000003-38c8-433e-87ec-652a2d136289, little endian
+static const uint8_t study_space_uuid[16] = {
+  0x89, 0x62, 0x13, 0x2d, 0x2a, 0x65, 0xec, 0x87,
+  0x3e, 0x43, 0xc8, 0x38, 0x03, 0x00, 0x00, 0x00
+};
+
+// periodic advertising data, set again only when the record changes
+uint8_t broadcast_buffer[BROADCAST_DATA_LEN];
+uint16_t broadcast_sequence = 0;
+#endif
+
+// retry timer expiries since the stack last took a notification
 uint8_t lazy_timer_count = 0;
+bool lazy_timer_running = false;
+
+#if BLE_HISTORY_CHANNEL
+ble_history_channel_t history_channel = {0};
+#endif
 #endif
 
 #if DEVICE_IS_BLE_SERVER
-#define FROM_INPUT true
-#define FROM_QUEUE false
-/*
-// sends indication, returns false if not able to, adds it to queue, if indication enabled
-// indication: pointer to indication data
-// from_input: send data from input, otherwise it is sent from queue
- * return value: true if indication sent, false if added to queue or no indication sent
- */
-bool send_notification(ble_notification_struct_t *notification){
+// NUM_BLE_NOTIFY for a characteristic that does not notify
+static ble_notify_t notify_index(uint16_t attribute){
+  switch (attribute){
+    case gattdb_temperature_measurement:
+      return BLE_NOTIFY_TEMPERATURE;
+    case gattdb_humidity:
+      return BLE_NOTIFY_HUMIDITY;
+    case gattdb_illuminance:
+      return BLE_NOTIFY_ILLUMINANCE;
+    case gattdb_audio_input_description:
+      return BLE_NOTIFY_SOUND_LEVEL;
+    case gattdb_space_occupied:
+      return BLE_NOTIFY_OCCUPIED;
+    case gattdb_study_space_snapshot:
+      return BLE_NOTIFY_SNAPSHOT;
+    default:
+      return NUM_BLE_NOTIFY;
+  }
+}
+
+// bit per connection slot that enabled notifications on the characteristic
+static uint8_t subscribed_connections(uint16_t attribute){
+  ble_notify_t index = notify_index(attribute);
+  uint8_t mask = 0;
+  if (index == NUM_BLE_NOTIFY){
+      return 0;
+  }
+  for (uint8_t i = 0; i < SL_BT_CONFIG_MAX_CONNECTIONS; i++){
+      if (ble_data.connections[i].in_use &&
+          (ble_data.connections[i].notify_flags & (1 << index))){
+          mask |= 1 << i;
+      }
+  }
+  return mask;
+}
+
+// asks the central for the idle or the burst parameter set, the result
+// comes back in sl_bt_evt_connection_parameters
+static void connection_params_request(ble_connection_t* conn, ble_params_t params){
   sl_status_t sc;
-  // do not send notification if not set
-  /*
-  if (notification->attribute == gattdb_temperature_measurement &&
-      !ble_data.ok_to_send_htm_notifications){
-      return false;
+  if (conn->params == params){
+      return;
   }
-  */
-  if (notification->attribute == gattdb_illuminance &&
-      !ble_data.ok_to_send_amb_light_notifications){
-      return false;
+  if (params == BLE_PARAMS_BURST){
+      sc = sl_bt_connection_set_parameters(conn->connection,
+                                           BLE_BURST_INTERVAL_MIN, BLE_BURST_INTERVAL_MAX,
+                                           BLE_BURST_LATENCY, BLE_BURST_TIMEOUT,
+                                           0, // default for connection event min/maxlength
+                                           0xffff);
   }
-  else if (notification->attribute == gattdb_audio_input_description &&
-      !ble_data.ok_to_send_sound_level_notifications){
-      return false;
+  else{
+      sc = sl_bt_connection_set_parameters(conn->connection,
+                                           BLE_IDLE_INTERVAL_MIN, BLE_IDLE_INTERVAL_MAX,
+                                           BLE_IDLE_LATENCY, BLE_IDLE_TIMEOUT,
+                                           0, 0xffff);
   }
-  else if (notification->attribute == gattdb_space_occupied &&
-      !ble_data.ok_to_send_occupied_notifications){
-      return false;
+  if (sc != SL_STATUS_OK){
+      LOG_ERROR("Error requesting Bluetooth connection parameters, Error code: 0x%x\r\n", (uint16_t)sc);
+      return;
   }
+  conn->params = params;
+}
 
-  // send notification
-  sc = sl_bt_gatt_server_notify_all(
-      notification->attribute, // from autogen/gattdb.h
-      notification->value_len,
-      notification->value);
-  if (sc != SL_STATUS_OK) {
-      LOG_ERROR("Error sending GATT notification, Error Code: 0x%x\r\n", (uint16_t)sc);
-      return false;
+// burst parameters right away when a reason comes up, idle ones
+// BLE_BURST_HOLD_MS after the last reason is gone
+static void connection_set_busy(ble_connection_t* conn, uint8_t reason, bool busy){
+  sl_status_t sc;
+  uint8_t was_busy = conn->busy;
+  if (busy){
+      conn->busy |= reason;
+  }
+  else{
+      conn->busy &= ~reason;
+  }
+  if (conn->busy != 0){
+      connection_params_request(conn, BLE_PARAMS_BURST);
+  }
+  else if (was_busy != 0){
+      // one timer for all connections, a restart only delays the others
+      sc = sl_bt_system_set_lazy_soft_timer(CONN_PARAMS_HOLD_TICKS, CONN_PARAMS_SLACK_TICKS,
+                                            CONN_PARAMS_TIMER_HANDLE, 1);
+      if (sc != SL_STATUS_OK){
+          LOG_ERROR("Error setting connection parameter timer, Error code: 0x%x\r\n", (uint16_t)sc);
+      }
+  }
+}
+
+// hold time over, connections with nothing going on go idle
+static void connection_params_idle(){
+  for (uint8_t i = 0; i < SL_BT_CONFIG_MAX_CONNECTIONS; i++){
+      if (ble_data.connections[i].in_use && ble_data.connections[i].busy == 0){
+          connection_params_request(&ble_data.connections[i], BLE_PARAMS_IDLE);
+      }
+  }
+}
+
+// a connection that paired, or encrypted with a bond from earlier in this
+// boot, for which the stack sends no sl_bt_evt_sm_bonded
+static void connection_bonded(ble_connection_t* conn, uint8_t bonding){
+  conn->is_bonded = true;
+  conn->bonding = bonding;
+  connection_set_busy(conn, BLE_BUSY_PAIRING, false);
+}
+
+static uint8_t connections_pairing(){
+  uint8_t n = 0;
+  for (uint8_t i = 0; i < SL_BT_CONFIG_MAX_CONNECTIONS; i++){
+      if (ble_data.connections[i].in_use && (ble_data.connections[i].busy & BLE_BUSY_PAIRING)){
+          n++;
+      }
+  }
+  return n;
+}
+
+// pairing that did not happen in BLE_PAIRING_TIMEOUT_MS no longer keeps
+// burst parameters, the timer goes again for connections opened later
+static void connection_pairing_timeout(){
+  sl_status_t sc;
+  uint64_t now = letimerTicks64();
+  uint64_t next = 0;
+  for (uint8_t i = 0; i < SL_BT_CONFIG_MAX_CONNECTIONS; i++){
+      ble_connection_t* conn = &ble_data.connections[i];
+      uint64_t age;
+      if (!conn->in_use || !(conn->busy & BLE_BUSY_PAIRING)){
+          continue;
+      }
+      age = letimerTicksToMs(now - conn->opened);
+      if (age >= BLE_PAIRING_TIMEOUT_MS){
+          LOG_WARN("Connection %u not bonded after %lu ms\r\n", (unsigned int)conn->connection,
+                   (unsigned long)age);
+          connection_set_busy(conn, BLE_BUSY_PAIRING, false);
+      }
+      else if (next == 0 || BLE_PAIRING_TIMEOUT_MS - age < next){
+          next = BLE_PAIRING_TIMEOUT_MS - age;
+      }
+  }
+  if (next != 0){
+      sc = sl_bt_system_set_lazy_soft_timer((uint32_t)((next * 32768) / 1000), PAIRING_SLACK_TICKS,
+                                            PAIRING_TIMER_HANDLE, 1);
+      if (sc != SL_STATUS_OK){
+          LOG_ERROR("Error setting pairing timer, Error code: 0x%x\r\n", (uint16_t)sc);
+      }
+  }
+}
+
+// connections with queued notifications get short intervals to catch up
+static void connection_backlog_update(){
+  uint8_t queued = 0;
+  for (uint8_t i = 0; i < queue_count; i++){
+      queued |= notification_queue[(queue_head + i) % QUEUE_DEPTH].connections;
+  }
+  for (uint8_t i = 0; i < SL_BT_CONFIG_MAX_CONNECTIONS; i++){
+      if (ble_data.connections[i].in_use){
+          connection_set_busy(&ble_data.connections[i], BLE_BUSY_BACKLOG, (queued & (1 << i)) != 0);
+      }
+  }
+}
+
+static void retry_timer_set(bool run){
+  sl_status_t sc;
+  if (run == lazy_timer_running){
+      return;
+  }
+  // time 0 stops the timer
+  sc = sl_bt_system_set_lazy_soft_timer(run ? NOTIFY_RETRY_TICKS : 0, NOTIFY_RETRY_SLACK_TICKS,
+                                        NOTIFY_RETRY_TIMER_HANDLE, 0);
+  if (sc != SL_STATUS_OK){
+      LOG_ERROR("Error setting notification retry timer, Error code: 0x%x\r\n", (uint16_t)sc);
+      return;
+  }
+  lazy_timer_running = run;
+  lazy_timer_count = 0;
+}
+
+// hands the notification to the stack for each connection in its mask,
+// clears the ones that are done. Connections the stack had no buffers for
+// (SL_STATUS_NO_MORE_RESOURCE) stay set.
+static void notify(ble_notification_struct_t* notification){
+  sl_status_t sc;
+  for (uint8_t i = 0; i < SL_BT_CONFIG_MAX_CONNECTIONS; i++){
+      if (!(notification->connections & (1 << i))){
+          continue;
+      }
+      // the value has to fit the connection's ATT_MTU less opcode and handle
+      if (notification->value_len > ble_data.connections[i].mtu - 3u){
+          notification_stats.dropped++;
+          notification->connections &= ~(1 << i);
+          continue;
+      }
+      sc = sl_bt_gatt_server_send_notification(
+          ble_data.connections[i].connection,
+          notification->attribute, // from autogen/gattdb.h
+          notification->value_len,
+          notification->value);
+      if (sc == SL_STATUS_NO_MORE_RESOURCE){
+          continue;
+      }
+      if (sc == SL_STATUS_OK){
+          notification_stats.sent++;
+      }
+      else{
+          LOG_ERROR("Error sending GATT notification, Error Code: 0x%x\r\n", (uint16_t)sc);
+          notification_stats.dropped++;
+      }
+      notification->connections &= ~(1 << i);
+  }
+}
+
+// sends queued notifications oldest first until the stack runs out of buffers
+static void notification_queue_drain(){
+  ble_notification_struct_t* notification;
+  while (queue_count > 0){
+      notification = &notification_queue[queue_head];
+      // clients that unsubscribed while it waited are skipped
+      notification->connections &= subscribed_connections(notification->attribute);
+      notify(notification);
+      if (notification->connections != 0){
+          break;
+      }
+      queue_head = (queue_head + 1) % QUEUE_DEPTH;
+      queue_count--;
+      lazy_timer_count = 0;
   }
-  return true;
+  retry_timer_set(queue_count > 0);
+  connection_backlog_update();
 }
 
-// dummy function, since temp sensor is disabled
-void update_temp_meas_gatt_and_send_notification(int temp_in_c){
-  latest_temp = temp_in_c;
+// number of connections in a slot mask
+static uint8_t connection_count(uint8_t mask){
+  uint8_t n = 0;
+  for (uint8_t b = 0; b < SL_BT_CONFIG_MAX_CONNECTIONS; b++){
+      if (mask & (1 << b)){
+          n++;
+      }
+  }
+  return n;
+}
+
+// forgets what is queued for the connections in mask
+static void notification_queue_remove(uint8_t mask){
+  ble_notification_struct_t* notification;
+  uint8_t kept = 0;
+  for (uint8_t i = 0; i < queue_count; i++){
+      notification = &notification_queue[(queue_head + i) % QUEUE_DEPTH];
+      notification_stats.dropped += connection_count(notification->connections & mask);
+      notification->connections &= ~mask;
+      // close the gaps, order stays the same
+      if (notification->connections != 0){
+          if (kept != i){
+              notification_queue[(queue_head + kept) % QUEUE_DEPTH] = *notification;
+          }
+          kept++;
+      }
+  }
+  queue_count = kept;
+  retry_timer_set(queue_count > 0);
+  connection_backlog_update();
+}
+
+static void notification_queue_put(const ble_notification_struct_t* value){
+  ble_notification_struct_t* notification;
+  // latest value wins, it keeps the place of the one it replaces
+  for (uint8_t i = 0; i < queue_count; i++){
+      notification = &notification_queue[(queue_head + i) % QUEUE_DEPTH];
+      if (notification->attribute == value->attribute){
+          notification_stats.coalesced += connection_count(notification->connections);
+          notification->value_len = value->value_len;
+          memcpy(notification->value, value->value, value->value_len);
+          notification->connections |= value->connections;
+          connection_backlog_update();
+          return;
+      }
+  }
+  if (queue_count == QUEUE_DEPTH){
+      notification_stats.dropped += connection_count(value->connections);
+      return;
+  }
+  notification_queue[(queue_head + queue_count) % QUEUE_DEPTH] = *value;
+  queue_count++;
+  notification_stats.enqueued++;
+  retry_timer_set(true);
+  connection_backlog_update();
 }
 
 /*
+ * sends a notification to every connection that enabled it, the value is
+ * copied. When the stack is out of buffers, or older notifications are
+ * still waiting, it is queued and sent from the retry timer.
+ * return value: true if sent now, false if queued, dropped or not enabled
+ */
+bool send_notification(uint16_t attribute, size_t value_len, const uint8_t* value){
+  ble_notification_struct_t notification;
+  notification.connections = subscribed_connections(attribute);
+  // do not send notification if not set
+  if (notification.connections == 0 || value_len > NOTIFICATION_MAX_LEN){
+      return false;
+  }
+  notification.attribute = attribute;
+  notification.offset = 0;
+  notification.value_len = value_len;
+  memcpy(notification.value, value, value_len);
+
+  // older values go first
+  if (queue_count > 0){
+      notification_queue_drain();
+  }
+  if (queue_count == 0){
+      notify(&notification);
+      if (notification.connections == 0){
+          return true;
+      }
+  }
+  notification_queue_put(&notification);
+  return false;
+}
+
 // Referenced from Lecture 10 slides
-void update_temp_meas_gatt_and_send_notification(int temp_in_c){
+void update_temp_meas_gatt_and_send_notification(int32_t temp_in_mc){
   sl_status_t sc;
   htm_temperature_ptr = &htm_temperature_buffer[0]; // reset pointer, otherwise causes segmentation fault
 
   // convert temperature for bluetooth
   UINT8_TO_BITSTREAM(htm_temperature_ptr, flags); // insert the flags byte
-  htm_temperature_flt = INT32_TO_FLOAT(temp_in_c*1000, -3);
+  htm_temperature_flt = INT32_TO_FLOAT(temp_in_mc, -3);
   // insert the temperature measurement
   UINT32_TO_BITSTREAM(htm_temperature_ptr, htm_temperature_flt);
 
@@ -181,36 +551,48 @@ void update_temp_meas_gatt_and_send_notification(int temp_in_c){
       LOG_ERROR("Error setting GATT for HTM, Error Code: 0x%x\r\n", (uint16_t)sc);
   }
 
-  // update notification to send
-  notif_to_send.attribute = gattdb_temperature_measurement;
-  notif_to_send.offset = 0;
-  notif_to_send.value_len = 5;
-  notif_to_send.value =  &htm_temperature_buffer[0]; // in IEEE-11073 format
-  send_notification(&notif_to_send);
+  // send or queue notification
+  send_notification(gattdb_temperature_measurement, 5, &htm_temperature_buffer[0]); // in IEEE-11073 format
 
-  // print temperature on lcd
-  displayPrintf(DISPLAY_ROW_TEMPVALUE, "Temp = %d", temp_in_c);
-  // update latest temperature value
-  latest_temp = temp_in_c;
+  // 0.01 C for the snapshot, the Si7021 range fits an int16
+  snapshot_temp_e2 = (int16_t)(temp_in_mc / 10);
+  snapshot_flags |= SNAPSHOT_FLAG_CLIMATE_VALID;
+
+  // print temperature on lcd, rounded to whole degrees
+  displayPrintf(DISPLAY_ROW_TEMPVALUE, "Temp = %d C",
+                (int)((temp_in_mc >= 0 ? temp_in_mc + 500 : temp_in_mc - 500) / 1000));
 }
-*/
 
-void update_sound_level_gatt_and_send_notification(uint32_t mV){
+void update_humidity_gatt_and_send_notification(uint16_t humidity_e2){
   sl_status_t sc;
-  size_t str_len;
-  if (mV > 100){
-      sound_ptr = "loud";
-      str_len = 4;
-  }
-  else if (mV > 45){
-      sound_ptr = "noisy";
-      str_len = 5;
-  }
-  else{
-      sound_ptr = "quiet";
-      str_len = 5;
+  humidity_val = humidity_e2;
+
+  // write to gatt_db
+  sc = sl_bt_gatt_server_write_attribute_value(
+        gattdb_humidity, // handle from autogen/gatt_db.h
+        0, // offset
+        2, // length
+        (uint8_t*)humidity_ptr
+  );
+  if (sc != SL_STATUS_OK) {
+      LOG_ERROR("Error setting GATT for Humidity, Error Code: 0x%x\r\n", (uint16_t)sc);
   }
 
+  // send or queue notification
+  send_notification(gattdb_humidity, 2, (const uint8_t*)humidity_ptr);
+
+  // update humidity on lcd, whole percent
+  displayPrintf(DISPLAY_ROW_HUMIDITY, "Humidity = %u %%", (humidity_e2 + 50) / 100);
+}
+
+void update_sound_level_gatt_and_send_notification(const sound_level_t* level){
+  sl_status_t sc;
+  // class comes from the running Leq and the window peak, see sound.c
+  sound_ptr = (char*)sound_level_name(level->level);
+  snapshot_sound_class = (uint8_t)level->level;
+  snapshot_leq_dB10 = level->leq_dB10;
+  size_t str_len = strlen(sound_ptr);
+
   // write to gatt_db
   sc = sl_bt_gatt_server_write_attribute_value(
         gattdb_audio_input_description, // handle from autogen/gatt_db.h
@@ -222,24 +604,21 @@ void update_sound_level_gatt_and_send_notification(uint32_t mV){
       LOG_ERROR("Error setting GATT for Sound Level, Error Code: 0x%x\r\n", (uint16_t)sc);
   }
 
-  // update notification to send
-  notif_to_send.attribute = gattdb_audio_input_description;
-  notif_to_send.offset = 0;
-  notif_to_send.value_len = str_len;
-  notif_to_send.value = (uint8_t*)sound_ptr;
-  send_notification(&notif_to_send);
+  // send or queue notification
+  send_notification(gattdb_audio_input_description, str_len, (const uint8_t*)sound_ptr);
 
   // update sound level on lcd
   displayPrintf(DISPLAY_ROW_SOUNDLEVEL, "Area is %s", sound_ptr);
 }
 
 void update_amb_light_gatt_and_send_notification(float lux){
-  if (lux > 1888){ // max measurable from sensor
-      amb_light_val = 1888;
+  if (lux > UINT16_MAX){ // characteristic is whole lux in 2 bytes
+      amb_light_val = UINT16_MAX;
   }
   else{
       amb_light_val = (uint16_t)lux;
   }
+  snapshot_flags |= SNAPSHOT_FLAG_LIGHT_VALID;
   sl_status_t sc;
 
   // write to gatt_db
@@ -253,12 +632,8 @@ void update_amb_light_gatt_and_send_notification(float lux){
       LOG_ERROR("Error setting GATT for Ambient Light Level, Error Code: 0x%x\r\n", (uint16_t)sc);
   }
 
-  // update notification to send
-  notif_to_send.attribute = gattdb_illuminance;
-  notif_to_send.offset = 0;
-  notif_to_send.value_len = 2;
-  notif_to_send.value = (uint8_t*)amb_light_ptr;
-  send_notification(&notif_to_send);
+  // send or queue notification
+  send_notification(gattdb_illuminance, 2, (const uint8_t*)amb_light_ptr);
 
   // update ambient light on lcd
   displayPrintf(DISPLAY_ROW_AMBLIGHTVALUE, "Light = %u lx", amb_light_val);
@@ -287,12 +662,8 @@ void update_space_occupied_gatt_and_send_notification(){
       LOG_ERROR("Error setting GATT for Space Occupied, Error Code: 0x%x\r\n", (uint16_t)sc);
   }
 
-  // update notification to send
-  notif_to_send.attribute = gattdb_space_occupied;
-  notif_to_send.offset = 0;
-  notif_to_send.value_len = str_len;
-  notif_to_send.value = (uint8_t*)occupied_ptr;
-  send_notification(&notif_to_send);
+  // send or queue notification
+  send_notification(gattdb_space_occupied, str_len, (const uint8_t*)occupied_ptr);
 
   // update space occupied for LCD
   displayPrintf(DISPLAY_ROW_OCCUPIED, "%s", occupied_ptr);
@@ -307,6 +678,499 @@ void update_space_occupied_gatt_and_send_notification(){
   }
 }
 
+#if BLE_BEACON
+// advertising data from the beacon values, used right away if advertising
+static void beacon_set_data(){
+  sl_status_t sc;
+  uint8_t* p = &beacon_buffer[0];
+
+  UINT8_TO_BITSTREAM(p, 2);
+  UINT8_TO_BITSTREAM(p, 0x01); // Flags
+  UINT8_TO_BITSTREAM(p, 0x06); // LE General Discoverable, BR/EDR not supported
+  UINT8_TO_BITSTREAM(p, 17);
+  UINT8_TO_BITSTREAM(p, 0x07); // Complete List of 128-bit Service UUIDs
+  memcpy(p, study_location_uuid, sizeof(study_location_uuid));
+  p += sizeof(study_location_uuid);
+  UINT8_TO_BITSTREAM(p, 3 + BEACON_PAYLOAD_LEN);
+  UINT8_TO_BITSTREAM(p, 0xFF); // Manufacturer Specific Data
+  UINT16_TO_BITSTREAM(p, BEACON_COMPANY_ID);
+  UINT8_TO_BITSTREAM(p, beacon_counter);
+  UINT8_TO_BITSTREAM(p, beacon_flags);
+  UINT8_TO_BITSTREAM(p, beacon_sound_class);
+  UINT16_TO_BITSTREAM(p, beacon_lux);
+
+  sc = sl_bt_legacy_advertiser_set_data(ble_data.advertisingSetHandle,
+                                        sl_bt_advertiser_advertising_data_packet,
+                                        BEACON_DATA_LEN, &beacon_buffer[0]);
+  if (sc != SL_STATUS_OK){
+      LOG_ERROR("Error setting Bluetooth advertising data, Error code: 0x%x\r\n", (uint16_t)sc);
+  }
+}
+
+// new advertising data once a value crossed its deadband
+static void beacon_update(){
+  uint8_t flags = snapshot_flags & (SNAPSHOT_FLAG_OCCUPIED | SNAPSHOT_FLAG_LIGHT_VALID);
+  uint16_t lux_change = amb_light_val > beacon_lux ? amb_light_val - beacon_lux
+                                                   : beacon_lux - amb_light_val;
+
+  if (flags == beacon_flags && snapshot_sound_class == beacon_sound_class &&
+      lux_change <= BEACON_LUX_DEADBAND(beacon_lux)){
+      return;
+  }
+  beacon_flags = flags;
+  beacon_sound_class = snapshot_sound_class;
+  beacon_lux = amb_light_val;
+  beacon_counter++;
+  beacon_set_data();
+}
+#endif
+
+#if BLE_PERIODIC_BROADCAST
+// the snapshot record in the periodic advertising data, if anything but
+// the sequence number changed
+static void broadcast_update(){
+  sl_status_t sc;
+  uint8_t record[SNAPSHOT_LEN];
+  uint8_t* p = &record[0];
+  int16_t leq_dB10;
+
+  if (!ble_data.broadcasting){
+      return;
+  }
+  // whole dB, tenths would change the data every window
+  leq_dB10 = (int16_t)((snapshot_leq_dB10 + (snapshot_leq_dB10 < 0 ? -5 : 5)) / 10 * 10);
+  UINT16_TO_BITSTREAM(p, broadcast_sequence);
+  UINT8_TO_BITSTREAM(p, snapshot_flags);
+  UINT8_TO_BITSTREAM(p, snapshot_sound_class);
+  UINT16_TO_BITSTREAM(p, (uint16_t)leq_dB10);
+  UINT16_TO_BITSTREAM(p, amb_light_val);
+  UINT16_TO_BITSTREAM(p, (uint16_t)snapshot_temp_e2);
+  UINT16_TO_BITSTREAM(p, humidity_val);
+  if (broadcast_buffer[0] != 0 &&
+      memcmp(&record[2], &broadcast_buffer[BROADCAST_DATA_LEN - SNAPSHOT_LEN + 2], SNAPSHOT_LEN - 2) == 0){
+      return;
+  }
+  broadcast_sequence++;
+  p = &record[0];
+  UINT16_TO_BITSTREAM(p, broadcast_sequence);
+
+  p = &broadcast_buffer[0];
+  UINT8_TO_BITSTREAM(p, BROADCAST_DATA_LEN - 1);
+  UINT8_TO_BITSTREAM(p, BROADCAST_AD_TYPE);
+  memcpy(p, study_space_uuid, sizeof(study_space_uuid));
+  p += sizeof(study_space_uuid);
+  memcpy(p, record, SNAPSHOT_LEN);
+
+  // used from the next periodic advertising event on
+  sc = sl_bt_periodic_advertiser_set_data(ble_data.broadcastSetHandle, BROADCAST_DATA_LEN,
+                                          &broadcast_buffer[0]);
+  if (sc != SL_STATUS_OK){
+      LOG_ERROR("Error setting periodic advertising data, Error code: 0x%x\r\n", (uint16_t)sc);
+  }
+}
+
+// second advertising set: non-connectable extended advertising that points
+// observers at the periodic train
+static void broadcast_start(){
+  sl_status_t sc;
+  sc = sl_bt_advertiser_create_set(&ble_data.broadcastSetHandle);
+  if (sc != SL_STATUS_OK){
+      LOG_ERROR("Error creating Bluetooth broadcast set, Error code: 0x%x\r\n", (uint16_t)sc);
+      return;
+  }
+  sc = sl_bt_advertiser_set_timing(ble_data.broadcastSetHandle,
+                                   ADVERTISING_INTERVAL(BROADCAST_AD_INTERVAL_MS_VAL),
+                                   ADVERTISING_INTERVAL(BROADCAST_AD_INTERVAL_MS_VAL),
+                                   0, 0);
+  if (sc != SL_STATUS_OK){
+      LOG_ERROR("Error setting Bluetooth broadcast timing, Error code: 0x%x\r\n", (uint16_t)sc);
+  }
+  sc = sl_bt_extended_advertiser_generate_data(ble_data.broadcastSetHandle,
+                                               sl_bt_advertiser_general_discoverable);
+  if (sc != SL_STATUS_OK){
+      LOG_ERROR("Error generating Bluetooth broadcast data, Error code: 0x%x\r\n", (uint16_t)sc);
+  }
+  sc = sl_bt_extended_advertiser_start(ble_data.broadcastSetHandle,
+                                       sl_bt_extended_advertiser_non_connectable, 0);
+  if (sc != SL_STATUS_OK){
+      LOG_ERROR("Error starting Bluetooth broadcast, Error code: 0x%x\r\n", (uint16_t)sc);
+      return;
+  }
+  sc = sl_bt_periodic_advertiser_start(ble_data.broadcastSetHandle,
+                                       BROADCAST_INTERVAL_MIN, BROADCAST_INTERVAL_MAX, 0);
+  if (sc != SL_STATUS_OK){
+      LOG_ERROR("Error starting periodic advertising, Error code: 0x%x\r\n", (uint16_t)sc);
+      return;
+  }
+  ble_data.broadcasting = true;
+  memset(broadcast_buffer, 0, sizeof(broadcast_buffer));
+}
+#endif
+
+// one notification with the latest of everything instead of one per sensor
+void update_snapshot_gatt_and_send_notification(){
+  sl_status_t sc;
+  uint8_t* p = &snapshot_buffer[0];
+
+  if (space_occupied){
+      snapshot_flags |= SNAPSHOT_FLAG_OCCUPIED;
+  }
+  else{
+      snapshot_flags &= ~SNAPSHOT_FLAG_OCCUPIED;
+  }
+  // counts windows, not notifications, so a client can tell it missed one
+  snapshot_sequence++;
+
+  UINT16_TO_BITSTREAM(p, snapshot_sequence);
+  UINT8_TO_BITSTREAM(p, snapshot_flags);
+  UINT8_TO_BITSTREAM(p, snapshot_sound_class);
+  UINT16_TO_BITSTREAM(p, (uint16_t)snapshot_leq_dB10);
+  UINT16_TO_BITSTREAM(p, amb_light_val);
+  UINT16_TO_BITSTREAM(p, (uint16_t)snapshot_temp_e2);
+  UINT16_TO_BITSTREAM(p, humidity_val);
+
+  // write to gatt_db
+  sc = sl_bt_gatt_server_write_attribute_value(
+        gattdb_study_space_snapshot, // handle from autogen/gatt_db.h
+        0, // offset
+        SNAPSHOT_LEN, // length
+        &snapshot_buffer[0]
+  );
+  if (sc != SL_STATUS_OK) {
+      LOG_ERROR("Error setting GATT for Study Space Snapshot, Error Code: 0x%x\r\n", (uint16_t)sc);
+  }
+
+  // send or queue notification
+  send_notification(gattdb_study_space_snapshot, SNAPSHOT_LEN, &snapshot_buffer[0]);
+#if BLE_HISTORY_CHANNEL
+  history_add_window(snapshot_flags, (sound_class_t)snapshot_sound_class, snapshot_leq_dB10,
+                     amb_light_val, snapshot_temp_e2, humidity_val);
+#endif
+#if BLE_BEACON
+  beacon_update();
+#endif
+#if BLE_PERIODIC_BROADCAST
+  broadcast_update();
+#endif
+}
+
+void set_space_occupied(bool occupied){
+  if (occupied == space_occupied){
+      return;
+  }
+  space_occupied = occupied;
+  update_space_occupied_gatt_and_send_notification();
+}
+
+const ble_notification_stats_t* get_notification_stats(){
+  return &notification_stats;
+}
+
+// NULL for a handle that is not open
+static ble_connection_t* find_connection(uint8_t connection){
+  for (uint8_t i = 0; i < SL_BT_CONFIG_MAX_CONNECTIONS; i++){
+      if (ble_data.connections[i].in_use && ble_data.connections[i].connection == connection){
+          return &ble_data.connections[i];
+      }
+  }
+  return NULL;
+}
+
+static uint8_t connection_slot(const ble_connection_t* conn){
+  return (uint8_t)(conn - &ble_data.connections[0]);
+}
+
+// asks for the 2M PHY and the longest LL payload, the results come back in
+// sl_bt_evt_connection_phy_status and sl_bt_evt_connection_data_length. The
+// stack exchanges the ATT_MTU on its own, up to BLE_MAX_MTU.
+static void connection_optimise_link(const ble_connection_t* conn){
+  sl_status_t sc;
+  // 1M stays acceptable for centrals without 2M
+  sc = sl_bt_connection_set_preferred_phy(conn->connection, sl_bt_gap_phy_2m, sl_bt_gap_phy_any);
+  if (sc != SL_STATUS_OK){
+      LOG_ERROR("Error requesting the 2M PHY, Error code: 0x%x\r\n", (uint16_t)sc);
+  }
+  sc = sl_bt_connection_set_data_length(conn->connection, BLE_DATA_LENGTH, DATA_LENGTH_TX_TIME_US);
+  if (sc != SL_STATUS_OK){
+      LOG_ERROR("Error requesting Bluetooth data length, Error code: 0x%x\r\n", (uint16_t)sc);
+  }
+}
+
+#if BLE_HISTORY_CHANNEL
+// forgets the channel, the stack closed it or is closing it
+static void history_channel_reset(){
+  sl_status_t sc;
+  ble_connection_t* conn = find_connection(history_channel.connection);
+  if (!history_channel.open){
+      return;
+  }
+  if (conn != NULL){
+      connection_set_busy(conn, BLE_BUSY_TRANSFER, false);
+  }
+  // time 0 stops the timer
+  sc = sl_bt_system_set_lazy_soft_timer(0, 0, HISTORY_RETRY_TIMER_HANDLE, 1);
+  if (sc != SL_STATUS_OK){
+      LOG_ERROR("Error stopping history retry timer, Error code: 0x%x\r\n", (uint16_t)sc);
+  }
+  memset(&history_channel, 0, sizeof(history_channel));
+}
+
+static void history_channel_close(){
+  sl_status_t sc;
+  sc = sl_bt_l2cap_close_channel(history_channel.connection, history_channel.cid);
+  if (sc != SL_STATUS_OK){
+      LOG_ERROR("Error closing history channel, Error code: 0x%x\r\n", (uint16_t)sc);
+  }
+  history_channel_reset();
+}
+
+// next SDU of the answer, with the 2 byte SDU length in front
+static void history_build_sdu(){
+  uint8_t* p = &history_channel.sdu[0];
+  uint32_t first = history_channel.index;
+  series_encoder_t encoder;
+  uint16_t count;
+  uint16_t len;
+
+  // overwritten since the client asked, it gets what is left
+  if (first < history_first()){
+      first = history_first();
+  }
+  series_encoder_init(&encoder, &history_channel.sdu[2 + HISTORY_HEADER_LEN], history_channel.sdu_stream,
+                      HISTORY_FIELDS);
+  count = (uint16_t)history_read(&first, &encoder, HISTORY_SDU_RECORDS);
+  len = HISTORY_HEADER_LEN + encoder.len;
+  UINT16_TO_BITSTREAM(p, len);
+  UINT32_TO_BITSTREAM(p, first);
+  UINT16_TO_BITSTREAM(p, count);
+  UINT16_TO_BITSTREAM(p, HISTORY_PERIOD_S);
+  UINT32_TO_BITSTREAM(p, history_next());
+
+  history_channel.index = first + count;
+  history_channel.record_bytes += encoder.len;
+  history_channel.sdu_len = 2 + len;
+  history_channel.sdu_sent = 0;
+  history_channel.sdu_last = (count == 0);
+}
+
+// longest K-frame: the client's limit, and one LL packet at the data length
+// the connection has now, so a K-frame is never split by the link layer
+static uint16_t history_frame_len(const ble_connection_t* conn){
+  uint16_t len = history_channel.max_pdu;
+  if (conn != NULL && conn->data_len - 4 < len){
+      len = conn->data_len - 4;
+  }
+  return len;
+}
+
+// records sent, time since the request and the link they went over
+static void history_log_goodput(const ble_connection_t* conn){
+  uint32_t ms = (uint32_t)letimerTicksToMs(letimerTicks64() - history_channel.started);
+  LOG_INFO("History sent: %lu bytes in %lu ms, %lu B/s, PHY %u, data length %u\r\n",
+           (unsigned long)history_channel.record_bytes, (unsigned long)ms,
+           (unsigned long)(ms > 0 ? history_channel.record_bytes * 1000ull / ms : 0),
+           (unsigned int)(conn != NULL ? conn->phy : 0),
+           (unsigned int)(conn != NULL ? conn->data_len : 0));
+}
+
+// K-frames while the client has credits and the stack has buffers
+static void history_send(){
+  sl_status_t sc;
+  uint16_t len;
+  ble_connection_t* conn = find_connection(history_channel.connection);
+
+  while (history_channel.streaming && history_channel.credits > 0){
+      if (history_channel.sdu_len == 0){
+          history_build_sdu();
+      }
+      len = history_channel.sdu_len - history_channel.sdu_sent;
+      if (len > history_frame_len(conn)){
+          len = history_frame_len(conn);
+      }
+      sc = sl_bt_l2cap_channel_send_data(history_channel.connection, history_channel.cid, len,
+                                         &history_channel.sdu[history_channel.sdu_sent]);
+      if (sc == SL_STATUS_NO_MORE_RESOURCE){
+          sc = sl_bt_system_set_lazy_soft_timer(HISTORY_RETRY_TICKS, HISTORY_RETRY_SLACK_TICKS,
+                                                HISTORY_RETRY_TIMER_HANDLE, 1);
+          if (sc != SL_STATUS_OK){
+              LOG_ERROR("Error setting history retry timer, Error code: 0x%x\r\n", (uint16_t)sc);
+          }
+          return;
+      }
+      if (sc != SL_STATUS_OK){
+          LOG_ERROR("Error sending history data, Error code: 0x%x\r\n", (uint16_t)sc);
+          history_channel_close();
+          return;
+      }
+      history_channel.credits--;
+      history_channel.sdu_sent += len;
+      if (history_channel.sdu_sent < history_channel.sdu_len){
+          continue;
+      }
+      history_channel.sdu_len = 0;
+      if (history_channel.sdu_last){
+          history_channel.streaming = false;
+          history_log_goodput(conn);
+          if (conn != NULL){
+              connection_set_busy(conn, BLE_BUSY_TRANSFER, false);
+          }
+      }
+  }
+}
+
+// a K-frame of the request, the first one starts with the SDU length
+static void history_receive(const uint8_t* data, uint16_t len){
+  sl_status_t sc;
+  ble_connection_t* conn;
+
+  // one credit back per K-frame, the request buffer is free again
+  sc = sl_bt_l2cap_channel_send_credit(history_channel.connection, history_channel.cid, 1);
+  if (sc != SL_STATUS_OK){
+      LOG_ERROR("Error sending history channel credit, Error code: 0x%x\r\n", (uint16_t)sc);
+  }
+  if (history_channel.request_len == 0){
+      if (len < 2){
+          history_channel_close();
+          return;
+      }
+      history_channel.request_len = (uint16_t)(data[0] | (data[1] << 8));
+      history_channel.request_got = 0;
+      data += 2;
+      len -= 2;
+  }
+  // the SDU has to be a request, and the K-frames must add up to it
+  if (history_channel.request_len != HISTORY_REQUEST_LEN ||
+      history_channel.request_got + len > HISTORY_REQUEST_LEN){
+      LOG_ERROR("Bad history request, %u bytes\r\n", (unsigned int)history_channel.request_len);
+      history_channel_close();
+      return;
+  }
+  memcpy(&history_channel.request[history_channel.request_got], data, len);
+  history_channel.request_got += len;
+  if (history_channel.request_got < HISTORY_REQUEST_LEN){
+      return;
+  }
+  history_channel.request_len = 0;
+  // one answer at a time, a request while one streams is ignored
+  if (history_channel.streaming){
+      return;
+  }
+  history_channel.index = (uint32_t)history_channel.request[0] |
+                          ((uint32_t)history_channel.request[1] << 8) |
+                          ((uint32_t)history_channel.request[2] << 16) |
+                          ((uint32_t)history_channel.request[3] << 24);
+  if (history_channel.index > history_next()){
+      history_channel.index = history_first();
+  }
+  history_channel.streaming = true;
+  history_channel.sdu_len = 0;
+  history_channel.started = letimerTicks64();
+  history_channel.record_bytes = 0;
+  conn = find_connection(history_channel.connection);
+  if (conn != NULL){
+      connection_set_busy(conn, BLE_BUSY_TRANSFER, true);
+  }
+  history_send();
+}
+
+// accepts a bonded client on HISTORY_SPSM if the channel is free
+static void history_open_request(const sl_bt_evt_l2cap_le_channel_open_request_t* request){
+  sl_status_t sc;
+  uint16_t result = sl_bt_l2cap_connection_result_successful;
+  ble_connection_t* conn = find_connection(request->connection);
+
+  if (request->spsm != HISTORY_SPSM){
+      result = sl_bt_l2cap_connection_result_spsm_not_supported;
+  }
+  else if (conn == NULL || !conn->is_bonded){
+      result = sl_bt_l2cap_connection_result_insufficient_authentication;
+  }
+  else if (history_channel.open){
+      result = sl_bt_l2cap_connection_result_no_resources_available;
+  }
+  else if (request->max_sdu < HISTORY_HEADER_LEN + SERIES_SAMPLE_MAX(HISTORY_FIELDS)){
+      result = sl_bt_l2cap_connection_result_unacceptable_parameters;
+  }
+  sc = sl_bt_l2cap_send_le_channel_open_response(request->connection, request->cid,
+                                                 HISTORY_RX_MAX_SDU, HISTORY_RX_MAX_PDU,
+                                                 HISTORY_RX_CREDITS, result);
+  if (sc != SL_STATUS_OK){
+      LOG_ERROR("Error answering history channel request, Error code: 0x%x\r\n", (uint16_t)sc);
+      return;
+  }
+  if (result != sl_bt_l2cap_connection_result_successful){
+      LOG_INFO("History channel refused, result 0x%x\r\n", (unsigned int)result);
+      return;
+  }
+  memset(&history_channel, 0, sizeof(history_channel));
+  history_channel.open = true;
+  history_channel.connection = request->connection;
+  history_channel.cid = request->cid;
+  history_channel.max_pdu = request->max_pdu < HISTORY_TX_MAX_PDU ? request->max_pdu : HISTORY_TX_MAX_PDU;
+  history_channel.sdu_stream = request->max_sdu - HISTORY_HEADER_LEN;
+  if (history_channel.sdu_stream > HISTORY_SDU_STREAM_MAX){
+      history_channel.sdu_stream = HISTORY_SDU_STREAM_MAX;
+  }
+  history_channel.credits = request->credit;
+}
+
+static bool history_channel_is(uint8_t connection, uint16_t cid){
+  return history_channel.open && history_channel.connection == connection && history_channel.cid == cid;
+}
+#endif
+
+static void advertising_start(){
+  sl_status_t sc;
+  if (ble_data.advertising){
+      return;
+  }
+  // the name goes in the scan response
+  sc = sl_bt_legacy_advertiser_generate_data(ble_data.advertisingSetHandle, \
+                                             sl_bt_advertiser_general_discoverable);
+  if (sc != SL_STATUS_OK){
+      LOG_ERROR("Error generating Bluetooth advertiser data, Error code: 0x%x\r\n", (uint16_t)sc);
+  }
+#if BLE_BEACON
+  // and the sensor values in the advertising data
+  beacon_set_data();
+#endif
+  sc = sl_bt_legacy_advertiser_start(ble_data.advertisingSetHandle, \
+                                     sl_bt_advertiser_connectable_scannable);
+  if (sc != SL_STATUS_OK){
+      LOG_ERROR("Error starting Bluetooth advertising, Error code: 0x%x\r\n", (uint16_t)sc);
+      return;
+  }
+  ble_data.advertising = true;
+}
+
+static void advertising_stop(){
+  sl_status_t sc;
+  sc = sl_bt_advertiser_stop(ble_data.advertisingSetHandle);
+  if (sc != SL_STATUS_OK){
+      LOG_ERROR("Error stopping Bluetooth advertising, Error code: 0x%x\r\n", (uint16_t)sc);
+  }
+  ble_data.advertising = false;
+}
+
+// "Advertising" with no client, the state of a single one, or the count
+static void display_connection_state(){
+  ble_connection_t* conn = NULL;
+  if (ble_data.num_connections == 0){
+      displayPrintf(DISPLAY_ROW_CONNECTION, "Advertising");
+      return;
+  }
+  if (ble_data.num_connections > 1){
+      displayPrintf(DISPLAY_ROW_CONNECTION, "%u Connections", ble_data.num_connections);
+      return;
+  }
+  for (uint8_t i = 0; i < SL_BT_CONFIG_MAX_CONNECTIONS; i++){
+      if (ble_data.connections[i].in_use){
+          conn = &ble_data.connections[i];
+      }
+  }
+  displayPrintf(DISPLAY_ROW_CONNECTION, "%s", conn->is_bonded ? "Bonded" : "Connected");
+}
+
 #endif
 
 ble_data_struct_t* get_ble_data(){
@@ -318,12 +1182,15 @@ void handle_ble_event(sl_bt_msg_t* evt){
 
   sl_status_t sc;
   sl_bt_evt_connection_opened_t bt_conn_open;
-  //sl_bt_evt_connection_parameters_t bt_conn_param;
+  sl_bt_evt_connection_parameters_t bt_conn_param;
   uint32_t passkey;
   uint16_t characteristic;
 
 #if DEVICE_IS_BLE_SERVER // for server states
   sl_bt_evt_gatt_server_characteristic_status_t gatt_server_char_status;
+  ble_connection_t* conn;
+  ble_notify_t notify;
+  uint16_t max_mtu;
 #endif
 
 #if DEVICE_IS_BLE_SERVER
@@ -360,16 +1227,19 @@ void handle_ble_event(sl_bt_msg_t* evt){
       if (sc != SL_STATUS_OK){
           LOG_ERROR("Error setting Bluetooth advertiser timing, Error code: 0x%x\r\n", (uint16_t)sc);
       }
-      sc = sl_bt_legacy_advertiser_generate_data(ble_data.advertisingSetHandle, \
-                                                 sl_bt_advertiser_general_discoverable);
-      if (sc != SL_STATUS_OK){
-          LOG_ERROR("Error generating Bluetooth advertiser data, Error code: 0x%x\r\n", (uint16_t)sc);
-      }
-      sc = sl_bt_legacy_advertiser_start(ble_data.advertisingSetHandle, \
-                                         sl_bt_advertiser_connectable_scannable);
+      // the stack's GATT client offers this in the MTU exchange
+      sc = sl_bt_gatt_server_set_max_mtu(BLE_MAX_MTU, &max_mtu);
       if (sc != SL_STATUS_OK){
-          LOG_ERROR("Error starting Bluetooth advertising, Error code: 0x%x\r\n", (uint16_t)sc);
+          LOG_ERROR("Error setting Bluetooth max MTU, Error code: 0x%x\r\n", (uint16_t)sc);
       }
+      memset(ble_data.connections, 0, sizeof(ble_data.connections));
+      ble_data.num_connections = 0;
+      ble_data.advertising = false;
+      advertising_start();
+#if BLE_PERIODIC_BROADCAST
+      ble_data.broadcasting = false;
+      broadcast_start();
+#endif
 
       // Start LCD Display
       displayInit();
@@ -409,95 +1279,135 @@ void handle_ble_event(sl_bt_msg_t* evt){
     case sl_bt_evt_connection_opened_id:
       bt_conn_open = evt->data.evt_connection_opened;
 
-      // stop advertising once connection complete
-      sc = sl_bt_advertiser_stop(ble_data.advertisingSetHandle);
-      if (sc != SL_STATUS_OK){
-         LOG_ERROR("Error stopping Bluetooth advertising, Error code: 0x%x\r\n", (uint16_t)sc);
+      // the stack stopped advertising for this connection
+      ble_data.advertising = false;
+      conn = NULL;
+      for (uint8_t i = 0; i < SL_BT_CONFIG_MAX_CONNECTIONS; i++){
+          if (!ble_data.connections[i].in_use){
+              conn = &ble_data.connections[i];
+              break;
+          }
       }
-
-      /*
-      // request sl_bt_connection parameter
-      sc = sl_bt_connection_set_parameters(bt_conn_open.connection,
-                                           CONNECTION_INTERVAL(CONN_INTERVAL_MS_VAL), // 75ms
-                                           CONNECTION_INTERVAL(CONN_INTERVAL_MS_VAL), // 75ms
-                                           SLAVE_LATENCY_INTERVALS, // see declaration above
-                                           SUPERVISION_TIMEOUT, // see declaration above
-                                           0, // default for connection event min/maxlength
-                                           0xffff
-                                           );
-      if (sc != SL_STATUS_OK){
-         LOG_ERROR("Error requesting Bluetooth connection parameters, Error code: 0x%x\r\n", (uint16_t)sc);
+      if (conn == NULL){
+          LOG_ERROR("No free connection slot\r\n");
+          sc = sl_bt_connection_close(bt_conn_open.connection);
+          if (sc != SL_STATUS_OK){
+             LOG_ERROR("Error closing BLE connection, Error code: 0x%x\r\n", (uint16_t)sc);
+          }
+          break;
       }
-      */
+      memset(conn, 0, sizeof(*conn));
+      conn->in_use = true;
+      conn->connection = bt_conn_open.connection;
+      conn->bonding = bt_conn_open.bonding;
+      conn->mtu = BLE_DEFAULT_MTU;
+      conn->phy = sl_bt_gap_phy_1m;
+      conn->data_len = BLE_DEFAULT_DATA_LENGTH;
+      conn->params = BLE_PARAMS_CENTRAL;
+      conn->opened = letimerTicks64();
+      ble_data.num_connections++;
+
+      // short intervals for service discovery and pairing, idle once bonded
+      // or after BLE_PAIRING_TIMEOUT_MS. A client bonded earlier in this
+      // boot goes idle after the hold time. The timer is running already
+      // if another connection is still pairing, it goes again for this one.
+      connection_set_busy(conn, BLE_BUSY_PAIRING, true);
+      if (bt_conn_open.bonding != SL_BT_INVALID_BONDING_HANDLE){
+          connection_bonded(conn, bt_conn_open.bonding);
+      }
+      else if (connections_pairing() == 1){
+          sc = sl_bt_system_set_lazy_soft_timer(PAIRING_TIMEOUT_TICKS, PAIRING_SLACK_TICKS,
+                                                PAIRING_TIMER_HANDLE, 1);
+          if (sc != SL_STATUS_OK){
+              LOG_ERROR("Error setting pairing timer, Error code: 0x%x\r\n", (uint16_t)sc);
+          }
+      }
+      connection_optimise_link(conn);
 
-      ble_data.connectionHandle = bt_conn_open.connection;
+      // keep advertising while another client can connect
+      if (ble_data.num_connections < SL_BT_CONFIG_MAX_CONNECTIONS){
+          advertising_start();
+      }
+      else{
+          advertising_stop();
+      }
 
-      // display that server in connected mode
-      displayPrintf(DISPLAY_ROW_CONNECTION, "Connected");
+      display_connection_state();
       break;
     // sl_bt_evt_connection_closed_id
     case sl_bt_evt_connection_closed_id:
-      // update states
-      ble_data.ok_to_send_htm_notifications = false;
-      ble_data.ok_to_send_amb_light_notifications = false;
-      ble_data.ok_to_send_sound_level_notifications= false;
-      ble_data.ok_to_send_occupied_notifications = false;
-      ble_data.passkey_received = false;
-      ble_data.is_bonded = false;
-      // turn LED off
-      gpioLed0SetOff();
-
-      // handle close event
-      sc = sl_bt_legacy_advertiser_generate_data(ble_data.advertisingSetHandle, \
-                                                 sl_bt_advertiser_general_discoverable);
-      if (sc != SL_STATUS_OK){
-          LOG_ERROR("Error generating Bluetooth advertiser data, Error code: 0x%x\r\n",(uint16_t)sc);
+      conn = find_connection(evt->data.evt_connection_closed.connection);
+      if (conn == NULL){
+          break;
       }
-
-      sc = sl_bt_legacy_advertiser_start(ble_data.advertisingSetHandle, \
-                                         sl_bt_advertiser_connectable_scannable);
-      if (sc != SL_STATUS_OK){
-         LOG_ERROR("Error starting Bluetooth advertising, Error code: 0x%x\r\n", (uint16_t)sc);
+      // nobody left to send its queued notifications to
+      notification_queue_remove(1 << connection_slot(conn));
+#if BLE_HISTORY_CHANNEL
+      // its channels went with it
+      if (history_channel.open && history_channel.connection == conn->connection){
+          history_channel_reset();
+      }
+#endif
+      if (conn->passkey_received){
+          displayPrintf(DISPLAY_ROW_PASSKEY, "");
+          displayPrintf(DISPLAY_ROW_ACTION, "");
+      }
+      conn->in_use = false;
+      ble_data.num_connections--;
+      if (ble_data.num_connections == 0){
+          // turn LED off
+          gpioLed0SetOff();
       }
 
-      // display that server in advertising mode
-      displayPrintf(DISPLAY_ROW_CONNECTION, "Advertising");
-      // clear temperature on lcd
-      displayPrintf(DISPLAY_ROW_TEMPVALUE, "");
-      displayPrintf(DISPLAY_ROW_PASSKEY, "");
-      displayPrintf(DISPLAY_ROW_ACTION, "");
+      // a slot is free again
+      advertising_start();
+      display_connection_state();
+      break;
+    // ATT_MTU agreed with a client
+    case sl_bt_evt_gatt_mtu_exchanged_id:
+      conn = find_connection(evt->data.evt_gatt_mtu_exchanged.connection);
+      if (conn != NULL){
+          conn->mtu = evt->data.evt_gatt_mtu_exchanged.mtu;
+          LOG_INFO("Connection %u ATT_MTU %u\r\n", (unsigned int)conn->connection, (unsigned int)conn->mtu);
+      }
+      break;
+    case sl_bt_evt_connection_phy_status_id:
+      conn = find_connection(evt->data.evt_connection_phy_status.connection);
+      if (conn != NULL){
+          conn->phy = evt->data.evt_connection_phy_status.phy;
+          LOG_INFO("Connection %u PHY %u\r\n", (unsigned int)conn->connection, (unsigned int)conn->phy);
+      }
+      break;
+    // LL payload either way, what the central's controller agreed to
+    case sl_bt_evt_connection_data_length_id:
+      conn = find_connection(evt->data.evt_connection_data_length.connection);
+      if (conn != NULL){
+          conn->data_len = evt->data.evt_connection_data_length.tx_data_len;
+          LOG_INFO("Connection %u data length TX %u RX %u\r\n", (unsigned int)conn->connection,
+                   (unsigned int)evt->data.evt_connection_data_length.tx_data_len,
+                   (unsigned int)evt->data.evt_connection_data_length.rx_data_len);
+      }
       break;
     // Triggered whenever the connection parameters are changed and at any
     // time a connection is established
     case sl_bt_evt_connection_parameters_id:
-      // Uncomment to log connection parameters
-      /*
       bt_conn_param = evt->data.evt_connection_parameters;
-      LOG_INFO("Connection parameter changed\r\n");
-      LOG_INFO("Interval(1.25ms): %d\r\n", bt_conn_param.interval);
-      LOG_INFO("Latency(num_skip_allowed): %d\r\n", bt_conn_param.latency);
-      LOG_INFO("Timeout(10ms): %d\r\n", bt_conn_param.timeout);
-      */
-      break;
-   // external events, only handles PB0 press here
-    case sl_bt_evt_system_external_signal_id:
-      if (evt->data.evt_system_external_signal.extsignals & BLE_PB0_PRESS){
-          // confirm BLE passkey if waiting
-          if (ble_data.passkey_received){
-              sc = sl_bt_sm_passkey_confirm(ble_data.connectionHandle, 1);
-              if (sc != SL_STATUS_OK){
-                 LOG_ERROR("Error confirming BLE passkey, Error code: 0x%x\r\n", (uint16_t)sc);
-              }
-              ble_data.passkey_received = false;
-          }
-          // update whether study space occupied or not
-          else{
-              space_occupied = !space_occupied;
-              update_space_occupied_gatt_and_send_notification();
-          }
+      conn = find_connection(bt_conn_param.connection);
+      if (conn == NULL){
+          break;
       }
-      else if (evt->data.evt_system_external_signal.extsignals & BLE_PB0_RELEASE){
-
+      // what the central agreed to, it may differ from the request
+      conn->interval = bt_conn_param.interval;
+      conn->latency = bt_conn_param.latency;
+      conn->timeout = bt_conn_param.timeout;
+      LOG_INFO("Connection %u parameters: interval %u x 1.25 ms, latency %u, timeout %u x 10 ms\r\n",
+               (unsigned int)bt_conn_param.connection, (unsigned int)bt_conn_param.interval,
+               (unsigned int)bt_conn_param.latency, (unsigned int)bt_conn_param.timeout);
+      // encrypted, with a bond from earlier in this boot there is no
+      // sl_bt_evt_sm_bonded
+      if (bt_conn_param.security_mode > sl_bt_connection_mode1_level1 && !conn->is_bonded){
+          connection_bonded(conn, conn->bonding);
+          display_connection_state();
       }
       break;
     // ******************************************************
@@ -515,47 +1425,16 @@ void handle_ble_event(sl_bt_msg_t* evt){
       // characteristic for CCCD change
       characteristic = gatt_server_char_status.characteristic;
 
-      // CCCD changed
-      if(gatt_server_char_status.status_flags & sl_bt_gatt_server_client_config){
-          /*
-          if (characteristic == gattdb_temperature_measurement){ // handle from gatt_db.h
-              // notification flag
-              if (gatt_server_char_status.client_config_flags & sl_bt_gatt_notification){
-                   ble_data.ok_to_send_htm_notifications= true;
-                   // print temperature on lcd
-                   displayPrintf(DISPLAY_ROW_TEMPVALUE, "Temp = %d", latest_temp);
-                   gpioLed0SetOn();
-              }
-              else{
-                  ble_data.ok_to_send_htm_notifications = false;
-                  // clear temperature on lcd
-                  displayPrintf(DISPLAY_ROW_TEMPVALUE, "");
-                  gpioLed0SetOff();
-              }
-          }*/
-          if (characteristic == gattdb_audio_input_description){
-              if (gatt_server_char_status.client_config_flags & sl_bt_gatt_notification){
-                  ble_data.ok_to_send_sound_level_notifications = true;
-              }
-              else{
-                  ble_data.ok_to_send_sound_level_notifications = false;
-              }
-          }
-          else if (characteristic == gattdb_illuminance){
-              if (gatt_server_char_status.client_config_flags & sl_bt_gatt_notification){
-                  ble_data.ok_to_send_amb_light_notifications = true;
-              }
-              else{
-                  ble_data.ok_to_send_amb_light_notifications = false;
-              }
+      // CCCD changed, kept per connection
+      conn = find_connection(gatt_server_char_status.connection);
+      notify = notify_index(characteristic);
+      if (conn != NULL && notify != NUM_BLE_NOTIFY &&
+          (gatt_server_char_status.status_flags & sl_bt_gatt_server_client_config)){
+          if (gatt_server_char_status.client_config_flags & sl_bt_gatt_notification){
+              conn->notify_flags |= 1 << notify;
           }
-          else if (characteristic == gattdb_space_occupied){
-              if (gatt_server_char_status.client_config_flags & sl_bt_gatt_notification){
-                  ble_data.ok_to_send_occupied_notifications = true;
-              }
-              else{
-                  ble_data.ok_to_send_occupied_notifications = false;
-              }
+          else{
+              conn->notify_flags &= ~(1 << notify);
           }
       }
       break;
@@ -564,17 +1443,70 @@ void handle_ble_event(sl_bt_msg_t* evt){
     case sl_bt_evt_gatt_server_indication_timeout_id:
       LOG_ERROR("Received Indication Timeout\r\n");
       break;
-    // Bluetooth soft timer interrupt (125 ms)
+    // notification retry timer
+    case sl_bt_evt_system_soft_timer_id:
+      if (evt->data.evt_system_soft_timer.handle == NOTIFY_RETRY_TIMER_HANDLE){
+          notification_queue_drain();
+          if (queue_count > 0 && ++lazy_timer_count >= NOTIFY_RETRY_LIMIT){
+              LOG_ERROR("No notification buffers for %u retries, %u notifications dropped\r\n",
+                        (unsigned int)lazy_timer_count, (unsigned int)queue_count);
+              notification_queue_remove(0xFF);
+          }
+      }
+      else if (evt->data.evt_system_soft_timer.handle == CONN_PARAMS_TIMER_HANDLE){
+          connection_params_idle();
+      }
+      else if (evt->data.evt_system_soft_timer.handle == PAIRING_TIMER_HANDLE){
+          connection_pairing_timeout();
+      }
+#if BLE_HISTORY_CHANNEL
+      else if (evt->data.evt_system_soft_timer.handle == HISTORY_RETRY_TIMER_HANDLE){
+          history_send();
+      }
+#endif
+      break;
+#if BLE_HISTORY_CHANNEL
+    // a client wants the history channel
+    case sl_bt_evt_l2cap_le_channel_open_request_id:
+      history_open_request(&evt->data.evt_l2cap_le_channel_open_request);
+      break;
+    // a K-frame of a request
+    case sl_bt_evt_l2cap_channel_data_id:
+      if (history_channel_is(evt->data.evt_l2cap_channel_data.connection,
+                             evt->data.evt_l2cap_channel_data.cid)){
+          history_receive(evt->data.evt_l2cap_channel_data.data.data,
+                          evt->data.evt_l2cap_channel_data.data.len);
+      }
+      break;
+    // the client can take more K-frames
+    case sl_bt_evt_l2cap_channel_credit_id:
+      if (history_channel_is(evt->data.evt_l2cap_channel_credit.connection,
+                             evt->data.evt_l2cap_channel_credit.cid)){
+          history_channel.credits += evt->data.evt_l2cap_channel_credit.credit;
+          history_send();
+      }
+      break;
+    case sl_bt_evt_l2cap_channel_closed_id:
+      if (history_channel_is(evt->data.evt_l2cap_channel_closed.connection,
+                             evt->data.evt_l2cap_channel_closed.cid)){
+          history_channel_reset();
+      }
+      break;
+#endif
     case sl_bt_evt_sm_confirm_bonding_id:
       // accept bonding request
-      sc = sl_bt_sm_bonding_confirm(ble_data.connectionHandle, 1);
+      sc = sl_bt_sm_bonding_confirm(evt->data.evt_sm_confirm_bonding.connection, 1);
       if (sc != SL_STATUS_OK){
          LOG_ERROR("Error confirming BLE bonding, Error code: 0x%x\r\n", (uint16_t)sc);
       }
       break;
     case sl_bt_evt_sm_confirm_passkey_id:
       passkey = evt->data.evt_sm_confirm_passkey.passkey;
-      ble_data.passkey_received = true;
+      conn = find_connection(evt->data.evt_sm_confirm_passkey.connection);
+      if (conn == NULL){
+          break;
+      }
+      conn->passkey_received = true;
       // display passkey
       displayPrintf(DISPLAY_ROW_PASSKEY, "Passkey %06u", passkey);
       displayPrintf(DISPLAY_ROW_ACTION, "Confirm with PB0");
@@ -583,11 +1515,16 @@ void handle_ble_event(sl_bt_msg_t* evt){
       displayPrintf(DISPLAY_ROW_ACTION2, "");
       break;
     case sl_bt_evt_sm_bonded_id:
-      displayPrintf(DISPLAY_ROW_CONNECTION, "Bonded");
+      conn = find_connection(evt->data.evt_sm_bonded.connection);
+      if (conn == NULL){
+          break;
+      }
+      // reset passkey flags
+      conn->passkey_received = false;
+      connection_bonded(conn, evt->data.evt_sm_bonded.bonding);
+      display_connection_state();
       displayPrintf(DISPLAY_ROW_PASSKEY, "");
       displayPrintf(DISPLAY_ROW_ACTION, "");
-      // reset passkey flags
-      ble_data.is_bonded = true;
 
       // display space occupied action again
       if (space_occupied){
@@ -604,7 +1541,7 @@ void handle_ble_event(sl_bt_msg_t* evt){
     case sl_bt_evt_sm_bonding_failed_id:
       LOG_ERROR("Bonding Failed\r\n");
       // close connection and reset
-      sc = sl_bt_connection_close(ble_data.connectionHandle);
+      sc = sl_bt_connection_close(evt->data.evt_sm_bonding_failed.connection);
       if (sc != SL_STATUS_OK){
          LOG_ERROR("Error closing BLE connection, Error code: 0x%x\r\n", (uint16_t)sc);
       }
@@ -614,3 +1551,41 @@ void handle_ble_event(sl_bt_msg_t* evt){
   }
 #endif
 }
+
+// PB0 events from the scheduler queue
+void handle_ble_scheduler_event(scheduler_event_entry* event){
+#if DEVICE_IS_BLE_SERVER
+  sl_status_t sc;
+  ble_connection_t* conn;
+
+  // data is the PB0 level sampled in the IRQ, 0 when pressed
+  if (event->event != EVENT_PB || event->data != 0){
+      return;
+  }
+  // confirm BLE passkey if a client is waiting, the one that asked first
+  conn = NULL;
+  for (uint8_t i = 0; i < SL_BT_CONFIG_MAX_CONNECTIONS; i++){
+      if (ble_data.connections[i].in_use && ble_data.connections[i].passkey_received){
+          conn = &ble_data.connections[i];
+          break;
+      }
+  }
+  if (conn != NULL){
+      sc = sl_bt_sm_passkey_confirm(conn->connection, 1);
+      if (sc != SL_STATUS_OK){
+         LOG_ERROR("Error confirming BLE passkey, Error code: 0x%x\r\n", (uint16_t)sc);
+      }
+      conn->passkey_received = false;
+  }
+  // update whether study space occupied or not
+  else{
+      space_occupied = !space_occupied;
+      update_space_occupied_gatt_and_send_notification();
+#if OCCUPANCY_AUTO
+      occupancy_set_manual(space_occupied);
+#endif
+  }
+#else
+  (void)event;
+#endif
+}
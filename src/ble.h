@@ -17,23 +17,172 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include "sl_bluetooth.h"
+#include "sl_bluetooth_connection_config.h"
+#include "scheduler.h"
+#include "sound.h"
 
 #define UINT8_TO_BITSTREAM(p, n)  { *(p)++ = (uint8_t)(n); }
 
+#define UINT16_TO_BITSTREAM(p, n) { *(p)++ = (uint8_t)(n); *(p)++ = (uint8_t)((n) >> 8); }
+
 #define UINT32_TO_BITSTREAM(p, n) { *(p)++ = (uint8_t)(n); *(p)++ = (uint8_t)((n) >> 8); \
                                     *(p)++ = (uint8_t)((n) >> 16); *(p)++ = (uint8_t)((n) >> 24); }
 
 #define INT32_TO_FLOAT(m, e) ( (int32_t) (((uint32_t) m) & 0x00FFFFFFU) | (((uint32_t) e) << 24) )
 
+// study space snapshot record, little endian, see gatt_configuration.btconf
+//  0  uint16  sequence number, counts update windows since boot
+//  2  uint8   SNAPSHOT_FLAG_*
+//  3  uint8   sound_class_t
+//  4  int16   Leq, 0.1 dB
+//  6  uint16  illuminance, whole lux
+//  8  int16   temperature, 0.01 C
+// 10  uint16  humidity, 0.01 %RH
+#define SNAPSHOT_LEN                12
+#define SNAPSHOT_FLAG_OCCUPIED      0x01
+#define SNAPSHOT_FLAG_LIGHT_VALID   0x02 // illuminance has been read since boot
+#define SNAPSHOT_FLAG_CLIMATE_VALID 0x04 // temperature and humidity have been read
+
+// connectable advertising carries occupancy, light and the sound class in
+// manufacturer specific data, a gateway tracks rooms from scan reports
+#ifndef BLE_BEACON
+#define BLE_BEACON 1
+#endif
+// advertising data: Flags, the Study Location service UUID and
+// manufacturer specific data with the Silicon Labs company identifier and
+//  0  uint8   counts payload changes since boot
+//  1  uint8   SNAPSHOT_FLAG_OCCUPIED, SNAPSHOT_FLAG_LIGHT_VALID
+//  2  uint8   sound_class_t
+//  3  uint16  illuminance, whole lux
+#define BEACON_COMPANY_ID           0x02FF
+#define BEACON_PAYLOAD_LEN          5
+#define BEACON_DATA_LEN             (3 + 18 + 4 + BEACON_PAYLOAD_LEN)
+// the payload is rebuilt when the occupancy or sound class change, or the
+// light moves by more than the deadband: 10 %, at least 5 lux
+#define BEACON_LUX_DEADBAND(lux)    ((lux) / 10 > 5 ? (lux) / 10 : 5)
+
+// the room status also goes out in periodic advertising, observers sync to
+// it and read every room without a connection
+#ifndef BLE_PERIODIC_BROADCAST
+#define BLE_PERIODIC_BROADCAST 1
+#endif
+// periodic advertising interval, 1.25 ms units, 1-1.2 s
+#define BROADCAST_INTERVAL_MIN      800
+#define BROADCAST_INTERVAL_MAX      960
+// one AD structure: length, Service Data - 128-bit UUID, the Study Space
+// service UUID and a snapshot record. Its sequence number counts changes of
+// the broadcast, Leq is rounded to whole dB.
+#define BROADCAST_AD_TYPE           0x21
+#define BROADCAST_DATA_LEN          (2 + 16 + SNAPSHOT_LEN)
+
+// stored sensor history goes out over an LE credit based L2CAP channel,
+// a gateway pulls a day of records in a few SDUs instead of notifications
+#ifndef BLE_HISTORY_CHANNEL
+#define BLE_HISTORY_CHANNEL 1
+#endif
+// the client opens the channel on HISTORY_SPSM once bonded and sends one
+// SDU with the uint32 index of the first record it wants. The board
+// answers with SDUs of
+//  0  uint32  index of the first record in it
+//  4  uint16  records that follow, 0 ends the answer
+//  6  uint16  HISTORY_PERIOD_S
+//  8  uint32  index of the record being collected, one past the newest
+// 12  the records as one stream of HISTORY_FIELDS fields with their
+//     timestamps, see series.h and history.h
+// Indexes carry on across resets. An index past the newest record, from
+// before the flash log was wiped, starts from the oldest one kept.
+#define HISTORY_SPSM                0x0080
+#define HISTORY_REQUEST_LEN         4
+#define HISTORY_HEADER_LEN          12
+#define HISTORY_SDU_RECORDS         480  // most records in one SDU
+#define HISTORY_SDU_STREAM_MAX      960  // longest stream in one SDU
+
+// notification TX queue counters, since boot. Everything but enqueued
+// counts once per connection.
+typedef struct {
+  uint32_t enqueued;   // held for a retry, the stack was out of buffers or older ones waited
+  uint32_t coalesced;  // queued value of the same characteristic replaced before it went out
+  uint32_t dropped;    // queue full, stack error, retries given up or connection closed
+  uint32_t sent;       // taken by the stack
+} ble_notification_stats_t;
 
 // Define BLE bit-flags
+// IRQ events travel through the scheduler event queue, the external signal
+// only says the queue has something in it
 #define NO_FLAG 0x0
-#define BLE_LETIMER0_UF_FLAG 0x1
-#define BLE_LETIMER0_COMP1_FLAG 0x2
-#define BLE_PB0_PRESS 0x4
-#define BLE_PB0_RELEASE 0x8
-#define BLE_I2C_VEML6030_TRANSFER_FLAG 0x10
-#define BLE_ADC_COMPLETE_FLAG 0x20
+#define BLE_SCHEDULER_EVENT_FLAG 0x1
+
+// notifying characteristics, bit positions in ble_connection_t.notify_flags
+typedef enum {
+  BLE_NOTIFY_TEMPERATURE = 0,
+  BLE_NOTIFY_HUMIDITY,
+  BLE_NOTIFY_ILLUMINANCE,
+  BLE_NOTIFY_SOUND_LEVEL,
+  BLE_NOTIFY_OCCUPIED,
+  BLE_NOTIFY_SNAPSHOT,
+  NUM_BLE_NOTIFY
+} ble_notify_t;
+
+// ATT_MTU before the client exchanges a larger one
+#define BLE_DEFAULT_MTU 23
+// LL payload octets before the data length update
+#define BLE_DEFAULT_DATA_LENGTH 27
+// every connection is asked for the LE 2M PHY, the longest LL payload and,
+// through the stack's MTU exchange, an ATT_MTU up to BLE_MAX_MTU. Bulk
+// transfers are sized to what the connection ends up with.
+#define BLE_MAX_MTU 247
+#define BLE_DATA_LENGTH SL_BT_CONFIG_CONNECTION_DATA_LENGTH
+
+// connection parameters the board asks for, interval in 1.25 ms and
+// supervision timeout in 10 ms units. Idle: 375-400 ms with 4 events the
+// board may skip, at most 2 s between events it listens to (Apple
+// accessory guidelines), the timeout covers two of those.
+#define BLE_IDLE_INTERVAL_MIN   300
+#define BLE_IDLE_INTERVAL_MAX   320
+#define BLE_IDLE_LATENCY        4
+#define BLE_IDLE_TIMEOUT        500
+// burst: pairing, service discovery, a backlog of notifications or a
+// history download
+#define BLE_BURST_INTERVAL_MIN  12
+#define BLE_BURST_INTERVAL_MAX  24
+#define BLE_BURST_LATENCY       0
+#define BLE_BURST_TIMEOUT       500
+// burst parameters are kept this long after the last reason went away
+#define BLE_BURST_HOLD_MS       2000
+// a connection that neither pairs nor encrypts with its bond in this long
+// stops asking for burst parameters for it
+#define BLE_PAIRING_TIMEOUT_MS  30000
+
+// parameter set last asked for on a connection
+typedef enum {
+  BLE_PARAMS_CENTRAL = 0,   // nothing asked for, the central's choice
+  BLE_PARAMS_IDLE,
+  BLE_PARAMS_BURST
+} ble_params_t;
+
+// why a connection wants short intervals, bits of ble_connection_t.busy
+#define BLE_BUSY_PAIRING  0x01    // opened and not bonded yet, for BLE_PAIRING_TIMEOUT_MS at most
+#define BLE_BUSY_BACKLOG  0x02    // notifications queued for it
+#define BLE_BUSY_TRANSFER 0x04    // history download streaming on it
+
+// state of one open connection, the stack allows SL_BT_CONFIG_MAX_CONNECTIONS
+typedef struct {
+  bool in_use;
+  uint8_t connection;       // handle from sl_bt_evt_connection_opened
+  uint8_t bonding;          // SL_BT_INVALID_BONDING_HANDLE until bonded
+  bool passkey_received;    // waiting for PB0 to confirm the passkey
+  bool is_bonded;           // paired now, or encrypted with a bond from before
+  uint64_t opened;          // letimerTicks64() when it opened
+  uint8_t notify_flags;     // 1 << ble_notify_t for each CCCD with notifications on
+  uint16_t mtu;             // ATT_MTU
+  uint8_t phy;              // sl_bt_gap_phy_*
+  uint16_t data_len;        // LL payload octets the board sends
+  uint8_t busy;             // BLE_BUSY_* reasons for burst parameters
+  uint8_t params;           // ble_params_t last requested
+  uint16_t interval;        // in use, from sl_bt_evt_connection_parameters
+  uint16_t latency;
+  uint16_t timeout;
+} ble_connection_t;
 
 // BLE Data Structure, save all of our private BT data in here.
 // Modern C (circa 2021 does it this way)
@@ -44,26 +193,33 @@ typedef struct {
   uint8_t myAddressType;
   // The advertising set handle allocated from Bluetooth stack.
   uint8_t advertisingSetHandle;
-  uint8_t connectionHandle;
-  bool ok_to_send_htm_notifications;
-  bool ok_to_send_amb_light_notifications;
-  bool ok_to_send_sound_level_notifications;
-  bool ok_to_send_occupied_notifications;
-  bool passkey_received;
-  bool is_bonded;
+  // connectable advertising runs while a connection slot is free
+  bool advertising;
+  // non-connectable extended advertising with the periodic broadcast
+  uint8_t broadcastSetHandle;
+  bool broadcasting;
+  uint8_t num_connections;
+  ble_connection_t connections[SL_BT_CONFIG_MAX_CONNECTIONS];
 } ble_data_struct_t;
 
 // ble functions
 ble_data_struct_t* get_ble_data();
 
 #if DEVICE_IS_BLE_SERVER
-void update_temp_meas_gatt_and_send_notification(int temp_in_c); // update temperature gatt and send notification
-void update_sound_level_gatt_and_send_notification(uint32_t mV);
+void update_temp_meas_gatt_and_send_notification(int32_t temp_in_mc); // update temperature gatt and send notification
+void update_humidity_gatt_and_send_notification(uint16_t humidity_e2); // 1/100 %RH
+void update_sound_level_gatt_and_send_notification(const sound_level_t* level);
 void update_amb_light_gatt_and_send_notification(float lux);
 void update_space_occupied_gatt_and_send_notification();
+void set_space_occupied(bool occupied); // from the occupancy classifier
+void update_snapshot_gatt_and_send_notification(); // once per update window
+const ble_notification_stats_t* get_notification_stats();
 #endif
 
 // handles all ble events, different implementation for server and client
 void handle_ble_event(sl_bt_msg_t* evt);
 
+// handles queued IRQ events that affect the BLE side (PB0)
+void handle_ble_scheduler_event(scheduler_event_entry* event);
+
 #endif
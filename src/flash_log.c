@@ -0,0 +1,519 @@
+/***********************************************************************
+ * @file      flash_log.c
+ * @brief     Append-only record log in internal flash
+ *
+ * @author    Hyounjun Chang, hyounjun.chang@colorado.edu
+ * @date      Oct 17, 2026
+ *
+ * @resources EFR32xG13 Reference Manual, MSC chapter
+ *            emlib MSC_ErasePage() / MSC_WriteWord()
+ *
+ * The pages are used as a ring. Records are appended to the head page;
+ * when it is full the next page is erased and takes over, and once the
+ * ring has gone round that is the oldest page, whose records are given up.
+ * Every page is erased once per lap, so the wear is level without a
+ * mapping table, and each page header keeps its erase count.
+ *
+ * A record header and its payload go out in one word write, header
+ * first, and nothing is ever written twice between erases. A reset in the
+ * middle leaves a record whose CRC does not check out; initFlashLog()
+ * stops reading that page there and the next record goes to a new page,
+ * with the sequence number the lost record would have had. Pages whose
+ * sequence numbers do not follow on from the newer ones, an erase that
+ * did not finish or garbage on new flash, are erased before they are used.
+ *
+ * RAM keeps the first sequence number and timestamp of every page, so a
+ * seek is a binary search over the pages in ring order and a scan of the
+ * records of one page.
+ *
+ */
+#include "flash_log.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include <em_device.h>
+#include <em_msc.h>
+
+#define PAGE_WORDS  (FLASH_PAGE_SIZE / 4)
+#define NO_RECORD   0xFFFFFFFFUL
+#define ERASED_WORD 0xFFFFFFFFUL
+
+typedef enum {
+  PAGE_DIRTY,   // needs an erase before use
+  PAGE_FREE,    // header, no records, erased after it
+  PAGE_USED     // holds records of the log
+} page_state_t;
+
+// The array only reserves the space. The linker file moves
+// .internal_storage to the end of flash, below NVM3, and
+// linker_storage_begin tells where it ended up.
+static const uint8_t flash_log_area[FLASH_LOG_PAGES * FLASH_PAGE_SIZE]
+  __attribute__((section(".internal_storage"), used));
+extern uint32_t linker_storage_begin[];
+
+static uint8_t page_state[FLASH_LOG_PAGES];
+static uint32_t page_erases[FLASH_LOG_PAGES];     // from the header, 0 if it has none
+static uint32_t page_first_seq[FLASH_LOG_PAGES];  // NO_RECORD unless PAGE_USED
+static uint32_t page_first_time[FLASH_LOG_PAGES];
+static uint32_t tail_page;      // oldest page in use
+static uint32_t head_page;      // page appended to
+static uint32_t head_offset;    // next free byte in it
+static bool head_open;          // more records can go there
+static bool empty;
+static uint32_t next_seq;
+static uint32_t last_time;
+static flash_log_stats_t stats;
+
+static uint32_t* page_base(uint32_t page){
+  return &linker_storage_begin[page * PAGE_WORDS];
+}
+
+static uint32_t record_size(uint16_t len){
+  return FLASH_LOG_RECORD_HEADER + ((len + 3u) & ~3u);
+}
+
+// CRC-16/CCITT-FALSE
+static uint16_t crc16(uint16_t crc, const uint8_t* data, uint32_t len){
+  for (uint32_t i = 0; i < len; i++){
+      crc ^= (uint16_t)(data[i] << 8);
+      for (int b = 0; b < 8; b++){
+          crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+      }
+  }
+  return crc;
+}
+
+static uint16_t record_crc(const uint32_t* header, const uint8_t* payload, uint16_t len){
+  uint16_t crc = crc16(0xFFFF, (const uint8_t*)header, 10);
+  return crc16(crc, payload, len);
+}
+
+static bool erased(const uint32_t* words, uint32_t n){
+  for (uint32_t i = 0; i < n; i++){
+      if (words[i] != ERASED_WORD){
+          return false;
+      }
+  }
+  return true;
+}
+
+// length of the record at offset, 0 for erased flash, -1 for one that
+// does not check out
+static int32_t check_record(uint32_t page, uint32_t offset){
+  const uint32_t* header = &page_base(page)[offset / 4];
+  uint16_t len;
+  if (offset + FLASH_LOG_RECORD_HEADER > FLASH_PAGE_SIZE){
+      return 0;
+  }
+  if (erased(header, FLASH_LOG_RECORD_HEADER / 4)){
+      return 0;
+  }
+  len = (uint16_t)header[2];
+  if (len == 0 || len > FLASH_LOG_MAX_LEN || offset + record_size(len) > FLASH_PAGE_SIZE ||
+      (uint16_t)(header[2] >> 16) != record_crc(header, (const uint8_t*)&header[3], len)){
+      return -1;
+  }
+  return len;
+}
+
+// reads the records of a page into the index, returns the last sequence
+// number, NO_RECORD if there is none
+static uint32_t scan_page(uint32_t page, uint32_t* end){
+  const uint32_t* base = page_base(page);
+  uint32_t offset = FLASH_LOG_PAGE_HEADER;
+  uint32_t last = NO_RECORD;
+  int32_t len;
+
+  while ((len = check_record(page, offset)) > 0){
+      // sequence numbers go up by one within a page
+      if (last != NO_RECORD && base[offset / 4] != last + 1){
+          len = -1;
+          break;
+      }
+      last = base[offset / 4];
+      if (page_first_seq[page] == NO_RECORD){
+          page_first_seq[page] = last;
+          page_first_time[page] = base[offset / 4 + 1];
+      }
+      offset += record_size((uint16_t)len);
+  }
+  // torn record or something left after the last one, nothing more can
+  // be written to the page
+  if (len < 0 || !erased(&base[offset / 4], PAGE_WORDS - offset / 4)){
+      stats.torn++;
+      offset = FLASH_PAGE_SIZE;
+  }
+  *end = offset;
+  return last;
+}
+
+// a page without a header, blank or with its erase cut short, has been
+// erased as often as the one before it in the ring, that one got its erase
+// of this lap already
+static void guess_erases(uint32_t page){
+  uint32_t prev = page_erases[(page + FLASH_LOG_PAGES - 1) % FLASH_LOG_PAGES];
+  page_erases[page] = prev > 0 ? prev - 1 : 0;
+}
+
+void initFlashLog(){
+  uint32_t last_seq[FLASH_LOG_PAGES];
+  uint32_t end[FLASH_LOG_PAGES];
+  uint32_t newest = NO_RECORD;
+  uint32_t page;
+  const uint32_t* base;
+
+  memset(&stats, 0, sizeof(stats));
+  for (page = 0; page < FLASH_LOG_PAGES; page++){
+      base = page_base(page);
+      page_first_seq[page] = NO_RECORD;
+      last_seq[page] = NO_RECORD;
+      end[page] = FLASH_PAGE_SIZE;
+      page_erases[page] = 0;
+      page_state[page] = PAGE_DIRTY;
+      if (base[0] != FLASH_LOG_MAGIC){
+          continue;
+      }
+      page_erases[page] = base[1];
+      last_seq[page] = scan_page(page, &end[page]);
+      if (last_seq[page] != NO_RECORD){
+          page_state[page] = PAGE_USED;
+          if (newest == NO_RECORD || last_seq[page] > last_seq[newest]){
+              newest = page;
+          }
+      }
+      else if (end[page] == FLASH_LOG_PAGE_HEADER){
+          page_state[page] = PAGE_FREE;
+      }
+  }
+
+  // twice round, so a run of pages without a header starts from one with
+  for (uint32_t n = 0; n < 2 * FLASH_LOG_PAGES; n++){
+      if (page_base(n % FLASH_LOG_PAGES)[0] != FLASH_LOG_MAGIC){
+          guess_erases(n % FLASH_LOG_PAGES);
+      }
+  }
+
+  empty = (newest == NO_RECORD);
+  if (empty){
+      // new flash, start on the first page
+      head_page = FLASH_LOG_PAGES - 1;
+      tail_page = 0;
+      head_open = false;
+      next_seq = 0;
+      last_time = 0;
+      return;
+  }
+
+  // back from the newest page while the pages follow on, anything else is
+  // left over from before
+  head_page = newest;
+  tail_page = newest;
+  for (uint32_t n = 1; n < FLASH_LOG_PAGES; n++){
+      page = (newest + FLASH_LOG_PAGES - n) % FLASH_LOG_PAGES;
+      if (page_state[page] != PAGE_USED || last_seq[page] + 1 != page_first_seq[tail_page]){
+          break;
+      }
+      tail_page = page;
+  }
+  for (page = 0; page < FLASH_LOG_PAGES; page++){
+      if (page_state[page] != PAGE_USED){
+          continue;
+      }
+      if ((page + FLASH_LOG_PAGES - tail_page) % FLASH_LOG_PAGES >
+          (head_page + FLASH_LOG_PAGES - tail_page) % FLASH_LOG_PAGES){
+          page_state[page] = PAGE_DIRTY;
+          page_first_seq[page] = NO_RECORD;
+          stats.dropped++;
+          continue;
+      }
+      stats.recovered += last_seq[page] - page_first_seq[page] + 1;
+  }
+
+  next_seq = last_seq[head_page] + 1;
+  head_offset = end[head_page];
+  head_open = head_offset < FLASH_PAGE_SIZE;
+  // the newest timestamp is in the last record of the head page
+  base = page_base(head_page);
+  for (uint32_t offset = FLASH_LOG_PAGE_HEADER; offset < end[head_page]; ){
+      int32_t len = check_record(head_page, offset);
+      if (len <= 0){
+          break;
+      }
+      last_time = base[offset / 4 + 1];
+      offset += record_size((uint16_t)len);
+  }
+}
+
+// erases the page unless it is free already and writes its header
+static bool format_page(uint32_t page){
+  uint32_t header[FLASH_LOG_PAGE_HEADER / 4];
+  uint32_t* base = page_base(page);
+  MSC_Status_TypeDef status;
+
+  if (page_state[page] == PAGE_FREE){
+      return true;
+  }
+  if (base[0] != FLASH_LOG_MAGIC){
+      guess_erases(page);
+  }
+  page_state[page] = PAGE_DIRTY;
+  page_first_seq[page] = NO_RECORD;
+  header[0] = FLASH_LOG_MAGIC;
+  header[1] = page_erases[page] + 1;
+
+  MSC_Init();
+  status = MSC_ErasePage(base);
+  if (status == mscReturnOk){
+      stats.erases++;
+      status = MSC_WriteWord(base, header, sizeof(header));
+  }
+  MSC_Deinit();
+  if (status != mscReturnOk || memcmp(base, header, sizeof(header)) != 0 ||
+      !erased(&base[FLASH_LOG_PAGE_HEADER / 4], PAGE_WORDS - FLASH_LOG_PAGE_HEADER / 4)){
+      stats.write_errors++;
+      return false;
+  }
+  page_erases[page] = header[1];
+  page_state[page] = PAGE_FREE;
+  return true;
+}
+
+// a page that got no record is not left as a hole in the ring, the next
+// try erases it again
+static void give_up_head(){
+  head_open = false;
+  if (page_first_seq[head_page] == NO_RECORD){
+      page_state[head_page] = PAGE_DIRTY;
+      head_page = (head_page + FLASH_LOG_PAGES - 1) % FLASH_LOG_PAGES;
+  }
+}
+
+// the page after the head takes over, the oldest page goes when the ring
+// is full
+static bool open_next_page(){
+  uint32_t page = (head_page + 1) % FLASH_LOG_PAGES;
+  if (!empty && page == tail_page){
+      tail_page = (tail_page + 1) % FLASH_LOG_PAGES;
+  }
+  head_page = page;
+  head_offset = FLASH_PAGE_SIZE;
+  if (!format_page(page)){
+      give_up_head();
+      return false;
+  }
+  if (empty){
+      tail_page = page;
+  }
+  head_offset = FLASH_LOG_PAGE_HEADER;
+  head_open = true;
+  return true;
+}
+
+bool flash_log_append(uint32_t timestamp, const void* data, uint16_t len){
+  uint32_t record[(FLASH_LOG_RECORD_HEADER + FLASH_LOG_MAX_LEN + 3) / 4];
+  uint32_t size = record_size(len);
+  uint32_t* at;
+  MSC_Status_TypeDef status;
+
+  if (len == 0 || len > FLASH_LOG_MAX_LEN || (!empty && timestamp < last_time)){
+      return false;
+  }
+  if (!head_open || head_offset + size > FLASH_PAGE_SIZE){
+      if (!open_next_page()){
+          return false;
+      }
+  }
+
+  memset(record, 0xFF, size);
+  record[0] = next_seq;
+  record[1] = timestamp;
+  record[2] = len;
+  memcpy(&record[3], data, len);
+  record[2] |= (uint32_t)record_crc(record, (const uint8_t*)&record[3], len) << 16;
+
+  at = &page_base(head_page)[head_offset / 4];
+  MSC_Init();
+  status = MSC_WriteWord(at, record, size);
+  MSC_Deinit();
+  if (status != mscReturnOk || memcmp(at, record, size) != 0){
+      // whatever made it to flash is unreadable, start over on a new page
+      stats.write_errors++;
+      give_up_head();
+      return false;
+  }
+
+  if (page_first_seq[head_page] == NO_RECORD){
+      page_first_seq[head_page] = next_seq;
+      page_first_time[head_page] = timestamp;
+      page_state[head_page] = PAGE_USED;
+  }
+  empty = false;
+  head_offset += size;
+  next_seq++;
+  last_time = timestamp;
+  stats.appends++;
+  return true;
+}
+
+bool flash_log_fits(uint16_t len){
+  return head_open && len <= FLASH_LOG_MAX_LEN && head_offset + record_size(len) <= FLASH_PAGE_SIZE;
+}
+
+void flash_log_close_page(){
+  if (head_open){
+      give_up_head();
+  }
+}
+
+uint32_t flash_log_next(){
+  return next_seq;
+}
+
+uint32_t flash_log_first(){
+  return empty ? next_seq : page_first_seq[tail_page];
+}
+
+uint32_t flash_log_last_timestamp(){
+  return empty ? 0 : last_time;
+}
+
+// pages in use from the oldest, NO_RECORD past the newest
+static uint32_t ring_page(uint32_t n){
+  uint32_t used = (head_page + FLASH_LOG_PAGES - tail_page) % FLASH_LOG_PAGES + 1;
+  return n < used ? (tail_page + n) % FLASH_LOG_PAGES : NO_RECORD;
+}
+
+// ring position of the last page whose first record has a sequence number
+// up to key, or a timestamp before key. 0 if there is none.
+static uint32_t find_page(uint32_t key, bool by_time){
+  uint32_t lo = 0;
+  uint32_t hi = (head_page + FLASH_LOG_PAGES - tail_page) % FLASH_LOG_PAGES;
+  uint32_t page;
+  // the head page may have no record yet after a failed write
+  while (hi > 0 && page_first_seq[ring_page(hi)] == NO_RECORD){
+      hi--;
+  }
+  while (lo < hi){
+      uint32_t mid = (lo + hi + 1) / 2;
+      page = ring_page(mid);
+      if (by_time ? page_first_time[page] < key : page_first_seq[page] <= key){
+          lo = mid;
+      }
+      else{
+          hi = mid - 1;
+      }
+  }
+  return lo;
+}
+
+bool flash_log_seek(uint32_t seq, flash_log_cursor_t* cursor){
+  uint32_t page;
+  uint32_t offset = FLASH_LOG_PAGE_HEADER;
+  int32_t len;
+  if (empty || seq < flash_log_first() || seq >= next_seq){
+      return false;
+  }
+  page = ring_page(find_page(seq, false));
+  while ((len = check_record(page, offset)) > 0 && page_base(page)[offset / 4] != seq){
+      offset += record_size((uint16_t)len);
+  }
+  cursor->page = (uint16_t)page;
+  cursor->offset = (uint16_t)offset;
+  return len > 0;
+}
+
+bool flash_log_seek_page(uint32_t seq, flash_log_cursor_t* cursor){
+  uint32_t page;
+  if (empty || seq < flash_log_first() || seq >= next_seq){
+      return false;
+  }
+  page = ring_page(find_page(seq, false));
+  cursor->page = (uint16_t)page;
+  cursor->offset = FLASH_LOG_PAGE_HEADER;
+  return true;
+}
+
+bool flash_log_seek_time(uint32_t timestamp, flash_log_cursor_t* cursor){
+  uint32_t n;
+  uint32_t page;
+  uint32_t offset = FLASH_LOG_PAGE_HEADER;
+  int32_t len;
+  if (empty || timestamp > last_time){
+      return false;
+  }
+  // the last page that starts before the time, the record is in it or
+  // first in the page after it. The oldest page if none starts before.
+  n = find_page(timestamp, true);
+  page = ring_page(n);
+  while ((len = check_record(page, offset)) > 0 && page_base(page)[offset / 4 + 1] < timestamp){
+      offset += record_size((uint16_t)len);
+  }
+  if (len <= 0 || (page == head_page && offset >= head_offset)){
+      page = ring_page(n + 1);
+      offset = FLASH_LOG_PAGE_HEADER;
+      if (page == NO_RECORD || page_first_seq[page] == NO_RECORD){
+          return false;
+      }
+  }
+  cursor->page = (uint16_t)page;
+  cursor->offset = (uint16_t)offset;
+  return true;
+}
+
+int32_t flash_log_read(flash_log_cursor_t* cursor, uint32_t* seq, uint32_t* timestamp,
+                       void* data, uint16_t max){
+  const uint32_t* header;
+  uint32_t next;
+  int32_t len;
+
+  if (empty || cursor->page >= FLASH_LOG_PAGES || page_state[cursor->page] != PAGE_USED){
+      return -1;
+  }
+  len = cursor->page == head_page && cursor->offset >= head_offset ? 0 :
+        check_record(cursor->page, cursor->offset);
+  if (len <= 0){
+      // end of the page, on to the next one unless this is the newest
+      if (cursor->page == head_page){
+          return -1;
+      }
+      next = (cursor->page + 1u) % FLASH_LOG_PAGES;
+      if (page_state[next] != PAGE_USED){
+          return -1;
+      }
+      cursor->page = (uint16_t)next;
+      cursor->offset = FLASH_LOG_PAGE_HEADER;
+      len = check_record(cursor->page, cursor->offset);
+      if (len <= 0){
+          return -1;
+      }
+  }
+  header = &page_base(cursor->page)[cursor->offset / 4];
+  if (seq != NULL){
+      *seq = header[0];
+  }
+  if (timestamp != NULL){
+      *timestamp = header[1];
+  }
+  memcpy(data, &header[3], (uint16_t)len < max ? (uint16_t)len : max);
+  cursor->offset = (uint16_t)(cursor->offset + record_size((uint16_t)len));
+  return len;
+}
+
+const flash_log_stats_t* flash_log_stats(){
+  return &stats;
+}
+
+void flash_log_wear(uint32_t* min, uint32_t* max){
+  *min = page_erases[0];
+  *max = page_erases[0];
+  for (uint32_t page = 1; page < FLASH_LOG_PAGES; page++){
+      if (page_erases[page] < *min){
+          *min = page_erases[page];
+      }
+      if (page_erases[page] > *max){
+          *max = page_erases[page];
+      }
+  }
+}
@@ -0,0 +1,87 @@
+/***********************************************************************
+ * @file      flash_log.h
+ * @brief     Append-only record log in internal flash
+ *
+ * @author    Hyounjun Chang, hyounjun.chang@colorado.edu
+ * @date      Oct 17, 2026
+ *
+ * @resources EFR32xG13 Reference Manual, MSC chapter
+ *
+ */
+#ifndef SRC_FLASH_LOG_H_
+#define SRC_FLASH_LOG_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// flash pages the log owns, reserved by the .internal_storage section at
+// the end of flash below NVM3, see flash_log.c
+#define FLASH_LOG_PAGES         32
+// longest record payload
+#define FLASH_LOG_MAX_LEN       64
+
+// flash layout, little endian words
+//  page:   uint32 FLASH_LOG_MAGIC, uint32 erase count, then records
+//  record: uint32 sequence number, uint32 timestamp,
+//          uint16 payload length, uint16 CRC-16 of all that and the payload,
+//          payload padded with 0xFF to a word
+#define FLASH_LOG_MAGIC         0x474F4C46  // "FLOG"
+#define FLASH_LOG_PAGE_HEADER   8
+#define FLASH_LOG_RECORD_HEADER 12
+
+typedef struct {
+  uint32_t recovered;     // records found by initFlashLog()
+  uint32_t torn;          // pages whose last record did not check out
+  uint32_t dropped;       // pages let go because they did not follow on
+  uint32_t appends;       // since initFlashLog()
+  uint32_t erases;
+  uint32_t write_errors;  // erases and writes that failed or read back wrong
+} flash_log_stats_t;
+
+// where a read is in the log
+typedef struct {
+  uint16_t page;
+  uint16_t offset;        // of the record header in the page
+} flash_log_cursor_t;
+
+// scans the pages and picks up every record that checks out, from the
+// newest back as long as sequence numbers follow on. Nothing is written.
+void initFlashLog();
+
+// writes a record with the next sequence number. Timestamps may not go
+// backwards. When the log is full the oldest page is erased to make room.
+// False if the record was not written, the next one goes to a new page.
+bool flash_log_append(uint32_t timestamp, const void* data, uint16_t len);
+// true if a record of len would go on the page appended to, false if the
+// next append starts a new page
+bool flash_log_fits(uint16_t len);
+// the next record goes to a new page. Nothing is written, after a reset
+// records may go on the old page again.
+void flash_log_close_page();
+
+// sequence numbers carry on across resets, from 0 on blank flash.
+// One past the newest record and the oldest record still kept.
+uint32_t flash_log_next();
+uint32_t flash_log_first();
+// timestamp of the newest record, 0 for an empty log
+uint32_t flash_log_last_timestamp();
+
+// puts the cursor on a record, false if it is not in the log
+bool flash_log_seek(uint32_t seq, flash_log_cursor_t* cursor);
+// on the first record of the page that holds seq, false if it is not in
+// the log
+bool flash_log_seek_page(uint32_t seq, flash_log_cursor_t* cursor);
+// on the oldest record with a timestamp at or after timestamp, false if
+// there is none. Binary search over the pages, then a scan of one page.
+bool flash_log_seek_time(uint32_t timestamp, flash_log_cursor_t* cursor);
+// copies the record at the cursor, up to max payload bytes, and moves the
+// cursor to the next one. Returns the payload length, -1 past the newest.
+// seq and timestamp may be NULL.
+int32_t flash_log_read(flash_log_cursor_t* cursor, uint32_t* seq, uint32_t* timestamp,
+                       void* data, uint16_t max);
+
+const flash_log_stats_t* flash_log_stats();
+// lowest and highest erase count of the pages, from their headers
+void flash_log_wear(uint32_t* min, uint32_t* max);
+
+#endif /* SRC_FLASH_LOG_H_ */
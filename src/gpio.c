@@ -70,6 +70,10 @@
 #define PB1_port gpioPortF
 #define PB1_pin 7
 
+// VEML6030 INT, open drain on the breakout, EXP header
+#define VEML6030_INT_port gpioPortD
+#define VEML6030_INT_pin 10 // PD10
+
 // Include logging for this file
 #define INCLUDE_LOG_DEBUG 1
 #include "src/log.h"
@@ -80,6 +84,9 @@ void gpioInit()
   gpioInit_SI7021();
   //gpioInit_LED(); portF used for ADC
   gpioInit_PB();
+#if DEVICE_IS_BLE_SERVER && VEML6030_THRESHOLD_INT
+  gpioInit_VEML6030_INT();
+#endif
 } // gpioInit()
 
 void gpioInit_LED(){
@@ -116,8 +123,8 @@ void gpioPowerOn_SI7021(){
   GPIO_PinOutSet(SI7021_ENABLE_PORT, SI7021_ENABLE_PIN);
 
   // 2- Wait for external device to complete its Power On Reset (POR) sequence
-  // 80ms max power-up time
-  timerWaitUs_irq(80000);
+  // 80ms max power-up time, the caller waits on a soft timer so the MCU can
+  // sleep, see initTemperatureSensor()
 
   // 3- Setup/enable GPIOs used for communication (I2C GPIOs: SCLK,SDA) with the device
   // this does not depend on step 2, so it's fine to call
@@ -132,15 +139,22 @@ void gpioInit_PB(){
   // Set GPIO pin to input
   GPIO_PinModeSet(PB0_port, PB0_pin, gpioModeInput, 1);
   // Interrupt number 6, since pin 4-7 must have Interrupt 4-7
-  GPIO_ExtIntConfig(PB0_port, PB0_pin, 6, true, true, true);
+  GPIO_ExtIntConfig(PB0_port, PB0_pin, GPIO_EXTINT_PB0, true, true, true);
   #if DEVICE_IS_BLE_SERVER == 0
     GPIO_PinModeSet(PB1_port, PB1_pin, gpioModeInput, 1);
     // Interrupt number 4 so GPIO_EVEN_IRQHandler() handles both,
     // otherwise GPIO_ODD_IRQHandler() must be called
-    GPIO_ExtIntConfig(PB1_port, PB1_pin, 4, true, true, true);
+    GPIO_ExtIntConfig(PB1_port, PB1_pin, GPIO_EXTINT_PB1, true, true, true);
   #endif
 }
 
+void gpioInit_VEML6030_INT(){
+  // pulled up, the sensor pulls it low until ALS_INT is read
+  GPIO_PinModeSet(VEML6030_INT_port, VEML6030_INT_pin, gpioModeInputPull, 1);
+  // falling edge only, pin 8-11 must have Interrupt 8-11
+  GPIO_ExtIntConfig(VEML6030_INT_port, VEML6030_INT_pin, GPIO_EXTINT_VEML6030, false, true, true);
+}
+
 // Referenced from Lecture 6
 void gpioPowerOff_SI7021(){
   // 5- If using interrupts, disable NVIC interrupts for the device
@@ -53,10 +53,18 @@ void gpioLed1SetOff();
 void gpioSetDisplayExtcomin(bool extcomin);
 void gpioSensorEnSetOn();
 
+// external interrupt numbers, all even so GPIO_EVEN_IRQHandler() gets them
+#define GPIO_EXTINT_PB0       6
+#define GPIO_EXTINT_PB1       4
+#define GPIO_EXTINT_VEML6030  10
+
 // PB0 button
 void gpioInit_PB();
 unsigned int gpioRead_PB0();
 unsigned int gpioRead_PB1();
 
+// VEML6030 INT line, active low
+void gpioInit_VEML6030_INT();
+
 
 #endif /* SRC_GPIO_H_ */
@@ -0,0 +1,212 @@
+/***********************************************************************
+ * @file      history.c
+ * @brief     Per-minute sensor history for bulk download
+ *
+ * @author    Hyounjun Chang, hyounjun.chang@colorado.edu
+ * @date      Oct 17, 2026
+ *
+ * @resources
+ *
+ * Every HISTORY_PERIOD_WINDOWS update windows the snapshot values of the
+ * period are reduced to one record and appended to the flash log the
+ * minute it is made, so the history outlives a reset and a gateway that
+ * stays away for days. A flash record carries the values as one sample of
+ * a series.c stream that runs over the records of a flash page: the first
+ * record of a page holds them whole, the others only the deltas from the
+ * record before. The log header already has the index, its sequence
+ * number, and the timestamp, so the stream gets timestamps of 0, a byte
+ * at the start of a page. The history is read out over the L2CAP history
+ * channel, see ble.c, decoded and encoded again as one stream per SDU.
+ * Leq is the energy mean of the windows, not the mean of their dB values,
+ * so one loud minute is not averaged away by the quiet ones around it.
+ *
+ * Records are stamped with the operating time in seconds. It carries on
+ * from the newest record after a reset, the time the board was off is not
+ * known.
+ *
+ */
+#include "history.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <math.h>
+
+#include "ble.h"
+#include "flash_log.h"
+#include "irq.h"
+
+// Include logging for this file
+#define INCLUDE_LOG_DEBUG 1
+#include "src/log.h"
+
+static uint32_t time_base_s = 0;   // operating time at boot
+
+// stream of the head page of the log, its last sample is the newest record
+// in flash. Only valid while page_stream is set.
+static series_encoder_t page_encoder;
+static bool page_stream = false;
+
+// period being collected
+static uint32_t period_windows = 0;
+static uint32_t period_occupied = 0;
+static uint8_t period_class = SOUND_QUIET;
+static float period_energy = 0.0f;
+static uint32_t period_lux = 0;
+
+// decodes the records of the head page into page_encoder, so the next one
+// can go on the page as a delta. False if they do not decode.
+static bool resume_page_stream(){
+  uint8_t payload[FLASH_LOG_MAX_LEN];
+  uint8_t sample[SERIES_SAMPLE_MAX(HISTORY_FIELDS)];
+  flash_log_cursor_t cursor;
+  series_decoder_t decoder;
+  int32_t values[HISTORY_FIELDS];
+  uint32_t timestamp;
+  uint16_t page;
+  int32_t len;
+
+  if (!flash_log_seek_page(flash_log_next() - 1, &cursor)){
+      return false;
+  }
+  page = cursor.page;
+  series_decoder_init(&decoder, NULL, 0, HISTORY_FIELDS);
+  series_encoder_init(&page_encoder, sample, sizeof(sample), HISTORY_FIELDS);
+  while ((len = flash_log_read(&cursor, NULL, NULL, payload, sizeof(payload))) > 0 && cursor.page == page){
+      series_decoder_continue(&decoder, payload, (uint16_t)len);
+      series_encoder_continue(&page_encoder, sample, sizeof(sample));
+      if (!series_decode(&decoder, &timestamp, values) || !series_encode(&page_encoder, 0, values)){
+          return false;
+      }
+  }
+  return page_encoder.count != 0;
+}
+
+// one flash record, a delta against the record before on the same page,
+// or the values whole on a new page
+static void append_record(uint32_t timestamp, const int32_t* values){
+  uint8_t payload[SERIES_SAMPLE_MAX(HISTORY_FIELDS)];
+  // a copy, the stream only moves on once the record is in flash
+  series_encoder_t encoder = page_encoder;
+
+  series_encoder_continue(&encoder, payload, sizeof(payload));
+  if (!page_stream || !series_encode(&encoder, 0, values) || !flash_log_fits(encoder.len)){
+      flash_log_close_page();
+      series_encoder_init(&encoder, payload, sizeof(payload), HISTORY_FIELDS);
+      series_encode(&encoder, 0, values);
+  }
+  if (!flash_log_append(timestamp, payload, encoder.len)){
+      LOG_ERROR("Error writing history record %lu to flash\r\n", (unsigned long)flash_log_next());
+      return;
+  }
+  page_encoder = encoder;
+  page_stream = true;
+}
+
+void initHistory(){
+  const flash_log_stats_t* stats;
+
+  initFlashLog();
+  stats = flash_log_stats();
+  time_base_s = 0;
+  page_stream = false;
+  // carry on from the newest record
+  if (flash_log_next() > flash_log_first()){
+      time_base_s = flash_log_last_timestamp() + HISTORY_PERIOD_S;
+      page_stream = resume_page_stream();
+  }
+  LOG_INFO("History: records %lu to %lu in flash, %lu torn pages, %lu dropped\r\n",
+           (unsigned long)flash_log_first(), (unsigned long)flash_log_next(),
+           (unsigned long)stats->torn, (unsigned long)stats->dropped);
+  period_windows = 0;
+  period_occupied = 0;
+  period_class = SOUND_QUIET;
+  period_energy = 0.0f;
+  period_lux = 0;
+}
+
+bool history_add_window(uint8_t flags, sound_class_t sound_class, int16_t leq_dB10,
+                        uint16_t lux, int16_t temp_e2, uint16_t humidity_e2){
+  int32_t values[HISTORY_FIELDS];
+  float leq_dB;
+
+  if (flags & SNAPSHOT_FLAG_OCCUPIED){
+      period_occupied++;
+  }
+  if ((uint8_t)sound_class > period_class){
+      period_class = (uint8_t)sound_class;
+  }
+  period_energy += powf(10.0f, leq_dB10 / 100.0f);
+  period_lux += lux;
+  if (++period_windows < HISTORY_PERIOD_WINDOWS){
+      return false;
+  }
+
+  leq_dB = 10.0f * log10f(period_energy / period_windows);
+  leq_dB = leq_dB < 0.0f ? 0.0f : (leq_dB > 255.0f ? 255.0f : leq_dB);
+  flags &= ~SNAPSHOT_FLAG_OCCUPIED;
+  if (period_occupied * 2 > period_windows){
+      flags |= SNAPSHOT_FLAG_OCCUPIED;
+  }
+
+  values[HISTORY_FLAGS] = flags;
+  values[HISTORY_SOUND_CLASS] = period_class;
+  values[HISTORY_LEQ] = (int32_t)(leq_dB + 0.5f);
+  values[HISTORY_HUMIDITY] = (humidity_e2 + 25) / 50;
+  values[HISTORY_LUX] = (int32_t)((period_lux + period_windows / 2) / period_windows);
+  values[HISTORY_TEMPERATURE] = temp_e2;
+  append_record(time_base_s + (uint32_t)(letimerMilliseconds() / 1000), values);
+
+  period_windows = 0;
+  period_occupied = 0;
+  period_class = SOUND_QUIET;
+  period_energy = 0.0f;
+  period_lux = 0;
+  return true;
+}
+
+uint32_t history_next(){
+  return flash_log_next();
+}
+
+uint32_t history_first(){
+  return flash_log_first();
+}
+
+uint32_t history_read(uint32_t* index, series_encoder_t* enc, uint32_t max){
+  uint8_t payload[FLASH_LOG_MAX_LEN];
+  flash_log_cursor_t cursor;
+  series_decoder_t decoder;
+  int32_t values[HISTORY_FIELDS];
+  uint32_t seq;
+  uint32_t timestamp;
+  uint32_t unused;
+  uint32_t count = 0;
+  uint16_t page = FLASH_LOG_PAGES;
+  int32_t len;
+
+  // the stream of a page has to be decoded from its first record
+  if (!flash_log_seek_page(*index, &cursor)){
+      return 0;
+  }
+  while (count < max && (len = flash_log_read(&cursor, &seq, &timestamp, payload, sizeof(payload))) > 0){
+      if (cursor.page != page){
+          page = cursor.page;
+          series_decoder_init(&decoder, payload, (uint16_t)len, HISTORY_FIELDS);
+      }
+      else{
+          series_decoder_continue(&decoder, payload, (uint16_t)len);
+      }
+      if (!series_decode(&decoder, &unused, values)){
+          LOG_ERROR("History record %lu does not decode\r\n", (unsigned long)seq);
+          break;
+      }
+      if (seq < *index){
+          continue;
+      }
+      if (!series_encode(enc, timestamp, values)){
+          break;
+      }
+      count++;
+  }
+  return count;
+}
@@ -0,0 +1,53 @@
+/***********************************************************************
+ * @file      history.h
+ * @brief     Per-minute sensor history for bulk download
+ *
+ * @author    Hyounjun Chang, hyounjun.chang@colorado.edu
+ * @date      Oct 17, 2026
+ *
+ * @resources
+ *
+ */
+#ifndef SRC_HISTORY_H_
+#define SRC_HISTORY_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sound.h"
+#include "series.h"
+
+#define HISTORY_PERIOD_WINDOWS  60    // update windows per record
+#define HISTORY_PERIOD_S        60    // HISTORY_PERIOD_WINDOWS at SOUND_WINDOW_PERIOD_MS
+
+// history record fields, in the order they are encoded, see series.h.
+// Records are stamped with the operating time in seconds.
+typedef enum {
+  HISTORY_FLAGS = 0,        // SNAPSHOT_FLAG_*, occupied if it was for most of the period
+  HISTORY_SOUND_CLASS,      // sound_class_t, the loudest window of the period
+  HISTORY_LEQ,              // Leq over the period, whole dB
+  HISTORY_HUMIDITY,         // 0.5 %RH
+  HISTORY_LUX,              // illuminance, whole lux, mean over the period
+  HISTORY_TEMPERATURE,      // 0.01 C
+  HISTORY_FIELDS,
+} history_field_t;
+
+// picks up the records in flash
+void initHistory();
+
+// one update window with the snapshot values, true when it completed a record
+bool history_add_window(uint8_t flags, sound_class_t sound_class, int16_t leq_dB10,
+                        uint16_t lux, int16_t temp_e2, uint16_t humidity_e2);
+
+// records are numbered from 0 on blank flash and carry on across resets,
+// an index is the sequence number of the record in the flash log.
+// Index of the record being collected, one past the newest complete one
+uint32_t history_next();
+// oldest record still kept
+uint32_t history_first();
+
+// encodes records from *index on into enc, up to max and as many as fit,
+// returns how many. *index has to be between history_first() and
+// history_next().
+uint32_t history_read(uint32_t* index, series_encoder_t* enc, uint32_t max);
+
+#endif /* SRC_HISTORY_H_ */
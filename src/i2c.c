@@ -13,10 +13,16 @@
 
 #include "i2c.h"
 #include <sl_i2cspm.h>
+#include "sl_power_manager.h"
 #include <stdint.h>
 #include "timer.h"
 #include "gpio.h"
 #include "app.h"
+#include "i2c_queue.h"
+#include "scheduler.h"
+#include "sl_udelay.h"
+#include <em_core.h>
+#include "em_gpio.h"
 
 // Include logging for this file
 #define INCLUDE_LOG_DEBUG 1
@@ -40,28 +46,150 @@
 
 // SI7021 Commands
 #define MEASURE_TEMP_NO_HOLD 0xF3// no hold master mode, no clock stretching
+#define MEASURE_RH_NO_HOLD 0xF5 // measures the temperature too
+#define READ_TEMP_FROM_RH 0xE0 // temperature of the last humidity measurement
 
 // VEML6030 Address
 #define VEML6030_ADDR 0x48 // 0x48 default (ADDR = 1), 0x10 (ADDR = 0)
 
 // VEML6030 Commands
 #define VEML6030_ALS_CONF_0 0x00
+#define VEML6030_ALS_WH 0x01
+#define VEML6030_ALS_WL 0x02
 #define VEML6030_POWER_SAVING 0x03
 #define VEML6030_ALS 0x04
+#define VEML6030_ALS_INT 0x06
 
-// global variables
-I2C_TransferSeq_TypeDef transferSequence; // global
+// ALS_CONF_0 fields
+#define VEML6030_GAIN_X1    (0b00 << 11)
+#define VEML6030_GAIN_X2    (0b01 << 11)
+#define VEML6030_GAIN_X1_8  (0b10 << 11)
+#define VEML6030_GAIN_X1_4  (0b11 << 11)
+#define VEML6030_IT_25MS    (0b1100 << 6)
+#define VEML6030_IT_50MS    (0b1000 << 6)
+#define VEML6030_IT_100MS   (0b0000 << 6)
+#define VEML6030_IT_200MS   (0b0001 << 6)
+#define VEML6030_IT_400MS   (0b0010 << 6)
+#define VEML6030_IT_800MS   (0b0011 << 6)
+#define VEML6030_INT_EN     (0b1 << 1)
 
-// for VEML6030
-uint8_t VEML6030_cmd_data[3];
-uint8_t VEML6030_read_data[2];
+// auto-ranging, on the counts of the last reading. Above HIGH (80 % of full
+// scale) or below LOW the range is changed to the most sensitive one that
+// puts the same light below TARGET counts.
+#define VEML6030_FULL_SCALE_COUNTS    0xFFFF
+#define VEML6030_RANGE_HIGH_COUNTS    52428
+#define VEML6030_RANGE_LOW_COUNTS     1000
+#define VEML6030_RANGE_TARGET_COUNTS  16384
 
+typedef struct {
+  uint16_t als_conf;
+  uint16_t lux_e4_per_count;  // resolution, 1/10000 lux per count
+} VEML6030_range_t;
+
+// resolution table of the VEML6030 application note, most sensitive first.
+// Every step is a factor of 2, 65535 counts at the last one is about 120 klux.
+static const VEML6030_range_t VEML6030_ranges[] = {
+  { VEML6030_GAIN_X2   | VEML6030_IT_800MS,    36 },
+  { VEML6030_GAIN_X2   | VEML6030_IT_400MS,    72 },
+  { VEML6030_GAIN_X2   | VEML6030_IT_200MS,   144 },
+  { VEML6030_GAIN_X2   | VEML6030_IT_100MS,   288 },
+  { VEML6030_GAIN_X1   | VEML6030_IT_100MS,   576 },
+  { VEML6030_GAIN_X1   | VEML6030_IT_50MS,   1152 },
+  { VEML6030_GAIN_X1_4 | VEML6030_IT_100MS,  2304 },
+  { VEML6030_GAIN_X1_8 | VEML6030_IT_100MS,  4608 },
+  { VEML6030_GAIN_X1_8 | VEML6030_IT_50MS,   9216 },
+  { VEML6030_GAIN_X1_8 | VEML6030_IT_25MS,  18432 },
+};
+#define VEML6030_NUM_RANGES (sizeof(VEML6030_ranges) / sizeof(VEML6030_ranges[0]))
+#define VEML6030_DEFAULT_RANGE 3 // ALS_GAIN = 01, ALS_IT = 0000, 0.0288 lux/count
+
+// for VEML6030, the ALS read and range changes go through the I2C queue
+static i2c_request_t VEML6030_als_request;
+static i2c_request_t VEML6030_conf_request;
+
+static uint8_t VEML6030_range = VEML6030_DEFAULT_RANGE; // ALS_CONF_0 last written
+static uint8_t VEML6030_discard = 0;        // readings to drop after a change
+static volatile bool VEML6030_conf_failed = false;
+static uint32_t VEML6030_range_change_count = 0;
+static uint32_t VEML6030_saturated_count = 0;
+
+// for SI7021, every step of a measurement goes through the I2C queue
+static i2c_request_t SI7021_measure_request;
+static i2c_request_t SI7021_rh_request;
+static i2c_request_t SI7021_temp_request;
+
+#if VEML6030_THRESHOLD_INT
+// the band is 1/8 of the reading either side, and a few counts at least so
+// a dark room does not interrupt on single counts
+#define VEML6030_HYSTERESIS_SHIFT       3
+#define VEML6030_HYSTERESIS_MIN_COUNTS  4
+
+static i2c_request_t VEML6030_int_request; // ALS_INT read, releases the INT line
+static i2c_request_t VEML6030_wh_request;
+static i2c_request_t VEML6030_wl_request;
+// thresholds still to write, ALS_WH and ALS_WL always go out together
+static bool VEML6030_thresholds_pending = false;
+static uint16_t VEML6030_pending_high = 0;
+static uint16_t VEML6030_pending_low = 0;
+
+static void VEML6030_write_thresholds();
+#endif
+
+// ALS_CONF_0 for a range, ALS_PERS = 00, ALS_SD = 0 (ALS power on)
+static uint16_t VEML6030_als_conf(uint8_t range){
+  uint16_t als_conf = VEML6030_ranges[range].als_conf;
+#if VEML6030_THRESHOLD_INT
+  als_conf |= VEML6030_INT_EN;
+#endif
+  return als_conf;
+}
+
+// I2C0_IRQHandler() context, the main loop takes the reading from here
+static void VEML6030_als_read_done(i2c_request_t* request){
+  if (request->result == i2cTransferDone){
+      set_scheduler_event_data(EVENT_I2C_TRANSFER, I2C_TRANSFER_VEML6030_ALS);
+  }
+}
+
+// I2C0_IRQHandler() context, a failed range change is retried on the next read
+static void VEML6030_conf_write_done(i2c_request_t* request){
+  if (request->result != i2cTransferDone){
+      VEML6030_conf_failed = true;
+  }
+}
+
+#if VEML6030_THRESHOLD_INT
+// I2C0_IRQHandler() context, a write that failed all its retries sends the
+// pair again, and a pair set meanwhile goes out once both writes are over.
+// A usage fault would fail again at once, that one is dropped.
+static void VEML6030_threshold_write_done(i2c_request_t* request){
+  if (request->result != i2cTransferDone && request->result != i2cTransferUsageFault){
+      VEML6030_thresholds_pending = true;
+  }
+  VEML6030_write_thresholds();
+}
+#endif
+
+// I2C0_IRQHandler() context, whether it worked is read from the request
+static void SI7021_measure_done(i2c_request_t* request){
+  set_scheduler_event_data(EVENT_I2C_TRANSFER, I2C_TRANSFER_SI7021_MEASURE);
+}
+
+// I2C0_IRQHandler() context, the temperature read goes out once the humidity
+// read is in, retries included, so the event always comes after both
+static void SI7021_rh_read_done(i2c_request_t* request){
+  if (request->result != i2cTransferDone || !i2c_queue_submit(&SI7021_temp_request)){
+      set_scheduler_event_data(EVENT_I2C_TRANSFER, I2C_TRANSFER_SI7021_READ);
+  }
+}
+
+static void SI7021_temp_read_done(i2c_request_t* request){
+  set_scheduler_event_data(EVENT_I2C_TRANSFER, I2C_TRANSFER_SI7021_READ);
+}
 
 // Used from Lecture 6 slides
 // Using I2CSPM_Init, as it's stated it's okay per spec
-void initialize_I2C(){
-  // Initialize the I2C hardware
-  I2CSPM_Init_TypeDef I2C_Config = {
+static I2CSPM_Init_TypeDef I2C_Config = {
   .port = I2C0,
   .sclPort = SI7021_I2C_PORT,
   .sclPin = SI7021_SCL_PIN,
@@ -72,98 +200,387 @@ void initialize_I2C(){
   .i2cRefFreq = 0,
   .i2cMaxFreq = I2C_FREQ_STANDARD_MAX,
   .i2cClhr = i2cClockHLRStandard
-  };
+};
+
+// half an SCL period of the bus clear, 100 kHz
+#define I2C_BUS_CLEAR_HALF_PERIOD_US 5
+#define I2C_BUS_CLEAR_CLOCKS         9
+
+// UM10204 3.1.16: a slave stopped in the middle of a byte holds SDA low
+// until it has clocked out the rest of it, at most 9 SCL clocks, then a STOP
+// puts every device back to idle. I2C0 is set up again from scratch after.
+static void I2C0_bus_recover(){
+  I2C_Reset(I2C0);
+  I2C0->ROUTEPEN = 0; // the pins back to GPIO
+  GPIO_PinModeSet(SI7021_I2C_PORT, SI7021_SCL_PIN, gpioModeWiredAndPullUp, 1);
+  GPIO_PinModeSet(SI7021_I2C_PORT, SI7021_SDA_PIN, gpioModeWiredAndPullUp, 1);
+
+  for (uint32_t i = 0; i < I2C_BUS_CLEAR_CLOCKS && !GPIO_PinInGet(SI7021_I2C_PORT, SI7021_SDA_PIN); i++){
+      GPIO_PinOutClear(SI7021_I2C_PORT, SI7021_SCL_PIN);
+      sl_udelay_wait(I2C_BUS_CLEAR_HALF_PERIOD_US);
+      GPIO_PinOutSet(SI7021_I2C_PORT, SI7021_SCL_PIN);
+      sl_udelay_wait(I2C_BUS_CLEAR_HALF_PERIOD_US);
+  }
+  // STOP, SDA rising while SCL is high
+  GPIO_PinOutClear(SI7021_I2C_PORT, SI7021_SDA_PIN);
+  sl_udelay_wait(I2C_BUS_CLEAR_HALF_PERIOD_US);
+  GPIO_PinOutSet(SI7021_I2C_PORT, SI7021_SDA_PIN);
+  sl_udelay_wait(I2C_BUS_CLEAR_HALF_PERIOD_US);
+  if (!GPIO_PinInGet(SI7021_I2C_PORT, SI7021_SDA_PIN)){
+      LOG_ERROR("I2C SDA still held low after bus clear\r\n");
+  }
+
+  I2CSPM_Init(&I2C_Config);
+}
+
+// blocking, for init before the queue is in use, with the same retry
+// budget as queued requests. Bus errors recover the bus before the retry.
+static I2C_TransferReturn_TypeDef I2C0_transfer_blocking(I2C_TransferSeq_TypeDef* seq){
+  I2C_TransferReturn_TypeDef status = I2CSPM_Transfer(I2C0, seq);
+
+  for (uint32_t retry = 0; status != i2cTransferDone && retry < I2C_REQUEST_MAX_RETRIES; retry++){
+      LOG_WARN("I2C transfer to 0x%x failed: %d, retrying\r\n", seq->addr >> 1, status);
+      if (status != i2cTransferNack){
+          I2C0_bus_recover();
+      }
+      sl_udelay_wait((uint32_t)I2C_RETRY_BACKOFF_US << retry);
+      status = I2CSPM_Transfer(I2C0, seq);
+  }
+  if (status != i2cTransferDone) {
+      LOG_ERROR("I2C transfer Failed\r\n");
+  }
+  return status;
+}
+
+void initialize_I2C(){
+  // Initialize the I2C hardware
   I2CSPM_Init(&I2C_Config);
   // uint32_t i2c_bus_frequency = I2C_BusFreqGet (I2C0);
+  initI2CQueue(I2C0_bus_recover);
 
   // Initialize ambient light sensor
   VEML6030_initialize();
+  // and temperature sensor
+  SI7021_initialize();
 }
 
-// Using I2CSPM for initialization
+// Using I2CSPM for initialization, blocking, before the queue is in use
 void VEML6030_initialize(){
   // Operation Mode - VDD = 3.3 V, PSM = 11, refresh time 4100 ms, ALS_GAIN = “01” for minimum gain
   // For VEML6030, 3 byte data is sent in cmd-data_LSB-data_MSB
-  I2C_TransferReturn_TypeDef transferStatus;
+  I2C_TransferSeq_TypeDef transferSequence;
+  uint8_t cmd_data[3];
 
   // Set mode
-  VEML6030_cmd_data[0] = VEML6030_ALS_CONF_0;
-  VEML6030_cmd_data[1] = 0b00000000; // ALS_PERS = 00, Protect # = 1, ALS_INT_EN = 0, ALS_SD = 0 (ALS power on)
-  VEML6030_cmd_data[2] = 0b00001000; // ALS_GAIN = 01, ALS_IT = 0000 for 100ms integration time
+  cmd_data[0] = VEML6030_ALS_CONF_0;
+  // ALS_PERS = 00, Protect # = 1, ALS_INT_EN per VEML6030_THRESHOLD_INT, ALS_SD = 0 (ALS power on)
+  // ALS_GAIN = 01, ALS_IT = 0000 for 100ms integration time, auto-ranging from there
+  VEML6030_range = VEML6030_DEFAULT_RANGE;
+  VEML6030_discard = 0;
+  cmd_data[1] = VEML6030_als_conf(VEML6030_range) & 0xFF;
+  cmd_data[2] = VEML6030_als_conf(VEML6030_range) >> 8;
 
   transferSequence.addr = VEML6030_ADDR << 1; // shift device address left
   transferSequence.flags = I2C_FLAG_WRITE;
-  transferSequence.buf[0].data = &(VEML6030_cmd_data[0]); // pointer to data to write
+  transferSequence.buf[0].data = &(cmd_data[0]); // pointer to data to write
   transferSequence.buf[0].len = 3;
 
-  // send twice, current hardware sometimes fails first I2C transfer
-  transferStatus = I2CSPM_Transfer(I2C0, &transferSequence);
-  if (transferStatus != i2cTransferDone) {
-      LOG_ERROR("I2C transfer Failed\r\n");
-  }
-  transferStatus = I2CSPM_Transfer(I2C0, &transferSequence);
-  if (transferStatus != i2cTransferDone) {
-      LOG_ERROR("I2C transfer Failed\r\n");
-  }
+  // current hardware sometimes fails the first I2C transfer, retried
+  I2C0_transfer_blocking(&transferSequence);
 
   // Power Saving Mode
-  VEML6030_cmd_data[0] = VEML6030_POWER_SAVING;
-  VEML6030_cmd_data[1] = 0b111; // PSM = 11, PSM_EN = 1
-  VEML6030_cmd_data[2] = 0b0;
+  cmd_data[0] = VEML6030_POWER_SAVING;
+  cmd_data[1] = 0b111; // PSM = 11, PSM_EN = 1
+  cmd_data[2] = 0b0;
 
-  transferSequence.addr = VEML6030_ADDR << 1; // shift device address left
-  transferSequence.flags = I2C_FLAG_WRITE;
-  transferSequence.buf[0].data = &(VEML6030_cmd_data[0]); // pointer to data to write
-  transferSequence.buf[0].len = 3;
+  I2C0_transfer_blocking(&transferSequence);
 
-  transferStatus = I2CSPM_Transfer(I2C0, &transferSequence);
-  if (transferStatus != i2cTransferDone) {
-     LOG_ERROR("I2C transfer Failed\r\n");
-  }
+#if VEML6030_THRESHOLD_INT
+  // empty band, high 0 and low full scale, the first measurement interrupts
+  cmd_data[0] = VEML6030_ALS_WH;
+  cmd_data[1] = 0x00;
+  cmd_data[2] = 0x00;
+  I2C0_transfer_blocking(&transferSequence);
+  cmd_data[0] = VEML6030_ALS_WL;
+  cmd_data[1] = 0xFF;
+  cmd_data[2] = 0xFF;
+  I2C0_transfer_blocking(&transferSequence);
+
+  // an interrupt latched before a reset holds INT low, no edge would come
+  uint8_t int_status[2];
+  cmd_data[0] = VEML6030_ALS_INT;
+  transferSequence.flags = I2C_FLAG_WRITE_READ;
+  transferSequence.buf[0].len = 1;
+  transferSequence.buf[1].data = int_status;
+  transferSequence.buf[1].len = 2;
+  I2C0_transfer_blocking(&transferSequence);
+
+  VEML6030_int_request.priority = I2C_PRIORITY_NORMAL;
+  VEML6030_int_request.done = NULL;
+  VEML6030_int_request.write_data[0] = VEML6030_ALS_INT;
+  i2c_request_write_read(&VEML6030_int_request, VEML6030_ADDR, 1, 2);
+
+  VEML6030_thresholds_pending = false;
+  VEML6030_wh_request.priority = I2C_PRIORITY_NORMAL;
+  VEML6030_wh_request.done = VEML6030_threshold_write_done;
+  VEML6030_wh_request.write_data[0] = VEML6030_ALS_WH;
+  i2c_request_write(&VEML6030_wh_request, VEML6030_ADDR, 3);
+
+  VEML6030_wl_request.priority = I2C_PRIORITY_NORMAL;
+  VEML6030_wl_request.done = VEML6030_threshold_write_done;
+  VEML6030_wl_request.write_data[0] = VEML6030_ALS_WL;
+  i2c_request_write(&VEML6030_wl_request, VEML6030_ADDR, 3);
+#endif
+
+  // ALS register read, every AMBIENT_LIGHT_PERIOD_MS or on the INT line
+  VEML6030_als_request.priority = I2C_PRIORITY_NORMAL;
+  VEML6030_als_request.done = VEML6030_als_read_done;
+  VEML6030_als_request.write_data[0] = VEML6030_ALS;
+  i2c_request_write_read(&VEML6030_als_request, VEML6030_ADDR, 1, 2);
+
+  // ALS_CONF_0 write for range changes, ahead of anything else queued
+  VEML6030_conf_request.priority = I2C_PRIORITY_HIGH;
+  VEML6030_conf_request.done = VEML6030_conf_write_done;
+  VEML6030_conf_request.write_data[0] = VEML6030_ALS_CONF_0;
+  i2c_request_write(&VEML6030_conf_request, VEML6030_ADDR, 3);
 }
 
 // since refresh time = 4100ms, call this every >5 sec
+// EVENT_I2C_TRANSFER with data I2C_TRANSFER_VEML6030_ALS when the reading is in
 void VEML6030_start_read_ambient_light_level(){
-  // Sleep at EM1 during I2C
-  if (LOWEST_ENERGY_MODE == 2){
-     sl_power_manager_remove_em_requirement(SL_POWER_MANAGER_EM2);
-     sl_power_manager_add_em_requirement(SL_POWER_MANAGER_EM1);
+#if VEML6030_THRESHOLD_INT
+  // reading ALS_INT releases the INT line for the next crossing
+  if (!i2c_queue_submit(&VEML6030_int_request)){
+      LOG_WARN("VEML6030 interrupt status read still in flight\r\n");
   }
-  if (LOWEST_ENERGY_MODE == 3){
-     sl_power_manager_add_em_requirement(SL_POWER_MANAGER_EM1);
+#endif
+  // the queue holds EM1 while the transfer runs
+  if (!i2c_queue_submit(&VEML6030_als_request)){
+      LOG_WARN("VEML6030 read still in flight, skipped\r\n");
   }
-  NVIC_EnableIRQ(I2C0_IRQn); // since updated state has I2C transfer, enable IRQ
-  // Set mode
-  VEML6030_cmd_data[0] = VEML6030_ALS;
+}
 
-  transferSequence.addr = VEML6030_ADDR << 1; // shift device address left
-  transferSequence.flags = I2C_FLAG_WRITE_READ;
-  transferSequence.buf[0].data = &(VEML6030_cmd_data[0]); // write cmd = register
-  transferSequence.buf[0].len = 1;
-  transferSequence.buf[1].data = &(VEML6030_read_data[0]);
-  transferSequence.buf[1].len = 2;
+uint32_t VEML6030_convert_to_lux_e4(const VEML6030_sample_t* sample){
+  // 65535 * 18432 still fits 32 bits
+  return (uint32_t)sample->counts * VEML6030_ranges[sample->range].lux_e4_per_count;
+}
 
-  I2C_TransferReturn_TypeDef transferStatus;
-  // receving SW fault if NVIC interrupt for I2C_Transfer is used, until this is fixed I2CSPM useds
-  transferStatus = I2C_TransferInit(I2C0, &transferSequence);
-  if (transferStatus < 0) {
-    LOG_ERROR("%d\r\n", transferStatus);
+// converts ADC value to light measurement in lux
+float VEML6030_convert_to_lux(const VEML6030_sample_t* sample){
+  return VEML6030_convert_to_lux_e4(sample) * 0.0001f;
+}
+
+// the most sensitive range that keeps the light of sample below target counts.
+// Saturated counts only give a lower bound, so those step at least 2 ranges.
+static uint8_t VEML6030_pick_range(const VEML6030_sample_t* sample){
+  uint32_t lux_e4 = VEML6030_convert_to_lux_e4(sample);
+  uint8_t range = VEML6030_NUM_RANGES - 1;
+
+  for (uint8_t r = 0; r < VEML6030_NUM_RANGES; r++){
+      if (lux_e4 / VEML6030_ranges[r].lux_e4_per_count <= VEML6030_RANGE_TARGET_COUNTS){
+          range = r;
+          break;
+      }
   }
+  if (sample->counts == VEML6030_FULL_SCALE_COUNTS && range < sample->range + 2){
+      range = sample->range + 2;
+      if (range >= VEML6030_NUM_RANGES){
+          range = VEML6030_NUM_RANGES - 1;
+      }
+  }
+  return range;
 }
 
-// converts ADC value to light measurement in lux
-float VEML6030_convert_to_lux(uint16_t adc_val){
-  // ALS_GAIN = 01, PSM = 11, ALS_IT = 0000
-  return 0.0288 * adc_val;
+// queues the ALS_CONF_0 write, the reading after it may still be integrated
+// with the old setting so it is dropped. False while the last write is in
+// flight, its buffer is not touched and the range stays as it is.
+static bool VEML6030_set_range(uint8_t range){
+  uint16_t als_conf = VEML6030_als_conf(range);
+
+  // only the main loop submits, so an idle request stays idle until then
+  if (VEML6030_conf_request.busy){
+      LOG_WARN("VEML6030 range change still in flight\r\n");
+      return false;
+  }
+  VEML6030_conf_request.write_data[1] = als_conf & 0xFF;
+  VEML6030_conf_request.write_data[2] = als_conf >> 8;
+  if (!i2c_queue_submit(&VEML6030_conf_request)){
+      return false;
+  }
+  VEML6030_range = range;
+  VEML6030_discard = 1;
+  return true;
+}
+
+#if VEML6030_THRESHOLD_INT
+// queues the pending pair once neither write is in flight, both or neither
+// so the chip never mixes a new high with an old low. Called from the main
+// loop and from the done callbacks.
+static void VEML6030_write_thresholds(){
+  CORE_DECLARE_IRQ_STATE;
+
+  CORE_ENTER_CRITICAL();
+  if (!VEML6030_thresholds_pending || VEML6030_wh_request.busy || VEML6030_wl_request.busy){
+      CORE_EXIT_CRITICAL();
+      return;
+  }
+  VEML6030_wh_request.write_data[1] = VEML6030_pending_high & 0xFF;
+  VEML6030_wh_request.write_data[2] = VEML6030_pending_high >> 8;
+  VEML6030_wl_request.write_data[1] = VEML6030_pending_low & 0xFF;
+  VEML6030_wl_request.write_data[2] = VEML6030_pending_low >> 8;
+  // cleared first, a callback run from inside submit may mark it again
+  VEML6030_thresholds_pending = false;
+  i2c_queue_submit(&VEML6030_wh_request);
+  i2c_queue_submit(&VEML6030_wl_request);
+  CORE_EXIT_CRITICAL();
+}
+
+// INT goes low once a measurement is above high or below low. A pair set
+// while the last one is in flight replaces it and goes out after it.
+static void VEML6030_set_thresholds(uint16_t high, uint16_t low){
+  CORE_DECLARE_IRQ_STATE;
+
+  CORE_ENTER_CRITICAL();
+  VEML6030_pending_high = high;
+  VEML6030_pending_low = low;
+  VEML6030_thresholds_pending = true;
+  CORE_EXIT_CRITICAL();
+  VEML6030_write_thresholds();
 }
 
-float VEML6030_read_measured_ambient_light(){
+// hysteresis band around the reading. Until a reading in a new range is in
+// the band is empty, so the next measurement interrupts whatever it is.
+static void VEML6030_arm_thresholds(const VEML6030_sample_t* sample){
+  uint32_t band = sample->counts >> VEML6030_HYSTERESIS_SHIFT;
+  uint32_t high;
+
+  if (VEML6030_discard > 0){
+      VEML6030_set_thresholds(0, VEML6030_FULL_SCALE_COUNTS);
+      return;
+  }
+  if (band < VEML6030_HYSTERESIS_MIN_COUNTS){
+      band = VEML6030_HYSTERESIS_MIN_COUNTS;
+  }
+  high = sample->counts + band;
+  if (high > VEML6030_FULL_SCALE_COUNTS){
+      high = VEML6030_FULL_SCALE_COUNTS;
+  }
+  VEML6030_set_thresholds(high, sample->counts > band ? sample->counts - band : 0);
+}
+#endif
+
+bool VEML6030_read_measured_ambient_light(VEML6030_sample_t* sample){
   // sends 2-byte data, MSB then LSB (big-endian)
   // uint16_t is little-endian, so you can't directly store to uint16_t
   // add values from 0
-  uint16_t sensor_value = VEML6030_read_data[0];
-  sensor_value += (uint16_t)VEML6030_read_data[1] << 8;
-  return VEML6030_convert_to_lux(sensor_value);
+  const uint8_t* read_data = VEML6030_als_request.read_data;
+  uint16_t sensor_value = read_data[0];
+  sensor_value += (uint16_t)read_data[1] << 8;
+  sample->counts = sensor_value;
+  sample->range = VEML6030_range;
+
+  if (VEML6030_conf_failed){
+      // tried again on the next reading if it cannot go out yet
+      VEML6030_conf_failed = !VEML6030_set_range(VEML6030_range);
+#if VEML6030_THRESHOLD_INT
+      VEML6030_arm_thresholds(sample);
+#endif
+      return false;
+  }
+  if (VEML6030_discard > 0){
+      VEML6030_discard--;
+#if VEML6030_THRESHOLD_INT
+      // the one after it has to be read too
+      VEML6030_set_thresholds(0, VEML6030_FULL_SCALE_COUNTS);
+#endif
+      return false;
+  }
+
+  if (sensor_value == VEML6030_FULL_SCALE_COUNTS){
+      VEML6030_saturated_count++;
+  }
+  if (sensor_value > VEML6030_RANGE_HIGH_COUNTS ||
+      (sensor_value < VEML6030_RANGE_LOW_COUNTS && VEML6030_range > 0)){
+      uint8_t range = VEML6030_pick_range(sample);
+      // the next reading picks again if the write cannot go out yet
+      if (range != VEML6030_range && VEML6030_set_range(range)){
+          LOG_INFO("VEML6030 range %u -> %u at %u counts\r\n", sample->range, range, sensor_value);
+          VEML6030_range_change_count++;
+      }
+  }
+#if VEML6030_THRESHOLD_INT
+  VEML6030_arm_thresholds(sample);
+#endif
+  return true;
+}
+
+uint32_t VEML6030_range_changes(){
+  return VEML6030_range_change_count;
+}
+
+uint32_t VEML6030_saturated_reads(){
+  return VEML6030_saturated_count;
+}
+
+void SI7021_initialize(){
+  // measure command, no hold master mode so the bus is free while it converts
+  SI7021_measure_request.priority = I2C_PRIORITY_NORMAL;
+  SI7021_measure_request.done = SI7021_measure_done;
+  SI7021_measure_request.write_data[0] = MEASURE_RH_NO_HOLD;
+  i2c_request_write(&SI7021_measure_request, SI7021_ADDR, 1);
+
+  // humidity result, a plain read. The sensor NACKs it until it is done.
+  SI7021_rh_request.priority = I2C_PRIORITY_NORMAL;
+  SI7021_rh_request.done = SI7021_rh_read_done;
+  i2c_request_read(&SI7021_rh_request, SI7021_ADDR, 2);
+
+  // temperature of the same measurement, no second conversion
+  SI7021_temp_request.priority = I2C_PRIORITY_NORMAL;
+  SI7021_temp_request.done = SI7021_temp_read_done;
+  SI7021_temp_request.write_data[0] = READ_TEMP_FROM_RH;
+  i2c_request_write_read(&SI7021_temp_request, SI7021_ADDR, 1, 2);
+}
+
+void SI7021_start_measurement(){
+  if (!i2c_queue_submit(&SI7021_measure_request)){
+      LOG_WARN("Si7021 measurement still in flight, skipped\r\n");
+  }
+}
+
+bool SI7021_measurement_started(){
+  return SI7021_measure_request.result == i2cTransferDone;
+}
+
+void SI7021_start_read(){
+  // the temperature read follows from SI7021_rh_read_done()
+  if (!i2c_queue_submit(&SI7021_rh_request)){
+      LOG_WARN("Si7021 read still in flight\r\n");
+  }
+}
+
+bool SI7021_read_measurement(SI7021_sample_t* sample){
+  // MSB first, the last 2 bits of the LSB are status bits
+  sample->rh_code = ((uint16_t)SI7021_rh_request.read_data[0] << 8) | SI7021_rh_request.read_data[1];
+  sample->temp_code = ((uint16_t)SI7021_temp_request.read_data[0] << 8) | SI7021_temp_request.read_data[1];
+  return SI7021_rh_request.result == i2cTransferDone &&
+         SI7021_temp_request.result == i2cTransferDone;
+}
+
+// Si7021 datasheet: T = 175.72 * code / 65536 - 46.85
+int32_t SI7021_convert_to_millidegrees(const SI7021_sample_t* sample){
+  return (int32_t)(((uint64_t)175720 * sample->temp_code) >> 16) - 46850;
+}
+
+// Si7021 datasheet: RH = 125 * code / 65536 - 6, can be a little outside 0 - 100
+uint16_t SI7021_convert_to_humidity_e2(const SI7021_sample_t* sample){
+  int32_t rh_e2 = (int32_t)(((uint32_t)12500 * sample->rh_code) >> 16) - 600;
+  if (rh_e2 < 0){
+      rh_e2 = 0;
+  }
+  else if (rh_e2 > 10000){
+      rh_e2 = 10000;
+  }
+  return (uint16_t)rh_e2;
 }
 
 #endif
@@ -14,19 +14,79 @@
 #define SRC_I2C_H_
 
 #include <stdint.h>
+#include <stdbool.h>
 
 #include "ble_device_type.h" // to determine type of device
 
 #if DEVICE_IS_BLE_SERVER == 1 // BLE Server
 
+// 1: the VEML6030 INT line asks for a read when the light leaves a band
+// around the last reading, 0: read every AMBIENT_LIGHT_PERIOD_MS
+#ifndef VEML6030_THRESHOLD_INT
+#define VEML6030_THRESHOLD_INT 1
+#endif
+
+// data of EVENT_I2C_TRANSFER, which request completed
+typedef enum {
+  I2C_TRANSFER_VEML6030_ALS = 0,
+  I2C_TRANSFER_SI7021_MEASURE,  // measure command written, or failed
+  I2C_TRANSFER_SI7021_READ,     // humidity and temperature read, or failed
+  NUM_I2C_TRANSFER_IDS
+} i2c_transfer_id;
+
+// one ALS reading and the VEML6030 range (gain and integration time) it was
+// taken with, the counts mean nothing without it
+typedef struct {
+  uint16_t counts;
+  uint8_t range;
+} VEML6030_sample_t;
+
+// one Si7021 measurement, raw codes of the humidity and of the temperature
+// taken along with it
+typedef struct {
+  uint16_t rh_code;
+  uint16_t temp_code;
+} SI7021_sample_t;
+
 // for configuring I2C
 void initialize_I2C();
 
 // Ambient Light Sensor
 void VEML6030_initialize();
+// threshold mode, clears the interrupt status before the ALS read
 void VEML6030_start_read_ambient_light_level();
-float VEML6030_convert_to_lux(uint16_t adc_val);
-float VEML6030_read_measured_ambient_light();
+// lux in 1/10000 lux, exact for every range
+uint32_t VEML6030_convert_to_lux_e4(const VEML6030_sample_t* sample);
+float VEML6030_convert_to_lux(const VEML6030_sample_t* sample);
+// takes the reading of the last read and adjusts the range for the next one,
+// in threshold mode also re-arms the thresholds around it.
+// False if the reading is not usable, the first one after a range change.
+bool VEML6030_read_measured_ambient_light(VEML6030_sample_t* sample);
+// range changes and saturated readings since reset
+uint32_t VEML6030_range_changes();
+uint32_t VEML6030_saturated_reads();
+
+// Si7021 maximums: power-up time, and a 12 bit humidity conversion plus
+// the 14 bit temperature conversion that follows it
+#define SI7021_POWER_UP_US    80000
+#define SI7021_CONVERSION_US  (12000 + 10800)
+
+// Temperature and Humidity Sensor, no hold master mode. Each step returns
+// right away, EVENT_I2C_TRANSFER tells when the bus part is done.
+void SI7021_initialize();
+// humidity measure command, the temperature is measured after it.
+// EVENT_I2C_TRANSFER with data I2C_TRANSFER_SI7021_MEASURE. Safe from an ISR.
+void SI7021_start_measurement();
+// false if the sensor did not take the command
+bool SI7021_measurement_started();
+// after SI7021_CONVERSION_US: reads the humidity, then the temperature of
+// the same measurement, EVENT_I2C_TRANSFER with I2C_TRANSFER_SI7021_READ
+void SI7021_start_read();
+// false if either read failed
+bool SI7021_read_measurement(SI7021_sample_t* sample);
+// 1/1000 degree C, and 1/100 %RH clipped to 0 - 100 %
+int32_t SI7021_convert_to_millidegrees(const SI7021_sample_t* sample);
+uint16_t SI7021_convert_to_humidity_e2(const SI7021_sample_t* sample);
 
 #endif
 
@@ -0,0 +1,425 @@
+/***********************************************************************
+ * @file      i2c_queue.c
+ * @brief     Interrupt driven I2C0 transaction queue
+ *
+ * @author    Hyounjun Chang, hyounjun.chang@colorado.edu
+ * @date      Oct 16, 2026
+ *
+ * @resources EFR32xG13 Reference Manual, I2C chapter
+ *            emlib I2C_TransferInit() / I2C_Transfer()
+ *            NXP UM10204 I2C-bus specification, 3.1.16 Bus clear
+ *
+ * Drivers submit requests, each with its own sequence and buffers, and get
+ * a callback from I2C0_IRQHandler() when it is over. One request is on the
+ * wire at a time, the rest wait in a FIFO per priority. The first submit to
+ * an idle queue takes the EM1 requirement I2C needs and the interrupt that
+ * empties the queue gives it back, so the bus costs no more than a single
+ * transfer did however many devices share it.
+ *
+ * A failed transfer goes on a retry list instead of back to its driver and
+ * is queued again after a backoff, other requests keep the bus meanwhile.
+ * NACKs are retried as they are. A bus error, lost arbitration or a
+ * transfer that never interrupts (a slave holding SDA low) may have left
+ * the bus in the middle of a byte: nothing more goes on the wire until the
+ * main loop has run the bus recovery of the driver that owns the pins.
+ *
+ */
+#include "i2c_queue.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include <em_core.h>
+#include <em_i2c.h>
+#include "sl_power_manager.h"
+#include "app.h"
+#include "irq.h"
+#include "soft_timer.h"
+
+// Include logging for this file
+#define INCLUDE_LOG_DEBUG 1
+#include "src/log.h"
+
+#define I2C_QUEUE_MAX_DEVICES 4
+
+static i2c_request_t* queue_head[NUM_I2C_PRIORITIES];
+static i2c_request_t* queue_tail[NUM_I2C_PRIORITIES];
+static i2c_request_t* active = NULL;  // on the wire
+static uint32_t active_started = 0;   // letimerTicks() it went on the wire
+static i2c_request_t* retry_list = NULL;
+static bool bus_fault = false;        // the bus needs recovery before the next transfer
+static uint32_t pending = 0;
+static uint32_t high_water = 0;
+static uint32_t bus_recoveries = 0;
+static i2c_bus_recover_t bus_recover = NULL;
+
+static soft_timer_t timeout_timer;
+static soft_timer_t retry_timer;
+
+static i2c_device_stats_t device_stats[I2C_QUEUE_MAX_DEVICES];
+static uint32_t num_devices = 0;
+
+// I2C needs the HF clock, stay in EM1 while a transfer is on the wire
+static void i2c_queue_hold_em1(){
+  if (LOWEST_ENERGY_MODE == 2){
+     sl_power_manager_remove_em_requirement(SL_POWER_MANAGER_EM2);
+     sl_power_manager_add_em_requirement(SL_POWER_MANAGER_EM1);
+  }
+  if (LOWEST_ENERGY_MODE == 3){
+     sl_power_manager_add_em_requirement(SL_POWER_MANAGER_EM1);
+  }
+}
+
+static void i2c_queue_release_em1(){
+  if (LOWEST_ENERGY_MODE == 2){
+     sl_power_manager_remove_em_requirement(SL_POWER_MANAGER_EM1);
+     sl_power_manager_add_em_requirement(SL_POWER_MANAGER_EM2);
+  }
+  if (LOWEST_ENERGY_MODE == 3){
+     sl_power_manager_remove_em_requirement(SL_POWER_MANAGER_EM1);
+  }
+}
+
+static i2c_device_stats_t* i2c_device_stats_for(uint8_t addr){
+  for (uint32_t i = 0; i < num_devices; i++){
+      if (device_stats[i].addr == addr){
+          return &device_stats[i];
+      }
+  }
+  if (num_devices == I2C_QUEUE_MAX_DEVICES){
+      return NULL;
+  }
+  device_stats[num_devices] = (i2c_device_stats_t){ .addr = addr };
+  return &device_stats[num_devices++];
+}
+
+static void i2c_queue_push(i2c_request_t* request){
+  i2c_priority_t p = request->priority;
+
+  if (p >= NUM_I2C_PRIORITIES){
+      p = I2C_PRIORITY_LOW;
+  }
+  request->next = NULL;
+  if (queue_tail[p]){
+      queue_tail[p]->next = request;
+  }
+  else{
+      queue_head[p] = request;
+  }
+  queue_tail[p] = request;
+}
+
+static i2c_request_t* i2c_queue_pop(){
+  for (uint32_t p = 0; p < NUM_I2C_PRIORITIES; p++){
+      i2c_request_t* request = queue_head[p];
+      if (request){
+          queue_head[p] = request->next;
+          if (!queue_head[p]){
+              queue_tail[p] = NULL;
+          }
+          request->next = NULL;
+          return request;
+      }
+  }
+  return NULL;
+}
+
+// the retry timer goes off at the earliest retry, or right away when the
+// bus needs recovery
+static void i2c_queue_arm_retry(){
+  i2c_request_t* request = retry_list;
+  uint32_t now = letimerTicks();
+  uint32_t earliest;
+
+  if (!request && !bus_fault){
+      soft_timer_stop(&retry_timer);
+      return;
+  }
+  earliest = request ? request->retry_at : now;
+  for (; request; request = request->next){
+      if ((int32_t)(request->retry_at - earliest) < 0){
+          earliest = request->retry_at;
+      }
+  }
+  if (bus_fault || (int32_t)(earliest - now) < 0){
+      earliest = now;
+  }
+  soft_timer_start_at(&retry_timer, SOFT_TIMER_I2C_RETRY, earliest, 0);
+}
+
+// the attempt is over and the bus handed on. A failure goes on the retry
+// list while it has retries left, otherwise the driver gets the result.
+static void i2c_queue_finish(i2c_request_t* request, I2C_TransferReturn_TypeDef status){
+  CORE_DECLARE_IRQ_STATE;
+  i2c_device_stats_t* stats;
+
+  CORE_ENTER_CRITICAL();
+  stats = i2c_device_stats_for(request->seq.addr >> 1);
+  if (stats){
+      stats->transfers++;
+      if (status == i2cTransferNack){
+          stats->nacks++;
+      }
+      else if (status < 0 && status != i2cTransferUsageFault){
+          stats->bus_errors++;
+      }
+  }
+  // a usage fault is the request itself, another attempt would not help
+  if (status < 0 && status != i2cTransferUsageFault &&
+      request->attempts < I2C_REQUEST_MAX_RETRIES){
+      uint32_t backoff_us = (uint32_t)I2C_RETRY_BACKOFF_US << request->attempts;
+      request->attempts++;
+      if (stats){
+          stats->retries++;
+      }
+      request->retry_at = letimerTicks() + soft_timer_us_to_ticks(backoff_us);
+      request->next = retry_list;
+      retry_list = request;
+      i2c_queue_arm_retry();
+      CORE_EXIT_CRITICAL();
+      LOG_WARN("I2C transfer to 0x%x failed: %d, retry %u in %lu us\r\n",
+               request->seq.addr >> 1, status, request->attempts, (unsigned long)backoff_us);
+      return;
+  }
+  if (status < 0 && stats){
+      stats->failures++;
+  }
+  request->result = status;
+  request->busy = false;
+  pending--;
+  CORE_EXIT_CRITICAL();
+
+  if (status < 0){
+      LOG_ERROR("I2C transfer to 0x%x failed: %d\r\n", request->seq.addr >> 1, status);
+  }
+  if (request->done){
+      request->done(request);
+  }
+}
+
+static void i2c_queue_kick();
+
+// puts the next request on the wire, with EM1 held by the caller. Gives EM1
+// back when there is nothing to start or the bus needs recovery first, and
+// then arms the retry timer, which recovers the bus even when no request is
+// left to retry. Requests refused by emlib are finished once the bus is
+// settled.
+static void i2c_queue_start_next(){
+  i2c_request_t* refused = NULL;
+  I2C_TransferReturn_TypeDef refused_status = i2cTransferDone;
+
+  while (!bus_fault && (active = i2c_queue_pop()) != NULL){
+      I2C_TransferReturn_TypeDef status = I2C_TransferInit(I2C0, &active->seq);
+      if (status == i2cTransferInProgress){
+          active_started = letimerTicks();
+          soft_timer_start_us(&timeout_timer, SOFT_TIMER_I2C_TIMEOUT, I2C_TRANSFER_TIMEOUT_US, 0);
+          break;
+      }
+      LOG_ERROR("I2C transfer to 0x%x not started: %d\r\n", active->seq.addr >> 1, status);
+      refused = active;
+      refused_status = status;
+      active = NULL;
+      if (status != i2cTransferUsageFault){
+          bus_fault = true;
+      }
+      break;
+  }
+  if (!active){
+      NVIC_DisableIRQ(I2C0_IRQn);
+      i2c_queue_release_em1();
+      if (bus_fault){
+          i2c_queue_arm_retry();
+      }
+  }
+  // its callback may submit, the bus is idle again by now
+  if (refused){
+      i2c_queue_finish(refused, refused_status);
+      i2c_queue_kick();
+  }
+}
+
+// starts the bus if it is idle and usable
+static void i2c_queue_kick(){
+  if (active || bus_fault){
+      return;
+  }
+  i2c_queue_hold_em1();
+  NVIC_ClearPendingIRQ(I2C0_IRQn);
+  NVIC_EnableIRQ(I2C0_IRQn);
+  i2c_queue_start_next();
+}
+
+void initI2CQueue(i2c_bus_recover_t recover){
+  for (uint32_t p = 0; p < NUM_I2C_PRIORITIES; p++){
+      queue_head[p] = NULL;
+      queue_tail[p] = NULL;
+  }
+  active = NULL;
+  retry_list = NULL;
+  bus_fault = false;
+  pending = 0;
+  high_water = 0;
+  bus_recoveries = 0;
+  bus_recover = recover;
+  num_devices = 0;
+  NVIC_ClearPendingIRQ(I2C0_IRQn);
+}
+
+void i2c_request_write(i2c_request_t* request, uint8_t addr, uint16_t write_len){
+  request->seq.addr = addr << 1; // shift device address left
+  request->seq.flags = I2C_FLAG_WRITE;
+  request->seq.buf[0].data = request->write_data;
+  request->seq.buf[0].len = write_len;
+}
+
+void i2c_request_write_read(i2c_request_t* request, uint8_t addr, uint16_t write_len,
+                            uint16_t read_len){
+  request->seq.addr = addr << 1;
+  request->seq.flags = I2C_FLAG_WRITE_READ;
+  request->seq.buf[0].data = request->write_data;
+  request->seq.buf[0].len = write_len;
+  request->seq.buf[1].data = request->read_data;
+  request->seq.buf[1].len = read_len;
+}
+
+void i2c_request_read(i2c_request_t* request, uint8_t addr, uint16_t read_len){
+  request->seq.addr = addr << 1;
+  request->seq.flags = I2C_FLAG_READ;
+  request->seq.buf[0].data = request->read_data;
+  request->seq.buf[0].len = read_len;
+}
+
+bool i2c_queue_submit(i2c_request_t* request){
+  CORE_DECLARE_IRQ_STATE;
+
+  CORE_ENTER_CRITICAL();
+  if (request->busy){
+      CORE_EXIT_CRITICAL();
+      return false;
+  }
+  request->busy = true;
+  request->result = i2cTransferInProgress;
+  request->attempts = 0;
+  i2c_queue_push(request);
+  if (++pending > high_water){
+      high_water = pending;
+  }
+  i2c_queue_kick();
+  CORE_EXIT_CRITICAL();
+  return true;
+}
+
+uint32_t i2c_queue_pending(){
+  return pending;
+}
+
+uint32_t i2c_queue_high_water(){
+  return high_water;
+}
+
+const i2c_device_stats_t* i2c_queue_device_stats(uint8_t addr){
+  for (uint32_t i = 0; i < num_devices; i++){
+      if (device_stats[i].addr == addr){
+          return &device_stats[i];
+      }
+  }
+  return NULL;
+}
+
+uint32_t i2c_queue_bus_recoveries(){
+  return bus_recoveries;
+}
+
+void i2c_queue_irq(){
+  I2C_TransferReturn_TypeDef status;
+  i2c_request_t* request = active;
+
+  // nothing on the wire, a late interrupt from the last transfer
+  if (!request){
+      return;
+  }
+  status = I2C_Transfer(I2C0);
+  if (status == i2cTransferInProgress){
+      return;
+  }
+  soft_timer_stop(&timeout_timer);
+  if (status < 0 && status != i2cTransferNack && status != i2cTransferUsageFault){
+      bus_fault = true;
+  }
+
+  // the next one goes out before the callback, it may submit again
+  active = NULL;
+  i2c_queue_start_next();
+  i2c_queue_finish(request, status);
+}
+
+// no interrupt for I2C_TRANSFER_TIMEOUT_US: the transfer is aborted and
+// counts as a bus error
+static void i2c_queue_timeout(){
+  CORE_DECLARE_IRQ_STATE;
+  i2c_request_t* request;
+
+  CORE_ENTER_CRITICAL();
+  request = active;
+  // a late expiry, that transfer is over and maybe another one started
+  if (!request || (int32_t)(letimerTicks() - active_started) <
+                  (int32_t)soft_timer_us_to_ticks(I2C_TRANSFER_TIMEOUT_US)){
+      CORE_EXIT_CRITICAL();
+      return;
+  }
+  I2C_Reset(I2C0);
+  bus_fault = true;
+  active = NULL;
+  LOG_ERROR("I2C transfer to 0x%x timed out\r\n", request->seq.addr >> 1);
+  // inside the critical section, so the done callback and the scheduler
+  // event it sets run as they do from I2C0_IRQHandler()
+  i2c_queue_finish(request, i2cTransferBusErr);
+  i2c_queue_start_next();
+  CORE_EXIT_CRITICAL();
+}
+
+// recovers the bus if needed, then queues the requests whose backoff is over
+static void i2c_queue_retry(){
+  CORE_DECLARE_IRQ_STATE;
+  i2c_request_t** link;
+  uint32_t now;
+
+  // nothing is on the wire while bus_fault is set, no interrupt changes it
+  if (bus_fault){
+      if (bus_recover){
+          bus_recover();
+      }
+      bus_recoveries++;
+      bus_fault = false;
+  }
+
+  CORE_ENTER_CRITICAL();
+  now = letimerTicks();
+  link = &retry_list;
+  while (*link){
+      i2c_request_t* request = *link;
+      if ((int32_t)(request->retry_at - now) <= 0){
+          *link = request->next;
+          i2c_queue_push(request);
+      }
+      else{
+          link = &request->next;
+      }
+  }
+  i2c_queue_arm_retry();
+  i2c_queue_kick();
+  CORE_EXIT_CRITICAL();
+}
+
+void i2c_queue_update(scheduler_event_entry* event){
+  if (event->event != EVENT_LETIMER0_COMP1){
+      return;
+  }
+  if (event->data == SOFT_TIMER_I2C_TIMEOUT){
+      i2c_queue_timeout();
+  }
+  else if (event->data == SOFT_TIMER_I2C_RETRY){
+      i2c_queue_retry();
+  }
+}
@@ -0,0 +1,106 @@
+/***********************************************************************
+ * @file      i2c_queue.h
+ * @brief     Interrupt driven I2C0 transaction queue
+ *
+ * @author    Hyounjun Chang, hyounjun.chang@colorado.edu
+ * @date      Oct 16, 2026
+ *
+ * @resources EFR32xG13 Reference Manual, I2C chapter
+ *            NXP UM10204 I2C-bus specification, 3.1.16 Bus clear
+ *
+ */
+#ifndef SRC_I2C_QUEUE_H_
+#define SRC_I2C_QUEUE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <em_i2c.h>
+#include "scheduler.h"
+
+// largest register write and read of the sensors on the bus
+#define I2C_REQUEST_MAX_WRITE   4
+#define I2C_REQUEST_MAX_READ    8
+
+// a failed transfer is tried again up to I2C_REQUEST_MAX_RETRIES times,
+// I2C_RETRY_BACKOFF_US after the first failure and twice as long after each
+// one after it. Other requests use the bus in the meantime.
+#define I2C_REQUEST_MAX_RETRIES   3
+#define I2C_RETRY_BACKOFF_US      1000
+// a transfer without an interrupt for this long is aborted as a bus error
+#define I2C_TRANSFER_TIMEOUT_US   10000
+
+// pending requests go out highest priority first, FIFO within a priority.
+// The transfer on the wire is never interrupted.
+typedef enum {
+  I2C_PRIORITY_HIGH = 0,
+  I2C_PRIORITY_NORMAL,
+  I2C_PRIORITY_LOW,
+  NUM_I2C_PRIORITIES
+} i2c_priority_t;
+
+struct i2c_request;
+
+// called from I2C0_IRQHandler() once the transfer is over, result is in the
+// request. Keep it short, e.g. queue a scheduler event.
+typedef void (*i2c_request_done_t)(struct i2c_request* request);
+
+// owned by the caller, usually a static in the sensor driver. The buffers
+// belong to the request, so requests to different devices never share one.
+typedef struct i2c_request {
+  struct i2c_request* next;
+  I2C_TransferSeq_TypeDef seq;
+  uint8_t write_data[I2C_REQUEST_MAX_WRITE];
+  uint8_t read_data[I2C_REQUEST_MAX_READ];
+  i2c_priority_t priority;
+  i2c_request_done_t done;
+  I2C_TransferReturn_TypeDef result;
+  bool busy;          // queued, on the wire or waiting for a retry
+  uint8_t attempts;   // failed attempts so far
+  uint32_t retry_at;  // letimerTicks() of the next attempt
+} i2c_request_t;
+
+// per 7-bit address, since boot
+typedef struct {
+  uint8_t addr;
+  uint32_t transfers;   // attempts that completed, retries included
+  uint32_t nacks;
+  uint32_t bus_errors;  // bus error, arbitration lost or timeout
+  uint32_t retries;
+  uint32_t failures;    // requests completed with an error after the last retry
+} i2c_device_stats_t;
+
+// after a bus error, arbitration loss or timeout: frees a stuck bus and
+// sets up I2C0 again. Main loop context.
+typedef void (*i2c_bus_recover_t)();
+
+void initI2CQueue(i2c_bus_recover_t bus_recover);
+
+// point the sequence at the request's own buffers, addr is the 7-bit address.
+// The caller fills write_data before submitting.
+void i2c_request_write(i2c_request_t* request, uint8_t addr, uint16_t write_len);
+void i2c_request_write_read(i2c_request_t* request, uint8_t addr, uint16_t write_len,
+                            uint16_t read_len);
+void i2c_request_read(i2c_request_t* request, uint8_t addr, uint16_t read_len);
+
+// queues the request, starts it right away if the bus is idle. False if it
+// is still busy from an earlier submit. Safe to call from an ISR.
+bool i2c_queue_submit(i2c_request_t* request);
+
+// requests queued, on the wire or waiting for a retry, and the most there
+// have been
+uint32_t i2c_queue_pending();
+uint32_t i2c_queue_high_water();
+
+// NULL for an address never used
+const i2c_device_stats_t* i2c_queue_device_stats(uint8_t addr);
+uint32_t i2c_queue_bus_recoveries();
+
+// retries, timeouts and bus recovery, for the scheduler events of the
+// I2C soft timers
+void i2c_queue_update(scheduler_event_entry* event);
+
+// I2C0 interrupt: advances the transfer, completes it and starts the next
+void i2c_queue_irq();
+
+#endif /* SRC_I2C_QUEUE_H_ */
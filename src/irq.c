@@ -20,6 +20,7 @@
 #include "em_letimer.h"
 #include <em_core.h>
 #include "timer.h"
+#include "soft_timer.h"
 
 // for power mode
 #include "app.h"
@@ -33,10 +34,12 @@
 // for I2C typedefs
 #include <em_i2c.h>
 #include "i2c.h"
+#include "i2c_queue.h"
 
 #include "ble.h"
 
 #include "src/em_adc.h"
+#include "em_ldma.h"
 #include "adc.h"
 
 // Include logging for this file
@@ -69,68 +72,100 @@ void LETIMER0_IRQHandler(){
 
   // step 3: your handling code
   if (interrupt_flags & LETIMER_IEN_UF){
-      set_scheduler_event(EVENT_LETIMER0_UF);
       // update ms_time on LETIMER_UF (underflow) interrupt
+      // before queuing, so the event timestamp includes this period
       CORE_ENTER_CRITICAL();
       letimer_uf_count++;
       CORE_EXIT_CRITICAL();
+      set_scheduler_event(EVENT_LETIMER0_UF);
 
+#if !TIMER_TICKLESS
+#if SOUND_SAMPLING_LDMA
+      // capture one window of sound samples every 1 sec
+      sound_capture_start();
+#else
       // Start next ADC conversion every 1 sec
       ADC_IntEnable(ADC0, ADC_IEN_SINGLE);
       ADC_Start(ADC0, adcStartSingle);
+#endif
 
+      // measure temperature and humidity every 30 sec
+      if (letimer_uf_count % (TEMPERATURE_PERIOD_MS / 1000) == 0){
+          SI7021_start_measurement();
+      }
+
+#if !VEML6030_THRESHOLD_INT
       // read ambient_light every 5 sec
       if (letimer_uf_count % 5 == 0){
           VEML6030_start_read_ambient_light_level();
       }
+#endif
+#endif
   }
   if (interrupt_flags & LETIMER_IEN_COMP1){
      set_timerwait_done(); // for timerWaitUs_polled()
-     set_scheduler_event(EVENT_LETIMER0_COMP1);
-     LETIMER_IntDisable(LETIMER0, LETIMER_IEN_COMP1);
+     // expired software timers queue EVENT_LETIMER0_COMP1 with their id,
+     // COMP1 is re-armed for the next deadline or switched off
+     soft_timer_irq();
+  }
+}
+
+// monotonic LETIMER0 tick count, underflows so far and the counter read
+// together. An underflow that is not counted yet shows in the UF flag; the
+// counter is then read again, after the flag, so it is surely past the
+// reload and goes with one more underflow. Tickless, the UF interrupt is
+// mostly off and the flag is counted here instead, which needs a call at
+// least once per LETIMER0 period: the software timers make sure of it.
+uint64_t letimerTicks64(){
+  CORE_DECLARE_IRQ_STATE;
+  uint32_t top = get_LETIMER_TOP_value();
+  uint32_t uf_count;
+  uint32_t curr_cnt;
+
+  CORE_ENTER_CRITICAL();
+  curr_cnt = LETIMER_CounterGet(LETIMER0);
+  uf_count = letimer_uf_count;
+  if (LETIMER_IntGet(LETIMER0) & LETIMER_IF_UF){
+      curr_cnt = LETIMER_CounterGet(LETIMER0);
+      uf_count++;
+#if TIMER_TICKLESS
+      // UF interrupt off, nobody else counts this underflow. With the
+      // interrupt on the ISR counts it when it runs.
+      if (!(LETIMER_IntGetEnabled(LETIMER0) & LETIMER_IF_UF)){
+          LETIMER_IntClear(LETIMER0, LETIMER_IF_UF);
+          letimer_uf_count = uf_count;
+      }
+#endif
   }
+  CORE_EXIT_CRITICAL();
+
+  // CNT starts at 0 and the first tick underflows it to TOP, so one period
+  // is TOP + 1 ticks and tick 0 is init_LETIMER0()
+  return (uint64_t)uf_count * (top + 1) - curr_cnt;
+}
+
+// low 32 bits, what the software timers are kept in. Wraps after 2^32
+// ticks, compare with signed differences.
+uint32_t letimerTicks(){
+  return (uint32_t)letimerTicks64();
 }
 
-uint32_t letimerMilliseconds(){
-  uint32_t time_elapsed = letimer_uf_count * get_LETIMER_UF_duration_ms();
-  uint32_t curr_cnt = LETIMER_CounterGet(LETIMER0);
-  // add time since last LETIMER0_UF
-  time_elapsed += (get_LETIMER_TOP_value() - curr_cnt) * (uint32_t)1000 / get_LETIMER_freq();
+uint64_t letimerMicroseconds(){
+  return letimerTicksToUs(letimerTicks64());
+}
 
-  return time_elapsed;
+uint64_t letimerMilliseconds(){
+  return letimerTicksToMs(letimerTicks64());
 }
 
 // From Lecture 8
 void I2C0_IRQHandler(void) {
   /*
    * see em_i2.c
-   * has access to global variables (transferSequence, cmd_data, read_data)
-   * which were sent to I2C_TransferInit()
+   * the request on the wire carries its own sequence and buffers, the
+   * queue completes it, calls back its driver and starts the next one
    */
-
-  I2C_TransferReturn_TypeDef transferStatus;
-  transferStatus = I2C_Transfer(I2C0);
-  if (transferStatus == i2cTransferDone) {
-      CORE_DECLARE_IRQ_STATE;
-      CORE_ENTER_CRITICAL();
-      set_scheduler_event(EVENT_I2C_TRANSFER);
-      CORE_EXIT_CRITICAL();
-
-      // Disable IRQ
-      NVIC_DisableIRQ(I2C0_IRQn);
-
-      //restore lowest EM mode, since we are done with I2C_Transfer
-      if (LOWEST_ENERGY_MODE == 2){
-         sl_power_manager_remove_em_requirement(SL_POWER_MANAGER_EM1);
-         sl_power_manager_add_em_requirement(SL_POWER_MANAGER_EM2);
-      }
-      if (LOWEST_ENERGY_MODE == 3){
-         sl_power_manager_remove_em_requirement(SL_POWER_MANAGER_EM1);
-      }
-  }
-  if (transferStatus < 0) {
-      LOG_ERROR("%d\r\n", transferStatus);
-  }
+  i2c_queue_irq();
 } // I2C0_IRQHandler()
 
 void GPIO_EVEN_IRQHandler(){
@@ -142,15 +177,19 @@ void GPIO_EVEN_IRQHandler(){
 
   // step 3: your handling code
   // set event
-  CORE_DECLARE_IRQ_STATE;
-  CORE_ENTER_CRITICAL();
-  set_scheduler_event(EVENT_PB);
-  CORE_EXIT_CRITICAL();
+#if DEVICE_IS_BLE_SERVER && VEML6030_THRESHOLD_INT
+  if (interrupt_flags & (1 << GPIO_EXTINT_VEML6030)){
+      set_scheduler_event(EVENT_ALS_INTERRUPT);
+      interrupt_flags &= ~(1 << GPIO_EXTINT_VEML6030);
+  }
+#endif
+  if (interrupt_flags){
+      set_scheduler_event(EVENT_PB);
+  }
 }
 
 void ADC0_IRQHandler(void)
 {
-  CORE_DECLARE_IRQ_STATE;
   // step 1: determine pending interrupts in peripheral
   uint32_t interrupt_flags = ADC_IntGetEnabled(ADC0);
 
@@ -159,14 +198,38 @@ void ADC0_IRQHandler(void)
   ADC_IntClear(ADC0, interrupt_flags);
 
   // step 3: your handling code
-  // update value in buffer (doing this outside IRQ creates resource problems)
+  // sample travels with the event, so a second conversion before the
+  // stack runs can't overwrite the first
   if (interrupt_flags & ADC_IEN_SINGLE){
-    CORE_ENTER_CRITICAL();
-    uint32_t* sound_ptr =  getSoundLevelptr();
-    *sound_ptr = ADC_DataSingleGet(ADC0); // ADC scan 12-bit resolution
-    *sound_ptr = (*sound_ptr) * 2500 / 4096; // ADC module in Blue Gecko handles 2.5V
-    set_scheduler_event(EVENT_ADC_CONVERSION);
-    CORE_EXIT_CRITICAL();
+    uint32_t sound_mV = ADC_DataSingleGet(ADC0); // ADC scan 12-bit resolution
+    sound_mV = sound_mV * 2500 / 4096; // ADC module in Blue Gecko handles 2.5V
+    set_scheduler_event_data(EVENT_ADC_CONVERSION, sound_mV);
   }
 }
 
+#if SOUND_SAMPLING_LDMA
+void LDMA_IRQHandler(void)
+{
+  // step 1: determine pending interrupts in peripheral
+  uint32_t interrupt_flags = LDMA_IntGetEnabled();
+
+  // step 2: clear pending interrupts in peripheral
+  LDMA_IntClear(interrupt_flags);
+
+  // step 3: your handling code
+  // one full ping-pong buffer, the samples stay in place for the main loop
+  if (interrupt_flags & (1 << SOUND_LDMA_CHANNEL)){
+      uint32_t n = sound_capture_buffer_done();
+#if SOUND_IRQ_PER_WINDOW
+      // the window's only interrupt, the buffers before the last are full too
+      for (uint32_t i = 0; i < n; i++){
+          set_scheduler_event_data(EVENT_SOUND_BUFFER, i);
+      }
+#endif
+      set_scheduler_event_data(EVENT_SOUND_BUFFER, n);
+  }
+  if (interrupt_flags & LDMA_IF_ERROR){
+      LOG_ERROR("LDMA transfer error\r\n");
+  }
+}
+#endif
@@ -19,6 +19,12 @@
 
 void LETIMER0_IRQHandler();
 void I2C0_IRQHandler();
+void LDMA_IRQHandler();
 
-uint32_t letimerMilliseconds();
+// time since init_LETIMER0(), monotonic and safe from any context
+uint64_t letimerTicks64();
+uint64_t letimerMicroseconds();
+uint64_t letimerMilliseconds();
+// low 32 bits of letimerTicks64(), for the software timers
+uint32_t letimerTicks();
 #endif
@@ -51,7 +51,7 @@ enum display_row {
 	DISPLAY_ROW_AMBLIGHTVALUE, // 4
 	DISPLAY_ROW_SOUNDLEVEL,    // 5
   DISPLAY_ROW_OCCUPIED,      // 6
-  DISPLAY_ROW_7,             // 7
+  DISPLAY_ROW_HUMIDITY,      // 7
 	DISPLAY_ROW_PASSKEY,       // 8
 	DISPLAY_ROW_ACTION,        // 9
   DISPLAY_ROW_ACTION2,       // 10
@@ -21,6 +21,9 @@
  *
  * Editor:  Feb 13, 2025, Hyounjun Chang
  * Change: updated loggerGetTimestamp()
+ *
+ * Editor:  Oct 16, 2026, Hyounjun Chang
+ * Change: loggerGetTimestamp() in microseconds from the 64-bit LETIMER0 timebase
 */
 
 
@@ -35,10 +38,10 @@
 
 /**
  * @return a timestamp value for the logging functions, typically based on a
- * free running timer.
+ * free running timer. Microseconds since boot.
  * This value will be printed at the beginning of each log message.
  */
-uint32_t loggerGetTimestamp()
+uint64_t loggerGetTimestamp()
 {
 
      // Students: You will eventually develop this function called letimerMilliseconds()
@@ -46,7 +49,8 @@ uint32_t loggerGetTimestamp()
      //           assignments that require logging (a fancy printf).
      //           Put the letimerMilliseconds() function in your irq.c/.h files.
 
-     return letimerMilliseconds();
+     // monotonic and 64-bit, lines never go back in time or wrap
+     return letimerMicroseconds();
 	   
 } // loggerGetTimestamp
 
@@ -51,9 +51,15 @@
 // File by file logging control
 #if INCLUDE_LOG_DEBUG
 
+// timestamp as seconds.microseconds since boot, read once per line
 #define LOG_DO(message,level, ...) \
-  app_log( "%5"PRIu32":%s:%s: " message "\n", loggerGetTimestamp(), level, __func__, ##__VA_ARGS__ )
-uint32_t loggerGetTimestamp (void);
+  do { \
+    uint64_t log_timestamp_us = loggerGetTimestamp(); \
+    app_log( "%5"PRIu32".%06"PRIu32":%s:%s: " message "\n", \
+             (uint32_t)(log_timestamp_us / 1000000), (uint32_t)(log_timestamp_us % 1000000), \
+             level, __func__, ##__VA_ARGS__ ); \
+  } while (0)
+uint64_t loggerGetTimestamp (void);
 void     printSLErrorString (sl_status_t status);
 
 #else
@@ -0,0 +1,177 @@
+/***********************************************************************
+ * @file      occupancy.c
+ * @brief     Occupancy inference from the light and sound streams
+ *
+ * @author    Hyounjun Chang, hyounjun.chang@colorado.edu
+ * @date      Oct 16, 2026
+ *
+ * @resources CMSIS-DSP Bayesian estimators
+ * https://arm-software.github.io/CMSIS-DSP/latest/group__groupBayes.html
+ *
+ * Every OCCUPANCY_PERIOD_WINDOWS sound windows the band levels, the A-weighted
+ * Leq and the VEML6030 readings of the period are reduced to a small feature
+ * vector and scored with arm_gaussian_naive_bayes_predict_f32 against the
+ * per-class means and variances in occupancy_model.c. The model is generated
+ * by sim/train_occupancy.c from labelled sim traces (make -C sim train).
+ *
+ * A single period can look empty while people sit in silence, so the
+ * decision averages the last OCCUPANCY_SMOOTHING predictions and only
+ * flips past the on/off probabilities. PB0 still has the last word, a press
+ * holds the user's choice for OCCUPANCY_MANUAL_HOLD_PERIODS periods.
+ *
+ */
+#include "occupancy.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+
+#include "arm_math.h"
+
+// occupancy_model.c, generated
+extern const arm_gaussian_naive_bayes_instance_f32 occupancy_model;
+
+// sums of the period being collected
+static uint32_t period_windows = 0;
+static uint32_t period_speech_windows = 0;
+static int32_t period_speech_dB10 = 0;
+static int32_t period_leq_dB10 = 0;
+static float period_log_lux = 0.0f;
+static uint32_t period_lux_readings = 0;
+static float last_log_lux = 0.0f;
+
+static float features[OCCUPANCY_FEATURES];
+static uint32_t periods = 0;
+
+// decision state
+static float recent_p[OCCUPANCY_SMOOTHING];
+static uint32_t recent_next = 0;
+static bool decided_occupied = false;
+static uint32_t manual_hold = 0;
+
+static int32_t dB10_floor_zero(int16_t dB10){
+  return (dB10 > 0) ? dB10 : 0;
+}
+
+static void occupancy_fill_recent(float p){
+  for (uint32_t i = 0; i < OCCUPANCY_SMOOTHING; i++){
+      recent_p[i] = p;
+  }
+  recent_next = 0;
+}
+
+void initOccupancy(){
+  period_windows = 0;
+  period_speech_windows = 0;
+  period_speech_dB10 = 0;
+  period_leq_dB10 = 0;
+  period_log_lux = 0.0f;
+  period_lux_readings = 0;
+  last_log_lux = 0.0f;
+  memset(features, 0, sizeof(features));
+  periods = 0;
+  decided_occupied = false;
+  manual_hold = 0;
+  occupancy_fill_recent(0.0f);
+}
+
+bool occupancy_add_sound(const sound_level_t* level){
+  int32_t speech_dB10 = dB10_floor_zero(level->features.speech_dB10);
+
+  period_speech_dB10 += speech_dB10;
+  period_leq_dB10 += dB10_floor_zero(level->leq_window_dB10);
+  if (level->features.speech_pct >= 50 && speech_dB10 >= OCCUPANCY_SPEECH_FLOOR_DB10){
+      period_speech_windows++;
+  }
+  period_windows++;
+  if (period_windows < OCCUPANCY_PERIOD_WINDOWS){
+      return false;
+  }
+
+  // the light sensor is read less often, keep the last value through a gap
+  if (period_lux_readings > 0){
+      last_log_lux = period_log_lux / period_lux_readings;
+  }
+  features[OCCUPANCY_FEATURE_SPEECH_DB] = period_speech_dB10 / (10.0f * period_windows);
+  features[OCCUPANCY_FEATURE_SPEECH_ACTIVITY] = (float)period_speech_windows / period_windows;
+  features[OCCUPANCY_FEATURE_LEQ_DB] = period_leq_dB10 / (10.0f * period_windows);
+  features[OCCUPANCY_FEATURE_LOG_LUX] = last_log_lux;
+  periods++;
+
+  period_windows = 0;
+  period_speech_windows = 0;
+  period_speech_dB10 = 0;
+  period_leq_dB10 = 0;
+  period_log_lux = 0.0f;
+  period_lux_readings = 0;
+  return true;
+}
+
+void occupancy_add_lux(float lux){
+  if (lux < 0.0f){
+      lux = 0.0f;
+  }
+  period_log_lux += log10f(lux + 1.0f);
+  period_lux_readings++;
+}
+
+const float* occupancy_features(){
+  return features;
+}
+
+uint32_t occupancy_periods(){
+  return periods;
+}
+
+float occupancy_predict(const float* x){
+  float32_t log_posterior[OCCUPANCY_CLASSES];
+  float32_t scratch[OCCUPANCY_CLASSES];
+
+  (void)arm_gaussian_naive_bayes_predict_f32(&occupancy_model, x, log_posterior, scratch);
+
+  // the outputs are unnormalized log posteriors, two classes normalize to a logistic
+  float32_t margin = log_posterior[OCCUPANCY_AVAILABLE] - log_posterior[OCCUPANCY_OCCUPIED];
+  if (margin > 80.0f){
+      return 0.0f;
+  }
+  if (margin < -80.0f){
+      return 1.0f;
+  }
+  return 1.0f / (1.0f + expf(margin));
+}
+
+bool occupancy_decide(float p_occupied, bool* occupied){
+  float p_mean = 0.0f;
+
+  recent_p[recent_next] = p_occupied;
+  recent_next = (recent_next + 1) % OCCUPANCY_SMOOTHING;
+  if (manual_hold > 0){
+      manual_hold--;
+      return false;
+  }
+
+  for (uint32_t i = 0; i < OCCUPANCY_SMOOTHING; i++){
+      p_mean += recent_p[i];
+  }
+  p_mean /= OCCUPANCY_SMOOTHING;
+
+  if (!decided_occupied && p_mean >= OCCUPANCY_ON_PROBABILITY){
+      decided_occupied = true;
+  }
+  else if (decided_occupied && p_mean <= OCCUPANCY_OFF_PROBABILITY){
+      decided_occupied = false;
+  }
+  else{
+      return false;
+  }
+  *occupied = decided_occupied;
+  return true;
+}
+
+void occupancy_set_manual(bool occupied){
+  decided_occupied = occupied;
+  manual_hold = OCCUPANCY_MANUAL_HOLD_PERIODS;
+  // the user just told us, start averaging from their answer
+  occupancy_fill_recent(occupied ? 1.0f : 0.0f);
+}
@@ -0,0 +1,66 @@
+/***********************************************************************
+ * @file      occupancy.h
+ * @brief     Occupancy inference from the light and sound streams
+ *
+ * @author    Hyounjun Chang, hyounjun.chang@colorado.edu
+ * @date      Oct 16, 2026
+ * @resources CMSIS-DSP Bayesian estimators
+ *
+ */
+#ifndef SRC_OCCUPANCY_H_
+#define SRC_OCCUPANCY_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sound.h"
+
+// 1: the classifier sets the occupied flag, PB0 still overrides it
+#define OCCUPANCY_AUTO                1
+
+// the model is trained on the band levels, the ENVELOPE path has none
+#if !SOUND_SAMPLING_LDMA || !SOUND_SPECTRAL_FEATURES
+#undef OCCUPANCY_AUTO
+#define OCCUPANCY_AUTO                0
+#endif
+
+#define OCCUPANCY_PERIOD_WINDOWS      60   // sound windows per feature vector, about 1 min
+#define OCCUPANCY_SPEECH_FLOOR_DB10   150  // speech band under this is not someone talking
+#define OCCUPANCY_SMOOTHING           3    // predictions averaged, 1 = none
+#define OCCUPANCY_ON_PROBABILITY      0.6f // averaged P(occupied) to mark occupied
+#define OCCUPANCY_OFF_PROBABILITY     0.4f // and to mark available again
+#define OCCUPANCY_MANUAL_HOLD_PERIODS 30   // after a PB0 press the classifier waits this long
+
+typedef enum {
+  OCCUPANCY_AVAILABLE = 0,
+  OCCUPANCY_OCCUPIED,
+  OCCUPANCY_CLASSES,
+} occupancy_class_t;
+
+// feature vector, the order is the order of the model tables
+typedef enum {
+  OCCUPANCY_FEATURE_SPEECH_DB = 0, // mean speech band level, dB
+  OCCUPANCY_FEATURE_SPEECH_ACTIVITY, // share of windows where speech dominates, 0 - 1
+  OCCUPANCY_FEATURE_LEQ_DB,        // mean A-weighted window Leq, dB
+  OCCUPANCY_FEATURE_LOG_LUX,       // log10(lux + 1), mean over the period
+  OCCUPANCY_FEATURES,
+} occupancy_feature_t;
+
+void initOccupancy();
+
+// one sound window, returns true when a feature vector is complete
+bool occupancy_add_sound(const sound_level_t* level);
+// one VEML6030 reading
+void occupancy_add_lux(float lux);
+// feature vector of the last completed period
+const float* occupancy_features();
+// completed periods since boot
+uint32_t occupancy_periods();
+
+// P(occupied) for a feature vector, Gaussian naive Bayes with the flash model
+float occupancy_predict(const float* features);
+// averages P(occupied) with hysteresis, returns true with the new state when it flips
+bool occupancy_decide(float p_occupied, bool* occupied);
+// PB0 press, the user is right and the classifier backs off for a while
+void occupancy_set_manual(bool occupied);
+
+#endif
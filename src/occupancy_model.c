@@ -0,0 +1,37 @@
+/***********************************************************************
+ * @file      occupancy_model.c
+ * @brief     Gaussian naive Bayes occupancy model, kept in flash
+ *
+ * @author    Hyounjun Chang, hyounjun.chang@colorado.edu
+ * @date      Oct 16, 2026
+ *
+ * @resources generated by sim/train_occupancy.c, do not edit
+ *
+ */
+#include "occupancy.h"
+
+#include "arm_math.h"
+
+// per class: speech dB, speech activity, Leq dB, log10(lux + 1)
+static const float32_t occupancy_theta[OCCUPANCY_CLASSES * OCCUPANCY_FEATURES] = {
+  6.88589f, 0.000333535f, 6.01125f, 1.02344f,
+  13.3313f, 0.0505159f, 21.2295f, 3.07521f,
+};
+
+static const float32_t occupancy_sigma[OCCUPANCY_CLASSES * OCCUPANCY_FEATURES] = {
+  0.245107f, 7.04635e-05f, 69.3682f, 1.81329f,
+  35.5651f, 0.0100043f, 13.4067f, 0.0925619f,
+};
+
+static const float32_t occupancy_priors[OCCUPANCY_CLASSES] = {
+  0.572768f, 0.427232f,
+};
+
+const arm_gaussian_naive_bayes_instance_f32 occupancy_model = {
+  .vectorDimension = OCCUPANCY_FEATURES,
+  .numberOfClasses = OCCUPANCY_CLASSES,
+  .theta = occupancy_theta,
+  .sigma = occupancy_sigma,
+  .classPriors = occupancy_priors,
+  .epsilon = 0.693682f,
+};
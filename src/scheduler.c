@@ -14,6 +14,13 @@
 #include <em_core.h>
 #include <stdint.h>
 
+// for event timestamps
+#include "irq.h"
+
+// tickless periodic work
+#include "timer.h"
+#include "soft_timer.h"
+
 // to control Si7021/GPIO
 #include "gpio.h"
 #include "i2c.h"
@@ -27,77 +34,203 @@
 
 #include "src/em_adc.h"
 #include "src/adc.h"
+#include "sound.h"
+#include "occupancy.h"
 
 // Include logging for this file
 #define INCLUDE_LOG_DEBUG 1
 #include "src/log.h"
 
-// store sound
-uint32_t sound_level;
+// Event queue, producers write at the head, sl_bt_on_event() reads at the
+// tail. The IRQs that raise events share the default NVIC priority, but a
+// push from thread mode or a higher priority would race them for the head,
+// so claiming and publishing a slot is a short critical section. Only the
+// main loop writes event_queue_tail, the read side needs no lock.
+static scheduler_event_entry event_queue[SCHEDULER_EVENT_QUEUE_DEPTH];
+static volatile uint32_t event_queue_head = 0; // free running, mask to index
+static volatile uint32_t event_queue_tail = 0;
+static volatile uint32_t event_queue_overruns[NUM_SCHEDULER_EVENTS];
+static volatile uint32_t event_queue_high_water = 0;
+
+// edited from Lecture 6 slides
+// queues event with a timestamp, the BLE external signal only wakes the
+// stack up, the queue keeps every event even if the stack is busy
+void set_scheduler_event_data(scheduler_event event, uint32_t data){
+  CORE_DECLARE_IRQ_STATE;
+  sl_status_t sc;
+  uint32_t head;
+  uint32_t used;
+  scheduler_event_entry* entry;
+
+  if (event == NO_EVENT || event >= NUM_SCHEDULER_EVENTS){
+      return;
+  }
 
-uint32_t* getSoundLevelptr(){
-  return &sound_level;
+  CORE_ENTER_CRITICAL();
+  head = event_queue_head;
+  used = head - event_queue_tail;
+  // never overwrite an entry the main loop has not read yet
+  if (used >= SCHEDULER_EVENT_QUEUE_DEPTH){
+      event_queue_overruns[event]++;
+      CORE_EXIT_CRITICAL();
+      return;
+  }
+
+  entry = &event_queue[head & (SCHEDULER_EVENT_QUEUE_DEPTH - 1)];
+  entry->event = event;
+  entry->timestamp_ticks = letimerTicks64(); // no conversion in the IRQ
+  entry->data = data;
+  __DMB(); // entry must be written before it is published
+  event_queue_head = head + 1;
+
+  if (used + 1 > event_queue_high_water){
+      event_queue_high_water = used + 1;
+  }
+  CORE_EXIT_CRITICAL();
+
+  sc = sl_bt_external_signal(BLE_SCHEDULER_EVENT_FLAG);
+  if (sc != SL_STATUS_OK){
+      LOG_ERROR("Error setting BLE_SCHEDULER_EVENT_FLAG, Error Code: 0x%x\r\n", (uint16_t)sc);
+  }
 }
 
-// edited from Lecture 6 slides
-// sets event flag for future use
 void set_scheduler_event(scheduler_event event){
-  sl_status_t sc;
-  unsigned int PB0_val;
-  CORE_DECLARE_IRQ_STATE;
-  switch (event){
-    case NO_EVENT:
+  uint32_t data = 0;
+  // PB0 is sampled in the IRQ, it may have changed again by the time the
+  // event is read
+  if (event == EVENT_PB){
+      data = gpioRead_PB0(); // 1 if released, 0 if pressed
+  }
+  set_scheduler_event_data(event, data);
+}
+
+bool getNextEvent(scheduler_event_entry* entry){
+  uint32_t tail = event_queue_tail;
+  if (tail == event_queue_head){
+      return false;
+  }
+  *entry = event_queue[tail & (SCHEDULER_EVENT_QUEUE_DEPTH - 1)];
+  __DMB(); // entry must be copied before the slot is handed back
+  event_queue_tail = tail + 1;
+  return true;
+}
+
+uint32_t get_scheduler_event_overruns(scheduler_event event){
+  if (event >= NUM_SCHEDULER_EVENTS){
+      return 0;
+  }
+  return event_queue_overruns[event];
+}
+
+uint32_t get_scheduler_event_high_water(){
+  return event_queue_high_water;
+}
+
+#if DEVICE_IS_BLE_SERVER
+
+#if TIMER_TICKLESS
+static soft_timer_t sound_window_timer;
+static soft_timer_t temperature_timer;
+#if !VEML6030_THRESHOLD_INT
+static soft_timer_t ambient_light_timer;
+#endif
+#endif
+
+// Si7021 power-up and conversion waits
+static soft_timer_t si7021_timer;
+static SI7021_state temperature_state = SI7021_POWER_ON_RESET;
+
+// tickless, the periodic work has deadlines of its own instead of riding on
+// the LETIMER0 underflow. All start from the same tick, so every 5th window
+// and the light read share one wake-up, every 30th the Si7021 measurement.
+// In threshold mode the VEML6030 INT line starts the light reads instead.
+void initPeriodicSampling(){
+#if TIMER_TICKLESS
+  uint32_t window_ticks = soft_timer_ms_to_ticks(SOUND_WINDOW_PERIOD_MS);
+  uint32_t temperature_ticks = soft_timer_ms_to_ticks(TEMPERATURE_PERIOD_MS);
+  uint32_t base = letimerTicks();
+
+  soft_timer_start_at(&sound_window_timer, SOFT_TIMER_SOUND_WINDOW, base + window_ticks, window_ticks);
+  soft_timer_start_at(&temperature_timer, SOFT_TIMER_TEMPERATURE, base + temperature_ticks, temperature_ticks);
+#if !VEML6030_THRESHOLD_INT
+  uint32_t light_ticks = soft_timer_ms_to_ticks(AMBIENT_LIGHT_PERIOD_MS);
+  soft_timer_start_at(&ambient_light_timer, SOFT_TIMER_AMBIENT_LIGHT, base + light_ticks, light_ticks);
+#endif
+#endif
+}
+
+// tickless, starts what the LETIMER0 UF ISR starts otherwise
+void periodic_sampling_update(scheduler_event_entry* event){
+#if TIMER_TICKLESS
+  if (event->event != EVENT_LETIMER0_COMP1){
+      return;
+  }
+  switch (event->data){
+    case SOFT_TIMER_SOUND_WINDOW:
+#if SOUND_SAMPLING_LDMA
+      sound_capture_start();
+#else
+      ADC_IntEnable(ADC0, ADC_IEN_SINGLE);
+      ADC_Start(ADC0, adcStartSingle);
+#endif
       break;
-    // prioritize I2C transfer event first
-    case EVENT_I2C_TRANSFER:
-     CORE_ENTER_CRITICAL();
-     sc = sl_bt_external_signal(BLE_I2C_VEML6030_TRANSFER_FLAG);
-     CORE_EXIT_CRITICAL();
-     if (sc != SL_STATUS_OK){
-         LOG_ERROR("Error setting BLE_I2C_VEML6030_TRANSFER_FLAG, Error Code: 0x%x\r\n", (uint16_t)sc);
-     }
-     break;
-    case EVENT_LETIMER0_COMP1:
-      CORE_ENTER_CRITICAL();
-      sc = sl_bt_external_signal(BLE_LETIMER0_COMP1_FLAG);
-      CORE_EXIT_CRITICAL();
-      if (sc != SL_STATUS_OK){
-          LOG_ERROR("Error setting BLE_LETIMER0_COMP1_FLAG, Error Code: 0x%x\r\n", (uint16_t)sc);
-      }
+    case SOFT_TIMER_AMBIENT_LIGHT:
+      VEML6030_start_read_ambient_light_level();
       break;
-    case EVENT_LETIMER0_UF:
-      CORE_ENTER_CRITICAL();
-      sc = sl_bt_external_signal(BLE_LETIMER0_UF_FLAG);
-      CORE_EXIT_CRITICAL();
-      if (sc != SL_STATUS_OK){
-          LOG_ERROR("Error setting BLE_LETIMER0_UF_FLAG, Error Code: 0x%x\r\n", (uint16_t)sc);
+    case SOFT_TIMER_TEMPERATURE:
+      SI7021_start_measurement();
+      break;
+    default:
+      break;
+  }
+#endif
+}
+
+// the Si7021 shares its enable line with the LCD, so it is powered once at
+// boot and stays on
+void initTemperatureSensor(){
+  temperature_state = SI7021_POWER_ON_RESET;
+  gpioPowerOn_SI7021();
+  soft_timer_start_us(&si7021_timer, SOFT_TIMER_SI7021, SI7021_POWER_UP_US, 0);
+}
+
+// Si7021 every 30 sec, each step waits for its event instead of the CPU:
+// power-up time, measure command, conversion time, humidity and temperature
+// reads. The bus is free for the VEML6030 while the Si7021 converts.
+void temperature_state_machine(scheduler_event_entry* event){
+  bool timer_expired = (event->event == EVENT_LETIMER0_COMP1 && event->data == SOFT_TIMER_SI7021);
+  SI7021_sample_t sample;
+
+  switch (temperature_state){
+    case SI7021_POWER_ON_RESET:
+      if (timer_expired){
+          temperature_state = SI7021_IDLE;
+          // first reading right away, the periodic ones follow
+          SI7021_start_measurement();
       }
       break;
-    case EVENT_PB:
-      PB0_val = gpioRead_PB0(); // 1 if released, 0 if pressed
-      if (PB0_val){
-          CORE_ENTER_CRITICAL();
-          sc = sl_bt_external_signal(BLE_PB0_RELEASE);
-          CORE_EXIT_CRITICAL();
-          if (sc != SL_STATUS_OK){
-              LOG_ERROR("Error setting BLE_PB0_FLAG, Error Code: 0x%x\r\n", (uint16_t)sc);
+    case SI7021_IDLE:
+      if (event->event == EVENT_I2C_TRANSFER && event->data == I2C_TRANSFER_SI7021_MEASURE){
+          // a command that failed after its retries skips this period
+          if (SI7021_measurement_started()){
+              soft_timer_start_us(&si7021_timer, SOFT_TIMER_SI7021, SI7021_CONVERSION_US, 0);
+              temperature_state = SI7021_WAIT_CONVERSION;
           }
       }
-      else{
-          CORE_ENTER_CRITICAL();
-          sc = sl_bt_external_signal(BLE_PB0_PRESS);
-          CORE_EXIT_CRITICAL();
-          if (sc != SL_STATUS_OK){
-              LOG_ERROR("Error setting BLE_PB0_FLAG, Error Code: 0x%x\r\n", (uint16_t)sc);
-          }
+      break;
+    case SI7021_WAIT_CONVERSION:
+      if (timer_expired){
+          SI7021_start_read();
+          temperature_state = SI7021_WAIT_I2C_READ;
       }
       break;
-    case EVENT_ADC_CONVERSION:
-      CORE_ENTER_CRITICAL();
-      sc = sl_bt_external_signal(BLE_ADC_COMPLETE_FLAG);
-      CORE_EXIT_CRITICAL();
-      if (sc != SL_STATUS_OK){
-          LOG_ERROR("Error setting BLE_SOUND_ADC_FLAG, Error Code: 0x%x\r\n", (uint16_t)sc);
+    case SI7021_WAIT_I2C_READ:
+      if (event->event == EVENT_I2C_TRANSFER && event->data == I2C_TRANSFER_SI7021_READ){
+          temperature_state = SI7021_IDLE;
+          if (SI7021_read_measurement(&sample)){
+              update_temp_meas_gatt_and_send_notification(SI7021_convert_to_millidegrees(&sample));
+              update_humidity_gatt_and_send_notification(SI7021_convert_to_humidity_e2(&sample));
+          }
       }
       break;
     default:
@@ -105,45 +238,62 @@ void set_scheduler_event(scheduler_event event){
   }
 }
 
-#if DEVICE_IS_BLE_SERVER
-
-// Read Ambient Light every 5 sec
-void ambient_light_state_machine(sl_bt_msg_t* evt){
-  // only update on external signal (non-bluetooth)
-  if (SL_BT_MSG_ID(evt->header) != sl_bt_evt_system_external_signal_id){
+// Read Ambient Light every 5 sec, or when the VEML6030 INT line says it changed
+void ambient_light_state_machine(scheduler_event_entry* event){
+  if (event->event == EVENT_ALS_INTERRUPT){
+      VEML6030_start_read_ambient_light_level();
       return;
   }
-  uint32_t ble_event_flags = evt->data.evt_system_external_signal.extsignals;
-
-  if (ble_event_flags & BLE_I2C_VEML6030_TRANSFER_FLAG){
-      float amb_light_lux = VEML6030_read_measured_ambient_light();
+  if (event->event == EVENT_I2C_TRANSFER && event->data == I2C_TRANSFER_VEML6030_ALS){
+      VEML6030_sample_t sample;
+      // the first reading after a range change is dropped
+      if (!VEML6030_read_measured_ambient_light(&sample)){
+          return;
+      }
+      float amb_light_lux = VEML6030_convert_to_lux(&sample);
       update_amb_light_gatt_and_send_notification(amb_light_lux);
+#if OCCUPANCY_AUTO
+      occupancy_add_lux(amb_light_lux);
+#endif
   }
 }
 
-void sound_detector_update(sl_bt_msg_t* evt){
-  // only update on external signal (non-bluetooth)
-    if (SL_BT_MSG_ID(evt->header) != sl_bt_evt_system_external_signal_id){
-        return;
-    }
-    uint32_t ble_event_flags = evt->data.evt_system_external_signal.extsignals;
-
-    if (ble_event_flags & BLE_ADC_COMPLETE_FLAG){
-        update_sound_level_gatt_and_send_notification(sound_level);
-    }
+#if OCCUPANCY_AUTO
+// a feature vector every OCCUPANCY_PERIOD_WINDOWS windows, the flag only
+// changes when the smoothed prediction crosses a threshold
+static void occupancy_update(const sound_level_t* level){
+  bool occupied;
+  if (occupancy_add_sound(level) &&
+      occupancy_decide(occupancy_predict(occupancy_features()), &occupied)){
+      set_space_occupied(occupied);
+  }
 }
+#endif
 
-void lcd_display_update(sl_bt_msg_t* evt){
-  // only update on external signal (non-bluetooth)
-  if (SL_BT_MSG_ID(evt->header) != sl_bt_evt_system_external_signal_id){
-      return;
+void sound_detector_update(scheduler_event_entry* event){
+  sound_level_t level;
+#if SOUND_SAMPLING_LDMA
+  // notify once per window, after its last buffer
+  if (event->event == EVENT_SOUND_BUFFER && sound_level_process(event->data, &level)){
+      update_sound_level_gatt_and_send_notification(&level);
+#if OCCUPANCY_AUTO
+      occupancy_update(&level);
+#endif
+      update_snapshot_gatt_and_send_notification();
   }
-  uint32_t ble_event_flags = evt->data.evt_system_external_signal.extsignals;
+#else
+  if (event->event == EVENT_ADC_CONVERSION){
+      sound_level_from_envelope(event->data, &level);
+      update_sound_level_gatt_and_send_notification(&level);
+      update_snapshot_gatt_and_send_notification();
+  }
+#endif
+}
 
+void lcd_display_update(scheduler_event_entry* event){
   // refresh LCD every 1s
-  if (ble_event_flags & BLE_LETIMER0_UF_FLAG){
+  if (event->event == EVENT_LETIMER0_UF){
       displayUpdate(); // prevent charge buildup within the Liquid Crystal Cells
   }
 }
 #endif
-
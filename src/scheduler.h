@@ -14,6 +14,8 @@
 #ifndef SCHEDULER_H
 #define SCHEDULER_H
 
+#include <stdint.h>
+#include <stdbool.h>
 #include "sl_bt_api.h"
 #include "ble_device_type.h"
 
@@ -25,9 +27,25 @@ typedef enum{
     EVENT_LETIMER0_COMP1,
     EVENT_I2C_TRANSFER,
     EVENT_PB,
-    EVENT_ADC_CONVERSION
+    EVENT_ADC_CONVERSION,
+    EVENT_SOUND_BUFFER,
+    EVENT_ALS_INTERRUPT,
+    NUM_SCHEDULER_EVENTS
 } scheduler_event;
 
+// one queued event, filled in by the IRQ that raised it
+typedef struct{
+  scheduler_event event;
+  uint32_t data;            // EVENT_LETIMER0_COMP1: soft_timer_id that expired,
+                            // EVENT_I2C_TRANSFER: i2c_transfer_id that completed,
+                            // EVENT_PB: PB0 level, EVENT_ADC_CONVERSION: mV,
+                            // EVENT_SOUND_BUFFER: buffer number in the window
+  uint64_t timestamp_ticks; // letimerTicks64() when the IRQ ran, see letimerTicksToUs()
+} scheduler_event_entry;
+
+// must be a power of 2
+#define SCHEDULER_EVENT_QUEUE_DEPTH 16
+
 #if DEVICE_IS_BLE_SERVER
 
 typedef enum{
@@ -35,27 +53,44 @@ typedef enum{
   VEML6030_WAIT_I2C_READ
 } VEML6030_state;
 
+// the measure command is started from the periodic work, in IDLE
+typedef enum{
+  SI7021_POWER_ON_RESET,
+  SI7021_IDLE,
+  SI7021_WAIT_CONVERSION,
+  SI7021_WAIT_I2C_READ
+} SI7021_state;
+
 
 #endif
 
 
-// for use in app.c
-// scheduler_event getNextEvent();
+// for use in app.c, false once the queue is empty
+bool getNextEvent(scheduler_event_entry* entry);
 
 // for use by IRQ
 void set_scheduler_event(scheduler_event event);
+void set_scheduler_event_data(scheduler_event event, uint32_t data);
+
+// events dropped because the queue was full, and the deepest it has been
+uint32_t get_scheduler_event_overruns(scheduler_event event);
+uint32_t get_scheduler_event_high_water();
 
 #if DEVICE_IS_BLE_SERVER // functions only for server
 
-// state machines using ble event
-void temperature_state_machine(sl_bt_msg_t* evt);
-void ambient_light_state_machine(sl_bt_msg_t* evt);
+// periodic sound windows and light reads, when TIMER_TICKLESS
+void initPeriodicSampling();
+void periodic_sampling_update(scheduler_event_entry* event);
+
+// powers the Si7021, the first measurement follows its power-up time
+void initTemperatureSensor();
 
-void sound_detector_update(sl_bt_msg_t* evt);
-void lcd_display_update(sl_bt_msg_t* evt);
+// state machines using queued events
+void temperature_state_machine(scheduler_event_entry* event);
+void ambient_light_state_machine(scheduler_event_entry* event);
 
-// for storing from IRQ
-uint32_t* getSoundLevelptr();
+void sound_detector_update(scheduler_event_entry* event);
+void lcd_display_update(scheduler_event_entry* event);
 #endif
 
 #endif
@@ -0,0 +1,192 @@
+/***********************************************************************
+ * @file      series.c
+ * @brief     Streaming delta encoding of timestamped sensor samples
+ *
+ * @author    Hyounjun Chang, hyounjun.chang@colorado.edu
+ * @date      Oct 17, 2026
+ *
+ * @resources Pelkonen et al., Gorilla: A Fast, Scalable, In-Memory Time
+ *            Series Database, VLDB 2015
+ *
+ * Timestamps are kept as the delta of their delta, which is 0 while
+ * samples come at a steady period, and fields as the delta from the
+ * previous sample. As in Gorilla an unchanged value costs a control bit,
+ * but the rest is byte aligned: zig-zag LEB128 varints instead of Gorilla's
+ * bit packed ranges and XORed floats. The fields are integers already, and
+ * bytes are cheaper to handle on the M4 and easier to cut into flash
+ * records and SDUs. A slowly changing room is 2-4 bytes a sample.
+ *
+ * Deltas wrap modulo 2^32, so any value comes back exactly.
+ *
+ */
+#include "series.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+
+static inline uint32_t zigzag(uint32_t n){
+  return (n << 1) ^ (uint32_t)((int32_t)n >> 31);
+}
+
+static inline uint32_t unzigzag(uint32_t n){
+  return (n >> 1) ^ (uint32_t)-(int32_t)(n & 1);
+}
+
+static inline uint8_t* put_varint(uint8_t* p, uint32_t n){
+  while (n >= 0x80){
+      *p++ = (uint8_t)(n | 0x80);
+      n >>= 7;
+  }
+  *p++ = (uint8_t)n;
+  return p;
+}
+
+// false past the end or on a varint longer than 5 bytes
+static bool get_varint(series_decoder_t* dec, uint32_t* n){
+  uint32_t value = 0;
+  for (uint32_t shift = 0; shift < 35; shift += 7){
+      uint8_t byte;
+      if (dec->pos >= dec->len){
+          return false;
+      }
+      byte = dec->buf[dec->pos++];
+      value |= (uint32_t)(byte & 0x7F) << shift;
+      if (!(byte & 0x80)){
+          *n = value;
+          return true;
+      }
+  }
+  return false;
+}
+
+void series_encoder_init(series_encoder_t* enc, uint8_t* buf, uint16_t size, uint8_t fields){
+  enc->buf = buf;
+  enc->size = size;
+  enc->len = 0;
+  enc->count = 0;
+  enc->fields = fields > SERIES_MAX_FIELDS ? SERIES_MAX_FIELDS : fields;
+  enc->last_time = 0;
+  enc->last_delta = 0;
+  for (uint8_t i = 0; i < SERIES_MAX_FIELDS; i++){
+      enc->last[i] = 0;
+  }
+}
+
+bool series_encode(series_encoder_t* enc, uint32_t timestamp, const int32_t* values){
+  // built on the stack first, the stream only takes whole samples
+  uint8_t sample[SERIES_SAMPLE_MAX(SERIES_MAX_FIELDS)];
+  uint8_t* p = sample;
+  uint32_t delta = timestamp - enc->last_time;
+  uint32_t len;
+
+  if (enc->count == 0){
+      p = put_varint(p, timestamp);
+      for (uint8_t i = 0; i < enc->fields; i++){
+          p = put_varint(p, zigzag((uint32_t)values[i]));
+      }
+      delta = 0;
+  }
+  else{
+      uint8_t* control = p++;
+      *control = 0;
+      if (delta != enc->last_delta){
+          *control |= SERIES_TIME_CHANGED;
+          p = put_varint(p, zigzag(delta - enc->last_delta));
+      }
+      for (uint8_t i = 0; i < enc->fields; i++){
+          if (values[i] != enc->last[i]){
+              *control |= (uint8_t)(1 << i);
+              p = put_varint(p, zigzag((uint32_t)values[i] - (uint32_t)enc->last[i]));
+          }
+      }
+  }
+
+  len = (uint32_t)(p - sample);
+  if (enc->len + len > enc->size){
+      return false;
+  }
+  for (uint32_t i = 0; i < len; i++){
+      enc->buf[enc->len + i] = sample[i];
+  }
+  enc->len += (uint16_t)len;
+  enc->count++;
+  enc->last_time = timestamp;
+  enc->last_delta = delta;
+  for (uint8_t i = 0; i < enc->fields; i++){
+      enc->last[i] = values[i];
+  }
+  return true;
+}
+
+void series_encoder_continue(series_encoder_t* enc, uint8_t* buf, uint16_t size){
+  enc->buf = buf;
+  enc->size = size;
+  enc->len = 0;
+}
+
+void series_decoder_init(series_decoder_t* dec, const uint8_t* buf, uint16_t len, uint8_t fields){
+  dec->buf = buf;
+  dec->len = len;
+  dec->pos = 0;
+  dec->count = 0;
+  dec->fields = fields > SERIES_MAX_FIELDS ? SERIES_MAX_FIELDS : fields;
+  dec->last_time = 0;
+  dec->last_delta = 0;
+  for (uint8_t i = 0; i < SERIES_MAX_FIELDS; i++){
+      dec->last[i] = 0;
+  }
+}
+
+void series_decoder_continue(series_decoder_t* dec, const uint8_t* buf, uint16_t len){
+  dec->buf = buf;
+  dec->len = len;
+  dec->pos = 0;
+}
+
+bool series_decode(series_decoder_t* dec, uint32_t* timestamp, int32_t* values){
+  uint32_t n;
+  uint8_t control;
+
+  if (dec->pos >= dec->len){
+      return false;
+  }
+  if (dec->count == 0){
+      if (!get_varint(dec, &dec->last_time)){
+          return false;
+      }
+      for (uint8_t i = 0; i < dec->fields; i++){
+          if (!get_varint(dec, &n)){
+              return false;
+          }
+          dec->last[i] = (int32_t)unzigzag(n);
+      }
+  }
+  else{
+      control = dec->buf[dec->pos++];
+      if (control & ~(SERIES_TIME_CHANGED | ((1u << dec->fields) - 1))){
+          return false;
+      }
+      if (control & SERIES_TIME_CHANGED){
+          if (!get_varint(dec, &n)){
+              return false;
+          }
+          dec->last_delta += unzigzag(n);
+      }
+      dec->last_time += dec->last_delta;
+      for (uint8_t i = 0; i < dec->fields; i++){
+          if (control & (1 << i)){
+              if (!get_varint(dec, &n)){
+                  return false;
+              }
+              dec->last[i] = (int32_t)((uint32_t)dec->last[i] + unzigzag(n));
+          }
+      }
+  }
+
+  dec->count++;
+  *timestamp = dec->last_time;
+  for (uint8_t i = 0; i < dec->fields; i++){
+      values[i] = dec->last[i];
+  }
+  return true;
+}
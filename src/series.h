@@ -0,0 +1,68 @@
+/***********************************************************************
+ * @file      series.h
+ * @brief     Streaming delta encoding of timestamped sensor samples
+ *
+ * @author    Hyounjun Chang, hyounjun.chang@colorado.edu
+ * @date      Oct 17, 2026
+ *
+ * @resources Pelkonen et al., Gorilla: A Fast, Scalable, In-Memory Time
+ *            Series Database, VLDB 2015
+ *
+ */
+#ifndef SRC_SERIES_H_
+#define SRC_SERIES_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// integer fields per sample, one control bit each
+#define SERIES_MAX_FIELDS   7
+
+// stream layout, a sample after another, varints are LEB128
+//  first:  varint timestamp, zig-zag varint of each field
+//  others: control byte, bit 7 set if the timestamp delta changed and bit i
+//          if field i did, then a zig-zag varint of the delta of delta of
+//          the timestamp and of the delta of each field whose bit is set
+// The first delta of delta is taken against a delta of 0. A stream is cut
+// only between samples, its length ends it.
+#define SERIES_TIME_CHANGED 0x80
+// longest encoded sample
+#define SERIES_SAMPLE_MAX(fields) (1 + 5 * (1 + (fields)))
+
+typedef struct {
+  uint8_t* buf;
+  uint16_t size;
+  uint16_t len;           // bytes encoded
+  uint16_t count;         // samples encoded
+  uint8_t fields;
+  uint32_t last_time;
+  uint32_t last_delta;
+  int32_t last[SERIES_MAX_FIELDS];
+} series_encoder_t;
+
+typedef struct {
+  const uint8_t* buf;
+  uint16_t len;
+  uint16_t pos;
+  uint16_t count;         // samples decoded
+  uint8_t fields;
+  uint32_t last_time;
+  uint32_t last_delta;
+  int32_t last[SERIES_MAX_FIELDS];
+} series_decoder_t;
+
+// starts an empty stream in buf
+void series_encoder_init(series_encoder_t* enc, uint8_t* buf, uint16_t size, uint8_t fields);
+// appends a sample, false and nothing written if it does not fit
+bool series_encode(series_encoder_t* enc, uint32_t timestamp, const int32_t* values);
+// carries the stream on in another buffer, its first sample is a delta
+// against the last one encoded, so it only decodes after the ones before
+void series_encoder_continue(series_encoder_t* enc, uint8_t* buf, uint16_t size);
+
+void series_decoder_init(series_decoder_t* dec, const uint8_t* buf, uint16_t len, uint8_t fields);
+// the next buffer of a stream carried on with series_encoder_continue()
+void series_decoder_continue(series_decoder_t* dec, const uint8_t* buf, uint16_t len);
+// the next sample, false at the end of the stream or on a malformed one
+bool series_decode(series_decoder_t* dec, uint32_t* timestamp, int32_t* values);
+
+#endif /* SRC_SERIES_H_ */
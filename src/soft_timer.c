@@ -0,0 +1,362 @@
+/***********************************************************************
+ * @file      soft_timer.c
+ * @brief     Software timers multiplexed on LETIMER0 COMP1
+ *
+ * @author    Hyounjun Chang, hyounjun.chang@colorado.edu
+ * @date      Oct 16, 2026
+ *
+ * @resources G. Varghese, T. Lauck, "Hashed and Hierarchical Timing Wheels"
+ *            EFR32xG13 Reference Manual, LETIMER chapter
+ *
+ * Timers are filed in a hierarchical wheel by how far away they are: level
+ * 0 holds the next 64 ticks one slot per tick, level 1 the next 4096 ticks
+ * 64 per slot, and so on. A slot on a higher level is re-filed ("cascaded")
+ * into the lower levels when the wheel reaches the start of it, so
+ * starting, stopping and expiring a timer are O(1) whatever the number of
+ * timers. The wheel is not stepped every tick: a bitmap per level finds the
+ * next slot that needs attention, and only the nearest expiry goes into
+ * COMP1. Cascades due by then are run in the same interrupt.
+ *
+ * LETIMER0 keeps counting through all of it. COMP1 matches once per period,
+ * so a deadline more than one period away is reached through an early match
+ * that only re-arms it. That early match is also what keeps letimerTicks()
+ * counting underflows when the timer runs tickless: the UF interrupt is only
+ * enabled while no software timer is pending.
+ *
+ */
+#include "soft_timer.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include <em_core.h>
+#include "em_letimer.h"
+
+#include "timer.h"
+#include "irq.h"
+#include "scheduler.h"
+
+#define LEVEL_SHIFT(level)    ((level) * SOFT_TIMER_SLOT_BITS)
+#define SLOT_MASK             (SOFT_TIMER_SLOTS - 1)
+#define WHEEL_SPAN            ((uint32_t)1 << LEVEL_SHIFT(SOFT_TIMER_LEVELS))
+
+// COMP1 writes take a few LF clocks to synchronize, nearer deadlines are
+// pushed out so the match is never written behind the counter
+#define SOFT_TIMER_MIN_TICKS  2
+
+// slot lists, bit s of occupied[n] is set while slot s of level n is not empty
+static soft_timer_t* wheel[SOFT_TIMER_LEVELS][SOFT_TIMER_SLOTS];
+static uint64_t occupied[SOFT_TIMER_LEVELS];
+static uint32_t wheel_now = 0;  // every deadline up to this tick has been handled
+static uint32_t pending = 0;
+
+static bool tick_before(uint32_t a, uint32_t b){
+  return (int32_t)(a - b) < 0;
+}
+
+static uint64_t rotate_right(uint64_t bits, uint32_t n){
+  n &= SLOT_MASK;
+  return n ? (bits >> n) | (bits << (SOFT_TIMER_SLOTS - n)) : bits;
+}
+
+static void wheel_link(soft_timer_t* timer, uint32_t level, uint32_t slot){
+  timer->level = level;
+  timer->slot = slot;
+  timer->prev = NULL;
+  timer->next = wheel[level][slot];
+  if (timer->next){
+      timer->next->prev = timer;
+  }
+  wheel[level][slot] = timer;
+  occupied[level] |= (uint64_t)1 << slot;
+  timer->active = true;
+  pending++;
+}
+
+static void wheel_unlink(soft_timer_t* timer){
+  if (timer->prev){
+      timer->prev->next = timer->next;
+  }
+  else{
+      wheel[timer->level][timer->slot] = timer->next;
+  }
+  if (timer->next){
+      timer->next->prev = timer->prev;
+  }
+  if (!wheel[timer->level][timer->slot]){
+      occupied[timer->level] &= ~((uint64_t)1 << timer->slot);
+  }
+  timer->active = false;
+  pending--;
+}
+
+// detaches a whole slot, its timers are re-filed or expired one by one
+static soft_timer_t* wheel_take_slot(uint32_t level, uint32_t slot){
+  soft_timer_t* list = wheel[level][slot];
+  wheel[level][slot] = NULL;
+  occupied[level] &= ~((uint64_t)1 << slot);
+  for (soft_timer_t* t = list; t; t = t->next){
+      t->active = false;
+      pending--;
+  }
+  return list;
+}
+
+static void wheel_file(soft_timer_t* timer){
+  uint32_t delta = timer->expires - wheel_now;
+  uint32_t filed_at = timer->expires;
+  uint32_t level = 0;
+
+  // due already: the current level 0 slot
+  if ((int32_t)delta <= 0){
+      wheel_link(timer, 0, wheel_now & SLOT_MASK);
+      return;
+  }
+  // beyond the top level: park it in the last slot, it comes back down
+  // through the cascade and is filed again from there
+  if (delta >= WHEEL_SPAN){
+      delta = WHEEL_SPAN - 1;
+      filed_at = wheel_now + delta;
+  }
+  while (level < SOFT_TIMER_LEVELS - 1 && delta >= ((uint32_t)1 << LEVEL_SHIFT(level + 1))){
+      level++;
+  }
+  wheel_link(timer, level, (filed_at >> LEVEL_SHIFT(level)) & SLOT_MASK);
+}
+
+// first tick at which a slot expires (level 0) or cascades (higher levels)
+static bool wheel_next_deadline(uint32_t* deadline){
+  bool found = false;
+
+  for (uint32_t level = 0; level < SOFT_TIMER_LEVELS; level++){
+      if (!occupied[level]){
+          continue;
+      }
+      uint32_t shift = LEVEL_SHIFT(level);
+      uint32_t position = (wheel_now >> shift) & SLOT_MASK;
+      uint32_t tick;
+      if (level == 0){
+          // the current slot counts, it holds timers that are due
+          tick = wheel_now + (uint32_t)__builtin_ctzll(rotate_right(occupied[0], position));
+      }
+      else{
+          uint32_t ahead = (uint32_t)__builtin_ctzll(rotate_right(occupied[level], position + 1)) + 1;
+          tick = ((wheel_now >> shift) + ahead) << shift;
+      }
+      if (!found || tick_before(tick, *deadline)){
+          *deadline = tick;
+          found = true;
+      }
+  }
+  return found;
+}
+
+// first tick at which a timer expires. Cascades on the way need no wake-up
+// of their own, the catch up at that tick runs them first. A higher level
+// slot covers a range of ticks, so its timers are looked at one by one;
+// slots further ahead on the same level only hold later timers.
+static bool wheel_next_expiry(uint32_t* expiry){
+  bool found = false;
+
+  for (uint32_t level = 0; level < SOFT_TIMER_LEVELS; level++){
+      if (!occupied[level]){
+          continue;
+      }
+      uint32_t position = (wheel_now >> LEVEL_SHIFT(level)) & SLOT_MASK;
+      uint32_t tick;
+      if (level == 0){
+          tick = wheel_now + (uint32_t)__builtin_ctzll(rotate_right(occupied[0], position));
+      }
+      else{
+          uint32_t ahead = (uint32_t)__builtin_ctzll(rotate_right(occupied[level], position + 1)) + 1;
+          const soft_timer_t* t = wheel[level][(position + ahead) & SLOT_MASK];
+          tick = t->expires;
+          for (t = t->next; t; t = t->next){
+              if (tick_before(t->expires, tick)){
+                  tick = t->expires;
+              }
+          }
+      }
+      if (!found || tick_before(tick, *expiry)){
+          *expiry = tick;
+          found = true;
+      }
+  }
+  return found;
+}
+
+static void wheel_expire(soft_timer_t* timer){
+  if (timer->period){
+      timer->expires += timer->period;
+      wheel_file(timer);
+  }
+  set_scheduler_event_data(EVENT_LETIMER0_COMP1, timer->id);
+}
+
+// everything that happens at tick: cascades from the top down, so a timer
+// can drop several levels at once, then the level 0 slot expires
+static void wheel_process(uint32_t tick){
+  soft_timer_t* list;
+  soft_timer_t* next;
+
+  wheel_now = tick;
+  for (uint32_t level = SOFT_TIMER_LEVELS - 1; level > 0; level--){
+      uint32_t shift = LEVEL_SHIFT(level);
+      if (tick & (((uint32_t)1 << shift) - 1)){
+          continue;
+      }
+      for (list = wheel_take_slot(level, (tick >> shift) & SLOT_MASK); list; list = next){
+          next = list->next;
+          wheel_file(list);
+      }
+  }
+  for (list = wheel_take_slot(0, tick & SLOT_MASK); list; list = next){
+      next = list->next;
+      wheel_expire(list);
+  }
+}
+
+// handles every deadline up to now, then moves the wheel to now. Slots
+// skipped on the way were empty, so nothing is lost by jumping.
+static void wheel_catch_up(uint32_t now){
+  uint32_t deadline = 0;
+  while (wheel_next_deadline(&deadline) && !tick_before(now, deadline)){
+      wheel_process(deadline);
+  }
+  if (tick_before(wheel_now, now)){
+      wheel_now = now;
+  }
+}
+
+// loads COMP1 with the nearest expiry, returns true if it is already due
+static bool wheel_arm(){
+  uint32_t deadline = 0;
+  if (!wheel_next_expiry(&deadline)){
+      LETIMER_IntDisable(LETIMER0, LETIMER_IEN_COMP1);
+#if TIMER_TICKLESS
+      // nothing to wake up for, the underflow keeps the tick count going
+      LETIMER_IntEnable(LETIMER0, LETIMER_IEN_UF);
+#endif
+      return false;
+  }
+  LETIMER_IntEnable(LETIMER0, LETIMER_IEN_COMP1);
+#if TIMER_TICKLESS
+  LETIMER_IntDisable(LETIMER0, LETIMER_IEN_UF);
+#endif
+
+  // ticks first: if the counter moves in between, the match lands a tick late, not early
+  uint32_t now = letimerTicks();
+  uint32_t cnt = LETIMER_CounterGet(LETIMER0);
+  int32_t delta = (int32_t)(deadline - now);
+  uint32_t period = get_LETIMER_TOP_value() + 1;
+  if (delta <= 0){
+      return true;
+  }
+  if (delta < SOFT_TIMER_MIN_TICKS){
+      delta = SOFT_TIMER_MIN_TICKS;
+  }
+  if ((uint32_t)delta >= period){
+      delta = period - 1; // matches once on the way, then re-armed
+  }
+
+  // the counter runs down and reloads TOP after 0
+  uint32_t comp1_cnt = (cnt >= (uint32_t)delta) ? cnt - delta : cnt + period - delta;
+  LETIMER_CompareSet(LETIMER0, 1, comp1_cnt);
+  return false;
+}
+
+void initSoftTimers(){
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_CRITICAL();
+  for (uint32_t level = 0; level < SOFT_TIMER_LEVELS; level++){
+      for (uint32_t slot = 0; slot < SOFT_TIMER_SLOTS; slot++){
+          wheel[level][slot] = NULL;
+      }
+      occupied[level] = 0;
+  }
+  pending = 0;
+  wheel_now = letimerTicks();
+  LETIMER_IntDisable(LETIMER0, LETIMER_IEN_COMP1);
+  LETIMER_IntClear(LETIMER0, LETIMER_IEN_COMP1);
+  CORE_EXIT_CRITICAL();
+}
+
+void soft_timer_start_at(soft_timer_t* timer, uint32_t id, uint32_t expires, uint32_t period_ticks){
+  CORE_DECLARE_IRQ_STATE;
+  bool due;
+
+  CORE_ENTER_CRITICAL();
+  if (timer->active){
+      wheel_unlink(timer);
+  }
+  wheel_catch_up(letimerTicks());
+  timer->id = id;
+  timer->period = period_ticks;
+  timer->expires = expires;
+  wheel_file(timer);
+  due = wheel_arm();
+  CORE_EXIT_CRITICAL();
+
+  // the COMP1 handler expires it, outside of this critical section
+  if (due){
+      LETIMER_IntSet(LETIMER0, LETIMER_IF_COMP1);
+  }
+}
+
+void soft_timer_start_ticks(soft_timer_t* timer, uint32_t id, uint32_t delay_ticks, uint32_t period_ticks){
+  soft_timer_start_at(timer, id, letimerTicks() + delay_ticks, period_ticks);
+}
+
+uint32_t soft_timer_ms_to_ticks(uint32_t ms){
+  // nearest tick, rounding up every period would drift
+  return (uint32_t)(((uint64_t)ms * get_LETIMER_freq() + 500) / 1000);
+}
+
+void soft_timer_start_us(soft_timer_t* timer, uint32_t id, uint32_t delay_us, uint32_t period_us){
+  uint32_t period_ticks = 0;
+  if (period_us){
+      // nearest tick, rounding up every period would drift
+      period_ticks = (uint32_t)(((uint64_t)period_us * get_LETIMER_freq() + 500000) / 1000000);
+      if (period_ticks == 0){
+          period_ticks = 1;
+      }
+  }
+  soft_timer_start_ticks(timer, id, soft_timer_us_to_ticks(delay_us), period_ticks);
+}
+
+void soft_timer_stop(soft_timer_t* timer){
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_CRITICAL();
+  if (timer->active){
+      wheel_unlink(timer);
+      // COMP1 stays armed for the old deadline, the handler re-arms it
+  }
+  CORE_EXIT_CRITICAL();
+}
+
+bool soft_timer_active(const soft_timer_t* timer){
+  return timer->active;
+}
+
+uint32_t soft_timer_pending(){
+  return pending;
+}
+
+uint32_t soft_timer_us_to_ticks(uint32_t us){
+  // + 1, the wait starts somewhere inside the current tick
+  return (uint32_t)((uint64_t)us * get_LETIMER_freq() / 1000000) + 1;
+}
+
+void soft_timer_irq(){
+  CORE_DECLARE_IRQ_STATE;
+  bool due;
+
+  CORE_ENTER_CRITICAL();
+  wheel_catch_up(letimerTicks());
+  due = wheel_arm();
+  CORE_EXIT_CRITICAL();
+  if (due){
+      LETIMER_IntSet(LETIMER0, LETIMER_IF_COMP1);
+  }
+}
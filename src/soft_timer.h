@@ -0,0 +1,72 @@
+/***********************************************************************
+ * @file      soft_timer.h
+ * @brief     Software timers multiplexed on LETIMER0 COMP1
+ *
+ * @author    Hyounjun Chang, hyounjun.chang@colorado.edu
+ * @date      Oct 16, 2026
+ *
+ * @resources G. Varghese, T. Lauck, "Hashed and Hierarchical Timing Wheels"
+ *
+ */
+#ifndef SRC_SOFT_TIMER_H_
+#define SRC_SOFT_TIMER_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// wheel geometry: SOFT_TIMER_LEVELS levels of 2^SOFT_TIMER_SLOT_BITS slots,
+// level n slots are 2^(n * SOFT_TIMER_SLOT_BITS) LETIMER0 ticks wide.
+// 4 x 64 covers 2^24 ticks, 34 min at LFXO/4, longer timers are re-filed
+#define SOFT_TIMER_SLOT_BITS  6
+#define SOFT_TIMER_SLOTS      (1 << SOFT_TIMER_SLOT_BITS)
+#define SOFT_TIMER_LEVELS     4
+
+// what expired, travels as the data of EVENT_LETIMER0_COMP1
+typedef enum {
+  SOFT_TIMER_WAIT_US = 0,       // timerWaitUs_irq()
+  SOFT_TIMER_SOUND_WINDOW,      // tickless: start a sound capture window
+  SOFT_TIMER_AMBIENT_LIGHT,     // tickless: start a VEML6030 read
+  SOFT_TIMER_I2C_TIMEOUT,       // I2C transfer on the wire for too long
+  SOFT_TIMER_I2C_RETRY,         // I2C request due for another attempt
+  SOFT_TIMER_TEMPERATURE,       // tickless: start a Si7021 measurement
+  SOFT_TIMER_SI7021,            // Si7021 power-up or conversion time is over
+  NUM_SOFT_TIMER_IDS
+} soft_timer_id;
+
+// owned by the caller, usually a static in the module that waits
+typedef struct soft_timer {
+  struct soft_timer* next;
+  struct soft_timer* prev;
+  uint32_t expires;   // LETIMER0 tick, see letimerTicks()
+  uint32_t period;    // ticks between expiries, 0 for one-shot
+  uint32_t id;        // soft_timer_id
+  uint8_t level;      // where it is filed while active
+  uint8_t slot;
+  bool active;
+} soft_timer_t;
+
+void initSoftTimers();
+
+// (re)starts timer, expires after at least delay_us, then every period_us
+// if period_us is not 0. Safe to call from an ISR.
+void soft_timer_start_us(soft_timer_t* timer, uint32_t id, uint32_t delay_us, uint32_t period_us);
+// same in LETIMER0 ticks, delay 0 expires right away
+void soft_timer_start_ticks(soft_timer_t* timer, uint32_t id, uint32_t delay_ticks, uint32_t period_ticks);
+// first expiry at letimerTicks() value expires. Timers started from the same
+// base tick with periods that divide each other expire in the same interrupt.
+void soft_timer_start_at(soft_timer_t* timer, uint32_t id, uint32_t expires, uint32_t period_ticks);
+void soft_timer_stop(soft_timer_t* timer);
+bool soft_timer_active(const soft_timer_t* timer);
+
+// timers waiting on the wheel
+uint32_t soft_timer_pending();
+
+// smallest number of ticks that covers us
+uint32_t soft_timer_us_to_ticks(uint32_t us);
+// nearest number of ticks to ms, for periods
+uint32_t soft_timer_ms_to_ticks(uint32_t ms);
+
+// LETIMER0 COMP1 interrupt: queues the expired timers, arms the next deadline
+void soft_timer_irq();
+
+#endif
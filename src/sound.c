@@ -0,0 +1,406 @@
+/***********************************************************************
+ * @file      sound.c
+ * @brief     Sound level engine, RMS / peak / Leq of ADC buffers
+ *
+ * @author    Hyounjun Chang, hyounjun.chang@colorado.edu
+ * @date      Oct 16, 2026
+ *
+ * @resources CMSIS-DSP statistics and basic math functions
+ * https://arm-software.github.io/CMSIS-DSP/latest/
+ *
+ * Each LDMA buffer is reduced with the CMSIS-DSP q15 kernels, which use the
+ * Cortex-M4 dual 16-bit MAC (SMLALD) and saturating SIMD instructions, so a
+ * 512 sample buffer costs a few thousand cycles. Everything up to the final
+ * dB conversion stays in fixed point.
+ *
+ * Leq is the level of a steady sound with the same energy, so it averages
+ * mean squares, never dB values.
+ *
+ * The A and C weighting filters are the IEC 61672 analog poles moved to
+ * 8 kHz with the bilinear transform and normalized to 0 dB at 1 kHz. They
+ * track the standard curves within 0.2 dB up to 2 kHz and roll off early
+ * close to Nyquist, where the detector has little output anyway. The
+ * 20.6 Hz poles sit very close to z = 1, so the cascade runs in q31.
+ *
+ * Band energies come from Hann windowed arm_rfft_q15 frames of the
+ * unweighted signal, SOUND_FFT_HOP apart across the whole window. The
+ * q15 RFFT scales its output down by the FFT size, which makes the sum of
+ * squared bins equal the frame's mean square, so arm_power_q15 over the
+ * interleaved bins of a band gives its energy without losing bits.
+ *
+ */
+#include "sound.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "arm_math.h"
+
+#if SOUND_PROFILE_CYCLES
+#include "em_device.h"
+// Include logging for this file
+#define INCLUDE_LOG_DEBUG 1
+#include "src/log.h"
+#endif
+
+// 12-bit codes around the bias shifted up to q15, 1250 mV full scale.
+// The AC part of AUDIO can not swing further than that from mid-supply.
+#define SOUND_Q15_SHIFT         4
+#define SOUND_FULL_SCALE_MV     1250
+#define SOUND_FULL_SCALE_DB10   619   // 200 * log10(1250 mV)
+
+// mean squares are q30, 1 << 30 is full scale
+#define SOUND_MS_FULL_SCALE     (1UL << 30)
+
+// running Leq, mean square of the last SOUND_LEQ_WINDOWS windows
+static uint32_t leq_history[SOUND_LEQ_WINDOWS];
+static uint32_t leq_next = 0;
+static uint32_t leq_count = 0;
+static uint64_t leq_sum = 0;
+
+#if SOUND_WEIGHTING != SOUND_WEIGHTING_Z
+#if SOUND_SAMPLING_LDMA && SOUND_SAMPLE_RATE_HZ != 8000
+#error "weighting coefficients are designed for 8 kHz sampling"
+#endif
+
+// samples converted to q31 and filtered per chunk
+#define SOUND_WEIGHTING_CHUNK   64
+#define SOUND_WEIGHTING_SHIFT   1  // coefficients are q30, |a1| is close to 2
+
+// {b0, b1, b2, a1, a2} per stage, a1 and a2 negated as CMSIS expects.
+// Stage 1 halves the signal for headroom, the output shift restores it.
+#if SOUND_WEIGHTING == SOUND_WEIGHTING_A
+#define SOUND_WEIGHTING_STAGES  3
+static const q31_t weighting_coeffs[5 * SOUND_WEIGHTING_STAGES] = {
+  // zeros at DC, poles at 20.6 Hz, 20.6 Hz
+  528289457, -1056578915, 528289457, 2113019555, -1039554281,
+  // zeros at DC, poles at 107.7 Hz, 737.9 Hz
+  798747182, -1597494364, 798747182, 1577925793, -543321111,
+  // zeros at Nyquist, poles at 12194 Hz, 12194 Hz, 1 kHz gain
+  908497184, 1816994367, 908497184, -1405521101, -459954507,
+};
+#else
+#define SOUND_WEIGHTING_STAGES  2
+static const q31_t weighting_coeffs[5 * SOUND_WEIGHTING_STAGES] = {
+  // zeros at DC, poles at 20.6 Hz, 20.6 Hz
+  528289457, -1056578915, 528289457, 2113019555, -1039554281,
+  // zeros at Nyquist, poles at 12194 Hz, 12194 Hz, 1 kHz gain
+  740584546, 1481169093, 740584546, -1405521101, -459954507,
+};
+#endif
+
+static arm_biquad_casd_df1_inst_q31 weighting_filter;
+static q31_t weighting_state[4 * SOUND_WEIGHTING_STAGES];
+static q31_t weighting_chunk[SOUND_WEIGHTING_CHUNK];
+#endif
+
+void sound_weighting_reset(){
+#if SOUND_WEIGHTING != SOUND_WEIGHTING_Z
+  // also clears the state
+  arm_biquad_cascade_df1_init_q31(&weighting_filter, SOUND_WEIGHTING_STAGES,
+                                  weighting_coeffs, weighting_state, SOUND_WEIGHTING_SHIFT);
+#endif
+}
+
+void sound_weighting_apply(int16_t* block, uint32_t block_size){
+#if SOUND_WEIGHTING != SOUND_WEIGHTING_Z
+  uint32_t done;
+  uint32_t n;
+
+  for (done = 0; done < block_size; done += n){
+      n = block_size - done;
+      if (n > SOUND_WEIGHTING_CHUNK){
+          n = SOUND_WEIGHTING_CHUNK;
+      }
+      arm_q15_to_q31(&block[done], weighting_chunk, n);
+      arm_biquad_cascade_df1_q31(&weighting_filter, weighting_chunk, weighting_chunk, n);
+      arm_shift_q31(weighting_chunk, 1, weighting_chunk, n); // saturates
+      arm_q31_to_q15(weighting_chunk, &block[done], n);
+  }
+#else
+  (void)block;
+  (void)block_size;
+#endif
+}
+
+// log2 of x in Q16, x > 0. Normalize to [1, 2) then square once per
+// fraction bit, each square that reaches 2 sets the bit.
+static int32_t log2_q16(uint32_t x){
+  int32_t result = 0;
+  uint64_t y;
+  int i;
+
+  while (result < 31 && (x >> (result + 1))){
+      result++;
+  }
+  y = (uint64_t)x << (31 - result); // Q31, 1 << 31 is 1.0
+  result <<= 16;
+
+  for (i = 15; i >= 0; i--){
+      y = (y * y) >> 31;
+      if (y >= (2ULL << 31)){
+          y >>= 1;
+          result |= (1L << i);
+      }
+  }
+  return result;
+}
+
+// q30 mean square to 0.1 dB re 1 mV RMS
+static int16_t mean_square_to_dB10(uint32_t ms){
+  if (ms == 0){
+      ms = 1;
+  }
+  // 100 * log10(ms / full scale) = 30.103 * (log2(ms) - 30)
+  int64_t db = (int64_t)(log2_q16(ms) - (30L << 16)) * 30103;
+  return (int16_t)(db / (1000L << 16) + SOUND_FULL_SCALE_DB10);
+}
+
+#if SOUND_SAMPLING_LDMA && SOUND_SPECTRAL_FEATURES
+#if SOUND_FFT_SIZE > SOUND_BUFFER_SAMPLES * SOUND_BUFFERS_PER_WINDOW
+#error "an FFT frame must fit in one capture window"
+#endif
+#if SOUND_FFT_HOP < 1 || SOUND_FFT_HOP > SOUND_FFT_SIZE
+#error "SOUND_FFT_HOP must be 1 to SOUND_FFT_SIZE"
+#endif
+
+// first bin of each band, the last band runs to Nyquist
+#define SOUND_BIN_LOW       1 // skip DC, the bias is already removed
+#define SOUND_BIN_SPEECH    (SOUND_BAND_LOW_HZ * SOUND_FFT_SIZE / SOUND_SAMPLE_RATE_HZ)
+#define SOUND_BIN_HIGH      (SOUND_BAND_SPEECH_HZ * SOUND_FFT_SIZE / SOUND_SAMPLE_RATE_HZ)
+#define SOUND_BIN_NYQUIST   (SOUND_FFT_SIZE / 2)
+
+static arm_rfft_instance_q15 fft_instance;
+static q15_t fft_staging[SOUND_FFT_SIZE];     // latest samples of the window
+static uint32_t fft_fill = 0;
+static q15_t fft_frame[SOUND_FFT_SIZE];       // windowed copy, the RFFT overwrites its input
+static q15_t fft_spectrum[2 * SOUND_FFT_SIZE];
+static uint64_t band_energy[3];
+static uint32_t fft_frames = 0;
+
+static uint64_t band_power(uint32_t first_bin, uint32_t end_bin){
+  q63_t power;
+  // bins are interleaved re, im
+  arm_power_q15(&fft_spectrum[2 * first_bin], 2 * (end_bin - first_bin), &power);
+  return (uint64_t)power;
+}
+
+static void sound_features_frame(){
+  arm_mult_q15(fft_staging, sound_hann_window, fft_frame, SOUND_FFT_SIZE);
+  arm_rfft_q15(&fft_instance, fft_frame, fft_spectrum);
+
+  band_energy[0] += band_power(SOUND_BIN_LOW, SOUND_BIN_SPEECH);
+  band_energy[1] += band_power(SOUND_BIN_SPEECH, SOUND_BIN_HIGH);
+  band_energy[2] += band_power(SOUND_BIN_HIGH, SOUND_BIN_NYQUIST + 1);
+  fft_frames++;
+}
+
+static void sound_features_reset(){
+  fft_fill = 0;
+  fft_frames = 0;
+  memset(band_energy, 0, sizeof(band_energy));
+}
+
+// feed the AC part of one buffer, a frame is taken every SOUND_FFT_HOP samples
+static void sound_features_add(const q15_t* block, uint32_t block_size){
+  uint32_t used = 0;
+  uint32_t n;
+
+  while (used < block_size){
+      n = SOUND_FFT_SIZE - fft_fill;
+      if (n > block_size - used){
+          n = block_size - used;
+      }
+      memcpy(&fft_staging[fft_fill], &block[used], n * sizeof(q15_t));
+      fft_fill += n;
+      used += n;
+
+      if (fft_fill == SOUND_FFT_SIZE){
+          sound_features_frame();
+          // the overlap stays for the next frame
+          memmove(fft_staging, &fft_staging[SOUND_FFT_HOP], (SOUND_FFT_SIZE - SOUND_FFT_HOP) * sizeof(q15_t));
+          fft_fill = SOUND_FFT_SIZE - SOUND_FFT_HOP;
+      }
+  }
+}
+
+// summed band energy to 0.1 dB, a one-sided spectrum holds half the energy
+// and the Hann window passes 3/8 of the power
+static int16_t band_dB10(uint64_t energy){
+  uint64_t ms = energy * 16 / 3 / fft_frames;
+  if (ms > UINT32_MAX){
+      ms = UINT32_MAX;
+  }
+  return mean_square_to_dB10((uint32_t)ms);
+}
+
+static void sound_features_finish(sound_features_t* features){
+  uint64_t total = band_energy[0] + band_energy[1] + band_energy[2];
+
+  memset(features, 0, sizeof(*features));
+  if (fft_frames == 0){
+      return;
+  }
+  features->low_dB10 = band_dB10(band_energy[0]);
+  features->speech_dB10 = band_dB10(band_energy[1]);
+  features->high_dB10 = band_dB10(band_energy[2]);
+  features->speech_pct = (total == 0) ? 0 : (uint8_t)(band_energy[1] * 100 / total);
+  features->frames = (uint8_t)fft_frames;
+}
+#endif
+
+// add one window to the running Leq and classify
+static void sound_level_finish(uint32_t window_ms, uint16_t peak_mV, sound_level_t* result){
+  if (leq_count == SOUND_LEQ_WINDOWS){
+      leq_sum -= leq_history[leq_next];
+  }
+  else{
+      leq_count++;
+  }
+  leq_history[leq_next] = window_ms;
+  leq_sum += window_ms;
+  leq_next = (leq_next + 1) % SOUND_LEQ_WINDOWS;
+
+  result->peak_mV = peak_mV;
+  result->leq_window_dB10 = mean_square_to_dB10(window_ms);
+  result->leq_dB10 = mean_square_to_dB10((uint32_t)(leq_sum / leq_count));
+
+  if (result->leq_dB10 >= SOUND_LOUD_LEQ_DB10 || peak_mV >= SOUND_LOUD_PEAK_MV){
+      result->level = SOUND_LOUD;
+  }
+  else if (result->leq_dB10 >= SOUND_NOISY_LEQ_DB10){
+      result->level = SOUND_NOISY;
+  }
+  else{
+      result->level = SOUND_QUIET;
+  }
+
+  // ventilation noise has most of its energy under the speech band, on
+  // its own it makes a space noisy, never loud
+  if (result->level == SOUND_LOUD && peak_mV < SOUND_LOUD_PEAK_MV && result->features.frames > 0
+      && result->features.low_dB10 > result->features.speech_dB10){
+      result->level = SOUND_NOISY;
+  }
+}
+
+void initSound(){
+  sound_weighting_reset();
+#if SOUND_SAMPLING_LDMA && SOUND_SPECTRAL_FEATURES
+  // twiddle and bit reversal tables are const tables inside CMSIS-DSP
+  arm_rfft_init_q15(&fft_instance, SOUND_FFT_SIZE, 0, 1);
+  sound_features_reset();
+#endif
+}
+
+#if SOUND_SAMPLING_LDMA
+static uint16_t q15_to_mV(int32_t value){
+  return (uint16_t)((value * SOUND_FULL_SCALE_MV) >> 15);
+}
+
+// AC part of the buffer being reduced
+static q15_t sound_block[SOUND_BUFFER_SAMPLES];
+
+// accumulated over the buffers of one window
+static uint32_t window_ms_sum = 0;
+static int32_t window_peak = 0;
+
+bool sound_level_process(uint32_t n, sound_level_t* result){
+  // 12-bit codes are already valid non-negative q15 values
+  const q15_t* samples = (const q15_t*)sound_capture_buffer(n);
+  q15_t bias;
+  q15_t rms;
+  q15_t max;
+  q15_t min;
+  uint32_t index;
+  int32_t peak;
+
+#if SOUND_PROFILE_CYCLES
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+  uint32_t cycles = DWT->CYCCNT;
+#endif
+
+  if (n == 0){
+      window_ms_sum = 0;
+      window_peak = 0;
+      // windows are not contiguous, start the filter from rest. Within a
+      // window the buffers are back to back and the state carries over.
+      sound_weighting_reset();
+#if SOUND_SPECTRAL_FEATURES
+      sound_features_reset();
+#endif
+  }
+
+  // AUDIO is biased at mid-supply, take the buffer mean as the bias
+  arm_mean_q15(samples, SOUND_BUFFER_SAMPLES, &bias);
+  arm_offset_q15(samples, (q15_t)-bias, sound_block, SOUND_BUFFER_SAMPLES);
+  arm_shift_q15(sound_block, SOUND_Q15_SHIFT, sound_block, SOUND_BUFFER_SAMPLES);
+#if SOUND_SPECTRAL_FEATURES
+  // spectrum of the unweighted signal, the weighting would hide the rumble
+  sound_features_add(sound_block, SOUND_BUFFER_SAMPLES);
+#endif
+  sound_weighting_apply(sound_block, SOUND_BUFFER_SAMPLES);
+
+  // arm_rms_q15 rounds the mean square to q15 before the square root, so
+  // anything under about 7 mV reads as 0, far below the quiet threshold
+  arm_rms_q15(sound_block, SOUND_BUFFER_SAMPLES, &rms);
+  arm_max_q15(sound_block, SOUND_BUFFER_SAMPLES, &max, &index);
+  arm_min_q15(sound_block, SOUND_BUFFER_SAMPLES, &min, &index);
+
+  window_ms_sum += (uint32_t)((int32_t)rms * rms);
+  peak = (max > -(int32_t)min) ? max : -(int32_t)min;
+  if (peak > window_peak){
+      window_peak = peak;
+  }
+
+#if SOUND_PROFILE_CYCLES
+  cycles = DWT->CYCCNT - cycles;
+  LOG_INFO("sound buffer %u: %u cycles, %u per sample\r\n", (unsigned int)n,
+           (unsigned int)cycles, (unsigned int)(cycles / SOUND_BUFFER_SAMPLES));
+#endif
+
+  if (n + 1 < SOUND_BUFFERS_PER_WINDOW){
+      return false;
+  }
+
+  // buffers are the same length, the window mean square is their average
+  uint32_t window_ms = window_ms_sum / SOUND_BUFFERS_PER_WINDOW;
+  q31_t window_rms;
+  arm_sqrt_q31((window_ms >= SOUND_MS_FULL_SCALE) ? INT32_MAX : (q31_t)(window_ms << 1), &window_rms);
+  result->rms_mV = q15_to_mV(window_rms >> 16);
+
+#if SOUND_SPECTRAL_FEATURES
+  sound_features_finish(&result->features);
+#else
+  memset(&result->features, 0, sizeof(result->features));
+#endif
+  sound_level_finish(window_ms, q15_to_mV(window_peak), result);
+  return true;
+}
+#else
+void sound_level_from_envelope(uint32_t envelope_mV, sound_level_t* result){
+  uint64_t rms_q15 = ((uint64_t)envelope_mV * 2 / 3 << 15) / SOUND_FULL_SCALE_MV;
+  uint64_t ms = rms_q15 * rms_q15;
+
+  if (ms > SOUND_MS_FULL_SCALE){
+      ms = SOUND_MS_FULL_SCALE;
+  }
+  result->rms_mV = (uint16_t)(envelope_mV * 2 / 3);
+  memset(&result->features, 0, sizeof(result->features));
+
+  // ENVELOPE is already smoothed, it carries no peak information
+  sound_level_finish((uint32_t)ms, 0, result);
+}
+#endif
+
+const char* sound_level_name(sound_class_t level){
+  switch (level){
+    case SOUND_LOUD:
+      return "loud";
+    case SOUND_NOISY:
+      return "noisy";
+    default:
+      return "quiet";
+  }
+}
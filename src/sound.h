@@ -0,0 +1,90 @@
+/***********************************************************************
+ * @file      sound.h
+ * @brief     Sound level engine header, RMS / peak / Leq of ADC buffers
+ *
+ * @author    Hyounjun Chang, hyounjun.chang@colorado.edu
+ * @date      Oct 16, 2026
+ * @resources CMSIS-DSP statistics and basic math functions
+ *
+ */
+#ifndef SRC_SOUND_H_
+#define SRC_SOUND_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "adc.h"
+
+// Levels are ADC-referred, in 0.1 dB re 1 mV RMS at the AUDIO pin.
+// They are not calibrated to dB SPL, the detector gain is set by a trimmer.
+// Thresholds match the old 100/45 mV ENVELOPE cut-offs, ENVELOPE reads
+// about 1.5x the AUDIO RMS
+#define SOUND_LOUD_LEQ_DB10   365  // 67 mV RMS
+#define SOUND_NOISY_LEQ_DB10  295  // 30 mV RMS
+#define SOUND_LOUD_PEAK_MV    1000 // a bang this big is loud however short
+
+// windows averaged into the running Leq, one window per LETIMER0 period
+#define SOUND_LEQ_WINDOWS     10
+
+// frequency weighting applied to AUDIO before the level is computed
+#define SOUND_WEIGHTING_Z     0   // none, flat
+#define SOUND_WEIGHTING_A     1   // perceived loudness, discounts fan rumble
+#define SOUND_WEIGHTING_C     2   // nearly flat, only the ends of the band
+#define SOUND_WEIGHTING       SOUND_WEIGHTING_A
+
+// 1: measure the block stage with the DWT cycle counter and log cycles per sample
+#define SOUND_PROFILE_CYCLES  0
+
+// 1: real FFT of the unweighted AUDIO, band energies published per window
+#define SOUND_SPECTRAL_FEATURES 1
+#define SOUND_FFT_SIZE        256  // 128, 256 or 512, 31.25 Hz bins at 256
+#define SOUND_FFT_HOP         128  // samples between frames, frames overlap below SOUND_FFT_SIZE
+#define SOUND_BAND_LOW_HZ     300  // under this: fans, HVAC rumble, traffic
+#define SOUND_BAND_SPEECH_HZ  3400 // telephone speech band, above it: broadband hiss
+
+typedef enum {
+  SOUND_QUIET,
+  SOUND_NOISY,
+  SOUND_LOUD,
+} sound_class_t;
+
+// band levels of one window, same units as the Leq but unweighted
+typedef struct {
+  int16_t low_dB10;         // DC excluded, up to SOUND_BAND_LOW_HZ
+  int16_t speech_dB10;      // SOUND_BAND_LOW_HZ to SOUND_BAND_SPEECH_HZ
+  int16_t high_dB10;        // SOUND_BAND_SPEECH_HZ to Nyquist
+  uint8_t speech_pct;       // speech band share of the total energy
+  uint8_t frames;           // FFT frames averaged, 0 when there were none
+} sound_features_t;
+
+typedef struct {
+  uint16_t rms_mV;          // RMS of the AC part over the window
+  uint16_t peak_mV;         // largest excursion from the bias in the window
+  int16_t leq_window_dB10;  // Leq of this window
+  int16_t leq_dB10;         // Leq of the last SOUND_LEQ_WINDOWS windows
+  sound_class_t level;
+  sound_features_t features;
+} sound_level_t;
+
+void initSound();
+
+#if SOUND_SAMPLING_LDMA
+// statistics of buffer number n of the current capture window, returns
+// true with the window results once the last buffer is in
+bool sound_level_process(uint32_t n, sound_level_t* result);
+#else
+// one ENVELOPE reading in mV, scaled to the AUDIO RMS it stands for
+void sound_level_from_envelope(uint32_t envelope_mV, sound_level_t* result);
+#endif
+
+const char* sound_level_name(sound_class_t level);
+
+#if SOUND_SPECTRAL_FEATURES
+// q15 Hann window for SOUND_FFT_SIZE, sound_tables.c
+extern const int16_t sound_hann_window[SOUND_FFT_SIZE];
+#endif
+
+// weighting filter, state carries over from one call to the next until reset
+void sound_weighting_reset();
+void sound_weighting_apply(int16_t* block, uint32_t block_size);
+
+#endif
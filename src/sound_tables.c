@@ -0,0 +1,106 @@
+/***********************************************************************
+ * @file      sound_tables.c
+ * @brief     Constant tables for the sound spectral stage, kept in flash
+ *
+ * @author    Hyounjun Chang, hyounjun.chang@colorado.edu
+ * @date      Oct 16, 2026
+ *
+ * @resources CMSIS-DSP transform functions
+ *
+ * Periodic Hann windows, w[n] = 0.5 - 0.5 * cos(2 * pi * n / N), rounded
+ * to q15. Only the table for SOUND_FFT_SIZE is compiled. The RFFT twiddle
+ * and bit reversal tables are the const ones inside CMSIS-DSP.
+ *
+ */
+#include "sound.h"
+
+#if SOUND_SPECTRAL_FEATURES
+#if SOUND_FFT_SIZE == 128
+const int16_t sound_hann_window[SOUND_FFT_SIZE] = {
+  0, 20, 79, 177, 315, 491, 705, 958, 1247, 1573, 1935, 2331,
+  2761, 3224, 3719, 4244, 4799, 5381, 5990, 6624, 7281, 7961, 8660, 9379,
+  10114, 10864, 11628, 12403, 13187, 13980, 14778, 15580, 16383, 17187, 17989, 18787,
+  19580, 20364, 21139, 21903, 22653, 23388, 24107, 24806, 25486, 26143, 26777, 27386,
+  27968, 28523, 29048, 29543, 30006, 30436, 30832, 31194, 31520, 31809, 32062, 32276,
+  32452, 32590, 32688, 32747, 32767, 32747, 32688, 32590, 32452, 32276, 32062, 31809,
+  31520, 31194, 30832, 30436, 30006, 29543, 29048, 28523, 27968, 27386, 26777, 26143,
+  25486, 24806, 24107, 23388, 22653, 21903, 21139, 20364, 19580, 18787, 17989, 17187,
+  16384, 15580, 14778, 13980, 13187, 12403, 11628, 10864, 10114, 9379, 8660, 7961,
+  7281, 6624, 5990, 5381, 4799, 4244, 3719, 3224, 2761, 2331, 1935, 1573,
+  1247, 958, 705, 491, 315, 177, 79, 20,
+};
+#elif SOUND_FFT_SIZE == 256
+const int16_t sound_hann_window[SOUND_FFT_SIZE] = {
+  0, 5, 20, 44, 79, 123, 177, 241, 315, 398, 491, 593,
+  705, 827, 958, 1098, 1247, 1406, 1573, 1749, 1935, 2128, 2331, 2542,
+  2761, 2989, 3224, 3468, 3719, 3978, 4244, 4518, 4799, 5086, 5381, 5682,
+  5990, 6304, 6624, 6950, 7281, 7618, 7961, 8308, 8660, 9017, 9379, 9744,
+  10114, 10487, 10864, 11244, 11628, 12014, 12403, 12794, 13187, 13583, 13980, 14378,
+  14778, 15178, 15580, 15981, 16383, 16786, 17187, 17589, 17989, 18389, 18787, 19184,
+  19580, 19973, 20364, 20753, 21139, 21523, 21903, 22280, 22653, 23023, 23388, 23750,
+  24107, 24459, 24806, 25149, 25486, 25817, 26143, 26463, 26777, 27085, 27386, 27681,
+  27968, 28249, 28523, 28789, 29048, 29299, 29543, 29778, 30006, 30225, 30436, 30639,
+  30832, 31018, 31194, 31361, 31520, 31669, 31809, 31940, 32062, 32174, 32276, 32369,
+  32452, 32526, 32590, 32644, 32688, 32723, 32747, 32762, 32767, 32762, 32747, 32723,
+  32688, 32644, 32590, 32526, 32452, 32369, 32276, 32174, 32062, 31940, 31809, 31669,
+  31520, 31361, 31194, 31018, 30832, 30639, 30436, 30225, 30006, 29778, 29543, 29299,
+  29048, 28789, 28523, 28249, 27968, 27681, 27386, 27085, 26777, 26463, 26143, 25817,
+  25486, 25149, 24806, 24459, 24107, 23750, 23388, 23023, 22653, 22280, 21903, 21523,
+  21139, 20753, 20364, 19973, 19580, 19184, 18787, 18389, 17989, 17589, 17187, 16786,
+  16384, 15981, 15580, 15178, 14778, 14378, 13980, 13583, 13187, 12794, 12403, 12014,
+  11628, 11244, 10864, 10487, 10114, 9744, 9379, 9017, 8660, 8308, 7961, 7618,
+  7281, 6950, 6624, 6304, 5990, 5682, 5381, 5086, 4799, 4518, 4244, 3978,
+  3719, 3468, 3224, 2989, 2761, 2542, 2331, 2128, 1935, 1749, 1573, 1406,
+  1247, 1098, 958, 827, 705, 593, 491, 398, 315, 241, 177, 123,
+  79, 44, 20, 5,
+};
+#elif SOUND_FFT_SIZE == 512
+const int16_t sound_hann_window[SOUND_FFT_SIZE] = {
+  0, 1, 5, 11, 20, 31, 44, 60, 79, 100, 123, 149,
+  177, 208, 241, 277, 315, 355, 398, 443, 491, 541, 593, 648,
+  705, 765, 827, 891, 958, 1027, 1098, 1171, 1247, 1325, 1406, 1488,
+  1573, 1660, 1749, 1841, 1935, 2030, 2128, 2229, 2331, 2435, 2542, 2650,
+  2761, 2874, 2989, 3105, 3224, 3345, 3468, 3592, 3719, 3847, 3978, 4110,
+  4244, 4380, 4518, 4657, 4799, 4942, 5086, 5233, 5381, 5531, 5682, 5835,
+  5990, 6146, 6304, 6463, 6624, 6786, 6950, 7115, 7281, 7449, 7618, 7789,
+  7961, 8134, 8308, 8484, 8660, 8838, 9017, 9197, 9379, 9561, 9744, 9929,
+  10114, 10300, 10487, 10675, 10864, 11054, 11244, 11436, 11628, 11820, 12014, 12208,
+  12403, 12598, 12794, 12990, 13187, 13385, 13583, 13781, 13980, 14179, 14378, 14578,
+  14778, 14978, 15178, 15379, 15580, 15780, 15981, 16182, 16383, 16585, 16786, 16987,
+  17187, 17388, 17589, 17789, 17989, 18189, 18389, 18588, 18787, 18986, 19184, 19382,
+  19580, 19777, 19973, 20169, 20364, 20559, 20753, 20947, 21139, 21331, 21523, 21713,
+  21903, 22092, 22280, 22467, 22653, 22838, 23023, 23206, 23388, 23570, 23750, 23929,
+  24107, 24283, 24459, 24633, 24806, 24978, 25149, 25318, 25486, 25652, 25817, 25981,
+  26143, 26304, 26463, 26621, 26777, 26932, 27085, 27236, 27386, 27534, 27681, 27825,
+  27968, 28110, 28249, 28387, 28523, 28657, 28789, 28920, 29048, 29175, 29299, 29422,
+  29543, 29662, 29778, 29893, 30006, 30117, 30225, 30332, 30436, 30538, 30639, 30737,
+  30832, 30926, 31018, 31107, 31194, 31279, 31361, 31442, 31520, 31596, 31669, 31740,
+  31809, 31876, 31940, 32002, 32062, 32119, 32174, 32226, 32276, 32324, 32369, 32412,
+  32452, 32490, 32526, 32559, 32590, 32618, 32644, 32667, 32688, 32707, 32723, 32736,
+  32747, 32756, 32762, 32766, 32767, 32766, 32762, 32756, 32747, 32736, 32723, 32707,
+  32688, 32667, 32644, 32618, 32590, 32559, 32526, 32490, 32452, 32412, 32369, 32324,
+  32276, 32226, 32174, 32119, 32062, 32002, 31940, 31876, 31809, 31740, 31669, 31596,
+  31520, 31442, 31361, 31279, 31194, 31107, 31018, 30926, 30832, 30737, 30639, 30538,
+  30436, 30332, 30225, 30117, 30006, 29893, 29778, 29662, 29543, 29422, 29299, 29175,
+  29048, 28920, 28789, 28657, 28523, 28387, 28249, 28110, 27968, 27825, 27681, 27534,
+  27386, 27236, 27085, 26932, 26777, 26621, 26463, 26304, 26143, 25981, 25817, 25652,
+  25486, 25318, 25149, 24978, 24806, 24633, 24459, 24283, 24107, 23929, 23750, 23570,
+  23388, 23206, 23023, 22838, 22653, 22467, 22280, 22092, 21903, 21713, 21523, 21331,
+  21139, 20947, 20753, 20559, 20364, 20169, 19973, 19777, 19580, 19382, 19184, 18986,
+  18787, 18588, 18389, 18189, 17989, 17789, 17589, 17388, 17187, 16987, 16786, 16585,
+  16384, 16182, 15981, 15780, 15580, 15379, 15178, 14978, 14778, 14578, 14378, 14179,
+  13980, 13781, 13583, 13385, 13187, 12990, 12794, 12598, 12403, 12208, 12014, 11820,
+  11628, 11436, 11244, 11054, 10864, 10675, 10487, 10300, 10114, 9929, 9744, 9561,
+  9379, 9197, 9017, 8838, 8660, 8484, 8308, 8134, 7961, 7789, 7618, 7449,
+  7281, 7115, 6950, 6786, 6624, 6463, 6304, 6146, 5990, 5835, 5682, 5531,
+  5381, 5233, 5086, 4942, 4799, 4657, 4518, 4380, 4244, 4110, 3978, 3847,
+  3719, 3592, 3468, 3345, 3224, 3105, 2989, 2874, 2761, 2650, 2542, 2435,
+  2331, 2229, 2128, 2030, 1935, 1841, 1749, 1660, 1573, 1488, 1406, 1325,
+  1247, 1171, 1098, 1027, 958, 891, 827, 765, 705, 648, 593, 541,
+  491, 443, 398, 355, 315, 277, 241, 208, 177, 149, 123, 100,
+  79, 60, 44, 31, 20, 11, 5, 1,
+};
+#else
+#error "SOUND_FFT_SIZE must be 128, 256 or 512"
+#endif
+#endif
@@ -16,11 +16,12 @@
 #include "em_letimer.h"
 
 #include "irq.h" // to disable scheduler event
+#include "soft_timer.h"
 
 // for critical section
 #include <em_core.h>
 
-#define LETIMER_PERIOD_MS 1000
+#define LETIMER_PERIOD_MS SOUND_WINDOW_PERIOD_MS
 
 #define LFXO_FREQ 32768
 #define ULFRCO_FREQ 1000
@@ -33,7 +34,12 @@
   #define LETIMER0_FREQ LFXO_FREQ/LETIMER0_PRESCALER
 #endif
 
-#define LETIMER0_TOP_VALUE (LETIMER_PERIOD_MS * LETIMER0_FREQ) / 1000
+#if TIMER_TICKLESS
+  // full 16-bit range, 8 s at LFXO/4 and 65.536 s on ULFRCO, whole ms both
+  #define LETIMER0_TOP_VALUE 0xFFFF
+#else
+  #define LETIMER0_TOP_VALUE (LETIMER_PERIOD_MS * LETIMER0_FREQ) / 1000
+#endif
 
 #define NUM_MIROSEC_IN_SEC 1000000
 //
@@ -45,13 +51,59 @@
 #include "src/log.h"
 
 static bool timerwait_done = false;
+static soft_timer_t timerwait_timer;
+
+// ticks to time as (ticks * mult) >> shift, no division per call
+typedef struct{
+  uint32_t mult;
+  uint32_t shift;
+} tick_scale_t;
+
+static tick_scale_t tick_scale_us;
+static tick_scale_t tick_scale_ms;
 
 // last requested letimer interrupt duration in ms
 static uint32_t letimer_uf_duration_ms = 0;
 
+// units_per_s / LETIMER0_FREQ as mult / 2^shift. Both LETIMER0 clocks are
+// 2^a * 5^b Hz, once the common factors are gone the rest of the frequency
+// is a power of 2 and the scale is exact.
+static void tick_scale_init(tick_scale_t* scale, uint32_t units_per_s){
+  uint32_t num = units_per_s;
+  uint32_t den = LETIMER0_FREQ;
+
+  while (num % 2 == 0 && den % 2 == 0){
+      num /= 2;
+      den /= 2;
+  }
+  while (num % 5 == 0 && den % 5 == 0){
+      num /= 5;
+      den /= 5;
+  }
+  scale->shift = 0;
+  while (den % 2 == 0){
+      den /= 2;
+      scale->shift++;
+  }
+  scale->mult = num;
+  if (den != 1){
+      // some other clock, 12 more fraction bits and rounding
+      LOG_WARN("LETIMER0 at %lu Hz, tick conversions are rounded\r\n", (unsigned long)LETIMER0_FREQ);
+      scale->mult = (uint32_t)((((uint64_t)num << 12) + den / 2) / den);
+      scale->shift += 12;
+  }
+}
+
 void init_LETIMER0(){
+  tick_scale_init(&tick_scale_us, NUM_MIROSEC_IN_SEC);
+  tick_scale_init(&tick_scale_ms, 1000);
+
   // Update last_letimer_duration_ms
+#if TIMER_TICKLESS
+  letimer_uf_duration_ms = ((uint32_t)LETIMER0_TOP_VALUE + 1) * 1000 / LETIMER0_FREQ;
+#else
   letimer_uf_duration_ms = LETIMER_PERIOD_MS;
+#endif
 
   // disable LETIMER0 in case its already initialized
   LETIMER_Enable(LETIMER0, false);
@@ -92,6 +144,10 @@ void init_LETIMER0(){
 
   // Enable the timer to starting counting down, set LETIMER0_CMD[START] bit, see LETIMER0_STATUS[RUNNING] bit
   LETIMER_Enable (LETIMER0, true);
+
+  // COMP1 belongs to the software timers from here on, when tickless they
+  // also decide whether the underflow stays enabled
+  initSoftTimers();
 }
 
 /*
@@ -156,34 +212,10 @@ void timerWaitUs_polled(uint32_t us_wait){
 
 
 // waits for at least us_wait microseconds, non-blocking
-// uses LETIMER0_COMP1 register
-// causes problems if used alongside timerWaitUS_polled()
-// has limit of 16-bit timer value
+// EVENT_LETIMER0_COMP1 with data SOFT_TIMER_WAIT_US when done. A new call
+// restarts the wait, other software timers keep running alongside it
 void timerWaitUs_irq(uint32_t us_wait){
-  uint64_t num_timer_cycles = ((uint64_t)us_wait * (uint64_t)LETIMER0_FREQ /
-                               (uint64_t)NUM_MIROSEC_IN_SEC) + 1; // 64-bit due to truncation
-
-  if (num_timer_cycles > 0xFFFF){
-      LOG_ERROR("timerWaitUs_irq() out of range, NO TIMER WILL BE SET!\r\n");
-      return;
-  }
-
-  LETIMER_Enable(LETIMER0, false); // briefly disable until comp1 set
-  // Calculate COMP1 value
-  uint32_t curr_cnt = LETIMER_CounterGet(LETIMER0);
-  uint32_t comp1_cnt;
-  if (curr_cnt < num_timer_cycles){
-      comp1_cnt = curr_cnt + LETIMER0_TOP_VALUE - num_timer_cycles;
-  }
-  else{
-      comp1_cnt =  curr_cnt - num_timer_cycles;
-  }
-  LETIMER_CompareSet(LETIMER0, 1, comp1_cnt);
-
-  // LETIMER_IntEnable() must hanve LETIMER_IntClear()
-  LETIMER_IntClear(LETIMER0, LETIMER_IEN_COMP1);
-  LETIMER_IntEnable(LETIMER0, LETIMER_IEN_COMP1);
-  LETIMER_Enable(LETIMER0, true);
+  soft_timer_start_us(&timerwait_timer, SOFT_TIMER_WAIT_US, us_wait, 0);
 }
 
 bool get_timerwait_done(){
@@ -209,3 +241,11 @@ uint32_t get_LETIMER_TOP_value(){
 uint32_t get_LETIMER_freq(){
   return LETIMER0_FREQ;
 }
+
+uint64_t letimerTicksToUs(uint64_t ticks){
+  return (ticks * tick_scale_us.mult) >> tick_scale_us.shift;
+}
+
+uint64_t letimerTicksToMs(uint64_t ticks){
+  return (ticks * tick_scale_ms.mult) >> tick_scale_ms.shift;
+}
@@ -16,6 +16,19 @@
 #include <stdint.h> // for uint32_t declaration
 #include <stdbool.h>
 
+// 1: tickless, LETIMER0 free runs over its full 16 bits and the MCU only
+//    wakes for software timer deadlines. The periodic work below runs on
+//    soft timers, the underflow is only enabled while none is pending.
+// 0: LETIMER0 underflows every second and its ISR starts the periodic work
+#ifndef TIMER_TICKLESS
+#define TIMER_TICKLESS 1
+#endif
+
+// periodic work of the server
+#define SOUND_WINDOW_PERIOD_MS    1000 // one sound capture window
+#define AMBIENT_LIGHT_PERIOD_MS   5000 // one VEML6030 read
+#define TEMPERATURE_PERIOD_MS     30000 // one Si7021 humidity and temperature measurement
+
 void init_LETIMER0();
 
 // waits for at least us_wait microseconds
@@ -32,4 +45,8 @@ uint32_t get_LETIMER_UF_duration_ms();
 uint32_t get_LETIMER_TOP_value();
 uint32_t get_LETIMER_freq();
 
+// LETIMER0 ticks to time, rounded down. A multiply and a shift, safe in ISRs
+uint64_t letimerTicksToUs(uint64_t ticks);
+uint64_t letimerTicksToMs(uint64_t ticks);
+
 #endif // GECKO_TIMERS